@@ -27,10 +27,159 @@
 #include "winbase.h"
 #include "ntsecapi.h"
 #include "bcrypt.h"
+
 #include "wine/debug.h"
+#include "wine/unicode.h"
+
+/* shared with rsaenh */
+#include "tomcrypt.h"
+#include "sha2.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(bcrypt);
 
+/* Next typedef copied from dlls/advapi32/crypt_md5.c */
+typedef struct tagMD5_CTX
+{
+    unsigned int i[2];
+    unsigned int buf[4];
+    unsigned char in[64];
+    unsigned char digest[16];
+} MD5_CTX;
+
+/* Next typedef copied from dlls/advapi32/crypt_sha.c */
+typedef struct tagSHA_CTX
+{
+    ULONG Unknown[6];
+    ULONG State[5];
+    ULONG Count[2];
+    UCHAR Buffer[64];
+} SHA_CTX;
+
+/* Function prototypes copied from dlls/advapi32/crypt_md5.c */
+VOID WINAPI MD5Init( MD5_CTX *ctx );
+VOID WINAPI MD5Update( MD5_CTX *ctx, const unsigned char *buf, unsigned int len );
+VOID WINAPI MD5Final( MD5_CTX *ctx );
+/* Function prototypes copied from dlls/advapi32/crypt_sha.c */
+VOID WINAPI A_SHAInit( SHA_CTX *ctx );
+VOID WINAPI A_SHAUpdate( SHA_CTX *ctx, const unsigned char *buffer, UINT size );
+VOID WINAPI A_SHAFinal( SHA_CTX *ctx, PULONG result );
+
+#define MAGIC_ALG  (('A' << 24) | ('L' << 16) | ('G' << 8) | '0')
+#define MAGIC_HASH (('H' << 24) | ('A' << 16) | ('S' << 8) | 'H')
+#define MAGIC_KEY  (('K' << 24) | ('E' << 16) | ('Y' << 8) | '0')
+
+struct object
+{
+    ULONG magic;
+};
+
+enum alg_id
+{
+    ALG_ID_AES,
+    ALG_ID_MD5,
+    ALG_ID_RNG,
+    ALG_ID_SHA1,
+    ALG_ID_SHA256,
+    ALG_ID_SHA384,
+    ALG_ID_SHA512
+};
+
+enum mode_id
+{
+    MODE_ID_ECB,
+    MODE_ID_CBC,
+    MODE_ID_GCM
+};
+
+#define MAX_HASH_OUTPUT_BYTES 64
+#define MAX_HASH_BLOCK_BITS   1024
+#define AES_BLOCK_SIZE        16
+
+static const WCHAR aesW[] = {'A','E','S',0};
+static const WCHAR md5W[] = {'M','D','5',0};
+static const WCHAR rngW[] = {'R','N','G',0};
+static const WCHAR sha1W[] = {'S','H','A','1',0};
+static const WCHAR sha256W[] = {'S','H','A','2','5','6',0};
+static const WCHAR sha384W[] = {'S','H','A','3','8','4',0};
+static const WCHAR sha512W[] = {'S','H','A','5','1','2',0};
+
+static const struct
+{
+    const WCHAR *name;
+    ULONG        class;
+    ULONG        hash_length;
+    ULONG        block_bits;
+}
+alg_props[] =
+{
+    /* ALG_ID_AES    */ { aesW,    BCRYPT_CIPHER_OPERATION, 0,  128 },
+    /* ALG_ID_MD5    */ { md5W,    BCRYPT_HASH_OPERATION,   16, 512 },
+    /* ALG_ID_RNG    */ { rngW,    BCRYPT_RNG_OPERATION,    0,  0 },
+    /* ALG_ID_SHA1   */ { sha1W,   BCRYPT_HASH_OPERATION,   20, 512 },
+    /* ALG_ID_SHA256 */ { sha256W, BCRYPT_HASH_OPERATION,   32, 512 },
+    /* ALG_ID_SHA384 */ { sha384W, BCRYPT_HASH_OPERATION,   48, 1024 },
+    /* ALG_ID_SHA512 */ { sha512W, BCRYPT_HASH_OPERATION,   64, 1024 }
+};
+
+static const WCHAR chain_mode_ecbW[] = {'C','h','a','i','n','i','n','g','M','o','d','e','E','C','B',0};
+static const WCHAR chain_mode_cbcW[] = {'C','h','a','i','n','i','n','g','M','o','d','e','C','B','C',0};
+static const WCHAR chain_mode_gcmW[] = {'C','h','a','i','n','i','n','g','M','o','d','e','G','C','M',0};
+
+static const WCHAR *mode_names[] =
+{
+    /* MODE_ID_ECB */ chain_mode_ecbW,
+    /* MODE_ID_CBC */ chain_mode_cbcW,
+    /* MODE_ID_GCM */ chain_mode_gcmW
+};
+
+struct algorithm
+{
+    struct object hdr;
+    enum alg_id   id;
+    enum mode_id  mode;
+    BOOL          hmac;
+};
+
+union hash_ctx
+{
+    MD5_CTX    md5;
+    SHA_CTX    sha1;
+    SHA256_CTX sha256;
+    SHA384_CTX sha384;
+    SHA512_CTX sha512;
+};
+
+struct hash
+{
+    struct object  hdr;
+    enum alg_id    alg_id;
+    BOOL           hmac;
+    BOOL           allocated;   /* FALSE if the object buffer belongs to the caller */
+    union hash_ctx ctx;
+    union hash_ctx inner;       /* initial state, keyed with the inner pad for HMAC */
+    union hash_ctx outer;       /* keyed with the outer pad for HMAC */
+};
+
+struct key
+{
+    struct object hdr;
+    enum mode_id  mode;
+    BOOL          allocated;
+    aes_key       aes;
+    UCHAR         gcm_h[16];    /* GHASH subkey, E(K, 0) */
+    ULONG64       gcm_hl[16];   /* multiples of the subkey for the generic GHASH */
+    ULONG64       gcm_hh[16];
+};
+
+/* Objects placed in caller supplied buffers are aligned by hand, the
+ * reported object lengths include the slack needed for that. */
+#define OBJECT_ALIGN 8
+
+static void *object_from_buffer( UCHAR *buffer )
+{
+    return (void *)(((ULONG_PTR)buffer + OBJECT_ALIGN - 1) & ~(ULONG_PTR)(OBJECT_ALIGN - 1));
+}
+
 BOOL WINAPI DllMain(HINSTANCE hInstDLL, DWORD fdwReason, LPVOID lpv)
 {
     TRACE("fdwReason %u\n", fdwReason);
@@ -76,13 +225,17 @@ NTSTATUS WINAPI BCryptGenRandom(BCRYPT_ALG_HANDLE algorithm, UCHAR *buffer, ULON
         FIXME("unsupported flags %08x\n", flags & ~supported_flags);
 
     if (algorithm)
-        FIXME("ignoring selected algorithm\n");
+    {
+        struct algorithm *alg = algorithm;
+        if (alg->hdr.magic != MAGIC_ALG || alg->id != ALG_ID_RNG)
+            return STATUS_INVALID_HANDLE;
+    }
 
     /* When zero bytes are requested the function returns success too. */
     if (!count)
         return STATUS_SUCCESS;
 
-    if (flags & BCRYPT_USE_SYSTEM_PREFERRED_RNG)
+    if (algorithm || (flags & BCRYPT_USE_SYSTEM_PREFERRED_RNG))
     {
         if (RtlGenRandom(buffer, count))
             return STATUS_SUCCESS;
@@ -91,3 +244,926 @@ NTSTATUS WINAPI BCryptGenRandom(BCRYPT_ALG_HANDLE algorithm, UCHAR *buffer, ULON
     FIXME("called with unsupported parameters, returning error\n");
     return STATUS_NOT_IMPLEMENTED;
 }
+
+NTSTATUS WINAPI BCryptOpenAlgorithmProvider( BCRYPT_ALG_HANDLE *handle, LPCWSTR id, LPCWSTR implementation, DWORD flags )
+{
+    struct algorithm *alg;
+    unsigned int i;
+
+    TRACE( "%p, %s, %s, %08x\n", handle, wine_dbgstr_w(id), wine_dbgstr_w(implementation), flags );
+
+    if (!handle || !id) return STATUS_INVALID_PARAMETER;
+    if (flags & ~BCRYPT_ALG_HANDLE_HMAC_FLAG)
+    {
+        FIXME( "unsupported flags %08x\n", flags & ~BCRYPT_ALG_HANDLE_HMAC_FLAG );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    for (i = 0; i < sizeof(alg_props) / sizeof(alg_props[0]); i++)
+        if (!strcmpW( id, alg_props[i].name )) break;
+    if (i == sizeof(alg_props) / sizeof(alg_props[0]))
+    {
+        FIXME( "algorithm %s not supported\n", debugstr_w(id) );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    if (implementation && strcmpW( implementation, MS_PRIMITIVE_PROVIDER ))
+    {
+        FIXME( "implementation %s not supported\n", debugstr_w(implementation) );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    if ((flags & BCRYPT_ALG_HANDLE_HMAC_FLAG) && alg_props[i].class != BCRYPT_HASH_OPERATION)
+        return STATUS_NOT_SUPPORTED;
+
+    if (!(alg = HeapAlloc( GetProcessHeap(), 0, sizeof(*alg) ))) return STATUS_NO_MEMORY;
+    alg->hdr.magic = MAGIC_ALG;
+    alg->id        = i;
+    alg->mode      = MODE_ID_CBC;
+    alg->hmac      = (flags & BCRYPT_ALG_HANDLE_HMAC_FLAG) != 0;
+
+    *handle = alg;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptCloseAlgorithmProvider( BCRYPT_ALG_HANDLE handle, DWORD flags )
+{
+    struct algorithm *alg = handle;
+
+    TRACE( "%p, %08x\n", handle, flags );
+
+    if (!alg || alg->hdr.magic != MAGIC_ALG) return STATUS_INVALID_HANDLE;
+    alg->hdr.magic = 0;
+    HeapFree( GetProcessHeap(), 0, alg );
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS copy_property( const void *value, ULONG value_size, UCHAR *buf, ULONG size, ULONG *ret_size )
+{
+    *ret_size = value_size;
+    if (!buf) return STATUS_SUCCESS;
+    if (size < value_size) return STATUS_BUFFER_TOO_SMALL;
+    memcpy( buf, value, value_size );
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS get_alg_property( enum alg_id id, enum mode_id mode, const WCHAR *prop,
+                                  UCHAR *buf, ULONG size, ULONG *ret_size )
+{
+    BOOL is_hash = alg_props[id].class == BCRYPT_HASH_OPERATION;
+    ULONG value;
+
+    if (!strcmpW( prop, BCRYPT_ALGORITHM_NAME ))
+        return copy_property( alg_props[id].name, (strlenW( alg_props[id].name ) + 1) * sizeof(WCHAR),
+                              buf, size, ret_size );
+
+    if (!strcmpW( prop, BCRYPT_OBJECT_LENGTH ))
+    {
+        if (is_hash) value = sizeof(struct hash) + OBJECT_ALIGN - 1;
+        else if (id == ALG_ID_AES) value = sizeof(struct key) + OBJECT_ALIGN - 1;
+        else return STATUS_NOT_SUPPORTED;
+        return copy_property( &value, sizeof(value), buf, size, ret_size );
+    }
+
+    if (is_hash)
+    {
+        if (!strcmpW( prop, BCRYPT_HASH_LENGTH ))
+            return copy_property( &alg_props[id].hash_length, sizeof(ULONG), buf, size, ret_size );
+        if (!strcmpW( prop, BCRYPT_HASH_BLOCK_LENGTH ))
+        {
+            value = alg_props[id].block_bits / 8;
+            return copy_property( &value, sizeof(value), buf, size, ret_size );
+        }
+    }
+    else if (id == ALG_ID_AES)
+    {
+        if (!strcmpW( prop, BCRYPT_BLOCK_LENGTH ))
+        {
+            value = AES_BLOCK_SIZE;
+            return copy_property( &value, sizeof(value), buf, size, ret_size );
+        }
+        if (!strcmpW( prop, BCRYPT_CHAINING_MODE ))
+            return copy_property( mode_names[mode], (strlenW( mode_names[mode] ) + 1) * sizeof(WCHAR),
+                                  buf, size, ret_size );
+        if (!strcmpW( prop, BCRYPT_KEY_LENGTHS ))
+        {
+            static const BCRYPT_KEY_LENGTHS_STRUCT key_lengths = { 128, 256, 64 };
+            return copy_property( &key_lengths, sizeof(key_lengths), buf, size, ret_size );
+        }
+        if (!strcmpW( prop, BCRYPT_AUTH_TAG_LENGTH ))
+        {
+            static const BCRYPT_AUTH_TAG_LENGTHS_STRUCT tag_lengths = { 12, 16, 1 };
+            if (mode != MODE_ID_GCM) return STATUS_NOT_SUPPORTED;
+            return copy_property( &tag_lengths, sizeof(tag_lengths), buf, size, ret_size );
+        }
+    }
+
+    FIXME( "unsupported property %s\n", debugstr_w(prop) );
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+NTSTATUS WINAPI BCryptGetProperty( BCRYPT_HANDLE handle, LPCWSTR prop, UCHAR *buf, ULONG size, ULONG *ret_size, ULONG flags )
+{
+    struct object *object = handle;
+
+    TRACE( "%p, %s, %p, %u, %p, %08x\n", handle, wine_dbgstr_w(prop), buf, size, ret_size, flags );
+
+    if (!object) return STATUS_INVALID_HANDLE;
+    if (!prop || !ret_size) return STATUS_INVALID_PARAMETER;
+
+    switch (object->magic)
+    {
+    case MAGIC_ALG:
+    {
+        const struct algorithm *alg = handle;
+        return get_alg_property( alg->id, alg->mode, prop, buf, size, ret_size );
+    }
+    case MAGIC_HASH:
+    {
+        const struct hash *hash = handle;
+        return get_alg_property( hash->alg_id, MODE_ID_ECB, prop, buf, size, ret_size );
+    }
+    case MAGIC_KEY:
+    {
+        const struct key *key = handle;
+        return get_alg_property( ALG_ID_AES, key->mode, prop, buf, size, ret_size );
+    }
+    default:
+        WARN( "unknown magic %08x\n", object->magic );
+        return STATUS_INVALID_HANDLE;
+    }
+}
+
+static NTSTATUS set_property( enum alg_id id, enum mode_id *mode, const WCHAR *prop, UCHAR *value, ULONG size )
+{
+    if (!strcmpW( prop, BCRYPT_CHAINING_MODE ))
+    {
+        unsigned int i;
+
+        if (id != ALG_ID_AES) return STATUS_NOT_SUPPORTED;
+        if (!value) return STATUS_INVALID_PARAMETER;
+        for (i = 0; i < sizeof(mode_names) / sizeof(mode_names[0]); i++)
+        {
+            if (!strcmpW( (const WCHAR *)value, mode_names[i] ))
+            {
+                *mode = i;
+                return STATUS_SUCCESS;
+            }
+        }
+        FIXME( "unsupported mode %s\n", debugstr_w((const WCHAR *)value) );
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    FIXME( "unsupported property %s\n", debugstr_w(prop) );
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+NTSTATUS WINAPI BCryptSetProperty( BCRYPT_HANDLE handle, LPCWSTR prop, UCHAR *value, ULONG size, ULONG flags )
+{
+    struct object *object = handle;
+
+    TRACE( "%p, %s, %p, %u, %08x\n", handle, debugstr_w(prop), value, size, flags );
+
+    if (!object) return STATUS_INVALID_HANDLE;
+    if (!prop) return STATUS_INVALID_PARAMETER;
+
+    switch (object->magic)
+    {
+    case MAGIC_ALG:
+    {
+        struct algorithm *alg = handle;
+        return set_property( alg->id, &alg->mode, prop, value, size );
+    }
+    case MAGIC_KEY:
+    {
+        struct key *key = handle;
+        return set_property( ALG_ID_AES, &key->mode, prop, value, size );
+    }
+    default:
+        WARN( "unknown magic %08x\n", object->magic );
+        return STATUS_INVALID_HANDLE;
+    }
+}
+
+static void hash_init( union hash_ctx *ctx, enum alg_id alg_id )
+{
+    switch (alg_id)
+    {
+    case ALG_ID_MD5:
+        MD5Init( &ctx->md5 );
+        break;
+    case ALG_ID_SHA1:
+        A_SHAInit( &ctx->sha1 );
+        break;
+    case ALG_ID_SHA256:
+        SHA256_Init( &ctx->sha256 );
+        break;
+    case ALG_ID_SHA384:
+        SHA384_Init( &ctx->sha384 );
+        break;
+    case ALG_ID_SHA512:
+        SHA512_Init( &ctx->sha512 );
+        break;
+    default:
+        ERR( "unhandled id %u\n", alg_id );
+        break;
+    }
+}
+
+static void hash_update( union hash_ctx *ctx, enum alg_id alg_id, const UCHAR *input, ULONG size )
+{
+    switch (alg_id)
+    {
+    case ALG_ID_MD5:
+        MD5Update( &ctx->md5, input, size );
+        break;
+    case ALG_ID_SHA1:
+        A_SHAUpdate( &ctx->sha1, input, size );
+        break;
+    case ALG_ID_SHA256:
+        SHA256_Update( &ctx->sha256, input, size );
+        break;
+    case ALG_ID_SHA384:
+        SHA384_Update( &ctx->sha384, input, size );
+        break;
+    case ALG_ID_SHA512:
+        SHA512_Update( &ctx->sha512, input, size );
+        break;
+    default:
+        ERR( "unhandled id %u\n", alg_id );
+        break;
+    }
+}
+
+static void hash_finish( union hash_ctx *ctx, enum alg_id alg_id, UCHAR *output )
+{
+    ULONG sha1[5];
+
+    switch (alg_id)
+    {
+    case ALG_ID_MD5:
+        MD5Final( &ctx->md5 );
+        memcpy( output, ctx->md5.digest, 16 );
+        break;
+    case ALG_ID_SHA1:
+        A_SHAFinal( &ctx->sha1, sha1 );
+        memcpy( output, sha1, sizeof(sha1) );
+        break;
+    case ALG_ID_SHA256:
+        SHA256_Final( output, &ctx->sha256 );
+        break;
+    case ALG_ID_SHA384:
+        SHA384_Final( output, &ctx->sha384 );
+        break;
+    case ALG_ID_SHA512:
+        SHA512_Final( output, &ctx->sha512 );
+        break;
+    default:
+        ERR( "unhandled id %u\n", alg_id );
+        break;
+    }
+}
+
+/* Sets up the initial state of a hash, for HMAC the inner and outer contexts
+ * already have the padded key hashed in so that it's done only once per object. */
+static void hash_prepare( struct hash *hash, const UCHAR *secret, ULONG secret_len )
+{
+    UCHAR key[MAX_HASH_BLOCK_BITS / 8], pad[MAX_HASH_BLOCK_BITS / 8];
+    ULONG block_bytes = alg_props[hash->alg_id].block_bits / 8, i;
+
+    hash_init( &hash->inner, hash->alg_id );
+    if (hash->hmac)
+    {
+        memset( key, 0, block_bytes );
+        if (secret_len > block_bytes)
+        {
+            hash_update( &hash->inner, hash->alg_id, secret, secret_len );
+            hash_finish( &hash->inner, hash->alg_id, key );
+            hash_init( &hash->inner, hash->alg_id );
+        }
+        else if (secret_len) memcpy( key, secret, secret_len );
+
+        for (i = 0; i < block_bytes; i++) pad[i] = key[i] ^ 0x5c;
+        hash_init( &hash->outer, hash->alg_id );
+        hash_update( &hash->outer, hash->alg_id, pad, block_bytes );
+
+        for (i = 0; i < block_bytes; i++) pad[i] = key[i] ^ 0x36;
+        hash_update( &hash->inner, hash->alg_id, pad, block_bytes );
+
+        memset( key, 0, sizeof(key) );
+        memset( pad, 0, sizeof(pad) );
+    }
+    hash->ctx = hash->inner;
+}
+
+static struct hash *alloc_hash( UCHAR *object, ULONG object_len, NTSTATUS *status )
+{
+    struct hash *hash;
+
+    if (object)
+    {
+        if (object_len < sizeof(*hash) + OBJECT_ALIGN - 1)
+        {
+            *status = STATUS_BUFFER_TOO_SMALL;
+            return NULL;
+        }
+        hash = object_from_buffer( object );
+        hash->allocated = FALSE;
+    }
+    else
+    {
+        if (!(hash = HeapAlloc( GetProcessHeap(), 0, sizeof(*hash) )))
+        {
+            *status = STATUS_NO_MEMORY;
+            return NULL;
+        }
+        hash->allocated = TRUE;
+    }
+    *status = STATUS_SUCCESS;
+    return hash;
+}
+
+NTSTATUS WINAPI BCryptCreateHash( BCRYPT_ALG_HANDLE algorithm, BCRYPT_HASH_HANDLE *handle, UCHAR *object, ULONG object_len,
+                                  UCHAR *secret, ULONG secret_len, ULONG flags )
+{
+    struct algorithm *alg = algorithm;
+    struct hash *hash;
+    NTSTATUS status;
+
+    TRACE( "%p, %p, %p, %u, %p, %u, %08x\n", algorithm, handle, object, object_len,
+           secret, secret_len, flags );
+
+    if (flags & ~BCRYPT_HASH_REUSABLE_FLAG)
+    {
+        FIXME( "unimplemented flags %08x\n", flags & ~BCRYPT_HASH_REUSABLE_FLAG );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    if (!alg || alg->hdr.magic != MAGIC_ALG) return STATUS_INVALID_HANDLE;
+    if (alg_props[alg->id].class != BCRYPT_HASH_OPERATION) return STATUS_INVALID_PARAMETER;
+    if (!handle) return STATUS_INVALID_PARAMETER;
+
+    if (!(hash = alloc_hash( object, object_len, &status ))) return status;
+    hash->hdr.magic = MAGIC_HASH;
+    hash->alg_id    = alg->id;
+    hash->hmac      = alg->hmac;
+    hash_prepare( hash, secret, secret_len );
+
+    *handle = hash;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptDuplicateHash( BCRYPT_HASH_HANDLE handle, BCRYPT_HASH_HANDLE *handle_copy,
+                                     UCHAR *object, ULONG object_len, ULONG flags )
+{
+    struct hash *hash_orig = handle;
+    struct hash *hash_copy;
+    NTSTATUS status;
+    BOOL allocated;
+
+    TRACE( "%p, %p, %p, %u, %u\n", handle, handle_copy, object, object_len, flags );
+
+    if (!hash_orig || hash_orig->hdr.magic != MAGIC_HASH) return STATUS_INVALID_HANDLE;
+    if (!handle_copy) return STATUS_INVALID_PARAMETER;
+
+    if (!(hash_copy = alloc_hash( object, object_len, &status ))) return status;
+    allocated = hash_copy->allocated;
+    memcpy( hash_copy, hash_orig, sizeof(*hash_orig) );
+    hash_copy->allocated = allocated;
+
+    *handle_copy = hash_copy;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptDestroyHash( BCRYPT_HASH_HANDLE handle )
+{
+    struct hash *hash = handle;
+    BOOL allocated;
+
+    TRACE( "%p\n", handle );
+
+    if (!hash || hash->hdr.magic != MAGIC_HASH) return STATUS_INVALID_HANDLE;
+    allocated = hash->allocated;
+    memset( hash, 0, sizeof(*hash) );
+    if (allocated) HeapFree( GetProcessHeap(), 0, hash );
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptHashData( BCRYPT_HASH_HANDLE handle, UCHAR *input, ULONG size, ULONG flags )
+{
+    struct hash *hash = handle;
+
+    TRACE( "%p, %p, %u, %08x\n", handle, input, size, flags );
+
+    if (!hash || hash->hdr.magic != MAGIC_HASH) return STATUS_INVALID_HANDLE;
+    if (!input && size) return STATUS_INVALID_PARAMETER;
+
+    hash_update( &hash->ctx, hash->alg_id, input, size );
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptFinishHash( BCRYPT_HASH_HANDLE handle, UCHAR *output, ULONG size, ULONG flags )
+{
+    struct hash *hash = handle;
+
+    TRACE( "%p, %p, %u, %08x\n", handle, output, size, flags );
+
+    if (!hash || hash->hdr.magic != MAGIC_HASH) return STATUS_INVALID_HANDLE;
+    if (!output || size != alg_props[hash->alg_id].hash_length) return STATUS_INVALID_PARAMETER;
+
+    hash_finish( &hash->ctx, hash->alg_id, output );
+    if (hash->hmac)
+    {
+        hash->ctx = hash->outer;
+        hash_update( &hash->ctx, hash->alg_id, output, size );
+        hash_finish( &hash->ctx, hash->alg_id, output );
+    }
+
+    /* start over, which is what BCRYPT_HASH_REUSABLE_FLAG asks for */
+    hash->ctx = hash->inner;
+    return STATUS_SUCCESS;
+}
+
+static inline ULONG get_be32( const UCHAR *p )
+{
+    return ((ULONG)p[0] << 24) | ((ULONG)p[1] << 16) | ((ULONG)p[2] << 8) | p[3];
+}
+
+static inline void put_be32( UCHAR *p, ULONG v )
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static inline ULONG64 get_be64( const UCHAR *p )
+{
+    return ((ULONG64)get_be32( p ) << 32) | get_be32( p + 4 );
+}
+
+static inline void put_be64( UCHAR *p, ULONG64 v )
+{
+    put_be32( p, v >> 32 );
+    put_be32( p + 4, v );
+}
+
+/* GHASH multiplies by the subkey in GF(2^128).  The generic version works
+ * on four bits at a time with the tables built here, see "The Galois/Counter
+ * Mode of Operation" by McGrew and Viega. */
+static void gcm_init( struct key *key )
+{
+    static const UCHAR zero[AES_BLOCK_SIZE];
+    ULONG64 vh, vl;
+    int i, j;
+
+    aes_ecb_encrypt( zero, key->gcm_h, &key->aes );
+
+    vh = get_be64( key->gcm_h );
+    vl = get_be64( key->gcm_h + 8 );
+    key->gcm_hh[0] = key->gcm_hl[0] = 0;
+    key->gcm_hh[8] = vh;
+    key->gcm_hl[8] = vl;
+    for (i = 4; i > 0; i >>= 1)
+    {
+        ULONG64 reduce = (vl & 1) ? (ULONG64)0xe1000000 << 32 : 0;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ reduce;
+        key->gcm_hh[i] = vh;
+        key->gcm_hl[i] = vl;
+    }
+    for (i = 2; i <= 8; i *= 2)
+    {
+        for (j = 1; j < i; j++)
+        {
+            key->gcm_hh[i + j] = key->gcm_hh[i] ^ key->gcm_hh[j];
+            key->gcm_hl[i + j] = key->gcm_hl[i] ^ key->gcm_hl[j];
+        }
+    }
+}
+
+static void gcm_mult( const struct key *key, UCHAR x[AES_BLOCK_SIZE] )
+{
+    static const ULONG64 last4[16] =
+    {
+        0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+        0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+    };
+    ULONG64 zh, zl;
+    UCHAR lo, hi, rem;
+    int i;
+
+    lo = x[15] & 0xf;
+    zh = key->gcm_hh[lo];
+    zl = key->gcm_hl[lo];
+    for (i = 15; i >= 0; i--)
+    {
+        lo = x[i] & 0xf;
+        hi = x[i] >> 4;
+        if (i != 15)
+        {
+            rem = zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (last4[rem] << 48);
+            zh ^= key->gcm_hh[lo];
+            zl ^= key->gcm_hl[lo];
+        }
+        rem = zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (last4[rem] << 48);
+        zh ^= key->gcm_hh[hi];
+        zl ^= key->gcm_hl[hi];
+    }
+    put_be64( x, zh );
+    put_be64( x + 8, zl );
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+
+/* Carry-less multiplication makes GHASH a handful of instructions per
+ * block.  Operands are byte swapped so that the bit reflected field
+ * elements of GCM can be multiplied as ordinary polynomials, the product
+ * is shifted by one bit and reduced as described in Intel's "Carry-Less
+ * Multiplication and Its Usage for Computing the GCM Mode" white paper. */
+#define HAVE_GHASH_CLMUL
+
+static int clmul_supported(void)
+{
+    static int supported = -1;
+
+    if (supported == -1)
+    {
+        unsigned int regs[4];
+
+        __asm__("cpuid"
+                : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+                : "0" (1));
+        /* PCLMULQDQ and SSSE3 */
+        supported = (regs[2] & (1 << 1)) && (regs[2] & (1 << 9));
+    }
+    return supported;
+}
+
+static const UCHAR ghash_swap_mask[16] = { 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+
+static void ghash_clmul( UCHAR x[AES_BLOCK_SIZE], const UCHAR h[AES_BLOCK_SIZE], const UCHAR *data, ULONG blocks )
+{
+    __asm__ __volatile__(
+        "movdqu (%[mask]), %%xmm10\n\t"
+        "movdqu (%[x]), %%xmm0\n\t"
+        "pshufb %%xmm10, %%xmm0\n\t"
+        "movdqu (%[h]), %%xmm1\n\t"
+        "pshufb %%xmm10, %%xmm1\n"
+        "1:\n\t"
+        "movdqu (%[data]), %%xmm2\n\t"
+        "pshufb %%xmm10, %%xmm2\n\t"
+        "pxor %%xmm2, %%xmm0\n\t"
+        /* 256-bit product in xmm6:xmm3 */
+        "movdqa %%xmm0, %%xmm3\n\t"
+        "pclmulqdq $0x00, %%xmm1, %%xmm3\n\t"
+        "movdqa %%xmm0, %%xmm4\n\t"
+        "pclmulqdq $0x10, %%xmm1, %%xmm4\n\t"
+        "movdqa %%xmm0, %%xmm5\n\t"
+        "pclmulqdq $0x01, %%xmm1, %%xmm5\n\t"
+        "movdqa %%xmm0, %%xmm6\n\t"
+        "pclmulqdq $0x11, %%xmm1, %%xmm6\n\t"
+        "pxor %%xmm5, %%xmm4\n\t"
+        "movdqa %%xmm4, %%xmm5\n\t"
+        "psrldq $8, %%xmm4\n\t"
+        "pslldq $8, %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        "pxor %%xmm4, %%xmm6\n\t"
+        /* shift left by one bit */
+        "movdqa %%xmm3, %%xmm7\n\t"
+        "movdqa %%xmm6, %%xmm8\n\t"
+        "pslld $1, %%xmm3\n\t"
+        "pslld $1, %%xmm6\n\t"
+        "psrld $31, %%xmm7\n\t"
+        "psrld $31, %%xmm8\n\t"
+        "movdqa %%xmm7, %%xmm9\n\t"
+        "pslldq $4, %%xmm8\n\t"
+        "pslldq $4, %%xmm7\n\t"
+        "psrldq $12, %%xmm9\n\t"
+        "por %%xmm7, %%xmm3\n\t"
+        "por %%xmm8, %%xmm6\n\t"
+        "por %%xmm9, %%xmm6\n\t"
+        /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+        "movdqa %%xmm3, %%xmm7\n\t"
+        "movdqa %%xmm3, %%xmm8\n\t"
+        "movdqa %%xmm3, %%xmm9\n\t"
+        "pslld $31, %%xmm7\n\t"
+        "pslld $30, %%xmm8\n\t"
+        "pslld $25, %%xmm9\n\t"
+        "pxor %%xmm8, %%xmm7\n\t"
+        "pxor %%xmm9, %%xmm7\n\t"
+        "movdqa %%xmm7, %%xmm8\n\t"
+        "pslldq $12, %%xmm7\n\t"
+        "psrldq $4, %%xmm8\n\t"
+        "pxor %%xmm7, %%xmm3\n\t"
+        "movdqa %%xmm3, %%xmm2\n\t"
+        "movdqa %%xmm3, %%xmm4\n\t"
+        "movdqa %%xmm3, %%xmm5\n\t"
+        "psrld $1, %%xmm2\n\t"
+        "psrld $2, %%xmm4\n\t"
+        "psrld $7, %%xmm5\n\t"
+        "pxor %%xmm4, %%xmm2\n\t"
+        "pxor %%xmm5, %%xmm2\n\t"
+        "pxor %%xmm8, %%xmm2\n\t"
+        "pxor %%xmm2, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm6\n\t"
+        "movdqa %%xmm6, %%xmm0\n\t"
+        "add $16, %[data]\n\t"
+        "dec %[blocks]\n\t"
+        "jnz 1b\n\t"
+        "pshufb %%xmm10, %%xmm0\n\t"
+        "movdqu %%xmm0, (%[x])"
+        : [data] "+r" (data), [blocks] "+r" (blocks)
+        : [x] "r" (x), [h] "r" (h), [mask] "r" (ghash_swap_mask)
+        : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7",
+          "xmm8", "xmm9", "xmm10", "memory", "cc");
+}
+
+#endif /* __GNUC__ && __x86_64__ */
+
+static void gcm_ghash( const struct key *key, UCHAR x[AES_BLOCK_SIZE], const UCHAR *data, ULONG len )
+{
+    ULONG i, n;
+
+#ifdef HAVE_GHASH_CLMUL
+    if (len >= AES_BLOCK_SIZE && clmul_supported())
+    {
+        ghash_clmul( x, key->gcm_h, data, len / AES_BLOCK_SIZE );
+        data += len & ~(AES_BLOCK_SIZE - 1);
+        len &= AES_BLOCK_SIZE - 1;
+    }
+#endif
+
+    /* a partial last block is padded with zeros */
+    while (len)
+    {
+        n = min( len, AES_BLOCK_SIZE );
+        for (i = 0; i < n; i++) x[i] ^= data[i];
+        gcm_mult( key, x );
+        data += n;
+        len -= n;
+    }
+}
+
+static void gcm_ctr( struct key *key, const UCHAR j0[AES_BLOCK_SIZE], const UCHAR *input, UCHAR *output, ULONG len )
+{
+    UCHAR counter[AES_BLOCK_SIZE], stream[AES_BLOCK_SIZE];
+    ULONG i, n;
+
+    memcpy( counter, j0, AES_BLOCK_SIZE );
+    while (len)
+    {
+        put_be32( counter + 12, get_be32( counter + 12 ) + 1 );
+        aes_ecb_encrypt( counter, stream, &key->aes );
+        n = min( len, AES_BLOCK_SIZE );
+        for (i = 0; i < n; i++) output[i] = input[i] ^ stream[i];
+        input += n;
+        output += n;
+        len -= n;
+    }
+}
+
+static void gcm_tag( struct key *key, const UCHAR j0[AES_BLOCK_SIZE], const UCHAR *auth_data, ULONG auth_len,
+                     const UCHAR *cipher, ULONG len, UCHAR tag[AES_BLOCK_SIZE] )
+{
+    UCHAR x[AES_BLOCK_SIZE], lengths[AES_BLOCK_SIZE], mask[AES_BLOCK_SIZE];
+    ULONG i;
+
+    memset( x, 0, sizeof(x) );
+    gcm_ghash( key, x, auth_data, auth_len );
+    gcm_ghash( key, x, cipher, len );
+    put_be64( lengths, (ULONG64)auth_len * 8 );
+    put_be64( lengths + 8, (ULONG64)len * 8 );
+    gcm_ghash( key, x, lengths, sizeof(lengths) );
+
+    aes_ecb_encrypt( j0, mask, &key->aes );
+    for (i = 0; i < AES_BLOCK_SIZE; i++) tag[i] = x[i] ^ mask[i];
+}
+
+static NTSTATUS gcm_check_params( const BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO *info, ULONG flags,
+                                  UCHAR j0[AES_BLOCK_SIZE] )
+{
+    if (!info || info->cbSize < sizeof(*info) ||
+        info->dwInfoVersion != BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO_VERSION)
+        return STATUS_INVALID_PARAMETER;
+    if (flags & BCRYPT_BLOCK_PADDING) return STATUS_INVALID_PARAMETER;
+    if (info->dwFlags & BCRYPT_AUTH_MODE_CHAIN_CALLS_FLAG)
+    {
+        FIXME( "call chaining not supported\n" );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    if (!info->pbTag || info->cbTag < 12 || info->cbTag > 16) return STATUS_INVALID_PARAMETER;
+    if (!info->pbNonce || info->cbNonce != 12)
+    {
+        FIXME( "nonce length %u not supported\n", info->cbNonce );
+        return STATUS_NOT_SUPPORTED;
+    }
+    if (info->cbAuthData && !info->pbAuthData) return STATUS_INVALID_PARAMETER;
+
+    memcpy( j0, info->pbNonce, 12 );
+    put_be32( j0 + 12, 1 );
+    return STATUS_SUCCESS;
+}
+
+static BOOL key_is_cbc( const struct key *key, const UCHAR *iv, ULONG iv_len )
+{
+    return key->mode == MODE_ID_CBC && (!iv || iv_len == AES_BLOCK_SIZE);
+}
+
+NTSTATUS WINAPI BCryptGenerateSymmetricKey( BCRYPT_ALG_HANDLE algorithm, BCRYPT_KEY_HANDLE *handle,
+                                            UCHAR *object, ULONG object_len, UCHAR *secret, ULONG secret_len,
+                                            ULONG flags )
+{
+    struct algorithm *alg = algorithm;
+    struct key *key;
+
+    TRACE( "%p, %p, %p, %u, %p, %u, %08x\n", algorithm, handle, object, object_len, secret, secret_len, flags );
+
+    if (!alg || alg->hdr.magic != MAGIC_ALG) return STATUS_INVALID_HANDLE;
+    if (alg->id != ALG_ID_AES) return STATUS_NOT_SUPPORTED;
+    if (!handle || !secret) return STATUS_INVALID_PARAMETER;
+    if (secret_len != 16 && secret_len != 24 && secret_len != 32) return STATUS_INVALID_PARAMETER;
+
+    if (object)
+    {
+        if (object_len < sizeof(*key) + OBJECT_ALIGN - 1) return STATUS_BUFFER_TOO_SMALL;
+        key = object_from_buffer( object );
+        key->allocated = FALSE;
+    }
+    else
+    {
+        if (!(key = HeapAlloc( GetProcessHeap(), 0, sizeof(*key) ))) return STATUS_NO_MEMORY;
+        key->allocated = TRUE;
+    }
+    key->hdr.magic = MAGIC_KEY;
+    key->mode      = alg->mode;
+    aes_setup( secret, secret_len, 0, &key->aes );
+    gcm_init( key );
+
+    *handle = key;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptDestroyKey( BCRYPT_KEY_HANDLE handle )
+{
+    struct key *key = handle;
+    BOOL allocated;
+
+    TRACE( "%p\n", handle );
+
+    if (!key || key->hdr.magic != MAGIC_KEY) return STATUS_INVALID_HANDLE;
+    allocated = key->allocated;
+    memset( key, 0, sizeof(*key) );
+    if (allocated) HeapFree( GetProcessHeap(), 0, key );
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptEncrypt( BCRYPT_KEY_HANDLE handle, UCHAR *input, ULONG input_len, void *padding, UCHAR *iv,
+                               ULONG iv_len, UCHAR *output, ULONG output_len, ULONG *ret_len, ULONG flags )
+{
+    struct key *key = handle;
+    UCHAR chain[AES_BLOCK_SIZE], block[AES_BLOCK_SIZE];
+    ULONG bytes, i, j;
+
+    TRACE( "%p, %p, %u, %p, %p, %u, %p, %u, %p, %08x\n", handle, input, input_len, padding, iv, iv_len,
+           output, output_len, ret_len, flags );
+
+    if (!key || key->hdr.magic != MAGIC_KEY) return STATUS_INVALID_HANDLE;
+    if (!ret_len || (!input && input_len)) return STATUS_INVALID_PARAMETER;
+    if (flags & ~BCRYPT_BLOCK_PADDING)
+    {
+        FIXME( "flags %08x not supported\n", flags );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    if (key->mode == MODE_ID_GCM)
+    {
+        BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO *info = padding;
+        NTSTATUS status;
+
+        if ((status = gcm_check_params( info, flags, block ))) return status;
+        *ret_len = input_len;
+        if (!output) return STATUS_SUCCESS;
+        if (output_len < input_len) return STATUS_BUFFER_TOO_SMALL;
+
+        gcm_ctr( key, block, input, output, input_len );
+        gcm_tag( key, block, info->pbAuthData, info->cbAuthData, output, input_len, chain );
+        memcpy( info->pbTag, chain, info->cbTag );
+        return STATUS_SUCCESS;
+    }
+
+    if (key->mode == MODE_ID_CBC && !key_is_cbc( key, iv, iv_len )) return STATUS_INVALID_PARAMETER;
+
+    bytes = input_len;
+    if (flags & BCRYPT_BLOCK_PADDING) bytes = (input_len / AES_BLOCK_SIZE + 1) * AES_BLOCK_SIZE;
+    else if (input_len % AES_BLOCK_SIZE) return STATUS_INVALID_BUFFER_SIZE;
+
+    *ret_len = bytes;
+    if (!output) return STATUS_SUCCESS;
+    if (output_len < bytes) return STATUS_BUFFER_TOO_SMALL;
+
+    if (iv && key->mode == MODE_ID_CBC) memcpy( chain, iv, AES_BLOCK_SIZE );
+    else memset( chain, 0, AES_BLOCK_SIZE );
+
+    for (i = 0; i < bytes; i += AES_BLOCK_SIZE)
+    {
+        if (i + AES_BLOCK_SIZE <= input_len) memcpy( block, input + i, AES_BLOCK_SIZE );
+        else
+        {
+            /* PKCS#7 padding */
+            ULONG rest = input_len - i;
+            memcpy( block, input + i, rest );
+            memset( block + rest, AES_BLOCK_SIZE - rest, AES_BLOCK_SIZE - rest );
+        }
+        if (key->mode == MODE_ID_CBC)
+            for (j = 0; j < AES_BLOCK_SIZE; j++) block[j] ^= chain[j];
+        aes_ecb_encrypt( block, output + i, &key->aes );
+        if (key->mode == MODE_ID_CBC) memcpy( chain, output + i, AES_BLOCK_SIZE );
+    }
+
+    if (iv && key->mode == MODE_ID_CBC) memcpy( iv, chain, AES_BLOCK_SIZE );
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptDecrypt( BCRYPT_KEY_HANDLE handle, UCHAR *input, ULONG input_len, void *padding, UCHAR *iv,
+                               ULONG iv_len, UCHAR *output, ULONG output_len, ULONG *ret_len, ULONG flags )
+{
+    struct key *key = handle;
+    UCHAR chain[AES_BLOCK_SIZE], block[AES_BLOCK_SIZE];
+    ULONG bytes, i;
+
+    TRACE( "%p, %p, %u, %p, %p, %u, %p, %u, %p, %08x\n", handle, input, input_len, padding, iv, iv_len,
+           output, output_len, ret_len, flags );
+
+    if (!key || key->hdr.magic != MAGIC_KEY) return STATUS_INVALID_HANDLE;
+    if (!ret_len || (!input && input_len)) return STATUS_INVALID_PARAMETER;
+    if (flags & ~BCRYPT_BLOCK_PADDING)
+    {
+        FIXME( "flags %08x not supported\n", flags );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    if (key->mode == MODE_ID_GCM)
+    {
+        BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO *info = padding;
+        UCHAR tag[AES_BLOCK_SIZE], diff = 0;
+        NTSTATUS status;
+
+        if ((status = gcm_check_params( info, flags, block ))) return status;
+        *ret_len = input_len;
+        if (!output) return STATUS_SUCCESS;
+        if (output_len < input_len) return STATUS_BUFFER_TOO_SMALL;
+
+        gcm_tag( key, block, info->pbAuthData, info->cbAuthData, input, input_len, tag );
+        for (i = 0; i < info->cbTag; i++) diff |= tag[i] ^ info->pbTag[i];
+        if (diff) return STATUS_AUTH_TAG_MISMATCH;
+
+        gcm_ctr( key, block, input, output, input_len );
+        return STATUS_SUCCESS;
+    }
+
+    if (key->mode == MODE_ID_CBC && !key_is_cbc( key, iv, iv_len )) return STATUS_INVALID_PARAMETER;
+    if (input_len % AES_BLOCK_SIZE) return STATUS_INVALID_BUFFER_SIZE;
+
+    *ret_len = input_len;
+    if (!output) return STATUS_SUCCESS;
+
+    /* with padding the last block goes through a temporary buffer */
+    bytes = input_len;
+    if (flags & BCRYPT_BLOCK_PADDING)
+    {
+        if (!input_len) return STATUS_INVALID_PARAMETER;
+        bytes -= AES_BLOCK_SIZE;
+    }
+    if (output_len < bytes) return STATUS_BUFFER_TOO_SMALL;
+
+    if (iv && key->mode == MODE_ID_CBC) memcpy( chain, iv, AES_BLOCK_SIZE );
+    else memset( chain, 0, AES_BLOCK_SIZE );
+
+    if (key->mode == MODE_ID_CBC)
+        aes_cbc_decrypt( input, output, bytes, chain, &key->aes );
+    else
+        for (i = 0; i < bytes; i += AES_BLOCK_SIZE) aes_ecb_decrypt( input + i, output + i, &key->aes );
+
+    if (flags & BCRYPT_BLOCK_PADDING)
+    {
+        UCHAR pad;
+
+        if (key->mode == MODE_ID_CBC)
+            aes_cbc_decrypt( input + bytes, block, AES_BLOCK_SIZE, chain, &key->aes );
+        else
+            aes_ecb_decrypt( input + bytes, block, &key->aes );
+
+        pad = block[AES_BLOCK_SIZE - 1];
+        if (!pad || pad > AES_BLOCK_SIZE) return STATUS_DATA_ERROR;
+        for (i = AES_BLOCK_SIZE - pad; i < AES_BLOCK_SIZE; i++)
+            if (block[i] != pad) return STATUS_DATA_ERROR;
+        if (output_len < bytes + AES_BLOCK_SIZE - pad) return STATUS_BUFFER_TOO_SMALL;
+        memcpy( output + bytes, block, AES_BLOCK_SIZE - pad );
+        *ret_len = bytes + AES_BLOCK_SIZE - pad;
+    }
+
+    if (iv && key->mode == MODE_ID_CBC) memcpy( iv, chain, AES_BLOCK_SIZE );
+    return STATUS_SUCCESS;
+}
@@ -27,6 +27,22 @@
 
 static NTSTATUS (WINAPI *pBCryptGenRandom)(BCRYPT_ALG_HANDLE hAlgorithm, PUCHAR pbBuffer,
                                            ULONG cbBuffer, ULONG dwFlags);
+static NTSTATUS (WINAPI *pBCryptOpenAlgorithmProvider)(BCRYPT_ALG_HANDLE *, LPCWSTR, LPCWSTR, ULONG);
+static NTSTATUS (WINAPI *pBCryptCloseAlgorithmProvider)(BCRYPT_ALG_HANDLE, ULONG);
+static NTSTATUS (WINAPI *pBCryptGetProperty)(BCRYPT_HANDLE, LPCWSTR, PUCHAR, ULONG, ULONG *, ULONG);
+static NTSTATUS (WINAPI *pBCryptSetProperty)(BCRYPT_HANDLE, LPCWSTR, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptCreateHash)(BCRYPT_ALG_HANDLE, BCRYPT_HASH_HANDLE *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptDuplicateHash)(BCRYPT_HASH_HANDLE, BCRYPT_HASH_HANDLE *, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptHashData)(BCRYPT_HASH_HANDLE, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptFinishHash)(BCRYPT_HASH_HANDLE, PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptDestroyHash)(BCRYPT_HASH_HANDLE);
+static NTSTATUS (WINAPI *pBCryptGenerateSymmetricKey)(BCRYPT_ALG_HANDLE, BCRYPT_KEY_HANDLE *, PUCHAR, ULONG,
+                                                      PUCHAR, ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptEncrypt)(BCRYPT_KEY_HANDLE, PUCHAR, ULONG, VOID *, PUCHAR, ULONG, PUCHAR, ULONG,
+                                         ULONG *, ULONG);
+static NTSTATUS (WINAPI *pBCryptDecrypt)(BCRYPT_KEY_HANDLE, PUCHAR, ULONG, VOID *, PUCHAR, ULONG, PUCHAR, ULONG,
+                                         ULONG *, ULONG);
+static NTSTATUS (WINAPI *pBCryptDestroyKey)(BCRYPT_KEY_HANDLE);
 
 static BOOL Init(void)
 {
@@ -37,7 +53,22 @@ static BOOL Init(void)
         return FALSE;
     }
 
-    pBCryptGenRandom = (void *)GetProcAddress(hbcrypt, "BCryptGenRandom");
+#define GET_PROC(func) p ## func = (void *)GetProcAddress(hbcrypt, #func)
+    GET_PROC(BCryptGenRandom);
+    GET_PROC(BCryptOpenAlgorithmProvider);
+    GET_PROC(BCryptCloseAlgorithmProvider);
+    GET_PROC(BCryptGetProperty);
+    GET_PROC(BCryptSetProperty);
+    GET_PROC(BCryptCreateHash);
+    GET_PROC(BCryptDuplicateHash);
+    GET_PROC(BCryptHashData);
+    GET_PROC(BCryptFinishHash);
+    GET_PROC(BCryptDestroyHash);
+    GET_PROC(BCryptGenerateSymmetricKey);
+    GET_PROC(BCryptEncrypt);
+    GET_PROC(BCryptDecrypt);
+    GET_PROC(BCryptDestroyKey);
+#undef GET_PROC
 
     return TRUE;
 }
@@ -78,10 +109,330 @@ static void test_BCryptGenRandom(void)
     ok(memcmp(buffer, buffer + 8, 8), "Expected a random number, got 0\n");
 }
 
+static void test_sha256(void)
+{
+    static const UCHAR expected[32] =
+    {
+        0x9f, 0x86, 0xd0, 0x81, 0x88, 0x4c, 0x7d, 0x65, 0x9a, 0x2f, 0xea, 0xa0,
+        0xc5, 0x5a, 0xd0, 0x15, 0xa3, 0xbf, 0x4f, 0x1b, 0x2b, 0x0b, 0x82, 0x2c,
+        0xd1, 0x5d, 0x6c, 0x15, 0xb0, 0xf0, 0x0a, 0x08
+    };
+    static const UCHAR expected_hmac[32] =
+    {
+        0x02, 0xaf, 0xb5, 0x63, 0x04, 0x90, 0x2c, 0x65, 0x6f, 0xcb, 0x73, 0x7c,
+        0xdd, 0x03, 0xde, 0x62, 0x05, 0xbb, 0x6d, 0x40, 0x1d, 0xa2, 0x81, 0x2e,
+        0xfd, 0x9b, 0x2d, 0x36, 0xa0, 0x8a, 0xf1, 0x59
+    };
+    static const WCHAR sha256W[] = {'S','H','A','2','5','6',0};
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_HASH_HANDLE hash, hash2;
+    UCHAR buf[1024], buf2[1024], hash_value[32];
+    ULONG size, len;
+    NTSTATUS ret;
+
+    if (!pBCryptOpenAlgorithmProvider)
+    {
+        win_skip("BCryptOpenAlgorithmProvider is not available\n");
+        return;
+    }
+
+    alg = NULL;
+    ret = pBCryptOpenAlgorithmProvider(&alg, BCRYPT_SHA256_ALGORITHM, MS_PRIMITIVE_PROVIDER, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(alg != NULL, "alg not set\n");
+
+    len = size = 0xdeadbeef;
+    ret = pBCryptGetProperty(alg, BCRYPT_OBJECT_LENGTH, (UCHAR *)&len, sizeof(len), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(len), "got %u\n", size);
+    ok(len && len <= sizeof(buf), "got %u\n", len);
+
+    len = size = 0xdeadbeef;
+    ret = pBCryptGetProperty(alg, BCRYPT_HASH_LENGTH, (UCHAR *)&len, sizeof(len), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(len == 32, "got %u\n", len);
+
+    size = 0;
+    ret = pBCryptGetProperty(alg, BCRYPT_ALGORITHM_NAME, NULL, 0, &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(sha256W), "got %u\n", size);
+    ret = pBCryptGetProperty(alg, BCRYPT_ALGORITHM_NAME, buf, sizeof(buf), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(!memcmp(buf, sha256W, sizeof(sha256W)), "wrong name\n");
+
+    /* hash object in a caller supplied buffer */
+    hash = NULL;
+    ret = pBCryptCreateHash(alg, &hash, buf, sizeof(buf), NULL, 0, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(hash != NULL, "hash not set\n");
+
+    ret = pBCryptHashData(hash, (UCHAR *)"te", 2, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    hash2 = NULL;
+    ret = pBCryptDuplicateHash(hash, &hash2, buf2, sizeof(buf2), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptHashData(hash, (UCHAR *)"st", 2, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptFinishHash(hash, hash_value, 16, 0);
+    ok(ret == STATUS_INVALID_PARAMETER, "got %08x\n", ret);
+
+    memset(hash_value, 0, sizeof(hash_value));
+    ret = pBCryptFinishHash(hash, hash_value, sizeof(hash_value), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(!memcmp(hash_value, expected, sizeof(expected)), "wrong hash\n");
+
+    ret = pBCryptHashData(hash2, (UCHAR *)"st", 2, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    memset(hash_value, 0, sizeof(hash_value));
+    ret = pBCryptFinishHash(hash2, hash_value, sizeof(hash_value), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(!memcmp(hash_value, expected, sizeof(expected)), "wrong hash\n");
+
+    ret = pBCryptDestroyHash(hash2);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ret = pBCryptDestroyHash(hash);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    /* hash object allocated by bcrypt and used for several messages */
+    hash = NULL;
+    ret = pBCryptCreateHash(alg, &hash, NULL, 0, NULL, 0, BCRYPT_HASH_REUSABLE_FLAG);
+    if (ret == STATUS_INVALID_PARAMETER)
+        win_skip("BCRYPT_HASH_REUSABLE_FLAG not supported\n");
+    else
+    {
+        int i;
+
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        for (i = 0; i < 2; i++)
+        {
+            ret = pBCryptHashData(hash, (UCHAR *)"test", 4, 0);
+            ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+            memset(hash_value, 0, sizeof(hash_value));
+            ret = pBCryptFinishHash(hash, hash_value, sizeof(hash_value), 0);
+            ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+            ok(!memcmp(hash_value, expected, sizeof(expected)), "wrong hash %d\n", i);
+        }
+        ret = pBCryptDestroyHash(hash);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    }
+
+    ret = pBCryptCloseAlgorithmProvider(alg, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    /* HMAC */
+    alg = NULL;
+    ret = pBCryptOpenAlgorithmProvider(&alg, BCRYPT_SHA256_ALGORITHM, NULL, BCRYPT_ALG_HANDLE_HMAC_FLAG);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    hash = NULL;
+    ret = pBCryptCreateHash(alg, &hash, buf, sizeof(buf), (UCHAR *)"key", 3, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ret = pBCryptHashData(hash, (UCHAR *)"test", 4, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    memset(hash_value, 0, sizeof(hash_value));
+    ret = pBCryptFinishHash(hash, hash_value, sizeof(hash_value), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(!memcmp(hash_value, expected_hmac, sizeof(expected_hmac)), "wrong hmac\n");
+    ret = pBCryptDestroyHash(hash);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptCloseAlgorithmProvider(alg, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+}
+
+static const char aes_plaintext[] = "Hello, World! 0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+
+static void test_aes_cbc(void)
+{
+    static const UCHAR expected[80] =
+    {
+        0x23, 0xf7, 0x54, 0x22, 0xeb, 0x6f, 0xc2, 0x26, 0x09, 0x6b, 0xe1, 0x9d,
+        0x16, 0x81, 0x5c, 0x87, 0xb0, 0x22, 0xe5, 0x0d, 0xa4, 0x49, 0x7c, 0x10,
+        0x72, 0xa9, 0xdc, 0x84, 0xf0, 0xd1, 0x56, 0x88, 0x8e, 0x4b, 0xb2, 0x21,
+        0x65, 0x62, 0xc8, 0x44, 0x4b, 0x36, 0x89, 0x3a, 0x20, 0x3b, 0x55, 0x07,
+        0xba, 0xa6, 0x90, 0x9f, 0xf1, 0x21, 0x32, 0x05, 0xd4, 0x4a, 0x40, 0x1c,
+        0x05, 0x11, 0xa2, 0x3b, 0xb5, 0x35, 0xc4, 0x79, 0xf1, 0xcd, 0x5c, 0xd9,
+        0x0d, 0x44, 0xa5, 0xdc, 0x09, 0x85, 0xcd, 0x9a
+    };
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_KEY_HANDLE key;
+    UCHAR secret[16], iv[16], buf[1024], ciphertext[96], plaintext[96];
+    ULONG size, len, i;
+    NTSTATUS ret;
+
+    if (!pBCryptOpenAlgorithmProvider)
+    {
+        win_skip("BCryptOpenAlgorithmProvider is not available\n");
+        return;
+    }
+
+    alg = NULL;
+    ret = pBCryptOpenAlgorithmProvider(&alg, BCRYPT_AES_ALGORITHM, NULL, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    len = size = 0xdeadbeef;
+    ret = pBCryptGetProperty(alg, BCRYPT_BLOCK_LENGTH, (UCHAR *)&len, sizeof(len), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(len == 16, "got %u\n", len);
+
+    size = 0;
+    ret = pBCryptGetProperty(alg, BCRYPT_CHAINING_MODE, buf, sizeof(buf), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(!lstrcmpW((WCHAR *)buf, BCRYPT_CHAIN_MODE_CBC), "got %s\n", wine_dbgstr_w((WCHAR *)buf));
+
+    for (i = 0; i < sizeof(secret); i++) secret[i] = iv[i] = i;
+    key = NULL;
+    ret = pBCryptGenerateSymmetricKey(alg, &key, buf, sizeof(buf), secret, sizeof(secret), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(key != NULL, "key not set\n");
+
+    /* data that isn't a multiple of the block size needs padding */
+    size = 0;
+    ret = pBCryptEncrypt(key, (UCHAR *)aes_plaintext, sizeof(aes_plaintext) - 1, NULL, iv, sizeof(iv),
+                         NULL, 0, &size, 0);
+    ok(ret == STATUS_INVALID_BUFFER_SIZE, "got %08x\n", ret);
+
+    size = 0;
+    ret = pBCryptEncrypt(key, (UCHAR *)aes_plaintext, sizeof(aes_plaintext) - 1, NULL, iv, sizeof(iv),
+                         NULL, 0, &size, BCRYPT_BLOCK_PADDING);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(expected), "got %u\n", size);
+
+    size = 0;
+    memset(ciphertext, 0, sizeof(ciphertext));
+    ret = pBCryptEncrypt(key, (UCHAR *)aes_plaintext, sizeof(aes_plaintext) - 1, NULL, iv, sizeof(iv),
+                         ciphertext, sizeof(ciphertext), &size, BCRYPT_BLOCK_PADDING);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(expected), "got %u\n", size);
+    ok(!memcmp(ciphertext, expected, sizeof(expected)), "wrong data\n");
+
+    for (i = 0; i < sizeof(iv); i++) iv[i] = i;
+    size = 0;
+    memset(plaintext, 0, sizeof(plaintext));
+    ret = pBCryptDecrypt(key, ciphertext, sizeof(expected), NULL, iv, sizeof(iv),
+                         plaintext, sizeof(plaintext), &size, BCRYPT_BLOCK_PADDING);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(aes_plaintext) - 1, "got %u\n", size);
+    ok(!memcmp(plaintext, aes_plaintext, sizeof(aes_plaintext) - 1), "wrong data\n");
+
+    /* without padding the whole blocks are returned */
+    for (i = 0; i < sizeof(iv); i++) iv[i] = i;
+    size = 0;
+    ret = pBCryptDecrypt(key, ciphertext, sizeof(expected), NULL, iv, sizeof(iv),
+                         plaintext, sizeof(plaintext), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(expected), "got %u\n", size);
+    ok(!memcmp(plaintext, aes_plaintext, sizeof(aes_plaintext) - 1), "wrong data\n");
+    ok(plaintext[sizeof(expected) - 1] == 2, "got %u\n", plaintext[sizeof(expected) - 1]);
+
+    ret = pBCryptDestroyKey(key);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ret = pBCryptCloseAlgorithmProvider(alg, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+}
+
+static void test_aes_gcm(void)
+{
+    static const UCHAR expected[78] =
+    {
+        0xdb, 0x09, 0xcb, 0xa2, 0x09, 0x37, 0xd7, 0x03, 0x24, 0xa0, 0x0d, 0xee,
+        0x17, 0x83, 0x40, 0x39, 0x81, 0x15, 0x2e, 0xd3, 0x65, 0xda, 0xc5, 0xcf,
+        0x87, 0x43, 0x92, 0x49, 0x71, 0x22, 0x92, 0x5d, 0xb7, 0x97, 0xef, 0xc2,
+        0xc2, 0xb7, 0x8f, 0xda, 0x21, 0x96, 0x6a, 0x83, 0xa5, 0xef, 0xe7, 0xa3,
+        0xfe, 0xac, 0x20, 0xc5, 0x32, 0xb0, 0x0e, 0x42, 0x4f, 0x2c, 0x11, 0xb6,
+        0xcf, 0x2a, 0x26, 0xd5, 0xa8, 0x3d, 0xc1, 0x7b, 0x69, 0x7b, 0xf2, 0x27,
+        0x42, 0x52, 0x12, 0x3b, 0x19, 0x5c
+    };
+    static const UCHAR expected_tag[16] =
+    {
+        0x2b, 0xa3, 0x36, 0xf0, 0xb6, 0x69, 0x95, 0xac, 0x8c, 0x25, 0x28, 0x54,
+        0xb3, 0x00, 0xfa, 0xe4
+    };
+    BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+    BCRYPT_AUTH_TAG_LENGTHS_STRUCT tag_lengths;
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_KEY_HANDLE key;
+    UCHAR secret[16], nonce[12], tag[16], ciphertext[80], plaintext[80];
+    ULONG size, i;
+    NTSTATUS ret;
+
+    if (!pBCryptOpenAlgorithmProvider)
+    {
+        win_skip("BCryptOpenAlgorithmProvider is not available\n");
+        return;
+    }
+
+    alg = NULL;
+    ret = pBCryptOpenAlgorithmProvider(&alg, BCRYPT_AES_ALGORITHM, NULL, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptSetProperty(alg, BCRYPT_CHAINING_MODE, (UCHAR *)BCRYPT_CHAIN_MODE_GCM, 0, 0);
+    if (ret != STATUS_SUCCESS)
+    {
+        win_skip("AES-GCM is not supported\n");
+        pBCryptCloseAlgorithmProvider(alg, 0);
+        return;
+    }
+
+    size = 0;
+    memset(&tag_lengths, 0, sizeof(tag_lengths));
+    ret = pBCryptGetProperty(alg, BCRYPT_AUTH_TAG_LENGTH, (UCHAR *)&tag_lengths, sizeof(tag_lengths), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(tag_lengths), "got %u\n", size);
+    ok(tag_lengths.dwMaxLength == 16, "got %u\n", tag_lengths.dwMaxLength);
+
+    for (i = 0; i < sizeof(secret); i++) secret[i] = i;
+    for (i = 0; i < sizeof(nonce); i++) nonce[i] = i;
+    key = NULL;
+    ret = pBCryptGenerateSymmetricKey(alg, &key, NULL, 0, secret, sizeof(secret), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    BCRYPT_INIT_AUTH_MODE_INFO(info);
+    info.pbNonce    = nonce;
+    info.cbNonce    = sizeof(nonce);
+    info.pbAuthData = (UCHAR *)"auth";
+    info.cbAuthData = 4;
+    info.pbTag      = tag;
+    info.cbTag      = sizeof(tag);
+
+    size = 0;
+    memset(tag, 0, sizeof(tag));
+    ret = pBCryptEncrypt(key, (UCHAR *)aes_plaintext, sizeof(aes_plaintext) - 1, &info, NULL, 0,
+                         ciphertext, sizeof(ciphertext), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(expected), "got %u\n", size);
+    ok(!memcmp(ciphertext, expected, sizeof(expected)), "wrong data\n");
+    ok(!memcmp(tag, expected_tag, sizeof(expected_tag)), "wrong tag\n");
+
+    size = 0;
+    memset(plaintext, 0, sizeof(plaintext));
+    ret = pBCryptDecrypt(key, ciphertext, sizeof(expected), &info, NULL, 0,
+                         plaintext, sizeof(plaintext), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(expected), "got %u\n", size);
+    ok(!memcmp(plaintext, aes_plaintext, sizeof(aes_plaintext) - 1), "wrong data\n");
+
+    tag[0] ^= 1;
+    ret = pBCryptDecrypt(key, ciphertext, sizeof(expected), &info, NULL, 0,
+                         plaintext, sizeof(plaintext), &size, 0);
+    ok(ret == STATUS_AUTH_TAG_MISMATCH, "got %08x\n", ret);
+
+    ret = pBCryptDestroyKey(key);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ret = pBCryptCloseAlgorithmProvider(alg, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+}
+
 START_TEST(bcrypt)
 {
     if (!Init())
         return;
 
     test_BCryptGenRandom();
+    test_sha256();
+    test_aes_cbc();
+    test_aes_gcm();
 }
@@ -127,6 +127,7 @@ typedef UINT32        cab_off_t;
 #define ZIPDBITS	6	/* bits in base distance lookup table */
 #define ZIPBMAX		16      /* maximum bit length of any code */
 #define ZIPN_MAX	288     /* maximum number of codes in any set */
+#define ZIPHUFT_MAX	2048    /* table entries kept in the decoder state */
 
 struct Ziphuft {
   cab_UBYTE e;                /* number of extra bits or operation */
@@ -137,9 +138,13 @@ struct Ziphuft {
   } v;
 };
 
+/* the MSZIP bit buffer is refilled a whole register at a time */
+typedef ULONG_PTR cab_bitbuf;
+#define CAB_BITBUF_BITS (sizeof(cab_bitbuf) * CHAR_BIT)
+
 struct ZIPstate {
     cab_ULONG window_posn;      /* current offset within the window        */
-    cab_ULONG bb;               /* bit buffer */
+    cab_bitbuf bb;              /* bit buffer */
     cab_ULONG bk;               /* bits in bit buffer */
     cab_ULONG ll[288+32];       /* literal/length and distance code lengths */
     cab_ULONG c[ZIPBMAX+1];     /* bit length count table */
@@ -148,6 +153,13 @@ struct ZIPstate {
     cab_ULONG v[ZIPN_MAX];      /* values in order of bit length */
     cab_ULONG x[ZIPBMAX+1];     /* bit offsets, then code stack */
     cab_UBYTE *inpos;
+    struct Ziphuft *fixed_tl;   /* cached fixed literal/length table */
+    struct Ziphuft *fixed_td;   /* cached fixed distance table */
+    cab_LONG fixed_bl, fixed_bd; /* lookup bits for the fixed tables */
+    cab_ULONG hufts;            /* table entries in use */
+    cab_ULONG huft_base;        /* entries reserved for the fixed tables */
+    struct Ziphuft *overflow;   /* tables that did not fit, freed per block */
+    struct Ziphuft huft[ZIPHUFT_MAX]; /* decoding table storage */
 };
   
 /* Quantum stuff */
@@ -46,6 +46,7 @@ There is still some work to be done:
 #include "winbase.h"
 #include "winerror.h"
 #include "winternl.h"
+#include "winreg.h"
 #include "fci.h"
 #include "cabinet.h"
 #include "wine/list.h"
@@ -142,6 +143,47 @@ struct data_block
     cab_UWORD   uncompressed;
 };
 
+/* Blocks can be compressed by a pool of worker threads. They are still written */
+/* out in order on the calling thread, so the cabinet layout doesn't change. */
+
+#define MAX_COMPRESS_THREADS 32
+
+struct FCI_Int;
+
+enum compress_state
+{
+    COMPRESS_FREE,
+    COMPRESS_QUEUED,
+    COMPRESS_BUSY,
+    COMPRESS_DONE
+};
+
+struct compress_slot
+{
+    enum compress_state state;
+    cab_UWORD           uncompressed;
+    cab_UWORD           compressed;   /* 0 if compression failed */
+    cab_UWORD         (*compress)(struct FCI_Int *, unsigned char *, const unsigned char *, cab_UWORD);
+    unsigned char       data_in[CAB_BLOCKMAX];
+    unsigned char       data_out[2 * CAB_BLOCKMAX];
+};
+
+struct compress_pool
+{
+    CRITICAL_SECTION     cs;
+    CONDITION_VARIABLE   work_cv;      /* a slot was queued or the pool is shutting down */
+    CONDITION_VARIABLE   done_cv;      /* a slot has been compressed */
+    HANDLE               threads[MAX_COMPRESS_THREADS];
+    unsigned int         thread_count;
+    BOOL                 shutdown;
+    unsigned int         first;        /* oldest slot not yet written out */
+    unsigned int         next;         /* next slot to compress */
+    unsigned int         queued;       /* slots not yet written out */
+    cab_ULONG            queued_size;  /* upper bound of the data size of these slots */
+    unsigned int         slot_count;
+    struct compress_slot slots[1];
+};
+
 typedef struct FCI_Int
 {
   unsigned int       magic;
@@ -188,7 +230,9 @@ typedef struct FCI_Int
   cab_ULONG          pending_data_size;   /* size of data not yet assigned to a folder */
   cab_ULONG          folders_data_size;   /* total size of data contained in the current folders */
   TCOMP              compression;
-  cab_UWORD        (*compress)(struct FCI_Int *);
+  cab_UWORD        (*compress)(struct FCI_Int *, unsigned char *, const unsigned char *, cab_UWORD);
+  unsigned int       compress_threads;    /* worker threads to use, 0 to compress synchronously */
+  struct compress_pool *pool;
 } FCI_Int;
 
 #define FCI_INT_MAGIC 0xfcfcfc05
@@ -309,14 +353,13 @@ static void free_file( FCI_Int *fci, struct file *file )
     fci->free( file );
 }
 
-/* create a new data block for the data in fci->data_in */
-static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+/* write a compressed data block to the temp file */
+static BOOL write_data_block( FCI_Int *fci, const unsigned char *data, cab_UWORD compressed,
+                              cab_UWORD uncompressed, PFNFCISTATUS status_callback )
 {
     int err;
     struct data_block *block;
 
-    if (!fci->cdata_in) return TRUE;
-
     if (fci->data.handle == -1 && !create_temp_file( fci, &fci->data )) return FALSE;
 
     if (!(block = fci->alloc( sizeof(*block) )))
@@ -324,10 +367,10 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
         set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
         return FALSE;
     }
-    block->uncompressed = fci->cdata_in;
-    block->compressed   = fci->compress( fci );
+    block->uncompressed = uncompressed;
+    block->compressed   = compressed;
 
-    if (fci->write( fci->data.handle, fci->data_out,
+    if (fci->write( fci->data.handle, (void *)data,
                     block->compressed, &err, fci->pv ) != block->compressed)
     {
         set_error( fci, FCIERR_TEMP_FILE, err );
@@ -335,10 +378,8 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
         return FALSE;
     }
 
-    fci->cdata_in = 0;
     fci->pending_data_size += sizeof(CFDATA) + fci->ccab.cbReserveCFData + block->compressed;
     fci->cCompressedBytesInFolder += block->compressed;
-    fci->cDataBlocks++;
     list_add_tail( &fci->blocks_list, &block->entry );
 
     if (status_callback( statusFile, block->compressed, block->uncompressed, fci->pv ) == -1)
@@ -349,6 +390,182 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
     return TRUE;
 }
 
+/* worst case size of a data block, including the CFDATA header */
+static cab_ULONG max_data_block_size( FCI_Int *fci, cab_UWORD uncompressed )
+{
+    /* same as zlib's compressBound(), plus the MSZIP signature */
+    return sizeof(CFDATA) + fci->ccab.cbReserveCFData + uncompressed +
+           (uncompressed >> 12) + (uncompressed >> 14) + 13 + 2;
+}
+
+static DWORD CALLBACK compress_thread( void *arg )
+{
+    struct compress_pool *pool = arg;
+    struct compress_slot *slot;
+
+    EnterCriticalSection( &pool->cs );
+    while (!pool->shutdown)
+    {
+        slot = &pool->slots[pool->next];
+        if (slot->state != COMPRESS_QUEUED)
+        {
+            SleepConditionVariableCS( &pool->work_cv, &pool->cs, INFINITE );
+            continue;
+        }
+        slot->state = COMPRESS_BUSY;
+        pool->next = (pool->next + 1) % pool->slot_count;
+        LeaveCriticalSection( &pool->cs );
+
+        slot->compressed = slot->compress( NULL, slot->data_out, slot->data_in, slot->uncompressed );
+
+        EnterCriticalSection( &pool->cs );
+        slot->state = COMPRESS_DONE;
+        WakeAllConditionVariable( &pool->done_cv );
+    }
+    LeaveCriticalSection( &pool->cs );
+    return 0;
+}
+
+static BOOL start_compress_pool( FCI_Int *fci )
+{
+    struct compress_pool *pool;
+    unsigned int i, count = 2 * fci->compress_threads;
+
+    if (!(pool = fci->alloc( FIELD_OFFSET( struct compress_pool, slots[count] ))))
+    {
+        set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
+        return FALSE;
+    }
+    InitializeCriticalSection( &pool->cs );
+    InitializeConditionVariable( &pool->work_cv );
+    InitializeConditionVariable( &pool->done_cv );
+    pool->thread_count = 0;
+    pool->shutdown     = FALSE;
+    pool->first        = 0;
+    pool->next         = 0;
+    pool->queued       = 0;
+    pool->queued_size  = 0;
+    pool->slot_count   = count;
+    for (i = 0; i < count; i++) pool->slots[i].state = COMPRESS_FREE;
+
+    for (i = 0; i < fci->compress_threads; i++)
+    {
+        if (!(pool->threads[i] = CreateThread( NULL, 0, compress_thread, pool, 0, NULL ))) break;
+        pool->thread_count++;
+    }
+    if (!pool->thread_count)
+    {
+        WARN( "failed to create compression threads, compressing synchronously\n" );
+        DeleteCriticalSection( &pool->cs );
+        fci->free( pool );
+        fci->compress_threads = 0;
+        return TRUE;
+    }
+    TRACE( "using %u compression threads\n", pool->thread_count );
+    fci->pool = pool;
+    return TRUE;
+}
+
+static void stop_compress_pool( FCI_Int *fci )
+{
+    struct compress_pool *pool = fci->pool;
+    unsigned int i;
+
+    if (!pool) return;
+
+    EnterCriticalSection( &pool->cs );
+    pool->shutdown = TRUE;
+    WakeAllConditionVariable( &pool->work_cv );
+    LeaveCriticalSection( &pool->cs );
+
+    WaitForMultipleObjects( pool->thread_count, pool->threads, TRUE, INFINITE );
+    for (i = 0; i < pool->thread_count; i++) CloseHandle( pool->threads[i] );
+    DeleteCriticalSection( &pool->cs );
+    fci->free( pool );
+    fci->pool = NULL;
+}
+
+/* wait for the oldest queued block and write it out */
+static BOOL write_compressed_slot( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    struct compress_pool *pool = fci->pool;
+    struct compress_slot *slot = &pool->slots[pool->first];
+
+    EnterCriticalSection( &pool->cs );
+    while (slot->state != COMPRESS_DONE)
+        SleepConditionVariableCS( &pool->done_cv, &pool->cs, INFINITE );
+    slot->state = COMPRESS_FREE;
+    LeaveCriticalSection( &pool->cs );
+
+    pool->first = (pool->first + 1) % pool->slot_count;
+    pool->queued--;
+    pool->queued_size -= max_data_block_size( fci, slot->uncompressed );
+
+    if (!slot->compressed)
+    {
+        set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
+        return FALSE;
+    }
+    return write_data_block( fci, slot->data_out, slot->compressed, slot->uncompressed, status_callback );
+}
+
+/* write out all the blocks still owned by the compression threads */
+static BOOL flush_compress_pool( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    if (!fci->pool) return TRUE;
+    while (fci->pool->queued)
+        if (!write_compressed_slot( fci, status_callback )) return FALSE;
+    return TRUE;
+}
+
+/* hand the data in fci->data_in over to the compression threads */
+static BOOL queue_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    struct compress_pool *pool = fci->pool;
+    struct compress_slot *slot;
+
+    if (pool->queued == pool->slot_count && !write_compressed_slot( fci, status_callback ))
+        return FALSE;
+
+    slot = &pool->slots[(pool->first + pool->queued) % pool->slot_count];
+    memcpy( slot->data_in, fci->data_in, fci->cdata_in );
+    slot->uncompressed = fci->cdata_in;
+    slot->compress     = fci->compress;
+    pool->queued++;
+    pool->queued_size += max_data_block_size( fci, slot->uncompressed );
+
+    EnterCriticalSection( &pool->cs );
+    slot->state = COMPRESS_QUEUED;
+    WakeConditionVariable( &pool->work_cv );
+    LeaveCriticalSection( &pool->cs );
+    return TRUE;
+}
+
+/* create a new data block for the data in fci->data_in */
+static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    cab_UWORD compressed;
+
+    if (!fci->cdata_in) return TRUE;
+
+    if (fci->compress_threads && !fci->pool && !start_compress_pool( fci )) return FALSE;
+
+    if (fci->pool)
+    {
+        if (!queue_data_block( fci, status_callback )) return FALSE;
+    }
+    else
+    {
+        if (!(compressed = fci->compress( fci, fci->data_out, fci->data_in, fci->cdata_in )))
+            return FALSE;
+        if (!write_data_block( fci, fci->data_out, compressed, fci->cdata_in, status_callback ))
+            return FALSE;
+    }
+    fci->cdata_in = 0;
+    fci->cDataBlocks++;
+    return TRUE;
+}
+
 /* add compressed blocks for all the data that can be read from the file */
 static BOOL add_file_data( FCI_Int *fci, char *sourcefile, char *filename, BOOL execute,
                            PFNFCIGETOPENINFO get_open_info, PFNFCISTATUS status_callback )
@@ -903,10 +1120,13 @@ static BOOL add_files_to_folder( FCI_Int *fci, struct folder *folder, cab_ULONG
     return TRUE;
 }
 
-static cab_UWORD compress_NONE( FCI_Int *fci )
+/* The compression functions are also called from the worker threads, */
+/* in which case fci is NULL. They return 0 on failure. */
+
+static cab_UWORD compress_NONE( FCI_Int *fci, unsigned char *out, const unsigned char *in, cab_UWORD size )
 {
-    memcpy( fci->data_out, fci->data_in, fci->cdata_in );
-    return fci->cdata_in;
+    memcpy( out, in, size );
+    return size;
 }
 
 #ifdef HAVE_ZLIB
@@ -914,16 +1134,21 @@ static cab_UWORD compress_NONE( FCI_Int *fci )
 static void *zalloc( void *opaque, unsigned int items, unsigned int size )
 {
     FCI_Int *fci = opaque;
+
+    /* the application allocator isn't necessarily thread safe */
+    if (!fci) return HeapAlloc( GetProcessHeap(), 0, items * size );
     return fci->alloc( items * size );
 }
 
 static void zfree( void *opaque, void *ptr )
 {
     FCI_Int *fci = opaque;
-    fci->free( ptr );
+
+    if (!fci) HeapFree( GetProcessHeap(), 0, ptr );
+    else fci->free( ptr );
 }
 
-static cab_UWORD compress_MSZIP( FCI_Int *fci )
+static cab_UWORD compress_MSZIP( FCI_Int *fci, unsigned char *out, const unsigned char *in, cab_UWORD size )
 {
     z_stream stream;
 
@@ -932,16 +1157,16 @@ static cab_UWORD compress_MSZIP( FCI_Int *fci )
     stream.opaque = fci;
     if (deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY ) != Z_OK)
     {
-        set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
+        if (fci) set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
         return 0;
     }
-    stream.next_in   = fci->data_in;
-    stream.avail_in  = fci->cdata_in;
-    stream.next_out  = fci->data_out + 2;
-    stream.avail_out = sizeof(fci->data_out) - 2;
+    stream.next_in   = (unsigned char *)in;
+    stream.avail_in  = size;
+    stream.next_out  = out + 2;
+    stream.avail_out = 2 * CAB_BLOCKMAX - 2;
     /* insert the signature */
-    fci->data_out[0] = 'C';
-    fci->data_out[1] = 'K';
+    out[0] = 'C';
+    out[1] = 'K';
     deflate( &stream, Z_FINISH );
     deflateEnd( &stream );
     return stream.total_out + 2;
@@ -950,6 +1175,29 @@ static cab_UWORD compress_MSZIP( FCI_Int *fci )
 #endif  /* HAVE_ZLIB */
 
 
+static unsigned int get_compress_threads(void)
+{
+    SYSTEM_INFO si;
+    DWORD value, type, size = sizeof(value);
+    unsigned int count = 0;
+    HKEY hkey;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Cabinet */
+    if (!RegOpenKeyA( HKEY_CURRENT_USER, "Software\\Wine\\Cabinet", &hkey ))
+    {
+        if (!RegQueryValueExA( hkey, "CompressionThreads", 0, &type, (LPBYTE)&value, &size ) &&
+            type == REG_DWORD)
+            count = value;
+        RegCloseKey( hkey );
+    }
+    if (count < 2) return 0;
+
+    GetSystemInfo( &si );
+    count = min( count, si.dwNumberOfProcessors );
+    count = min( count, MAX_COMPRESS_THREADS );
+    return count < 2 ? 0 : count;
+}
+
 /***********************************************************************
  *		FCICreate (CABINET.10)
  *
@@ -1071,6 +1319,8 @@ HFCI __cdecl FCICreate(
   p_fci_internal->folders_data_size = 0;
   p_fci_internal->compression = tcompTYPE_NONE;
   p_fci_internal->compress = compress_NONE;
+  p_fci_internal->compress_threads = get_compress_threads();
+  p_fci_internal->pool = NULL;
 
   list_init( &p_fci_internal->folders_list );
   list_init( &p_fci_internal->files_list );
@@ -1099,6 +1349,8 @@ static BOOL fci_flush_folder( FCI_Int *p_fci_internal,
     return FALSE;
   }
 
+  if (!flush_compress_pool( p_fci_internal, pfnfcis )) return FALSE;
+
   if( p_fci_internal->fGetNextCabInVain &&
       p_fci_internal->fNextCab ){
     /* internal error */
@@ -1128,6 +1380,7 @@ static BOOL fci_flush_folder( FCI_Int *p_fci_internal,
 
   /* START of COPY */
   if (!add_data_block( p_fci_internal, pfnfcis )) return FALSE;
+  if (!flush_compress_pool( p_fci_internal, pfnfcis )) return FALSE;
 
   /* reset to get the number of data blocks of this folder which are */
   /* actually in this cabinet ( at least partially ) */
@@ -1357,6 +1610,7 @@ static BOOL fci_flush_cabinet( FCI_Int *p_fci_internal,
     }
 
     /* if the FolderThreshold has been reached flush the folder automatically */
+    if (!flush_compress_pool( p_fci_internal, pfnfcis )) return FALSE;
     if (p_fci_internal->cCompressedBytesInFolder >= p_fci_internal->ccab.cbFolderThresh)
         return fci_flush_folder(p_fci_internal, FALSE, pfnfcignc, pfnfcis);
 
@@ -1533,6 +1787,21 @@ BOOL __cdecl FCIAddFile(
   if (!add_file_data( p_fci_internal, pszSourceFile, pszFileName, fExecute, pfnfcigoi, pfnfcis ))
       return FALSE;
 
+  /* The blocks still being compressed only have to be written out if */
+  /* they might not fit into this cabinet or might reach the folder */
+  /* threshold, the checks below can't trigger otherwise. */
+  if (p_fci_internal->pool) {
+    read_result = get_header_size( p_fci_internal ) + p_fci_internal->ccab.cbReserveCFFolder;
+    read_result+= p_fci_internal->pending_data_size + p_fci_internal->pool->queued_size +
+      p_fci_internal->files_size + p_fci_internal->folders_data_size +
+      p_fci_internal->placed_files_size + p_fci_internal->folders_size +
+      sizeof(CFFOLDER) + CB_MAX_CABINET_NAME + CB_MAX_DISK_NAME;
+    if ((p_fci_internal->ccab.cb < read_result ||
+         p_fci_internal->ccab.cbFolderThresh <=
+         p_fci_internal->cCompressedBytesInFolder + p_fci_internal->pool->queued_size) &&
+        !flush_compress_pool( p_fci_internal, pfnfcis )) return FALSE;
+  }
+
   /* REUSE the variable read_result */
   read_result = get_header_size( p_fci_internal ) + p_fci_internal->ccab.cbReserveCFFolder;
   read_result+= p_fci_internal->pending_data_size +
@@ -1736,6 +2005,8 @@ BOOL __cdecl FCIDestroy(HFCI hfci)
     /* and deleted */
     p_fci_internal->magic = 0;
 
+    stop_compress_pool( p_fci_internal );
+
     LIST_FOR_EACH_ENTRY_SAFE( folder, folder_next, &p_fci_internal->folders_list, struct folder, entry )
     {
         free_folder( p_fci_internal, folder );
@@ -142,7 +142,7 @@ typedef struct fdi_cds_fwd {
   cab_UBYTE *outpos;               /* (high level) start of data to use up  */
   cab_UWORD outlen;                /* (high level) amount of data to use up */
   int (*decompress)(int, int, struct fdi_cds_fwd *); /* chosen compress fn  */
-  cab_UBYTE inbuf[CAB_INPUTMAX+2]; /* +2 for lzx bitbuffer overflows!       */
+  cab_UBYTE inbuf[CAB_INPUTMAX+8]; /* +8 for bitbuffer overflows!           */
   cab_UBYTE outbuf[CAB_BLOCKMAX];
   union {
     struct ZIPstate zip;
@@ -163,8 +163,8 @@ typedef struct fdi_cds_fwd {
   struct fdi_cds_fwd *next;
 } fdi_decomp_state;
 
-#define ZIPNEEDBITS(n) {while(k<(n)){cab_LONG c=*(ZIP(inpos)++);\
-    b|=((cab_ULONG)c)<<k;k+=8;}}
+#define ZIPNEEDBITS(n) {if(k<(n)){do{cab_LONG c=*(ZIP(inpos)++);\
+    b|=((cab_bitbuf)c)<<k;k+=8;}while(k<=CAB_BITBUF_BITS-8);}}
 #define ZIPDUMPBITS(n) {b>>=(n);k-=(n);}
 
 /* endian-neutral reading of little-endian data */
@@ -790,6 +790,16 @@ static int QTMfdi_init(int window, int level, fdi_decomp_state *decomp_state) {
   return DECR_OK;
 }
 
+/************************************************************
+ * ZIPfdi_init (internal)
+ */
+static void ZIPfdi_init(fdi_decomp_state *decomp_state) {
+  /* the method state is shared with the other decompressors */
+  ZIP(fixed_tl) = ZIP(fixed_td) = NULL;
+  ZIP(hufts) = ZIP(huft_base) = 0;
+  ZIP(overflow) = NULL;
+}
+
 /************************************************************
  * LZXfdi_init (internal)
  */
@@ -862,21 +872,46 @@ static int NONEfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
   return DECR_OK;
 }
 
+/********************************************************
+ * Ziphuft_alloc (internal)
+ *
+ * Tables are carved out of the decoder state; only pathological code sets
+ * that do not fit there fall back to the heap.
+ */
+static struct Ziphuft *fdi_Ziphuft_alloc(cab_ULONG n, fdi_decomp_state *decomp_state)
+{
+  struct Ziphuft *q;
+
+  if (n <= ZIPHUFT_MAX - ZIP(hufts))
+  {
+    q = ZIP(huft) + ZIP(hufts);
+    ZIP(hufts) += n;
+    return q;
+  }
+
+  /* the first entry links the overflow list for Ziphuft_free() */
+  if (!(q = CAB(fdi)->alloc((n + 1) * sizeof(struct Ziphuft))))
+    return NULL;
+  q->v.t = ZIP(overflow);
+  ZIP(overflow) = q;
+  return q + 1;
+}
+
 /********************************************************
  * Ziphuft_free (internal)
+ *
+ * Releases all tables except the cached fixed ones.
  */
-static void fdi_Ziphuft_free(FDI_Int *fdi, struct Ziphuft *t)
+static void fdi_Ziphuft_free(fdi_decomp_state *decomp_state)
 {
-  register struct Ziphuft *p, *q;
+  struct Ziphuft *p;
 
-  /* Go through linked list, freeing from the allocated (t[-1]) address. */
-  p = t;
-  while (p != NULL)
+  while ((p = ZIP(overflow)) != NULL)
   {
-    q = (--p)->v.t;
-    fdi->free(p);
-    p = q;
-  } 
+    ZIP(overflow) = p->v.t;
+    CAB(fdi)->free(p);
+  }
+  ZIP(hufts) = ZIP(huft_base);
 }
 
 /*********************************************************
@@ -999,16 +1034,12 @@ struct Ziphuft **t, cab_LONG *m, fdi_decomp_state *decomp_state)
         z = 1 << j;             /* table entries for j-bit table */
         l[h] = j;               /* set table size in stack */
 
-        /* allocate and link in new table */
-        if (!(q = CAB(fdi)->alloc((z + 1)*sizeof(struct Ziphuft))))
-        {
-          if(h)
-            fdi_Ziphuft_free(CAB(fdi), ZIP(u)[0]);
+        /* allocate new table, it is released by Ziphuft_free() */
+        if (!(q = fdi_Ziphuft_alloc(z, decomp_state)))
           return 3;             /* not enough memory */
-        }
-        *t = q + 1;             /* link to list for Ziphuft_free() */
-        *(t = &(q->v.t)) = NULL;
-        ZIP(u)[h] = ++q;             /* table starts after link */
+        if (!h)
+          *t = q;               /* return the base table */
+        ZIP(u)[h] = q;
 
         /* connect to last table, if there is one */
         if (h)
@@ -1071,7 +1102,7 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
   cab_ULONG w;              /* current window position */
   const struct Ziphuft *t;  /* pointer to table entry */
   cab_ULONG ml, md;         /* masks for bl and bd bits */
-  register cab_ULONG b;     /* bit buffer */
+  register cab_bitbuf b;    /* bit buffer */
   register cab_ULONG k;     /* number of bits in bit buffer */
 
   /* make local copies of globals */
@@ -1097,7 +1128,11 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
       } while ((e = (t = t->v.t + (b & Zipmask[e]))->e) > 16);
     ZIPDUMPBITS(t->b)
     if (e == 16)                /* then it's a literal */
+    {
+      if (w >= ZIPWSIZE)
+        return 1;
       CAB(outbuf)[w++] = (cab_UBYTE)t->v.n;
+    }
     else                        /* it's an EOB or a length */
     {
       /* exit if end of block */
@@ -1123,13 +1158,22 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
       ZIPNEEDBITS(e)
       d = w - t->v.n - (b & Zipmask[e]);
       ZIPDUMPBITS(e)
+      if (w + n > ZIPWSIZE)
+        return 1;
       do
       {
         d &= ZIPWSIZE - 1;
         e = ZIPWSIZE - max(d, w);
         e = min(e, n);
         n -= e;
-        do
+        if (d + e <= w || w + e <= d)
+        {
+          /* source and destination don't overlap */
+          memcpy(CAB(outbuf) + w, CAB(outbuf) + d, e);
+          w += e;
+          d += e;
+        }
+        else do
         {
           CAB(outbuf)[w++] = CAB(outbuf)[d++];
         } while (--e);
@@ -1154,7 +1198,7 @@ static cab_LONG fdi_Zipinflate_stored(fdi_decomp_state *decomp_state)
 {
   cab_ULONG n;           /* number of bytes in block */
   cab_ULONG w;           /* current window position */
-  register cab_ULONG b;  /* bit buffer */
+  register cab_bitbuf b; /* bit buffer */
   register cab_ULONG k;  /* number of bits in bit buffer */
 
   /* make local copies of globals */
@@ -1175,14 +1219,22 @@ static cab_LONG fdi_Zipinflate_stored(fdi_decomp_state *decomp_state)
     return 1;                   /* error in compressed data */
   ZIPDUMPBITS(16)
 
-  /* read and output the compressed data */
-  while(n--)
+  if (w + n > ZIPWSIZE)
+    return 1;
+
+  /* flush whole bytes still held in the bit buffer... */
+  while (n && k)
   {
-    ZIPNEEDBITS(8)
     CAB(outbuf)[w++] = (cab_UBYTE)b;
     ZIPDUMPBITS(8)
+    n--;
   }
 
+  /* ...then copy the rest of the data straight from the input */
+  memcpy(CAB(outbuf) + w, ZIP(inpos), n);
+  ZIP(inpos) += n;
+  w += n;
+
   /* restore the globals from the locals */
   ZIP(window_posn) = w;              /* restore global window pointer */
   ZIP(bb) = b;                       /* restore global bit buffer */
@@ -1195,13 +1247,15 @@ static cab_LONG fdi_Zipinflate_stored(fdi_decomp_state *decomp_state)
  */
 static cab_LONG fdi_Zipinflate_fixed(fdi_decomp_state *decomp_state)
 {
-  struct Ziphuft *fixed_tl;
-  struct Ziphuft *fixed_td;
-  cab_LONG fixed_bl, fixed_bd;
   cab_LONG i;                /* temporary variable */
   cab_ULONG *l;
 
+  /* the fixed tables are built once and kept at the start of the storage */
+  if (ZIP(fixed_tl))
+    return fdi_Zipinflate_codes(ZIP(fixed_tl), ZIP(fixed_td), ZIP(fixed_bl), ZIP(fixed_bd), decomp_state);
+
   l = ZIP(ll);
+  ZIP(hufts) = ZIP(huft_base) = 0;
 
   /* literal table */
   for(i = 0; i < 144; i++)
@@ -1212,26 +1266,26 @@ static cab_LONG fdi_Zipinflate_fixed(fdi_decomp_state *decomp_state)
     l[i] = 7;
   for(; i < 288; i++)          /* make a complete, but wrong code set */
     l[i] = 8;
-  fixed_bl = 7;
-  if((i = fdi_Ziphuft_build(l, 288, 257, Zipcplens, Zipcplext, &fixed_tl, &fixed_bl, decomp_state)))
+  ZIP(fixed_bl) = 7;
+  if((i = fdi_Ziphuft_build(l, 288, 257, Zipcplens, Zipcplext, &ZIP(fixed_tl), &ZIP(fixed_bl), decomp_state)))
+  {
+    ZIP(fixed_tl) = NULL;
     return i;
+  }
 
   /* distance table */
   for(i = 0; i < 30; i++)      /* make an incomplete code set */
     l[i] = 5;
-  fixed_bd = 5;
-  if((i = fdi_Ziphuft_build(l, 30, 0, Zipcpdist, Zipcpdext, &fixed_td, &fixed_bd, decomp_state)) > 1)
+  ZIP(fixed_bd) = 5;
+  if((i = fdi_Ziphuft_build(l, 30, 0, Zipcpdist, Zipcpdext, &ZIP(fixed_td), &ZIP(fixed_bd), decomp_state)) > 1)
   {
-    fdi_Ziphuft_free(CAB(fdi), fixed_tl);
+    ZIP(fixed_tl) = NULL;
     return i;
   }
+  ZIP(huft_base) = ZIP(hufts);
 
   /* decompress until an end-of-block code */
-  i = fdi_Zipinflate_codes(fixed_tl, fixed_td, fixed_bl, fixed_bd, decomp_state);
-
-  fdi_Ziphuft_free(CAB(fdi), fixed_td);
-  fdi_Ziphuft_free(CAB(fdi), fixed_tl);
-  return i;
+  return fdi_Zipinflate_codes(ZIP(fixed_tl), ZIP(fixed_td), ZIP(fixed_bl), ZIP(fixed_bd), decomp_state);
 }
 
 /**************************************************************
@@ -1253,7 +1307,7 @@ static cab_LONG fdi_Zipinflate_dynamic(fdi_decomp_state *decomp_state)
   cab_ULONG nb;          	/* number of bit length codes */
   cab_ULONG nl;          	/* number of literal/length codes */
   cab_ULONG nd;          	/* number of distance codes */
-  register cab_ULONG b;         /* bit buffer */
+  register cab_bitbuf b;        /* bit buffer */
   register cab_ULONG k;	        /* number of bits in bit buffer */
 
   /* make local bit buffer */
@@ -1287,11 +1341,7 @@ static cab_LONG fdi_Zipinflate_dynamic(fdi_decomp_state *decomp_state)
   /* build decoding table for trees--single level, 7 bit lookup */
   bl = 7;
   if((i = fdi_Ziphuft_build(ll, 19, 19, NULL, NULL, &tl, &bl, decomp_state)) != 0)
-  {
-    if(i == 1)
-      fdi_Ziphuft_free(CAB(fdi), tl);
     return i;                   /* incomplete code set */
-  }
 
   /* read in literal and distance code lengths */
   n = nl + nd;
@@ -1340,7 +1390,7 @@ static cab_LONG fdi_Zipinflate_dynamic(fdi_decomp_state *decomp_state)
   }
 
   /* free decoding table for trees */
-  fdi_Ziphuft_free(CAB(fdi), tl);
+  fdi_Ziphuft_free(decomp_state);
 
   /* restore the global bit buffer */
   ZIP(bb) = b;
@@ -1349,22 +1399,12 @@ static cab_LONG fdi_Zipinflate_dynamic(fdi_decomp_state *decomp_state)
   /* build the decoding tables for literal/length and distance codes */
   bl = ZIPLBITS;
   if((i = fdi_Ziphuft_build(ll, nl, 257, Zipcplens, Zipcplext, &tl, &bl, decomp_state)) != 0)
-  {
-    if(i == 1)
-      fdi_Ziphuft_free(CAB(fdi), tl);
     return i;                   /* incomplete code set */
-  }
   bd = ZIPDBITS;
   fdi_Ziphuft_build(ll + nl, nd, 0, Zipcpdist, Zipcpdext, &td, &bd, decomp_state);
 
   /* decompress until an end-of-block code */
-  if(fdi_Zipinflate_codes(tl, td, bl, bd, decomp_state))
-    return 1;
-
-  /* free the decoding tables, return */
-  fdi_Ziphuft_free(CAB(fdi), tl);
-  fdi_Ziphuft_free(CAB(fdi), td);
-  return 0;
+  return fdi_Zipinflate_codes(tl, td, bl, bd, decomp_state);
 }
 
 /*****************************************************
@@ -1373,7 +1413,7 @@ static cab_LONG fdi_Zipinflate_dynamic(fdi_decomp_state *decomp_state)
 static cab_LONG fdi_Zipinflate_block(cab_LONG *e, fdi_decomp_state *decomp_state) /* e == last block flag */
 { /* decompress an inflated block */
   cab_ULONG t;           	/* block type */
-  register cab_ULONG b;     /* bit buffer */
+  register cab_bitbuf b;    /* bit buffer */
   register cab_ULONG k;     /* number of bits in bit buffer */
 
   /* make local bit buffer */
@@ -1396,13 +1436,17 @@ static cab_LONG fdi_Zipinflate_block(cab_LONG *e, fdi_decomp_state *decomp_state
 
   /* inflate that block type */
   if(t == 2)
-    return fdi_Zipinflate_dynamic(decomp_state);
-  if(t == 0)
-    return fdi_Zipinflate_stored(decomp_state);
-  if(t == 1)
-    return fdi_Zipinflate_fixed(decomp_state);
-  /* bad block type */
-  return 2;
+    t = fdi_Zipinflate_dynamic(decomp_state);
+  else if(t == 0)
+    t = fdi_Zipinflate_stored(decomp_state);
+  else if(t == 1)
+    t = fdi_Zipinflate_fixed(decomp_state);
+  else
+    return 2;                   /* bad block type */
+
+  /* release the decoding tables of this block */
+  fdi_Ziphuft_free(decomp_state);
+  return t;
 }
 
 /****************************************************
@@ -1433,6 +1477,21 @@ static int ZIPfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
   return DECR_OK;
 }
 
+/*******************************************************************
+ * fdi_copy_match (internal)
+ *
+ * Copies an LZ77 match within the window. Overlapping matches repeat the
+ * last bytes, so they have to be copied one byte at a time.
+ */
+static inline void fdi_copy_match(cab_UBYTE *dest, const cab_UBYTE *src, int len)
+{
+  if (len <= 0) return;
+  if (src + len <= dest || dest + len <= src)
+    memcpy(dest, src, len);
+  else
+    while (len-- > 0) *dest++ = *src++;
+}
+
 /*******************************************************************
  * QTMfdi_decomp(internal)
  */
@@ -1542,7 +1601,7 @@ static int QTMfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
       window_posn += match_length;
 
       /* copy match data - no worries about destination wraps */
-      while (match_length-- > 0) *rundest++ = *runsrc++;
+      fdi_copy_match(rundest, runsrc, match_length);
     }
   } /* while (togo > 0) */
 
@@ -1780,7 +1839,7 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            fdi_copy_match(rundest, runsrc, match_length);
           }
         }
         break;
@@ -1869,7 +1928,7 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            fdi_copy_match(rundest, runsrc, match_length);
           }
         }
         break;
@@ -2712,6 +2771,7 @@ BOOL __cdecl FDICopy(
           break;
         case cffoldCOMPTYPE_MSZIP:
           CAB(decompress) = ZIPfdi_decomp;
+          ZIPfdi_init(decomp_state);
           break;
         case cffoldCOMPTYPE_QUANTUM:
           CAB(decompress) = QTMfdi_decomp;
@@ -47,6 +47,57 @@ struct ID3DXMatrixStackImpl
 
 static const unsigned int INITIAL_STACK_SIZE = 32;
 
+#if defined(__GNUC__) && defined(__x86_64__)
+
+/*
+ * SSE is part of x86-64, so it can be used without checking the processor.
+ * The four components of a vector are transformed together and divided by
+ * w at once, with the same operations in the same order as the C code, so
+ * the results are identical. Each vector is read before its result is
+ * written, and nothing past its 12 bytes is accessed.
+ */
+#define HAVE_SSE_MATH
+
+static void sse_vec3_transform_coord_array(D3DXVECTOR3 *out, ULONG_PTR outstride, const D3DXVECTOR3 *in,
+        ULONG_PTR instride, const D3DXMATRIX *m, ULONG_PTR elements)
+{
+    if (!elements) return;
+
+    __asm__ __volatile__(
+        "movups (%[m]), %%xmm4\n\t"
+        "movups 16(%[m]), %%xmm5\n\t"
+        "movups 32(%[m]), %%xmm6\n\t"
+        "movups 48(%[m]), %%xmm7\n"
+        "1:\n\t"
+        "movss (%[src]), %%xmm0\n\t"
+        "movss 4(%[src]), %%xmm1\n\t"
+        "movss 8(%[src]), %%xmm2\n\t"
+        "shufps $0, %%xmm0, %%xmm0\n\t"
+        "shufps $0, %%xmm1, %%xmm1\n\t"
+        "shufps $0, %%xmm2, %%xmm2\n\t"
+        "mulps %%xmm4, %%xmm0\n\t"
+        "mulps %%xmm5, %%xmm1\n\t"
+        "mulps %%xmm6, %%xmm2\n\t"
+        "addps %%xmm1, %%xmm0\n\t"
+        "addps %%xmm2, %%xmm0\n\t"
+        "addps %%xmm7, %%xmm0\n\t"
+        "movaps %%xmm0, %%xmm1\n\t"
+        "shufps $0xff, %%xmm1, %%xmm1\n\t"
+        "divps %%xmm1, %%xmm0\n\t"
+        "movlps %%xmm0, (%[dst])\n\t"
+        "movhlps %%xmm0, %%xmm0\n\t"
+        "movss %%xmm0, 8(%[dst])\n\t"
+        "add %[instride], %[src]\n\t"
+        "add %[outstride], %[dst]\n\t"
+        "dec %[count]\n\t"
+        "jnz 1b"
+        : [src] "+r" (in), [dst] "+r" (out), [count] "+r" (elements)
+        : [m] "r" (m), [instride] "r" (instride), [outstride] "r" (outstride)
+        : "xmm0", "xmm1", "xmm2", "xmm4", "xmm5", "xmm6", "xmm7", "memory", "cc");
+}
+
+#endif
+
 /*_________________D3DXColor____________________*/
 
 D3DXCOLOR* WINAPI D3DXColorAdjustContrast(D3DXCOLOR *pout, const D3DXCOLOR *pc, FLOAT s)
@@ -259,73 +310,53 @@ FLOAT WINAPI D3DXMatrixDeterminant(const D3DXMATRIX *pm)
 
 D3DXMATRIX* WINAPI D3DXMatrixInverse(D3DXMATRIX *pout, FLOAT *pdeterminant, const D3DXMATRIX *pm)
 {
-    FLOAT det, t[3], v[16];
-    UINT i, j;
+    const D3DXMATRIX m = *pm;
+    FLOAT det, s[6], c[6];
 
     TRACE("pout %p, pdeterminant %p, pm %p\n", pout, pdeterminant, pm);
 
-    t[0] = pm->u.m[2][2] * pm->u.m[3][3] - pm->u.m[2][3] * pm->u.m[3][2];
-    t[1] = pm->u.m[1][2] * pm->u.m[3][3] - pm->u.m[1][3] * pm->u.m[3][2];
-    t[2] = pm->u.m[1][2] * pm->u.m[2][3] - pm->u.m[1][3] * pm->u.m[2][2];
-    v[0] = pm->u.m[1][1] * t[0] - pm->u.m[2][1] * t[1] + pm->u.m[3][1] * t[2];
-    v[4] = -pm->u.m[1][0] * t[0] + pm->u.m[2][0] * t[1] - pm->u.m[3][0] * t[2];
-
-    t[0] = pm->u.m[1][0] * pm->u.m[2][1] - pm->u.m[2][0] * pm->u.m[1][1];
-    t[1] = pm->u.m[1][0] * pm->u.m[3][1] - pm->u.m[3][0] * pm->u.m[1][1];
-    t[2] = pm->u.m[2][0] * pm->u.m[3][1] - pm->u.m[3][0] * pm->u.m[2][1];
-    v[8] = pm->u.m[3][3] * t[0] - pm->u.m[2][3] * t[1] + pm->u.m[1][3] * t[2];
-    v[12] = -pm->u.m[3][2] * t[0] + pm->u.m[2][2] * t[1] - pm->u.m[1][2] * t[2];
-
-    det = pm->u.m[0][0] * v[0] + pm->u.m[0][1] * v[4] +
-        pm->u.m[0][2] * v[8] + pm->u.m[0][3] * v[12];
+    /* 2x2 minors of the two upper and the two lower rows, shared by all the cofactors */
+    s[0] = m.u.m[0][0] * m.u.m[1][1] - m.u.m[0][1] * m.u.m[1][0];
+    s[1] = m.u.m[0][0] * m.u.m[1][2] - m.u.m[0][2] * m.u.m[1][0];
+    s[2] = m.u.m[0][0] * m.u.m[1][3] - m.u.m[0][3] * m.u.m[1][0];
+    s[3] = m.u.m[0][1] * m.u.m[1][2] - m.u.m[0][2] * m.u.m[1][1];
+    s[4] = m.u.m[0][1] * m.u.m[1][3] - m.u.m[0][3] * m.u.m[1][1];
+    s[5] = m.u.m[0][2] * m.u.m[1][3] - m.u.m[0][3] * m.u.m[1][2];
+
+    c[0] = m.u.m[2][0] * m.u.m[3][1] - m.u.m[2][1] * m.u.m[3][0];
+    c[1] = m.u.m[2][0] * m.u.m[3][2] - m.u.m[2][2] * m.u.m[3][0];
+    c[2] = m.u.m[2][0] * m.u.m[3][3] - m.u.m[2][3] * m.u.m[3][0];
+    c[3] = m.u.m[2][1] * m.u.m[3][2] - m.u.m[2][2] * m.u.m[3][1];
+    c[4] = m.u.m[2][1] * m.u.m[3][3] - m.u.m[2][3] * m.u.m[3][1];
+    c[5] = m.u.m[2][2] * m.u.m[3][3] - m.u.m[2][3] * m.u.m[3][2];
+
+    det = s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] - s[4] * c[1] + s[5] * c[0];
     if (det == 0.0f)
         return NULL;
     if (pdeterminant)
         *pdeterminant = det;
 
-    t[0] = pm->u.m[2][2] * pm->u.m[3][3] - pm->u.m[2][3] * pm->u.m[3][2];
-    t[1] = pm->u.m[0][2] * pm->u.m[3][3] - pm->u.m[0][3] * pm->u.m[3][2];
-    t[2] = pm->u.m[0][2] * pm->u.m[2][3] - pm->u.m[0][3] * pm->u.m[2][2];
-    v[1] = -pm->u.m[0][1] * t[0] + pm->u.m[2][1] * t[1] - pm->u.m[3][1] * t[2];
-    v[5] = pm->u.m[0][0] * t[0] - pm->u.m[2][0] * t[1] + pm->u.m[3][0] * t[2];
+    det = 1.0f / det;
 
-    t[0] = pm->u.m[0][0] * pm->u.m[2][1] - pm->u.m[2][0] * pm->u.m[0][1];
-    t[1] = pm->u.m[3][0] * pm->u.m[0][1] - pm->u.m[0][0] * pm->u.m[3][1];
-    t[2] = pm->u.m[2][0] * pm->u.m[3][1] - pm->u.m[3][0] * pm->u.m[2][1];
-    v[9] = -pm->u.m[3][3] * t[0] - pm->u.m[2][3] * t[1]- pm->u.m[0][3] * t[2];
-    v[13] = pm->u.m[3][2] * t[0] + pm->u.m[2][2] * t[1] + pm->u.m[0][2] * t[2];
-
-    t[0] = pm->u.m[1][2] * pm->u.m[3][3] - pm->u.m[1][3] * pm->u.m[3][2];
-    t[1] = pm->u.m[0][2] * pm->u.m[3][3] - pm->u.m[0][3] * pm->u.m[3][2];
-    t[2] = pm->u.m[0][2] * pm->u.m[1][3] - pm->u.m[0][3] * pm->u.m[1][2];
-    v[2] = pm->u.m[0][1] * t[0] - pm->u.m[1][1] * t[1] + pm->u.m[3][1] * t[2];
-    v[6] = -pm->u.m[0][0] * t[0] + pm->u.m[1][0] * t[1] - pm->u.m[3][0] * t[2];
-
-    t[0] = pm->u.m[0][0] * pm->u.m[1][1] - pm->u.m[1][0] * pm->u.m[0][1];
-    t[1] = pm->u.m[3][0] * pm->u.m[0][1] - pm->u.m[0][0] * pm->u.m[3][1];
-    t[2] = pm->u.m[1][0] * pm->u.m[3][1] - pm->u.m[3][0] * pm->u.m[1][1];
-    v[10] = pm->u.m[3][3] * t[0] + pm->u.m[1][3] * t[1] + pm->u.m[0][3] * t[2];
-    v[14] = -pm->u.m[3][2] * t[0] - pm->u.m[1][2] * t[1] - pm->u.m[0][2] * t[2];
-
-    t[0] = pm->u.m[1][2] * pm->u.m[2][3] - pm->u.m[1][3] * pm->u.m[2][2];
-    t[1] = pm->u.m[0][2] * pm->u.m[2][3] - pm->u.m[0][3] * pm->u.m[2][2];
-    t[2] = pm->u.m[0][2] * pm->u.m[1][3] - pm->u.m[0][3] * pm->u.m[1][2];
-    v[3] = -pm->u.m[0][1] * t[0] + pm->u.m[1][1] * t[1] - pm->u.m[2][1] * t[2];
-    v[7] = pm->u.m[0][0] * t[0] - pm->u.m[1][0] * t[1] + pm->u.m[2][0] * t[2];
-
-    v[11] = -pm->u.m[0][0] * (pm->u.m[1][1] * pm->u.m[2][3] - pm->u.m[1][3] * pm->u.m[2][1]) +
-        pm->u.m[1][0] * (pm->u.m[0][1] * pm->u.m[2][3] - pm->u.m[0][3] * pm->u.m[2][1]) -
-        pm->u.m[2][0] * (pm->u.m[0][1] * pm->u.m[1][3] - pm->u.m[0][3] * pm->u.m[1][1]);
-
-    v[15] = pm->u.m[0][0] * (pm->u.m[1][1] * pm->u.m[2][2] - pm->u.m[1][2] * pm->u.m[2][1]) -
-        pm->u.m[1][0] * (pm->u.m[0][1] * pm->u.m[2][2] - pm->u.m[0][2] * pm->u.m[2][1]) +
-        pm->u.m[2][0] * (pm->u.m[0][1] * pm->u.m[1][2] - pm->u.m[0][2] * pm->u.m[1][1]);
+    pout->u.m[0][0] = ( m.u.m[1][1] * c[5] - m.u.m[1][2] * c[4] + m.u.m[1][3] * c[3]) * det;
+    pout->u.m[0][1] = (-m.u.m[0][1] * c[5] + m.u.m[0][2] * c[4] - m.u.m[0][3] * c[3]) * det;
+    pout->u.m[0][2] = ( m.u.m[3][1] * s[5] - m.u.m[3][2] * s[4] + m.u.m[3][3] * s[3]) * det;
+    pout->u.m[0][3] = (-m.u.m[2][1] * s[5] + m.u.m[2][2] * s[4] - m.u.m[2][3] * s[3]) * det;
 
-    det = 1.0f / det;
+    pout->u.m[1][0] = (-m.u.m[1][0] * c[5] + m.u.m[1][2] * c[2] - m.u.m[1][3] * c[1]) * det;
+    pout->u.m[1][1] = ( m.u.m[0][0] * c[5] - m.u.m[0][2] * c[2] + m.u.m[0][3] * c[1]) * det;
+    pout->u.m[1][2] = (-m.u.m[3][0] * s[5] + m.u.m[3][2] * s[2] - m.u.m[3][3] * s[1]) * det;
+    pout->u.m[1][3] = ( m.u.m[2][0] * s[5] - m.u.m[2][2] * s[2] + m.u.m[2][3] * s[1]) * det;
 
-    for (i = 0; i < 4; i++)
-        for (j = 0; j < 4; j++)
-            pout->u.m[i][j] = v[4 * i + j] * det;
+    pout->u.m[2][0] = ( m.u.m[1][0] * c[4] - m.u.m[1][1] * c[2] + m.u.m[1][3] * c[0]) * det;
+    pout->u.m[2][1] = (-m.u.m[0][0] * c[4] + m.u.m[0][1] * c[2] - m.u.m[0][3] * c[0]) * det;
+    pout->u.m[2][2] = ( m.u.m[3][0] * s[4] - m.u.m[3][1] * s[2] + m.u.m[3][3] * s[0]) * det;
+    pout->u.m[2][3] = (-m.u.m[2][0] * s[4] + m.u.m[2][1] * s[2] - m.u.m[2][3] * s[0]) * det;
+
+    pout->u.m[3][0] = (-m.u.m[1][0] * c[3] + m.u.m[1][1] * c[1] - m.u.m[1][2] * c[0]) * det;
+    pout->u.m[3][1] = ( m.u.m[0][0] * c[3] - m.u.m[0][1] * c[1] + m.u.m[0][2] * c[0]) * det;
+    pout->u.m[3][2] = (-m.u.m[3][0] * s[3] + m.u.m[3][1] * s[1] - m.u.m[3][2] * s[0]) * det;
+    pout->u.m[3][3] = ( m.u.m[2][0] * s[3] - m.u.m[2][1] * s[1] + m.u.m[2][2] * s[0]) * det;
 
     return pout;
 }
@@ -398,17 +429,21 @@ D3DXMATRIX * WINAPI D3DXMatrixLookAtRH(D3DXMATRIX *out, const D3DXVECTOR3 *eye,
 
 D3DXMATRIX* WINAPI D3DXMatrixMultiply(D3DXMATRIX *pout, const D3DXMATRIX *pm1, const D3DXMATRIX *pm2)
 {
+    const D3DXMATRIX m = *pm2;
     D3DXMATRIX out;
-    int i,j;
+    int i;
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
-    for (i=0; i<4; i++)
+    /* each row of the result is a combination of the rows of pm2 */
+    for (i = 0; i < 4; i++)
     {
-        for (j=0; j<4; j++)
-        {
-            out.u.m[i][j] = pm1->u.m[i][0] * pm2->u.m[0][j] + pm1->u.m[i][1] * pm2->u.m[1][j] + pm1->u.m[i][2] * pm2->u.m[2][j] + pm1->u.m[i][3] * pm2->u.m[3][j];
-        }
+        const FLOAT a = pm1->u.m[i][0], b = pm1->u.m[i][1], c = pm1->u.m[i][2], d = pm1->u.m[i][3];
+
+        out.u.m[i][0] = a * m.u.m[0][0] + b * m.u.m[1][0] + c * m.u.m[2][0] + d * m.u.m[3][0];
+        out.u.m[i][1] = a * m.u.m[0][1] + b * m.u.m[1][1] + c * m.u.m[2][1] + d * m.u.m[3][1];
+        out.u.m[i][2] = a * m.u.m[0][2] + b * m.u.m[1][2] + c * m.u.m[2][2] + d * m.u.m[3][2];
+        out.u.m[i][3] = a * m.u.m[0][3] + b * m.u.m[1][3] + c * m.u.m[2][3] + d * m.u.m[3][3];
     }
 
     *pout = out;
@@ -1911,15 +1946,22 @@ D3DXVECTOR4* WINAPI D3DXVec3Transform(D3DXVECTOR4 *pout, const D3DXVECTOR3 *pv,
 
 D3DXVECTOR4* WINAPI D3DXVec3TransformArray(D3DXVECTOR4* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DXMATRIX* matrix, UINT elements)
 {
+    const D3DXMATRIX m = *matrix;
+    const char *src = (const char *)in;
+    char *dst = (char *)out;
     UINT i;
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
-    for (i = 0; i < elements; ++i) {
-        D3DXVec3Transform(
-            (D3DXVECTOR4*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            matrix);
+    for (i = 0; i < elements; ++i, src += instride, dst += outstride)
+    {
+        const D3DXVECTOR3 v = *(const D3DXVECTOR3 *)src;
+        D3DXVECTOR4 *o = (D3DXVECTOR4 *)dst;
+
+        o->x = m.u.m[0][0] * v.x + m.u.m[1][0] * v.y + m.u.m[2][0] * v.z + m.u.m[3][0];
+        o->y = m.u.m[0][1] * v.x + m.u.m[1][1] * v.y + m.u.m[2][1] * v.z + m.u.m[3][1];
+        o->z = m.u.m[0][2] * v.x + m.u.m[1][2] * v.y + m.u.m[2][2] * v.z + m.u.m[3][2];
+        o->w = m.u.m[0][3] * v.x + m.u.m[1][3] * v.y + m.u.m[2][3] * v.z + m.u.m[3][3];
     }
     return out;
 }
@@ -1944,15 +1986,29 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformCoord(D3DXVECTOR3 *pout, const D3DXVECTOR3
 
 D3DXVECTOR3* WINAPI D3DXVec3TransformCoordArray(D3DXVECTOR3* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DXMATRIX* matrix, UINT elements)
 {
+    const D3DXMATRIX m = *matrix;
+    const char *src = (const char *)in;
+    char *dst = (char *)out;
     UINT i;
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
-    for (i = 0; i < elements; ++i) {
-        D3DXVec3TransformCoord(
-            (D3DXVECTOR3*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            matrix);
+#ifdef HAVE_SSE_MATH
+    sse_vec3_transform_coord_array(out, outstride, in, instride, &m, elements);
+    return out;
+#endif
+
+    for (i = 0; i < elements; ++i, src += instride, dst += outstride)
+    {
+        const D3DXVECTOR3 v = *(const D3DXVECTOR3 *)src;
+        D3DXVECTOR3 *o = (D3DXVECTOR3 *)dst;
+        FLOAT norm;
+
+        norm = m.u.m[0][3] * v.x + m.u.m[1][3] * v.y + m.u.m[2][3] * v.z + m.u.m[3][3];
+
+        o->x = (m.u.m[0][0] * v.x + m.u.m[1][0] * v.y + m.u.m[2][0] * v.z + m.u.m[3][0]) / norm;
+        o->y = (m.u.m[0][1] * v.x + m.u.m[1][1] * v.y + m.u.m[2][1] * v.z + m.u.m[3][1]) / norm;
+        o->z = (m.u.m[0][2] * v.x + m.u.m[1][2] * v.y + m.u.m[2][2] * v.z + m.u.m[3][2]) / norm;
     }
     return out;
 }
@@ -2112,15 +2168,22 @@ D3DXVECTOR4* WINAPI D3DXVec4Transform(D3DXVECTOR4 *pout, const D3DXVECTOR4 *pv,
 
 D3DXVECTOR4* WINAPI D3DXVec4TransformArray(D3DXVECTOR4* out, UINT outstride, const D3DXVECTOR4* in, UINT instride, const D3DXMATRIX* matrix, UINT elements)
 {
+    const D3DXMATRIX m = *matrix;
+    const char *src = (const char *)in;
+    char *dst = (char *)out;
     UINT i;
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
-    for (i = 0; i < elements; ++i) {
-        D3DXVec4Transform(
-            (D3DXVECTOR4*)((char*)out + outstride * i),
-            (const D3DXVECTOR4*)((const char*)in + instride * i),
-            matrix);
+    for (i = 0; i < elements; ++i, src += instride, dst += outstride)
+    {
+        const D3DXVECTOR4 v = *(const D3DXVECTOR4 *)src;
+        D3DXVECTOR4 *o = (D3DXVECTOR4 *)dst;
+
+        o->x = m.u.m[0][0] * v.x + m.u.m[1][0] * v.y + m.u.m[2][0] * v.z + m.u.m[3][0] * v.w;
+        o->y = m.u.m[0][1] * v.x + m.u.m[1][1] * v.y + m.u.m[2][1] * v.z + m.u.m[3][1] * v.w;
+        o->z = m.u.m[0][2] * v.x + m.u.m[1][2] * v.y + m.u.m[2][2] * v.z + m.u.m[3][2] * v.w;
+        o->w = m.u.m[0][3] * v.x + m.u.m[1][3] * v.y + m.u.m[2][3] * v.z + m.u.m[3][3] * v.w;
     }
     return out;
 }
@@ -1226,6 +1226,171 @@ static int compare_vertex_keys(const void *a, const void *b)
     return left->key < right->key ? -1 : 1;
 }
 
+static int compare_dwords(const void *a, const void *b)
+{
+    const DWORD *left = a;
+    const DWORD *right = b;
+    if (*left == *right)
+        return 0;
+    return *left < *right ? -1 : 1;
+}
+
+/* Hash grid used to find coincident vertices. The cells are four times
+ * epsilon wide, so only the cells overlapping the epsilon box around a vertex
+ * need to be searched, usually one or two per dimension. With a zero epsilon
+ * the cells are the exact positions. */
+struct vertex_grid
+{
+    DWORD *buckets;
+    DWORD *next;
+    DWORD mask;
+    float epsilon;
+};
+
+static INT vertex_grid_coord(const struct vertex_grid *grid, double coord)
+{
+    coord = floor(coord / (4.0 * grid->epsilon));
+
+    /* Clamping keeps neighbours neighbours, and takes care of NaNs. */
+    if (!(coord >= -1.0e9))
+        return -1000000000;
+    if (coord > 1.0e9)
+        return 1000000000;
+    return coord;
+}
+
+static void vertex_grid_cell(const struct vertex_grid *grid, const D3DXVECTOR3 *vertex, INT cell[3])
+{
+    const float *coords = &vertex->x;
+    unsigned int i;
+
+    for (i = 0; i < 3; ++i)
+    {
+        if (grid->epsilon == 0.0f)
+        {
+            /* Adding zero turns -0.0f into 0.0f, they compare equal. */
+            float coord = coords[i] + 0.0f;
+            memcpy(&cell[i], &coord, sizeof(cell[i]));
+        }
+        else
+        {
+            cell[i] = vertex_grid_coord(grid, coords[i]);
+        }
+    }
+}
+
+static DWORD vertex_grid_bucket(const struct vertex_grid *grid, const INT cell[3])
+{
+    DWORD hash = (DWORD)cell[0] * 0x8da6b343 ^ (DWORD)cell[1] * 0xd8163841 ^ (DWORD)cell[2] * 0xcb1ab31f;
+
+    return (hash ^ hash >> 16) & grid->mask;
+}
+
+static HRESULT init_vertex_grid(struct vertex_grid *grid, const BYTE *vertices, DWORD vertex_size,
+        const struct vertex_metadata *metadata, DWORD num_vertices, float epsilon)
+{
+    DWORD bucket_count = 16;
+    DWORD i;
+
+    while (bucket_count < num_vertices && bucket_count < 0x80000000)
+        bucket_count <<= 1;
+
+    grid->buckets = HeapAlloc(GetProcessHeap(), 0, (bucket_count + num_vertices) * sizeof(*grid->buckets));
+    if (!grid->buckets)
+        return E_OUTOFMEMORY;
+    grid->next = grid->buckets + bucket_count;
+    grid->mask = bucket_count - 1;
+    grid->epsilon = epsilon;
+    memset(grid->buckets, 0xff, bucket_count * sizeof(*grid->buckets));
+
+    for (i = 0; i < num_vertices; ++i)
+    {
+        INT cell[3];
+        DWORD bucket;
+
+        /* Vertices not used by any face can't make faces adjacent. */
+        if (metadata[i].first_shared_index == -1)
+            continue;
+        vertex_grid_cell(grid, (const D3DXVECTOR3 *)(vertices + i * vertex_size), cell);
+        bucket = vertex_grid_bucket(grid, cell);
+        grid->next[i] = grid->buckets[bucket];
+        grid->buckets[bucket] = i;
+    }
+
+    return D3D_OK;
+}
+
+/* Finds the vertices that come after vertex_index in the sorted order and
+ * are within epsilon of it in each dimension. Returns their positions in the
+ * sorted order, in increasing order. */
+static DWORD find_coincident_vertices(const struct vertex_grid *grid, const BYTE *vertices, DWORD vertex_size,
+        DWORD vertex_index, const DWORD *sorted_positions, DWORD *coincident)
+{
+    const D3DXVECTOR3 *vertex_a = (const D3DXVECTOR3 *)(vertices + vertex_index * vertex_size);
+    const float *coords = &vertex_a->x;
+    DWORD position = sorted_positions[vertex_index];
+    DWORD visited[8], visited_count = 0;
+    DWORD count = 0;
+    INT first[3], last[3], cell[3];
+    unsigned int i;
+
+    if (grid->epsilon == 0.0f)
+    {
+        vertex_grid_cell(grid, vertex_a, first);
+        memcpy(last, first, sizeof(last));
+    }
+    else
+    {
+        /* Leave some room for rounding in the coincidence test. */
+        for (i = 0; i < 3; ++i)
+        {
+            first[i] = vertex_grid_coord(grid, coords[i] - 1.01 * grid->epsilon);
+            last[i] = vertex_grid_coord(grid, coords[i] + 1.01 * grid->epsilon);
+        }
+    }
+
+    for (cell[2] = first[2]; cell[2] <= last[2]; ++cell[2])
+    {
+        for (cell[1] = first[1]; cell[1] <= last[1]; ++cell[1])
+        {
+            for (cell[0] = first[0]; cell[0] <= last[0]; ++cell[0])
+            {
+                DWORD bucket = vertex_grid_bucket(grid, cell);
+                DWORD j;
+
+                /* Different cells can share a bucket. */
+                for (i = 0; i < visited_count; ++i)
+                {
+                    if (visited[i] == bucket)
+                        break;
+                }
+                if (i < visited_count)
+                    continue;
+                visited[visited_count++] = bucket;
+
+                for (j = grid->buckets[bucket]; j != -1; j = grid->next[j])
+                {
+                    const D3DXVECTOR3 *vertex_b;
+
+                    if (sorted_positions[j] <= position)
+                        continue;
+                    vertex_b = (const D3DXVECTOR3 *)(vertices + j * vertex_size);
+                    if (fabsf(vertex_a->x - vertex_b->x) <= grid->epsilon &&
+                        fabsf(vertex_a->y - vertex_b->y) <= grid->epsilon &&
+                        fabsf(vertex_a->z - vertex_b->z) <= grid->epsilon)
+                    {
+                        coincident[count++] = sorted_positions[j];
+                    }
+                }
+            }
+        }
+    }
+
+    if (count > 1)
+        qsort(coincident, count, sizeof(*coincident), compare_dwords);
+    return count;
+}
+
 static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsilon, DWORD *adjacency)
 {
     struct d3dx9_mesh *This = impl_from_ID3DXMesh(iface);
@@ -1234,11 +1399,15 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
     const DWORD *indices = NULL;
     DWORD vertex_size;
     DWORD buffer_size;
-    /* sort the vertices by (x + y + z) to quickly find coincident vertices */
+    /* sort the vertices by (x + y + z), faces are matched up in that order */
     struct vertex_metadata *sorted_vertices;
     /* shared_indices links together identical indices in the index buffer so
      * that adjacency checks can be limited to faces sharing a vertex */
     DWORD *shared_indices = NULL;
+    /* positions of the vertices in sorted_vertices, and the positions of the
+     * vertices coincident with the current one */
+    DWORD *sorted_positions, *coincident;
+    struct vertex_grid grid = {NULL};
     const FLOAT epsilon_sq = epsilon * epsilon;
     DWORD i;
 
@@ -1247,13 +1416,16 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
     if (!adjacency)
         return D3DERR_INVALIDCALL;
 
-    buffer_size = This->numfaces * 3 * sizeof(*shared_indices) + This->numvertices * sizeof(*sorted_vertices);
+    buffer_size = This->numfaces * 3 * sizeof(*shared_indices) + This->numvertices * sizeof(*sorted_vertices)
+            + This->numvertices * (sizeof(*sorted_positions) + sizeof(*coincident));
     if (!(This->options & D3DXMESH_32BIT))
         buffer_size += This->numfaces * 3 * sizeof(*indices);
     shared_indices = HeapAlloc(GetProcessHeap(), 0, buffer_size);
     if (!shared_indices)
         return E_OUTOFMEMORY;
     sorted_vertices = (struct vertex_metadata*)(shared_indices + This->numfaces * 3);
+    sorted_positions = (DWORD *)(sorted_vertices + This->numvertices);
+    coincident = sorted_positions + This->numvertices;
 
     hr = iface->lpVtbl->LockVertexBuffer(iface, D3DLOCK_READONLY, (void**)&vertices);
     if (FAILED(hr)) goto cleanup;
@@ -1262,7 +1434,7 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
 
     if (!(This->options & D3DXMESH_32BIT)) {
         const WORD *word_indices = (const WORD*)indices;
-        DWORD *dword_indices = (DWORD*)(sorted_vertices + This->numvertices);
+        DWORD *dword_indices = coincident + This->numvertices;
         indices = dword_indices;
         for (i = 0; i < This->numfaces * 3; i++)
             *dword_indices++ = *word_indices++;
@@ -1281,17 +1453,31 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
         *first_shared_index = i;
         adjacency[i] = -1;
     }
+
+    /* Coincident vertices are only searched for with a non-negative epsilon. */
+    if (epsilon >= 0.0f)
+    {
+        hr = init_vertex_grid(&grid, vertices, vertex_size, sorted_vertices, This->numvertices, epsilon);
+        if (FAILED(hr)) goto cleanup;
+    }
+
     qsort(sorted_vertices, This->numvertices, sizeof(*sorted_vertices), compare_vertex_keys);
+    for (i = 0; i < This->numvertices; i++)
+        sorted_positions[sorted_vertices[i].vertex_index] = i;
 
     for (i = 0; i < This->numvertices; i++) {
         struct vertex_metadata *sorted_vertex_a = &sorted_vertices[i];
-        D3DXVECTOR3 *vertex_a = (D3DXVECTOR3*)(vertices + sorted_vertex_a->vertex_index * vertex_size);
         DWORD shared_index_a = sorted_vertex_a->first_shared_index;
+        DWORD coincident_count;
+
+        if (shared_index_a == -1)
+            continue;
+        coincident_count = grid.buckets ? find_coincident_vertices(&grid, vertices, vertex_size,
+                sorted_vertex_a->vertex_index, sorted_positions, coincident) : 0;
 
         while (shared_index_a != -1) {
-            DWORD j = i;
+            DWORD j = 0;
             DWORD shared_index_b = shared_indices[shared_index_a];
-            struct vertex_metadata *sorted_vertex_b = sorted_vertex_a;
 
             while (TRUE) {
                 while (shared_index_b != -1) {
@@ -1336,27 +1522,10 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
 
                     shared_index_b = shared_indices[shared_index_b];
                 }
-                while (++j < This->numvertices) {
-                    D3DXVECTOR3 *vertex_b;
-
-                    sorted_vertex_b++;
-                    if (sorted_vertex_b->key - sorted_vertex_a->key > epsilon * 3.0f) {
-                        /* no more coincident vertices to try */
-                        j = This->numvertices;
-                        break;
-                    }
-                    /* check for coincidence */
-                    vertex_b = (D3DXVECTOR3*)(vertices + sorted_vertex_b->vertex_index * vertex_size);
-                    if (fabsf(vertex_a->x - vertex_b->x) <= epsilon &&
-                        fabsf(vertex_a->y - vertex_b->y) <= epsilon &&
-                        fabsf(vertex_a->z - vertex_b->z) <= epsilon)
-                    {
-                        break;
-                    }
-                }
-                if (j >= This->numvertices)
+                /* continue with the next coincident vertex */
+                if (j >= coincident_count)
                     break;
-                shared_index_b = sorted_vertex_b->first_shared_index;
+                shared_index_b = sorted_vertices[coincident[j++]].first_shared_index;
             }
 
             sorted_vertex_a->first_shared_index = shared_indices[sorted_vertex_a->first_shared_index];
@@ -1368,6 +1537,7 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
 cleanup:
     if (indices) iface->lpVtbl->UnlockIndexBuffer(iface);
     if (vertices) iface->lpVtbl->UnlockVertexBuffer(iface);
+    HeapFree(GetProcessHeap(), 0, grid.buckets);
     HeapFree(GetProcessHeap(), 0, shared_indices);
     return hr;
 }
@@ -1645,6 +1815,394 @@ static HRESULT remap_faces_for_attrsort(struct d3dx9_mesh *This, const DWORD *in
     return D3D_OK;
 }
 
+/* Post-transform vertex cache optimization, after Tom Forsyth's "Linear-Speed
+ * Vertex Cache Optimisation". Faces are emitted greedily; a vertex scores
+ * higher the more recently it was used and the fewer faces still need it, and
+ * only faces around the vertices in the simulated cache are rescored after
+ * each step. */
+#define VCACHE_SIZE 32
+#define VCACHE_MAX_VALENCE 32
+
+struct vcache_vertex
+{
+    DWORD first_face;   /* offset into vcache.vertex_faces */
+    DWORD face_count;
+    DWORD remaining;    /* faces of the current group not emitted yet */
+    int cache_pos;
+    float score;
+};
+
+struct vcache
+{
+    const DWORD *indices;
+    struct vcache_vertex *vertices;
+    DWORD *vertex_faces;
+    BYTE *pending;
+    DWORD cache[VCACHE_SIZE];
+    DWORD cache_count;
+    float position_score[VCACHE_SIZE];
+    float valence_score[VCACHE_MAX_VALENCE];
+};
+
+static void vcache_update_score(struct vcache *vc, DWORD vertex)
+{
+    struct vcache_vertex *v = &vc->vertices[vertex];
+
+    if (!v->remaining)
+    {
+        v->score = -1.0f;
+        return;
+    }
+
+    v->score = v->cache_pos < 0 ? 0.0f : vc->position_score[v->cache_pos];
+    if (v->remaining < VCACHE_MAX_VALENCE)
+        v->score += vc->valence_score[v->remaining];
+    else
+        v->score += 2.0f / sqrtf(v->remaining);
+}
+
+/* The sum of three vertex scores is exact in double precision, so faces with
+ * the same vertex scores compare equal whatever order they list them in. */
+static double vcache_face_score(const struct vcache *vc, DWORD face)
+{
+    const DWORD *idx = vc->indices + face * 3;
+
+    return (double)vc->vertices[idx[0]].score + vc->vertices[idx[1]].score + vc->vertices[idx[2]].score;
+}
+
+static void vcache_emit_face(struct vcache *vc, DWORD face)
+{
+    const DWORD *idx = vc->indices + face * 3;
+    DWORD new_cache[VCACHE_SIZE + 3];
+    DWORD count = 0;
+    DWORD i;
+
+    vc->pending[face] = 0;
+    for (i = 0; i < 3; i++)
+    {
+        struct vcache_vertex *v = &vc->vertices[idx[i]];
+
+        --v->remaining;
+        /* Degenerate faces may reference a vertex more than once. */
+        if (v->cache_pos != -2)
+        {
+            v->cache_pos = -2;
+            new_cache[count++] = idx[i];
+        }
+    }
+    for (i = 0; i < vc->cache_count; i++)
+    {
+        if (vc->vertices[vc->cache[i]].cache_pos != -2)
+            new_cache[count++] = vc->cache[i];
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        vc->vertices[new_cache[i]].cache_pos = i < VCACHE_SIZE ? i : -1;
+        vcache_update_score(vc, new_cache[i]);
+    }
+    vc->cache_count = min(count, VCACHE_SIZE);
+    memcpy(vc->cache, new_cache, vc->cache_count * sizeof(*vc->cache));
+}
+
+static DWORD vcache_best_cached_face(const struct vcache *vc)
+{
+    double best_score = -1.0;
+    DWORD best_face = ~0u;
+    DWORD i, j;
+
+    for (i = 0; i < vc->cache_count; i++)
+    {
+        const struct vcache_vertex *v = &vc->vertices[vc->cache[i]];
+
+        for (j = v->first_face; j < v->first_face + v->face_count; j++)
+        {
+            DWORD face = vc->vertex_faces[j];
+            double score;
+
+            if (!vc->pending[face])
+                continue;
+            score = vcache_face_score(vc, face);
+            if (score > best_score)
+            {
+                best_score = score;
+                best_face = face;
+            }
+        }
+    }
+
+    return best_face;
+}
+
+/* Reorders the faces listed in order so that the vertex cache is used
+ * efficiently. If attribs is given, it holds the attribute of each entry in
+ * order, and faces are only moved within runs of the same attribute. */
+static HRESULT optimize_faces_for_vcache(const DWORD *indices, DWORD num_faces, DWORD num_vertices,
+        const DWORD *attribs, DWORD *order)
+{
+    struct vcache vc;
+    DWORD *new_order;
+    DWORD start, end, pos, cursor;
+    DWORD i;
+    HRESULT hr = D3D_OK;
+
+    vc.indices = indices;
+    vc.cache_count = 0;
+    vc.vertices = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, num_vertices * sizeof(*vc.vertices));
+    vc.vertex_faces = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*vc.vertex_faces));
+    vc.pending = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, num_faces * sizeof(*vc.pending));
+    new_order = HeapAlloc(GetProcessHeap(), 0, num_faces * sizeof(*new_order));
+    if (!vc.vertices || !vc.vertex_faces || !vc.pending || !new_order)
+    {
+        hr = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+
+    for (i = 0; i < num_faces * 3; i++)
+    {
+        if (indices[i] >= num_vertices)
+        {
+            WARN("Index %u out of range, vertex count %u.\n", indices[i], num_vertices);
+            hr = D3DERR_INVALIDCALL;
+            goto cleanup;
+        }
+        vc.vertices[indices[i]].face_count++;
+    }
+    for (i = 0, pos = 0; i < num_vertices; i++)
+    {
+        vc.vertices[i].first_face = pos;
+        vc.vertices[i].cache_pos = -1;
+        pos += vc.vertices[i].face_count;
+    }
+    for (i = 0; i < num_faces * 3; i++)
+    {
+        struct vcache_vertex *v = &vc.vertices[indices[i]];
+        vc.vertex_faces[v->first_face + v->remaining++] = i / 3;
+    }
+    for (i = 0; i < num_vertices; i++)
+        vc.vertices[i].remaining = 0;
+
+    for (i = 0; i < VCACHE_SIZE; i++)
+    {
+        if (i < 3)
+            vc.position_score[i] = 0.75f;
+        else
+            vc.position_score[i] = powf(1.0f - (i - 3) * (1.0f / (VCACHE_SIZE - 3)), 1.5f);
+    }
+    vc.valence_score[0] = 0.0f;
+    for (i = 1; i < VCACHE_MAX_VALENCE; i++)
+        vc.valence_score[i] = 2.0f / sqrtf(i);
+
+    for (start = 0; start < num_faces; start = end)
+    {
+        double best_score = -1.0;
+        DWORD face = 0;
+
+        end = start + 1;
+        if (attribs)
+        {
+            while (end < num_faces && attribs[end] == attribs[start])
+                ++end;
+        }
+        else
+        {
+            end = num_faces;
+        }
+
+        for (i = start; i < end; i++)
+        {
+            const DWORD *idx = indices + order[i] * 3;
+
+            vc.pending[order[i]] = 1;
+            vc.vertices[idx[0]].remaining++;
+            vc.vertices[idx[1]].remaining++;
+            vc.vertices[idx[2]].remaining++;
+        }
+        for (i = start * 3; i < end * 3; i++)
+            vcache_update_score(&vc, indices[order[i / 3] * 3 + i % 3]);
+
+        /* Start from the best face of the group, preferring later faces on
+         * ties. The only full scan; afterwards faces are found through the
+         * cache, or by walking back from the end of the group. */
+        for (i = start; i < end; i++)
+        {
+            double score = vcache_face_score(&vc, order[i]);
+
+            if (score >= best_score)
+            {
+                best_score = score;
+                face = order[i];
+            }
+        }
+
+        cursor = end;
+        for (pos = start;;)
+        {
+            new_order[pos++] = face;
+            vcache_emit_face(&vc, face);
+            if (pos == end)
+                break;
+
+            if ((face = vcache_best_cached_face(&vc)) == ~0u)
+            {
+                while (!vc.pending[order[--cursor]]);
+                face = order[cursor];
+            }
+        }
+    }
+
+    memcpy(order, new_order, num_faces * sizeof(*order));
+
+cleanup:
+    HeapFree(GetProcessHeap(), 0, new_order);
+    HeapFree(GetProcessHeap(), 0, vc.pending);
+    HeapFree(GetProcessHeap(), 0, vc.vertex_faces);
+    HeapFree(GetProcessHeap(), 0, vc.vertices);
+    return hr;
+}
+
+/* Create or update face_remap so that faces are drawn in a vertex cache
+ * friendly order, without moving faces across attribute boundaries. */
+static HRESULT remap_faces_for_vcache(struct d3dx9_mesh *This, const DWORD *indices,
+        const DWORD *attrib_buffer, DWORD **face_remap)
+{
+    DWORD *order;
+    DWORD i;
+    HRESULT hr;
+
+    order = HeapAlloc(GetProcessHeap(), 0, This->numfaces * sizeof(*order));
+    if (!order)
+        return E_OUTOFMEMORY;
+
+    if (*face_remap)
+    {
+        for (i = 0; i < This->numfaces; i++)
+            order[(*face_remap)[i]] = i;
+    }
+    else
+    {
+        *face_remap = HeapAlloc(GetProcessHeap(), 0, This->numfaces * sizeof(**face_remap));
+        if (!*face_remap)
+        {
+            HeapFree(GetProcessHeap(), 0, order);
+            return E_OUTOFMEMORY;
+        }
+        for (i = 0; i < This->numfaces; i++)
+            order[i] = i;
+    }
+
+    hr = optimize_faces_for_vcache(indices, This->numfaces, This->numvertices, attrib_buffer, order);
+    if (SUCCEEDED(hr))
+    {
+        for (i = 0; i < This->numfaces; i++)
+            (*face_remap)[order[i]] = i;
+    }
+
+    HeapFree(GetProcessHeap(), 0, order);
+    return hr;
+}
+
+/* Numbers the vertices in the order the indices first use them, and updates
+ * the indices to match. vertex_remap receives the old index of each new
+ * vertex; unused vertices are moved to the end. */
+static HRESULT remap_vertices_by_first_use(DWORD *indices, DWORD num_indices, DWORD num_vertices,
+        DWORD *vertex_remap, DWORD *num_used_vertices)
+{
+    DWORD *new_index;
+    DWORD used = 0, unused;
+    DWORD i;
+
+    new_index = HeapAlloc(GetProcessHeap(), 0, num_vertices * sizeof(*new_index));
+    if (!new_index)
+        return E_OUTOFMEMORY;
+    memset(new_index, 0xff, num_vertices * sizeof(*new_index));
+
+    for (i = 0; i < num_indices; i++)
+    {
+        DWORD vertex = indices[i];
+
+        if (vertex >= num_vertices)
+        {
+            WARN("Index %u out of range, vertex count %u.\n", vertex, num_vertices);
+            HeapFree(GetProcessHeap(), 0, new_index);
+            return D3DERR_INVALIDCALL;
+        }
+        if (new_index[vertex] == ~0u)
+        {
+            new_index[vertex] = used;
+            vertex_remap[used++] = vertex;
+        }
+        indices[i] = new_index[vertex];
+    }
+
+    unused = used;
+    for (i = 0; i < num_vertices; i++)
+    {
+        if (new_index[i] == ~0u)
+            vertex_remap[unused++] = i;
+    }
+
+    HeapFree(GetProcessHeap(), 0, new_index);
+    *num_used_vertices = used;
+    return D3D_OK;
+}
+
+/* Creates a vertex_remap that orders the vertices by first use, dropping
+ * unused vertices if compact is set. Indices are updated accordingly. */
+static HRESULT reorder_mesh_vertices(struct d3dx9_mesh *This, DWORD *indices, BOOL compact,
+        DWORD *new_num_vertices, ID3DXBuffer **vertex_remap)
+{
+    DWORD *vertex_remap_ptr;
+    DWORD num_used_vertices;
+    DWORD i;
+    HRESULT hr;
+
+    hr = D3DXCreateBuffer(This->numvertices * sizeof(DWORD), vertex_remap);
+    if (FAILED(hr)) return hr;
+    vertex_remap_ptr = ID3DXBuffer_GetBufferPointer(*vertex_remap);
+
+    hr = remap_vertices_by_first_use(indices, This->numfaces * 3, This->numvertices,
+            vertex_remap_ptr, &num_used_vertices);
+    if (FAILED(hr)) return hr;
+
+    if (compact)
+    {
+        for (i = num_used_vertices; i < This->numvertices; i++)
+            vertex_remap_ptr[i] = -1;
+        *new_num_vertices = num_used_vertices;
+    }
+    else
+    {
+        *new_num_vertices = This->numvertices;
+    }
+
+    return D3D_OK;
+}
+
+/* Recomputes the vertex ranges of the attribute table after the vertices
+ * were reordered. */
+static void update_attribute_table_vertices(struct d3dx9_mesh *This, const DWORD *indices)
+{
+    DWORD i, j;
+
+    for (i = 0; i < This->attrib_table_size; i++)
+    {
+        D3DXATTRIBUTERANGE *range = &This->attrib_table[i];
+        DWORD end = min(range->FaceStart + range->FaceCount, This->numfaces);
+        DWORD min_vertex = ~0u, max_vertex = 0;
+
+        if (range->FaceStart >= end)
+            continue;
+        for (j = range->FaceStart * 3; j < end * 3; j++)
+        {
+            min_vertex = min(min_vertex, indices[j]);
+            max_vertex = max(max_vertex, indices[j]);
+        }
+        range->VertexStart = min_vertex;
+        range->VertexCount = max_vertex - min_vertex + 1;
+    }
+}
+
 static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags, const DWORD *adjacency_in,
         DWORD *adjacency_out, DWORD *face_remap_out, ID3DXBuffer **vertex_remap_out)
 {
@@ -1659,6 +2217,8 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
     DWORD new_num_alloc_vertices = 0;
     IDirect3DVertexBuffer9 *vertex_buffer = NULL;
     DWORD *sorted_attrib_buffer = NULL;
+    DWORD *new_indices;
+    const DWORD reorder_flags = D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER;
     DWORD i;
 
     TRACE("iface %p, flags %#x, adjacency_in %p, adjacency_out %p, face_remap_out %p, vertex_remap_out %p.\n",
@@ -1671,20 +2231,14 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
     if ((flags & (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER)) == (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER))
         return D3DERR_INVALIDCALL;
 
-    if (flags & (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER))
-    {
-        if (flags & D3DXMESHOPT_VERTEXCACHE)
-            FIXME("D3DXMESHOPT_VERTEXCACHE not implemented.\n");
-        if (flags & D3DXMESHOPT_STRIPREORDER)
-            FIXME("D3DXMESHOPT_STRIPREORDER not implemented.\n");
-        return E_NOTIMPL;
-    }
-
     hr = iface->lpVtbl->LockIndexBuffer(iface, 0, &indices);
     if (FAILED(hr)) goto cleanup;
 
     dword_indices = HeapAlloc(GetProcessHeap(), 0, This->numfaces * 3 * sizeof(DWORD));
-    if (!dword_indices) return E_OUTOFMEMORY;
+    if (!dword_indices) {
+        hr = E_OUTOFMEMORY;
+        goto cleanup;
+    }
     if (This->options & D3DXMESH_32BIT) {
         memcpy(dword_indices, indices, This->numfaces * 3 * sizeof(DWORD));
     } else {
@@ -1693,24 +2247,46 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
             dword_indices[i] = *word_indices++;
     }
 
-    if ((flags & (D3DXMESHOPT_COMPACT | D3DXMESHOPT_IGNOREVERTS | D3DXMESHOPT_ATTRSORT)) == D3DXMESHOPT_COMPACT)
+    if ((flags & (D3DXMESHOPT_COMPACT | D3DXMESHOPT_IGNOREVERTS | D3DXMESHOPT_ATTRSORT | reorder_flags)) == D3DXMESHOPT_COMPACT)
     {
         new_num_alloc_vertices = This->numvertices;
         hr = compact_mesh(This, dword_indices, &new_num_vertices, &vertex_remap);
         if (FAILED(hr)) goto cleanup;
-    } else if (flags & D3DXMESHOPT_ATTRSORT) {
-        if (!(flags & D3DXMESHOPT_IGNOREVERTS))
+    } else if (flags & (D3DXMESHOPT_ATTRSORT | reorder_flags)) {
+        hr = iface->lpVtbl->LockAttributeBuffer(iface, 0, &attrib_buffer);
+        if (FAILED(hr)) goto cleanup;
+
+        if (flags & D3DXMESHOPT_ATTRSORT)
         {
-            FIXME("D3DXMESHOPT_ATTRSORT vertex reordering not implemented.\n");
-            hr = E_NOTIMPL;
-            goto cleanup;
+            hr = remap_faces_for_attrsort(This, dword_indices, attrib_buffer, &sorted_attrib_buffer, &face_remap);
+            if (FAILED(hr)) goto cleanup;
         }
 
-        hr = iface->lpVtbl->LockAttributeBuffer(iface, 0, &attrib_buffer);
-        if (FAILED(hr)) goto cleanup;
+        if (flags & reorder_flags)
+        {
+            hr = remap_faces_for_vcache(This, dword_indices,
+                    sorted_attrib_buffer ? sorted_attrib_buffer : attrib_buffer, &face_remap);
+            if (FAILED(hr)) goto cleanup;
+        }
 
-        hr = remap_faces_for_attrsort(This, dword_indices, attrib_buffer, &sorted_attrib_buffer, &face_remap);
-        if (FAILED(hr)) goto cleanup;
+        /* reorder the indices using face_remap */
+        new_indices = HeapAlloc(GetProcessHeap(), 0, This->numfaces * 3 * sizeof(DWORD));
+        if (!new_indices) {
+            hr = E_OUTOFMEMORY;
+            goto cleanup;
+        }
+        for (i = 0; i < This->numfaces; i++)
+            memcpy(new_indices + face_remap[i] * 3, dword_indices + i * 3, 3 * sizeof(DWORD));
+        HeapFree(GetProcessHeap(), 0, dword_indices);
+        dword_indices = new_indices;
+
+        if (!(flags & D3DXMESHOPT_IGNOREVERTS))
+        {
+            new_num_alloc_vertices = This->numvertices;
+            hr = reorder_mesh_vertices(This, dword_indices, flags & D3DXMESHOPT_COMPACT,
+                    &new_num_vertices, &vertex_remap);
+            if (FAILED(hr)) goto cleanup;
+        }
     }
 
     if (vertex_remap)
@@ -1766,46 +2342,36 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
         }
 
         memcpy(attrib_buffer, sorted_attrib_buffer, This->numfaces * sizeof(*attrib_buffer));
-
-        /* reorder the indices using face_remap */
-        if (This->options & D3DXMESH_32BIT) {
-            for (i = 0; i < This->numfaces; i++)
-                memcpy((DWORD*)indices + face_remap[i] * 3, dword_indices + i * 3, 3 * sizeof(DWORD));
-        } else {
-            WORD *word_indices = indices;
-            for (i = 0; i < This->numfaces; i++) {
-                DWORD new_pos = face_remap[i] * 3;
-                DWORD old_pos = i * 3;
-                word_indices[new_pos++] = dword_indices[old_pos++];
-                word_indices[new_pos++] = dword_indices[old_pos++];
-                word_indices[new_pos] = dword_indices[old_pos];
-            }
-        }
-
-        fill_attribute_table(attrib_buffer, This->numfaces, indices,
-                             This->options & D3DXMESH_32BIT, attrib_table);
-
         HeapFree(GetProcessHeap(), 0, This->attrib_table);
         This->attrib_table = attrib_table;
         This->attrib_table_size = attrib_table_size;
+    }
+
+    if (This->options & D3DXMESH_32BIT) {
+        memcpy(indices, dword_indices, This->numfaces * 3 * sizeof(DWORD));
     } else {
-        if (This->options & D3DXMESH_32BIT) {
-            memcpy(indices, dword_indices, This->numfaces * 3 * sizeof(DWORD));
-        } else {
-            WORD *word_indices = indices;
-            for (i = 0; i < This->numfaces * 3; i++)
-                *word_indices++ = dword_indices[i];
-        }
+        WORD *word_indices = indices;
+        for (i = 0; i < This->numfaces * 3; i++)
+            *word_indices++ = dword_indices[i];
     }
 
+    if (flags & D3DXMESHOPT_ATTRSORT)
+        fill_attribute_table(attrib_buffer, This->numfaces, indices,
+                             This->options & D3DXMESH_32BIT, This->attrib_table);
+    else if (vertex_buffer)
+        update_attribute_table_vertices(This, dword_indices);
+
     if (adjacency_out) {
         if (face_remap) {
             for (i = 0; i < This->numfaces; i++) {
                 DWORD old_pos = i * 3;
                 DWORD new_pos = face_remap[i] * 3;
-                adjacency_out[new_pos++] = face_remap[adjacency_in[old_pos++]];
-                adjacency_out[new_pos++] = face_remap[adjacency_in[old_pos++]];
-                adjacency_out[new_pos++] = face_remap[adjacency_in[old_pos++]];
+                DWORD j;
+
+                for (j = 0; j < 3; j++) {
+                    DWORD adjacent = adjacency_in[old_pos + j];
+                    adjacency_out[new_pos + j] = adjacent == ~0u ? ~0u : face_remap[adjacent];
+                }
             }
         } else {
             memcpy(adjacency_out, adjacency_in, This->numfaces * 3 * sizeof(*adjacency_out));
@@ -6848,6 +7414,11 @@ HRESULT WINAPI D3DXWeldVertices(ID3DXMesh *mesh, DWORD flags, const D3DXWELDEPSI
 
     if (flags & D3DXWELDEPSILONS_WELDPARTIALMATCHES)
     {
+        DWORD vertex_size = mesh->lpVtbl->GetNumBytesPerVertex(mesh);
+        FLOAT component_epsilons[MAX_FVF_DECL_SIZE];
+        D3DVERTEXELEMENT9 *decl_ptr;
+        DWORD num_vertex_components;
+
         hr = mesh->lpVtbl->LockVertexBuffer(mesh, 0, (void**)&vertices);
         if (FAILED(hr))
         {
@@ -6861,29 +7432,26 @@ HRESULT WINAPI D3DXWeldVertices(ID3DXMesh *mesh, DWORD flags, const D3DXWELDEPSI
          * belong to the same attribute group. Otherwise the vertex components
          * that are within epsilon are set to the same value.
          */
+        for (decl_ptr = This->cached_declaration, num_vertex_components = 0; decl_ptr->Stream != 0xFF; decl_ptr++, num_vertex_components++)
+            component_epsilons[num_vertex_components] = get_component_epsilon(decl_ptr, epsilons);
+
         for (i = 0; i < 3 * This->numfaces; i++)
         {
-            D3DVERTEXELEMENT9 *decl_ptr;
-            DWORD vertex_size = mesh->lpVtbl->GetNumBytesPerVertex(mesh);
-            DWORD num_vertex_components;
             INT matches = 0;
             BOOL all_match;
             DWORD index = read_ib(indices, indices_are_32bit, i);
+            DWORD component;
+
+            /* Don't weld self */
+            if (index == point_reps[index])
+                continue;
 
-            for (decl_ptr = This->cached_declaration, num_vertex_components = 0; decl_ptr->Stream != 0xFF; decl_ptr++, num_vertex_components++)
+            for (decl_ptr = This->cached_declaration, component = 0; component < num_vertex_components; decl_ptr++, component++)
             {
                 BYTE *to = &vertices[vertex_size*index + decl_ptr->Offset];
                 BYTE *from = &vertices[vertex_size*point_reps[index] + decl_ptr->Offset];
-                FLOAT epsilon = get_component_epsilon(decl_ptr, epsilons);
-
-                /* Don't weld self */
-                if (index == point_reps[index])
-                {
-                    matches++;
-                    continue;
-                }
 
-                if (weld_component(to, from, decl_ptr->Type, epsilon))
+                if (weld_component(to, from, decl_ptr->Type, component_epsilons[component]))
                     matches++;
             }
 
@@ -6939,6 +7507,29 @@ cleanup:
     return hr;
 }
 
+static DWORD *get_dword_indices(const void *indices, DWORD num_indices, BOOL indices_are_32bit)
+{
+    DWORD *dword_indices;
+    DWORD i;
+
+    dword_indices = HeapAlloc(GetProcessHeap(), 0, num_indices * sizeof(*dword_indices));
+    if (!dword_indices)
+        return NULL;
+
+    if (indices_are_32bit)
+    {
+        memcpy(dword_indices, indices, num_indices * sizeof(*dword_indices));
+    }
+    else
+    {
+        const WORD *word_indices = indices;
+        for (i = 0; i < num_indices; i++)
+            dword_indices[i] = word_indices[i];
+    }
+
+    return dword_indices;
+}
+
 /*************************************************************************
  * D3DXOptimizeFaces    (D3DX9_36.@)
  *
@@ -6955,51 +7546,81 @@ cleanup:
  *   Success: D3D_OK.
  *   Failure: D3DERR_INVALIDCALL.
  *
- * BUGS
- *   The face re-ordering does not use the vertex cache optimally.
- *
  */
 HRESULT WINAPI D3DXOptimizeFaces(const void *indices, UINT num_faces,
         UINT num_vertices, BOOL indices_are_32bit, DWORD *face_remap)
 {
     UINT i;
-    UINT j = num_faces - 1;
     UINT limit_16_bit = 2 << 15; /* According to MSDN */
-    HRESULT hr = D3D_OK;
+    DWORD *dword_indices;
+    HRESULT hr;
 
-    FIXME("indices %p, num_faces %u, num_vertices %u, indices_are_32bit %#x, face_remap %p semi-stub. "
-            "Face order will not be optimal.\n",
+    TRACE("indices %p, num_faces %u, num_vertices %u, indices_are_32bit %#x, face_remap %p.\n",
             indices, num_faces, num_vertices, indices_are_32bit, face_remap);
 
     if (!indices_are_32bit && num_faces >= limit_16_bit)
     {
         WARN("Number of faces must be less than %d when using 16-bit indices.\n",
              limit_16_bit);
-        hr = D3DERR_INVALIDCALL;
-        goto error;
+        return D3DERR_INVALIDCALL;
     }
 
     if (!face_remap)
     {
         WARN("Face remap pointer is NULL.\n");
-        hr = D3DERR_INVALIDCALL;
-        goto error;
+        return D3DERR_INVALIDCALL;
     }
 
-    /* The faces are drawn in reverse order for simple meshes. This ordering
-     * is not optimal for complicated meshes, but will not break anything
-     * either. The ordering should be changed to take advantage of the vertex
-     * cache on the graphics card.
-     *
-     * TODO Re-order to take advantage of vertex cache.
-     */
+    if (!(dword_indices = get_dword_indices(indices, num_faces * 3, indices_are_32bit)))
+        return E_OUTOFMEMORY;
+
     for (i = 0; i < num_faces; i++)
+        face_remap[i] = i;
+    hr = optimize_faces_for_vcache(dword_indices, num_faces, num_vertices, NULL, face_remap);
+
+    HeapFree(GetProcessHeap(), 0, dword_indices);
+    return hr;
+}
+
+/*************************************************************************
+ * D3DXOptimizeVertices    (D3DX9_36.@)
+ *
+ * Re-orders the vertices so they are fetched in the order the faces use them.
+ *
+ * PARAMS
+ *   indices           [I] Pointer to an index buffer belonging to a mesh.
+ *   num_faces         [I] Number of faces in the mesh.
+ *   num_vertices      [I] Number of vertices in the mesh.
+ *   indices_are_32bit [I] Specifies whether indices are 32- or 16-bit.
+ *   vertex_remap      [I/O] The old index of each vertex in the new order.
+ *
+ * RETURNS
+ *   Success: D3D_OK.
+ *   Failure: D3DERR_INVALIDCALL.
+ *
+ */
+HRESULT WINAPI D3DXOptimizeVertices(const void *indices, UINT num_faces,
+        UINT num_vertices, BOOL indices_are_32bit, DWORD *vertex_remap)
+{
+    DWORD *dword_indices;
+    DWORD num_used_vertices;
+    HRESULT hr;
+
+    TRACE("indices %p, num_faces %u, num_vertices %u, indices_are_32bit %#x, vertex_remap %p.\n",
+            indices, num_faces, num_vertices, indices_are_32bit, vertex_remap);
+
+    if (!vertex_remap)
     {
-        face_remap[i] = j--;
+        WARN("Vertex remap pointer is NULL.\n");
+        return D3DERR_INVALIDCALL;
     }
 
-    return D3D_OK;
+    if (!(dword_indices = get_dword_indices(indices, num_faces * 3, indices_are_32bit)))
+        return E_OUTOFMEMORY;
 
-error:
+    hr = remap_vertices_by_first_use(dword_indices, num_faces * 3, num_vertices,
+            vertex_remap, &num_used_vertices);
+
+    HeapFree(GetProcessHeap(), 0, dword_indices);
     return hr;
 }
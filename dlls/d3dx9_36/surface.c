@@ -1471,6 +1471,66 @@ static void format_from_vec4(const struct pixel_format_desc *format, const struc
     }
 }
 
+/* Formats whose channels all occupy whole bytes, e.g. A8R8G8B8, X8R8G8B8,
+ * A8B8G8R8 or R8G8B8, are converted through a packed A8R8G8B8 value instead
+ * of going through the generic per-channel code. */
+static BOOL is_byte_argb_format(const struct pixel_format_desc *format)
+{
+    unsigned int c;
+
+    if (format->type != FORMAT_ARGB || format->to_rgba || format->from_rgba
+            || format->bytes_per_pixel > 4)
+        return FALSE;
+
+    for (c = 0; c < 4; ++c)
+    {
+        if ((format->bits[c] && format->bits[c] != 8) || format->shift[c] % 8)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Missing channels read as 0xff, like in format_to_vec4(). */
+static DWORD read_byte_argb(const struct pixel_format_desc *format, const BYTE *src)
+{
+    DWORD argb = 0;
+    unsigned int c;
+
+    if (format->format == D3DFMT_A8R8G8B8)
+        return *(const DWORD *)src;
+    if (format->format == D3DFMT_X8R8G8B8)
+        return *(const DWORD *)src | 0xff000000;
+
+    for (c = 0; c < 4; ++c)
+        argb |= (format->bits[c] ? src[format->shift[c] / 8] : 0xff) << (24 - 8 * c);
+    return argb;
+}
+
+/* Bytes without a channel are written as zero, like in format_from_vec4(). */
+static void write_byte_argb(const struct pixel_format_desc *format, DWORD argb, BYTE *dst)
+{
+    DWORD val = 0;
+    unsigned int c;
+
+    if (format->format == D3DFMT_A8R8G8B8)
+    {
+        *(DWORD *)dst = argb;
+        return;
+    }
+    if (format->format == D3DFMT_X8R8G8B8)
+    {
+        *(DWORD *)dst = argb & 0x00ffffff;
+        return;
+    }
+
+    for (c = 0; c < 4; ++c)
+    {
+        if (format->bits[c])
+            val |= ((argb >> (24 - 8 * c)) & 0xff) << format->shift[c];
+    }
+    memcpy(dst, &val, format->bytes_per_pixel);
+}
+
 /************************************************************
  * copy_pixels
  *
@@ -1519,6 +1579,7 @@ void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pit
     const struct pixel_format_desc *ck_format = NULL;
     DWORD channels[4];
     UINT min_width, min_height, min_depth;
+    BOOL byte_formats = is_byte_argb_format(src_format) && is_byte_argb_format(dst_format);
     UINT x, y, z;
 
     ZeroMemory(channels, sizeof(channels));
@@ -1544,7 +1605,15 @@ void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pit
             BYTE *dst_ptr = dst_slice_ptr + y * dst_row_pitch;
 
             for (x = 0; x < min_width; x++) {
-                if (!src_format->to_rgba && !dst_format->from_rgba
+                if (byte_formats)
+                {
+                    DWORD argb = read_byte_argb(src_format, src_ptr);
+
+                    if (color_key && argb == color_key)
+                        argb &= 0x00ffffff;
+                    write_byte_argb(dst_format, argb, dst_ptr);
+                }
+                else if (!src_format->to_rgba && !dst_format->from_rgba
                         && src_format->bytes_per_pixel <= 4 && dst_format->bytes_per_pixel <= 4)
                 {
                     DWORD val;
@@ -1621,6 +1690,7 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
     struct argb_conversion_info conv_info, ck_conv_info;
     const struct pixel_format_desc *ck_format = NULL;
     DWORD channels[4];
+    BOOL byte_formats = is_byte_argb_format(src_format) && is_byte_argb_format(dst_format);
     UINT x, y, z;
 
     ZeroMemory(channels, sizeof(channels));
@@ -1647,7 +1717,15 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
             {
                 const BYTE *src_ptr = src_row_ptr + (x * src_size->width / dst_size->width) * src_format->bytes_per_pixel;
 
-                if (!src_format->to_rgba && !dst_format->from_rgba
+                if (byte_formats)
+                {
+                    DWORD argb = read_byte_argb(src_format, src_ptr);
+
+                    if (color_key && argb == color_key)
+                        argb &= 0x00ffffff;
+                    write_byte_argb(dst_format, argb, dst_ptr);
+                }
+                else if (!src_format->to_rgba && !dst_format->from_rgba
                         && src_format->bytes_per_pixel <= 4 && dst_format->bytes_per_pixel <= 4)
                 {
                     DWORD val;
@@ -1699,6 +1777,879 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
     }
 }
 
+#if defined(__GNUC__) && defined(__x86_64__)
+
+/*
+ * SSE2 is part of x86-64, so the conversions between packed ARGB and
+ * float rows can use it without checking the processor. The results are
+ * identical to the C code.
+ */
+#define HAVE_SSE_CONVERSION
+
+static inline void sse_argb_to_vec4(DWORD argb, struct vec4 *dst)
+{
+    static const float scale[4] = {1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
+
+    __asm__(
+        "movd %[argb], %%xmm0\n\t"
+        "pxor %%xmm1, %%xmm1\n\t"
+        "punpcklbw %%xmm1, %%xmm0\n\t"
+        "punpcklwd %%xmm1, %%xmm0\n\t"
+        "cvtdq2ps %%xmm0, %%xmm0\n\t"
+        "shufps $0xc6, %%xmm0, %%xmm0\n\t" /* BGRA to RGBA */
+        "mulps %[scale], %%xmm0\n\t"
+        "movups %%xmm0, %[dst]"
+        : [dst] "=m" (*dst)
+        : [argb] "r" (argb), [scale] "m" (scale)
+        : "xmm0", "xmm1");
+}
+
+/* Same rounding as float_to_byte: clamp, scale, add 0.5 and truncate. */
+static inline DWORD sse_vec4_to_argb(const struct vec4 *src)
+{
+    static const float consts[4][4] =
+    {
+        {0.0f, 0.0f, 0.0f, 0.0f},
+        {1.0f, 1.0f, 1.0f, 1.0f},
+        {255.0f, 255.0f, 255.0f, 255.0f},
+        {0.5f, 0.5f, 0.5f, 0.5f},
+    };
+    DWORD argb;
+
+    __asm__(
+        "movups %[src], %%xmm0\n\t"
+        "maxps %[zero], %%xmm0\n\t"
+        "minps %[one], %%xmm0\n\t"
+        "mulps %[scale], %%xmm0\n\t"
+        "addps %[half], %%xmm0\n\t"
+        "cvttps2dq %%xmm0, %%xmm0\n\t"
+        "shufps $0xc6, %%xmm0, %%xmm0\n\t" /* RGBA to BGRA */
+        "packssdw %%xmm0, %%xmm0\n\t"
+        "packuswb %%xmm0, %%xmm0\n\t"
+        "movd %%xmm0, %[argb]"
+        : [argb] "=r" (argb)
+        : [src] "m" (*src), [zero] "m" (consts[0]), [one] "m" (consts[1]),
+          [scale] "m" (consts[2]), [half] "m" (consts[3])
+        : "xmm0");
+    return argb;
+}
+
+#endif
+
+static void read_vec4_row(const BYTE *src, UINT width, const struct pixel_format_desc *format,
+        BOOL byte_format, D3DCOLOR color_key, const PALETTEENTRY *palette, struct vec4 *dst)
+{
+    const struct pixel_format_desc *ck_format = get_format_info(D3DFMT_A8R8G8B8);
+    UINT x;
+
+    for (x = 0; x < width; x++, src += format->bytes_per_pixel)
+    {
+        if (byte_format)
+        {
+            DWORD argb = read_byte_argb(format, src);
+
+            if (color_key && argb == color_key)
+                argb &= 0x00ffffff;
+#ifdef HAVE_SSE_CONVERSION
+            sse_argb_to_vec4(argb, &dst[x]);
+#else
+            dst[x].x = ((argb >> 16) & 0xff) * (1.0f / 255.0f);
+            dst[x].y = ((argb >> 8) & 0xff) * (1.0f / 255.0f);
+            dst[x].z = (argb & 0xff) * (1.0f / 255.0f);
+            dst[x].w = (argb >> 24) * (1.0f / 255.0f);
+#endif
+        }
+        else
+        {
+            struct vec4 color;
+
+            format_to_vec4(format, src, &color);
+            if (format->to_rgba)
+                format->to_rgba(&color, &dst[x], palette);
+            else
+                dst[x] = color;
+
+            if (color_key)
+            {
+                DWORD ck_pixel;
+
+                format_from_vec4(ck_format, &dst[x], (BYTE *)&ck_pixel);
+                if (ck_pixel == color_key)
+                    dst[x].w = 0.0f;
+            }
+        }
+    }
+}
+
+static inline BYTE float_to_byte(float f)
+{
+    if (f <= 0.0f) return 0;
+    if (f >= 1.0f) return 0xff;
+    return f * 255.0f + 0.5f;
+}
+
+static void write_vec4_row(const struct vec4 *src, UINT width, const struct pixel_format_desc *format,
+        BOOL byte_format, BYTE *dst)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, dst += format->bytes_per_pixel)
+    {
+        if (byte_format)
+        {
+#ifdef HAVE_SSE_CONVERSION
+            DWORD argb = sse_vec4_to_argb(&src[x]);
+#else
+            DWORD argb = float_to_byte(src[x].w) << 24 | float_to_byte(src[x].x) << 16
+                    | float_to_byte(src[x].y) << 8 | float_to_byte(src[x].z);
+#endif
+            write_byte_argb(format, argb, dst);
+        }
+        else if (format->from_rgba)
+        {
+            struct vec4 color;
+
+            format->from_rgba(&src[x], &color);
+            format_from_vec4(format, &color, dst);
+        }
+        else
+        {
+            format_from_vec4(format, &src[x], dst);
+        }
+    }
+}
+
+/* Source texels and weights contributing to each destination texel along one
+ * axis. Weights are normalized, texels outside the source are dropped. */
+struct filter_axis
+{
+    UINT taps;
+    UINT *first;
+    UINT *count;
+    float *weights;
+};
+
+static void free_filter_axis(struct filter_axis *axis)
+{
+    HeapFree(GetProcessHeap(), 0, axis->first);
+    HeapFree(GetProcessHeap(), 0, axis->count);
+    HeapFree(GetProcessHeap(), 0, axis->weights);
+}
+
+static BOOL init_filter_axis(struct filter_axis *axis, UINT src_len, UINT dst_len, DWORD filter)
+{
+    float scale = (float)src_len / dst_len;
+    float radius;
+    UINT i;
+
+    switch (filter & 0xf)
+    {
+        case D3DX_FILTER_BOX:
+            /* Each destination texel averages the source area it covers. */
+            radius = scale / 2.0f;
+            break;
+        case D3DX_FILTER_LINEAR:
+            radius = 1.0f;
+            break;
+        default:
+            /* Triangle: a tent as wide as the destination texel, and at least
+             * as wide as a source texel. */
+            radius = max(scale, 1.0f);
+            break;
+    }
+
+    axis->taps = (UINT)ceilf(2.0f * radius) + 1;
+    axis->first = HeapAlloc(GetProcessHeap(), 0, dst_len * sizeof(*axis->first));
+    axis->count = HeapAlloc(GetProcessHeap(), 0, dst_len * sizeof(*axis->count));
+    axis->weights = HeapAlloc(GetProcessHeap(), 0, dst_len * axis->taps * sizeof(*axis->weights));
+    if (!axis->first || !axis->count || !axis->weights)
+    {
+        free_filter_axis(axis);
+        return FALSE;
+    }
+
+    for (i = 0; i < dst_len; i++)
+    {
+        float center = (i + 0.5f) * scale - 0.5f;
+        float *weights = &axis->weights[i * axis->taps];
+        float total = 0.0f;
+        int j, lo, hi;
+        UINT count = 0;
+
+        lo = max((int)floorf(center - radius), 0);
+        hi = min((int)ceilf(center + radius), (int)src_len - 1);
+        axis->first[i] = lo;
+
+        for (j = lo; j <= hi && count < axis->taps; j++)
+        {
+            float w;
+
+            if ((filter & 0xf) == D3DX_FILTER_BOX)
+                w = min(j + 1.0f, center + 0.5f + radius) - max((float)j, center + 0.5f - radius);
+            else
+                w = 1.0f - fabsf(j - center) / radius;
+
+            if (w <= 0.0f)
+            {
+                if (!count)
+                    axis->first[i] = j + 1;
+                continue;
+            }
+            weights[count++] = w;
+            total += w;
+        }
+
+        /* Possible with tiny boxes falling between two texel centers. */
+        if (!count)
+        {
+            axis->first[i] = min(max((int)floorf(center + 0.5f), 0), (int)src_len - 1);
+            weights[count++] = total = 1.0f;
+        }
+
+        for (j = 0; j < count; j++)
+            weights[j] /= total;
+        axis->count[i] = count;
+    }
+
+    return TRUE;
+}
+
+/************************************************************
+ * filter_argb_pixels
+ *
+ * Copies the source buffer to the destination buffer, performing
+ * any necessary format conversion, color keying and stretching
+ * with a box, linear or triangle filter. The filter is separable:
+ * source rows are filtered horizontally once and kept in a small
+ * cache while the destination rows that need them are built.
+ */
+HRESULT filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pitch, const struct volume *src_size,
+        const struct pixel_format_desc *src_format, BYTE *dst, UINT dst_row_pitch, UINT dst_slice_pitch,
+        const struct volume *dst_size, const struct pixel_format_desc *dst_format, D3DCOLOR color_key,
+        const PALETTEENTRY *palette, DWORD filter)
+{
+    struct filter_axis x_axis, y_axis, z_axis;
+    BOOL src_byte_format = is_byte_argb_format(src_format);
+    BOOL dst_byte_format = is_byte_argb_format(dst_format);
+    struct vec4 *src_row = NULL, *cache = NULL, *dst_row = NULL;
+    UINT *cache_keys = NULL;
+    UINT x, y, z, i, j, k;
+    HRESULT hr = E_OUTOFMEMORY;
+
+    if (!init_filter_axis(&x_axis, src_size->width, dst_size->width, filter))
+        return E_OUTOFMEMORY;
+    if (!init_filter_axis(&y_axis, src_size->height, dst_size->height, filter))
+    {
+        free_filter_axis(&x_axis);
+        return E_OUTOFMEMORY;
+    }
+    if (!init_filter_axis(&z_axis, src_size->depth, dst_size->depth, filter))
+    {
+        free_filter_axis(&y_axis);
+        free_filter_axis(&x_axis);
+        return E_OUTOFMEMORY;
+    }
+
+    src_row = HeapAlloc(GetProcessHeap(), 0, src_size->width * sizeof(*src_row));
+    dst_row = HeapAlloc(GetProcessHeap(), 0, dst_size->width * sizeof(*dst_row));
+    cache = HeapAlloc(GetProcessHeap(), 0, y_axis.taps * dst_size->width * sizeof(*cache));
+    cache_keys = HeapAlloc(GetProcessHeap(), 0, y_axis.taps * sizeof(*cache_keys));
+    if (!src_row || !dst_row || !cache || !cache_keys)
+        goto done;
+    memset(cache_keys, 0xff, y_axis.taps * sizeof(*cache_keys));
+
+    for (z = 0; z < dst_size->depth; z++)
+    {
+        const float *z_weights = &z_axis.weights[z * z_axis.taps];
+
+        for (y = 0; y < dst_size->height; y++)
+        {
+            const float *y_weights = &y_axis.weights[y * y_axis.taps];
+
+            memset(dst_row, 0, dst_size->width * sizeof(*dst_row));
+
+            for (k = 0; k < z_axis.count[z]; k++)
+            {
+                UINT src_z = z_axis.first[z] + k;
+
+                for (j = 0; j < y_axis.count[y]; j++)
+                {
+                    UINT src_y = y_axis.first[y] + j;
+                    UINT key = src_z * src_size->height + src_y;
+                    struct vec4 *row = &cache[(key % y_axis.taps) * dst_size->width];
+                    float w = z_weights[k] * y_weights[j];
+
+                    if (cache_keys[key % y_axis.taps] != key)
+                    {
+                        read_vec4_row(src + src_z * src_slice_pitch + src_y * src_row_pitch, src_size->width,
+                                src_format, src_byte_format, color_key, palette, src_row);
+
+                        for (x = 0; x < dst_size->width; x++)
+                        {
+                            const float *x_weights = &x_axis.weights[x * x_axis.taps];
+                            const struct vec4 *s = &src_row[x_axis.first[x]];
+                            struct vec4 sum = {0.0f, 0.0f, 0.0f, 0.0f};
+
+                            for (i = 0; i < x_axis.count[x]; i++)
+                            {
+                                sum.x += x_weights[i] * s[i].x;
+                                sum.y += x_weights[i] * s[i].y;
+                                sum.z += x_weights[i] * s[i].z;
+                                sum.w += x_weights[i] * s[i].w;
+                            }
+                            row[x] = sum;
+                        }
+                        cache_keys[key % y_axis.taps] = key;
+                    }
+
+                    for (x = 0; x < dst_size->width; x++)
+                    {
+                        dst_row[x].x += w * row[x].x;
+                        dst_row[x].y += w * row[x].y;
+                        dst_row[x].z += w * row[x].z;
+                        dst_row[x].w += w * row[x].w;
+                    }
+                }
+            }
+
+            write_vec4_row(dst_row, dst_size->width, dst_format, dst_byte_format,
+                    dst + z * dst_slice_pitch + y * dst_row_pitch);
+        }
+    }
+    hr = D3D_OK;
+
+done:
+    HeapFree(GetProcessHeap(), 0, cache_keys);
+    HeapFree(GetProcessHeap(), 0, cache);
+    HeapFree(GetProcessHeap(), 0, dst_row);
+    HeapFree(GetProcessHeap(), 0, src_row);
+    free_filter_axis(&z_axis);
+    free_filter_axis(&y_axis);
+    free_filter_axis(&x_axis);
+    return hr;
+}
+
+/************************************************************
+ * DXTn (S3TC) block compression
+ *
+ * Blocks are decoded to and encoded from D3DFMT_A8R8G8B8 pixels.
+ */
+static void dxt_color_palette(WORD c0, WORD c1, BOOL four_colors, int palette[4][3])
+{
+    unsigned int c;
+
+    palette[0][0] = (c0 >> 11) << 3 | (c0 >> 13);
+    palette[0][1] = (c0 >> 5 & 0x3f) << 2 | (c0 >> 9 & 0x3);
+    palette[0][2] = (c0 & 0x1f) << 3 | (c0 >> 2 & 0x7);
+    palette[1][0] = (c1 >> 11) << 3 | (c1 >> 13);
+    palette[1][1] = (c1 >> 5 & 0x3f) << 2 | (c1 >> 9 & 0x3);
+    palette[1][2] = (c1 & 0x1f) << 3 | (c1 >> 2 & 0x7);
+
+    for (c = 0; c < 3; ++c)
+    {
+        if (four_colors)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+static void dxt5_alpha_palette(BYTE a0, BYTE a1, BYTE palette[8])
+{
+    unsigned int i;
+
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1)
+    {
+        for (i = 2; i < 8; ++i)
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    }
+    else
+    {
+        for (i = 2; i < 6; ++i)
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 0xff;
+    }
+}
+
+static void decode_dxt_block(D3DFORMAT format, const BYTE *block, DWORD *pixels)
+{
+    const BYTE *color_block = format == D3DFMT_DXT1 ? block : block + 8;
+    WORD c0 = color_block[0] | color_block[1] << 8;
+    WORD c1 = color_block[2] | color_block[3] << 8;
+    BOOL four_colors = format != D3DFMT_DXT1 || c0 > c1;
+    DWORD color_bits = color_block[4] | color_block[5] << 8 | color_block[6] << 16 | (DWORD)color_block[7] << 24;
+    int palette[4][3];
+    BYTE alpha[16];
+    unsigned int i;
+
+    dxt_color_palette(c0, c1, four_colors, palette);
+
+    switch (format)
+    {
+        case D3DFMT_DXT1:
+            for (i = 0; i < 16; ++i)
+                alpha[i] = (!four_colors && (color_bits >> (2 * i) & 3) == 3) ? 0 : 0xff;
+            break;
+
+        case D3DFMT_DXT2:
+        case D3DFMT_DXT3:
+            for (i = 0; i < 16; ++i)
+                alpha[i] = (block[i / 2] >> (4 * (i & 1)) & 0xf) * 0x11;
+            break;
+
+        default:
+        {
+            ULONGLONG alpha_bits = 0;
+            BYTE alpha_palette[8];
+
+            for (i = 0; i < 6; ++i)
+                alpha_bits |= (ULONGLONG)block[2 + i] << (8 * i);
+            dxt5_alpha_palette(block[0], block[1], alpha_palette);
+            for (i = 0; i < 16; ++i)
+                alpha[i] = alpha_palette[alpha_bits >> (3 * i) & 7];
+            break;
+        }
+    }
+
+    for (i = 0; i < 16; ++i)
+    {
+        const int *rgb = palette[color_bits >> (2 * i) & 3];
+        DWORD r = rgb[0], g = rgb[1], b = rgb[2];
+
+        if ((format == D3DFMT_DXT2 || format == D3DFMT_DXT4) && alpha[i] && alpha[i] != 0xff)
+        {
+            r = min(r * 0xff / alpha[i], 0xff);
+            g = min(g * 0xff / alpha[i], 0xff);
+            b = min(b * 0xff / alpha[i], 0xff);
+        }
+        pixels[i] = alpha[i] << 24 | r << 16 | g << 8 | b;
+    }
+}
+
+static WORD dxt_color_from_rgb(const float *rgb)
+{
+    int r = min(max((int)(rgb[0] * 31.0f / 255.0f + 0.5f), 0), 31);
+    int g = min(max((int)(rgb[1] * 63.0f / 255.0f + 0.5f), 0), 63);
+    int b = min(max((int)(rgb[2] * 31.0f / 255.0f + 0.5f), 0), 31);
+
+    return r << 11 | g << 5 | b;
+}
+
+/* Picks the nearest palette entry for each used pixel, and returns the total
+ * squared error. Unused (transparent) pixels get index 3. */
+static unsigned int dxt_color_indices(const int colors[16][3], const BOOL *used, WORD c0, WORD c1,
+        BOOL four_colors, DWORD *indices)
+{
+    unsigned int count = four_colors ? 4 : 3;
+    unsigned int error = 0;
+    int palette[4][3];
+    unsigned int i, j;
+
+    dxt_color_palette(c0, c1, four_colors, palette);
+
+    *indices = 0;
+    for (i = 0; i < 16; ++i)
+    {
+        unsigned int best = 3, best_error = ~0u;
+
+        if (!used[i])
+        {
+            *indices |= 3u << (2 * i);
+            continue;
+        }
+
+        for (j = 0; j < count; ++j)
+        {
+            int dr = colors[i][0] - palette[j][0];
+            int dg = colors[i][1] - palette[j][1];
+            int db = colors[i][2] - palette[j][2];
+            unsigned int e = dr * dr + dg * dg + db * db;
+
+            if (e < best_error)
+            {
+                best_error = e;
+                best = j;
+            }
+        }
+        *indices |= best << (2 * i);
+        error += best_error;
+    }
+
+    return error;
+}
+
+/* Orders the endpoints for the block mode and computes the indices. */
+static unsigned int dxt_fit_endpoints(const int colors[16][3], const BOOL *used, WORD a, WORD b,
+        BOOL four_colors, WORD *c0, WORD *c1, DWORD *indices)
+{
+    if (four_colors == (a < b))
+    {
+        WORD tmp = a;
+        a = b;
+        b = tmp;
+    }
+    *c0 = a;
+    *c1 = b;
+    /* Equal endpoints can only be decoded in three color mode, where the
+     * first two entries are the same anyway. */
+    return dxt_color_indices(colors, used, a, b, four_colors && a != b, indices);
+}
+
+static void encode_dxt_color_block(const DWORD *pixels, BOOL transparency, BOOL premultiplied, BYTE *block)
+{
+    static const float four_color_weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+    static const float three_color_weights[4] = {0.0f, 1.0f, 0.5f, 0.0f};
+    BOOL four_colors = TRUE;
+    int colors[16][3];
+    BOOL used[16];
+    float mean[3] = {0.0f, 0.0f, 0.0f}, cov[6] = {0.0f}, axis[3];
+    float lo[3], hi[3], min_proj = 0.0f, max_proj = 0.0f;
+    unsigned int count = 0, error, iter, i, c;
+    WORD c0, c1;
+    DWORD indices;
+
+    for (i = 0; i < 16; ++i)
+    {
+        DWORD a = pixels[i] >> 24;
+
+        colors[i][0] = pixels[i] >> 16 & 0xff;
+        colors[i][1] = pixels[i] >> 8 & 0xff;
+        colors[i][2] = pixels[i] & 0xff;
+        if (premultiplied)
+        {
+            for (c = 0; c < 3; ++c)
+                colors[i][c] = (colors[i][c] * a + 127) / 255;
+        }
+        used[i] = !transparency || a >= 0x80;
+        if (!used[i])
+        {
+            four_colors = FALSE;
+            continue;
+        }
+        for (c = 0; c < 3; ++c)
+            mean[c] += colors[i][c];
+        ++count;
+    }
+
+    if (!count)
+    {
+        block[0] = block[1] = block[2] = block[3] = 0;
+        block[4] = block[5] = block[6] = block[7] = 0xff;
+        return;
+    }
+
+    for (c = 0; c < 3; ++c)
+        mean[c] /= count;
+    for (i = 0; i < 16; ++i)
+    {
+        float d[3];
+
+        if (!used[i]) continue;
+        for (c = 0; c < 3; ++c)
+            d[c] = colors[i][c] - mean[c];
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+
+    /* Principal axis by power iteration, starting from the covariance row of
+     * the channel with the largest variance. */
+    if (cov[0] >= cov[3] && cov[0] >= cov[5])
+    {
+        axis[0] = cov[0];
+        axis[1] = cov[1];
+        axis[2] = cov[2];
+    }
+    else if (cov[3] >= cov[5])
+    {
+        axis[0] = cov[1];
+        axis[1] = cov[3];
+        axis[2] = cov[4];
+    }
+    else
+    {
+        axis[0] = cov[2];
+        axis[1] = cov[4];
+        axis[2] = cov[5];
+    }
+    for (iter = 0; iter < 8; ++iter)
+    {
+        float v[3], len;
+
+        v[0] = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        v[1] = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        v[2] = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        len = max(max(fabsf(v[0]), fabsf(v[1])), fabsf(v[2]));
+        if (len < 1e-6f)
+            break;
+        for (c = 0; c < 3; ++c)
+            axis[c] = v[c] / len;
+    }
+    {
+        float len = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        for (c = 0; c < 3; ++c)
+            axis[c] = len > 1e-6f ? axis[c] / len : 0.0f;
+    }
+
+    for (i = 0; i < 16; ++i)
+    {
+        float proj;
+
+        if (!used[i]) continue;
+        proj = (colors[i][0] - mean[0]) * axis[0] + (colors[i][1] - mean[1]) * axis[1]
+                + (colors[i][2] - mean[2]) * axis[2];
+        min_proj = min(min_proj, proj);
+        max_proj = max(max_proj, proj);
+    }
+    for (c = 0; c < 3; ++c)
+    {
+        lo[c] = mean[c] + axis[c] * min_proj;
+        hi[c] = mean[c] + axis[c] * max_proj;
+    }
+
+    error = dxt_fit_endpoints(colors, used, dxt_color_from_rgb(hi), dxt_color_from_rgb(lo),
+            four_colors, &c0, &c1, &indices);
+
+    /* Refine the endpoints with a least squares fit to the chosen indices. */
+    for (iter = 0; iter < 2 && error; ++iter)
+    {
+        const float *weights = four_colors ? four_color_weights : three_color_weights;
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f, ax[3] = {0.0f}, bx[3] = {0.0f}, det;
+        WORD new_c0, new_c1;
+        DWORD new_indices;
+        unsigned int new_error;
+
+        for (i = 0; i < 16; ++i)
+        {
+            float t, s;
+
+            if (!used[i]) continue;
+            t = weights[indices >> (2 * i) & 3];
+            s = 1.0f - t;
+            aa += s * s;
+            bb += t * t;
+            ab += s * t;
+            for (c = 0; c < 3; ++c)
+            {
+                ax[c] += s * colors[i][c];
+                bx[c] += t * colors[i][c];
+            }
+        }
+        det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+            break;
+
+        for (c = 0; c < 3; ++c)
+        {
+            lo[c] = (ax[c] * bb - bx[c] * ab) / det;
+            hi[c] = (bx[c] * aa - ax[c] * ab) / det;
+        }
+        new_error = dxt_fit_endpoints(colors, used, dxt_color_from_rgb(lo), dxt_color_from_rgb(hi),
+                four_colors, &new_c0, &new_c1, &new_indices);
+        if (new_error >= error)
+            break;
+        error = new_error;
+        c0 = new_c0;
+        c1 = new_c1;
+        indices = new_indices;
+    }
+
+    block[0] = c0 & 0xff;
+    block[1] = c0 >> 8;
+    block[2] = c1 & 0xff;
+    block[3] = c1 >> 8;
+    block[4] = indices & 0xff;
+    block[5] = indices >> 8 & 0xff;
+    block[6] = indices >> 16 & 0xff;
+    block[7] = indices >> 24;
+}
+
+static void encode_dxt5_alpha_block(const DWORD *pixels, BYTE *block)
+{
+    BYTE a0 = 0, a1 = 0xff, palette[8];
+    ULONGLONG bits = 0;
+    unsigned int i, j;
+
+    for (i = 0; i < 16; ++i)
+    {
+        BYTE a = pixels[i] >> 24;
+        a0 = max(a0, a);
+        a1 = min(a1, a);
+    }
+
+    block[0] = a0;
+    block[1] = a1;
+    if (a0 != a1)
+    {
+        dxt5_alpha_palette(a0, a1, palette);
+        for (i = 0; i < 16; ++i)
+        {
+            int a = pixels[i] >> 24;
+            unsigned int best = 0, best_error = ~0u;
+
+            for (j = 0; j < 8; ++j)
+            {
+                unsigned int e = abs(a - palette[j]);
+                if (e < best_error)
+                {
+                    best_error = e;
+                    best = j;
+                }
+            }
+            bits |= (ULONGLONG)best << (3 * i);
+        }
+    }
+    for (i = 0; i < 6; ++i)
+        block[2 + i] = bits >> (8 * i) & 0xff;
+}
+
+static void encode_dxt_block(D3DFORMAT format, const DWORD *pixels, BYTE *block)
+{
+    unsigned int i;
+
+    switch (format)
+    {
+        case D3DFMT_DXT1:
+            encode_dxt_color_block(pixels, TRUE, FALSE, block);
+            return;
+
+        case D3DFMT_DXT2:
+        case D3DFMT_DXT3:
+            for (i = 0; i < 8; ++i)
+                block[i] = ((pixels[2 * i] >> 24) * 15 + 127) / 255
+                        | (((pixels[2 * i + 1] >> 24) * 15 + 127) / 255) << 4;
+            break;
+
+        default:
+            encode_dxt5_alpha_block(pixels, block);
+            break;
+    }
+    encode_dxt_color_block(pixels, FALSE, format == D3DFMT_DXT2 || format == D3DFMT_DXT4, block + 8);
+}
+
+/* Decodes the blocks covering width x height pixels into A8R8G8B8 pixels. The
+ * destination must hold whole blocks. */
+static void decode_dxt_pixels(const BYTE *src, UINT src_pitch, BYTE *dst, UINT dst_pitch,
+        UINT width, UINT height, const struct pixel_format_desc *format)
+{
+    UINT x, y, i;
+
+    for (y = 0; y < height; y += 4)
+    {
+        const BYTE *block = src + (y / 4) * src_pitch;
+
+        for (x = 0; x < width; x += 4, block += format->block_byte_count)
+        {
+            DWORD pixels[16];
+
+            decode_dxt_block(format->format, block, pixels);
+            for (i = 0; i < 4; ++i)
+                memcpy(dst + (y + i) * dst_pitch + x * sizeof(DWORD), &pixels[i * 4], 4 * sizeof(DWORD));
+        }
+    }
+}
+
+/* Large surfaces are split into horizontal bands of blocks, each encoded by
+ * its own thread. */
+#define DXT_MAX_THREADS 8
+#define DXT_MIN_BLOCKS_PER_THREAD 1024
+
+struct dxt_encode_job
+{
+    const BYTE *src;
+    UINT src_pitch;
+    BYTE *dst;
+    UINT dst_pitch;
+    UINT block_columns;
+    UINT first_row;
+    UINT row_count;
+    const struct pixel_format_desc *format;
+};
+
+static void encode_dxt_rows(const struct dxt_encode_job *job)
+{
+    UINT row, column, i;
+
+    for (row = job->first_row; row < job->first_row + job->row_count; ++row)
+    {
+        const BYTE *src = job->src + row * 4 * job->src_pitch;
+        BYTE *block = job->dst + row * job->dst_pitch;
+
+        for (column = 0; column < job->block_columns; ++column, block += job->format->block_byte_count)
+        {
+            DWORD pixels[16];
+
+            for (i = 0; i < 4; ++i)
+                memcpy(&pixels[i * 4], src + i * job->src_pitch + column * 4 * sizeof(DWORD), 4 * sizeof(DWORD));
+            encode_dxt_block(job->format->format, pixels, block);
+        }
+    }
+}
+
+static DWORD WINAPI encode_dxt_thread(void *arg)
+{
+    encode_dxt_rows(arg);
+    return 0;
+}
+
+/* Encodes A8R8G8B8 pixels into blocks. The source must hold whole blocks. */
+static void encode_dxt_pixels(const BYTE *src, UINT src_pitch, BYTE *dst, UINT dst_pitch,
+        UINT width, UINT height, const struct pixel_format_desc *format)
+{
+    struct dxt_encode_job jobs[DXT_MAX_THREADS];
+    HANDLE threads[DXT_MAX_THREADS];
+    UINT block_columns = (width + 3) / 4, block_rows = (height + 3) / 4;
+    UINT thread_count, handle_count = 0, row = 0, i;
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    thread_count = min(info.dwNumberOfProcessors, DXT_MAX_THREADS);
+    thread_count = min(thread_count, block_columns * block_rows / DXT_MIN_BLOCKS_PER_THREAD);
+    thread_count = max(min(thread_count, block_rows), 1);
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        jobs[i].src = src;
+        jobs[i].src_pitch = src_pitch;
+        jobs[i].dst = dst;
+        jobs[i].dst_pitch = dst_pitch;
+        jobs[i].block_columns = block_columns;
+        jobs[i].first_row = row;
+        jobs[i].row_count = block_rows * (i + 1) / thread_count - row;
+        jobs[i].format = format;
+        row += jobs[i].row_count;
+    }
+
+    /* The calling thread takes the first band. */
+    for (i = 1; i < thread_count; ++i)
+    {
+        if ((threads[handle_count] = CreateThread(NULL, 0, encode_dxt_thread, &jobs[i], 0, NULL)))
+            ++handle_count;
+        else
+            encode_dxt_rows(&jobs[i]);
+    }
+    encode_dxt_rows(&jobs[0]);
+
+    if (handle_count)
+    {
+        WaitForMultipleObjects(handle_count, threads, TRUE, INFINITE);
+        for (i = 0; i < handle_count; ++i)
+            CloseHandle(threads[i]);
+    }
+}
+
 /************************************************************
  * D3DXLoadSurfaceFromMemory
  *
@@ -1821,33 +2772,107 @@ HRESULT WINAPI D3DXLoadSurfaceFromMemory(IDirect3DSurface9 *dst_surface,
     }
     else /* Stretching or format conversion. */
     {
-        if (((srcformatdesc->type != FORMAT_ARGB) && (srcformatdesc->type != FORMAT_INDEX)) ||
-            (destformatdesc->type != FORMAT_ARGB))
+        const struct pixel_format_desc *argb_format = get_format_info(D3DFMT_A8R8G8B8);
+        BYTE *src_pixels = NULL, *dst_pixels = NULL, *dst_addr;
+        UINT dst_pitch;
+        HRESULT hr = D3D_OK;
+
+        if ((srcformatdesc->type != FORMAT_ARGB && srcformatdesc->type != FORMAT_INDEX
+                && srcformatdesc->type != FORMAT_DXT)
+                || (destformatdesc->type != FORMAT_ARGB && destformatdesc->type != FORMAT_DXT))
         {
             FIXME("Format conversion missing %#x -> %#x\n", src_format, surfdesc.Format);
             return E_NOTIMPL;
         }
 
+        if (srcformatdesc->type == FORMAT_DXT)
+        {
+            UINT width = (src_size.width + 3) & ~3, height = (src_size.height + 3) & ~3;
+
+            if (!(src_pixels = HeapAlloc(GetProcessHeap(), 0, width * height * sizeof(DWORD))))
+                return E_OUTOFMEMORY;
+            decode_dxt_pixels(src_memory, src_pitch, src_pixels, width * sizeof(DWORD),
+                    src_size.width, src_size.height, srcformatdesc);
+            src_memory = src_pixels;
+            src_pitch = width * sizeof(DWORD);
+            srcformatdesc = argb_format;
+        }
+
         if (FAILED(IDirect3DSurface9_LockRect(dst_surface, &lockrect, dst_rect, 0)))
+        {
+            HeapFree(GetProcessHeap(), 0, src_pixels);
             return D3DXERR_INVALIDDATA;
+        }
+
+        if (destformatdesc->type == FORMAT_DXT)
+        {
+            dst_pitch = ((dst_size.width + 3) & ~3) * sizeof(DWORD);
+            if (!(dst_pixels = HeapAlloc(GetProcessHeap(), 0, dst_pitch * ((dst_size.height + 3) & ~3))))
+            {
+                IDirect3DSurface9_UnlockRect(dst_surface);
+                HeapFree(GetProcessHeap(), 0, src_pixels);
+                return E_OUTOFMEMORY;
+            }
+            dst_addr = dst_pixels;
+        }
+        else
+        {
+            dst_pitch = lockrect.Pitch;
+            dst_addr = lockrect.pBits;
+        }
 
         if ((filter & 0xf) == D3DX_FILTER_NONE)
         {
             convert_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
-                    lockrect.pBits, lockrect.Pitch, 0, &dst_size, destformatdesc, color_key, src_palette);
+                    dst_addr, dst_pitch, 0, &dst_size, dst_pixels ? argb_format : destformatdesc,
+                    color_key, src_palette);
+        }
+        else if ((filter & 0xf) == D3DX_FILTER_POINT
+                || (src_size.width == dst_size.width && src_size.height == dst_size.height))
+        {
+            point_filter_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
+                    dst_addr, dst_pitch, 0, &dst_size, dst_pixels ? argb_format : destformatdesc,
+                    color_key, src_palette);
         }
-        else /* if ((filter & 0xf) == D3DX_FILTER_POINT) */
+        else
         {
-            if ((filter & 0xf) != D3DX_FILTER_POINT)
+            if ((filter & 0xf) > D3DX_FILTER_BOX)
                 FIXME("Unhandled filter %#x.\n", filter);
 
-            /* Always apply a point filter until D3DX_FILTER_LINEAR,
-             * D3DX_FILTER_TRIANGLE and D3DX_FILTER_BOX are implemented. */
-            point_filter_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
-                    lockrect.pBits, lockrect.Pitch, 0, &dst_size, destformatdesc, color_key, src_palette);
+            hr = filter_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
+                    dst_addr, dst_pitch, 0, &dst_size, dst_pixels ? argb_format : destformatdesc,
+                    color_key, src_palette, filter);
+        }
+
+        if (dst_pixels)
+        {
+            if (SUCCEEDED(hr))
+            {
+                UINT width = (dst_size.width + 3) & ~3, height = (dst_size.height + 3) & ~3;
+                UINT x, y;
+
+                /* Pad partial blocks by repeating the edge pixels. */
+                for (y = 0; y < height; ++y)
+                {
+                    DWORD *row = (DWORD *)(dst_pixels + y * dst_pitch);
+
+                    if (y >= dst_size.height)
+                        memcpy(row, dst_pixels + (dst_size.height - 1) * dst_pitch, dst_pitch);
+                    else
+                        for (x = dst_size.width; x < width; ++x)
+                            row[x] = row[dst_size.width - 1];
+                }
+
+                encode_dxt_pixels(dst_pixels, dst_pitch, lockrect.pBits, lockrect.Pitch,
+                        dst_size.width, dst_size.height, destformatdesc);
+            }
+            HeapFree(GetProcessHeap(), 0, dst_pixels);
         }
 
         IDirect3DSurface9_UnlockRect(dst_surface);
+        HeapFree(GetProcessHeap(), 0, src_pixels);
+        if (FAILED(hr))
+            return hr;
     }
 
     return D3D_OK;
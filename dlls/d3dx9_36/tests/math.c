@@ -21,6 +21,7 @@
 
 #include "wine/test.h"
 #include "d3dx9.h"
+#include <limits.h>
 #include <math.h>
 
 #define ARRAY_SIZE 5
@@ -29,6 +30,22 @@
 
 #define relative_error(exp, out) (fabsf(exp) < 1e-38f ? fabsf(exp - out) : fabsf(1.0f - (out) / (exp)))
 
+static BOOL compare_float(float f, float g, unsigned int ulps)
+{
+    int x = *(int *)&f;
+    int y = *(int *)&g;
+
+    if (x < 0)
+        x = INT_MIN - x;
+    if (y < 0)
+        y = INT_MIN - y;
+
+    if (abs(x - y) > ulps)
+        return FALSE;
+
+    return TRUE;
+}
+
 #define expect_color(expectedcolor,gotcolor) ok((relative_error(expectedcolor.r, gotcolor.r)<admitted_error)&&(relative_error(expectedcolor.g, gotcolor.g)<admitted_error)&&(relative_error(expectedcolor.b, gotcolor.b)<admitted_error)&&(relative_error(expectedcolor.a, gotcolor.a)<admitted_error),"Expected Color= (%f, %f, %f, %f)\n , Got Color= (%f, %f, %f, %f)\n", expectedcolor.r, expectedcolor.g, expectedcolor.b, expectedcolor.a, gotcolor.r, gotcolor.g, gotcolor.b, gotcolor.a);
 
 static inline BOOL compare_matrix(const D3DXMATRIX *m1, const D3DXMATRIX *m2)
@@ -2337,6 +2354,102 @@ static void test_D3DXVec_Array(void)
     compare_planes(exp_plane, out_plane);
 }
 
+static void test_D3DXVec_Array_strides(void)
+{
+    static const D3DXMATRIX affine =
+    {{{
+        2.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 4.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 8.0f, 0.0f,
+        1.0f, 2.0f, 3.0f, 1.0f,
+    }}};
+    static const D3DXMATRIX affine_inv =
+    {{{
+        0.5f, 0.0f,   0.0f,    0.0f,
+        0.0f, 0.25f,  0.0f,    0.0f,
+        0.0f, 0.0f,   0.125f,  0.0f,
+       -0.5f, -0.5f, -0.375f,  1.0f,
+    }}};
+    D3DXVECTOR3 in3[17], out3[17], exp3;
+    D3DXVECTOR4 in4[17], out4[17], exp4;
+    D3DXMATRIX mat, inv, prod;
+    unsigned int i, j;
+    BOOL equal;
+
+    D3DXMatrixPerspectiveFovLH(&mat, D3DX_PI / 3.0f, 4.0f / 3.0f, 0.5f, 100.0f);
+    U(mat).m[3][0] = 1.5f; U(mat).m[3][1] = -2.25f;
+    for (i = 0; i < 17; ++i)
+    {
+        in3[i].x = in4[i].x = i * 0.37f - 3.0f;
+        in3[i].y = in4[i].y = 2.0f - i * 0.21f;
+        in3[i].z = in4[i].z = 1.0f + i * 0.53f;
+        in4[i].w = 1.0f - i * 0.125f;
+    }
+
+    /* tightly packed vectors */
+    D3DXVec3TransformCoordArray(out3, sizeof(*out3), in3, sizeof(*in3), &mat, 17);
+    for (i = 0; i < 17; ++i)
+    {
+        D3DXVec3TransformCoord(&exp3, &in3[i], &mat);
+        ok(compare_float(exp3.x, out3[i].x, 4) && compare_float(exp3.y, out3[i].y, 4)
+                && compare_float(exp3.z, out3[i].z, 4),
+                "%u: Got (%.8e, %.8e, %.8e), expected (%.8e, %.8e, %.8e).\n", i,
+                out3[i].x, out3[i].y, out3[i].z, exp3.x, exp3.y, exp3.z);
+    }
+
+    D3DXVec3TransformArray(out4, sizeof(*out4), in3, sizeof(*in3), &mat, 17);
+    for (i = 0; i < 17; ++i)
+    {
+        D3DXVec3Transform(&exp4, &in3[i], &mat);
+        ok(compare_float(exp4.x, out4[i].x, 4) && compare_float(exp4.y, out4[i].y, 4)
+                && compare_float(exp4.z, out4[i].z, 4) && compare_float(exp4.w, out4[i].w, 4),
+                "%u: Got (%.8e, %.8e, %.8e, %.8e), expected (%.8e, %.8e, %.8e, %.8e).\n", i,
+                out4[i].x, out4[i].y, out4[i].z, out4[i].w, exp4.x, exp4.y, exp4.z, exp4.w);
+    }
+
+    /* in place */
+    memcpy(out4, in4, sizeof(in4));
+    D3DXVec4TransformArray(out4, sizeof(*out4), out4, sizeof(*out4), &mat, 17);
+    for (i = 0; i < 17; ++i)
+    {
+        D3DXVec4Transform(&exp4, &in4[i], &mat);
+        ok(compare_float(exp4.x, out4[i].x, 4) && compare_float(exp4.y, out4[i].y, 4)
+                && compare_float(exp4.z, out4[i].z, 4) && compare_float(exp4.w, out4[i].w, 4),
+                "%u: Got (%.8e, %.8e, %.8e, %.8e), expected (%.8e, %.8e, %.8e, %.8e).\n", i,
+                out4[i].x, out4[i].y, out4[i].z, out4[i].w, exp4.x, exp4.y, exp4.z, exp4.w);
+    }
+
+    /* every other element */
+    memset(out4, 0, sizeof(out4));
+    D3DXVec4TransformArray(out4, 2 * sizeof(*out4), in4, 2 * sizeof(*in4), &mat, 9);
+    for (i = 0; i < 17; ++i)
+    {
+        if (i & 1)
+        {
+            ok(!out4[i].x && !out4[i].y && !out4[i].z && !out4[i].w, "%u: Element was written.\n", i);
+            continue;
+        }
+        D3DXVec4Transform(&exp4, &in4[i], &mat);
+        ok(compare_float(exp4.x, out4[i].x, 4) && compare_float(exp4.w, out4[i].w, 4),
+                "%u: Got (%.8e, %.8e), expected (%.8e, %.8e).\n", i, out4[i].x, out4[i].w, exp4.x, exp4.w);
+    }
+
+    D3DXMatrixInverse(&inv, NULL, &affine);
+    equal = TRUE;
+    for (i = 0; i < 4; ++i)
+        for (j = 0; j < 4; ++j)
+            equal = equal && compare_float(U(inv).m[i][j], U(affine_inv).m[i][j], 1);
+    ok(equal, "Got unexpected inverse.\n");
+
+    ok(D3DXMatrixInverse(&inv, NULL, &mat) == &inv, "Failed to invert the matrix.\n");
+    D3DXMatrixMultiply(&prod, &mat, &inv);
+    equal = TRUE;
+    for (i = 0; i < 4; ++i)
+        for (j = 0; j < 4; ++j)
+            equal = equal && fabsf(U(prod).m[i][j] - (i == j ? 1.0f : 0.0f)) < 1e-5f;
+    ok(equal, "Product with the inverse is not the identity.\n");
+}
+
 static void test_D3DXFloat_Array(void)
 {
     static const float z = 0.0f;
@@ -3391,6 +3504,7 @@ START_TEST(math)
     test_Matrix_Decompose();
     test_Matrix_Transformation2D();
     test_D3DXVec_Array();
+    test_D3DXVec_Array_strides();
     test_D3DXFloat_Array();
     test_D3DXSHAdd();
     test_D3DXSHDot();
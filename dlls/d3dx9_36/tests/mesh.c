@@ -4361,6 +4361,12 @@ static void D3DXGenerateAdjacencyTest(void)
             0.354, /* > sqrt(0.25*0.25 + 0.25*0.25) */
             {-1, -1, 1,  0, -1, -1},
         },
+        { /* coincident vertices on either side of zero */
+            6, {{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {1.0, 1.0, 0.0}, {-0.005, 0.0, 0.0}, {1.0, 0.995, 0.0}, {0.0, 1.0, 0.0}},
+            2, {0, 1, 2,  3, 4, 5},
+            0.01,
+            {-1, -1, 1,  0, -1, -1},
+        },
         { /* adjacent faces must have opposite winding orders at the shared edge */
             4, {{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {1.0, 1.0, 0.0}, {0.0, 1.0, 0.0}},
             2, {0, 1, 2,  0, 3, 2},
@@ -10134,6 +10140,34 @@ cleanup:
     free_test_context(test_context);
 }
 
+/* Average cache miss ratio, the number of vertex cache misses per face, with
+ * a FIFO cache as found in most hardware. */
+static float compute_acmr(const DWORD *indices, const DWORD *face_remap, UINT num_faces, UINT cache_size)
+{
+    DWORD cache[32];
+    UINT count = 0, head = 0, misses = 0;
+    UINT i, j, k;
+
+    for (i = 0; i < num_faces; i++)
+    {
+        const DWORD *face = indices + face_remap[i] * 3;
+
+        for (j = 0; j < 3; j++)
+        {
+            for (k = 0; k < count; k++)
+                if (cache[k] == face[j]) break;
+            if (k < count) continue;
+
+            misses++;
+            cache[head] = face[j];
+            head = (head + 1) % cache_size;
+            if (count < cache_size) count++;
+        }
+    }
+
+    return (float)misses / num_faces;
+}
+
 static void test_optimize_faces(void)
 {
     HRESULT hr;
@@ -10286,6 +10320,327 @@ static void test_optimize_faces(void)
                            &smallest_face_remap);
     ok(hr == D3DERR_INVALIDCALL, "D3DXOptimizeFaces should not accept 2^15 "
     "faces when using 16-bit indices. Got %x\n, expected D3DERR_INVALIDCALL\n", hr);
+
+    /* A 24x24 grid whose faces are listed in a scrambled order */
+    {
+        const UINT grid_size = 24;
+        const UINT num_faces = grid_size * grid_size * 2;
+        const UINT num_vertices = (grid_size + 1) * (grid_size + 1);
+        DWORD *indices = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*indices));
+        DWORD *face_remap = HeapAlloc(GetProcessHeap(), 0, num_faces * sizeof(*face_remap));
+        BYTE *seen = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, num_faces);
+        float acmr_before, acmr_after;
+        UINT valid = 0;
+
+        for (i = 0; i < num_faces; i++)
+        {
+            DWORD scrambled = i * 709 % num_faces;
+            DWORD quad = scrambled / 2;
+            DWORD v = quad / grid_size * (grid_size + 1) + quad % grid_size;
+            DWORD *face = indices + i * 3;
+
+            if (scrambled % 2)
+            {
+                face[0] = v; face[1] = v + 1; face[2] = v + grid_size + 1;
+            }
+            else
+            {
+                face[0] = v + 1; face[1] = v + grid_size + 2; face[2] = v + grid_size + 1;
+            }
+            face_remap[i] = i;
+        }
+        acmr_before = compute_acmr(indices, face_remap, num_faces, 16);
+
+        hr = D3DXOptimizeFaces(indices, num_faces, num_vertices, TRUE, face_remap);
+        ok(hr == D3D_OK, "D3DXOptimizeFaces failed, hr %#x.\n", hr);
+
+        for (i = 0; i < num_faces; i++)
+        {
+            if (face_remap[i] < num_faces && !seen[face_remap[i]])
+            {
+                seen[face_remap[i]] = 1;
+                valid++;
+            }
+        }
+        ok(valid == num_faces, "Face remap is not a permutation.\n");
+
+        acmr_after = compute_acmr(indices, face_remap, num_faces, 16);
+        ok(acmr_after < 1.0f && acmr_after < acmr_before,
+           "Got ACMR %.3f after optimization, %.3f before.\n", acmr_after, acmr_before);
+
+        HeapFree(GetProcessHeap(), 0, seen);
+        HeapFree(GetProcessHeap(), 0, face_remap);
+        HeapFree(GetProcessHeap(), 0, indices);
+    }
+}
+
+static void test_optimize_vertices(void)
+{
+    static const DWORD indices0[] = {0, 1, 2};
+    static const DWORD exp_vertex_remap0[] = {0, 1, 2};
+    static const WORD indices1[] = {3, 1, 4, 1, 0, 4};
+    static const DWORD exp_vertex_remap1[] = {3, 1, 4, 0, 2};
+    static const DWORD indices2[] = {2, 0, 1};
+    static const DWORD exp_vertex_remap2[] = {2, 0, 1};
+    DWORD vertex_remap[5];
+    HRESULT hr;
+    UINT i;
+
+    hr = D3DXOptimizeVertices(indices0, 1, 3, TRUE, vertex_remap);
+    ok(hr == D3D_OK, "D3DXOptimizeVertices failed, hr %#x.\n", hr);
+    for (i = 0; i < ARRAY_SIZE(exp_vertex_remap0); i++)
+        ok(vertex_remap[i] == exp_vertex_remap0[i], "Got vertex %u at %u, expected %u.\n",
+           vertex_remap[i], i, exp_vertex_remap0[i]);
+
+    hr = D3DXOptimizeVertices(indices1, 2, 5, FALSE, vertex_remap);
+    ok(hr == D3D_OK, "D3DXOptimizeVertices failed, hr %#x.\n", hr);
+    for (i = 0; i < ARRAY_SIZE(exp_vertex_remap1); i++)
+        ok(vertex_remap[i] == exp_vertex_remap1[i], "Got vertex %u at %u, expected %u.\n",
+           vertex_remap[i], i, exp_vertex_remap1[i]);
+
+    /* vertex_remap holds the old index of each new vertex, not the other way round */
+    hr = D3DXOptimizeVertices(indices2, 1, 3, TRUE, vertex_remap);
+    ok(hr == D3D_OK, "D3DXOptimizeVertices failed, hr %#x.\n", hr);
+    for (i = 0; i < ARRAY_SIZE(exp_vertex_remap2); i++)
+        ok(vertex_remap[i] == exp_vertex_remap2[i], "Got vertex %u at %u, expected %u.\n",
+           vertex_remap[i], i, exp_vertex_remap2[i]);
+
+    hr = D3DXOptimizeVertices(indices0, 1, 3, TRUE, NULL);
+    ok(hr == D3DERR_INVALIDCALL, "Got unexpected hr %#x.\n", hr);
+}
+
+static void test_optimize_inplace(void)
+{
+    static const D3DVERTEXELEMENT9 declaration[] =
+    {
+        {0, 0, D3DDECLTYPE_FLOAT3, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0},
+        D3DDECL_END()
+    };
+    static const struct
+    {
+        DWORD flags;
+        BOOL presort; /* sort by attribute beforehand, so the mesh has an attribute table */
+    }
+    tc[] =
+    {
+        {D3DXMESHOPT_ATTRSORT, FALSE},
+        {D3DXMESHOPT_ATTRSORT | D3DXMESHOPT_VERTEXCACHE, FALSE},
+        {D3DXMESHOPT_ATTRSORT | D3DXMESHOPT_STRIPREORDER, FALSE},
+        {D3DXMESHOPT_VERTEXCACHE, TRUE},
+        {D3DXMESHOPT_STRIPREORDER, TRUE},
+        {D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_IGNOREVERTS, TRUE},
+    };
+    /* A grid of 4x3 vertices with 12 faces, listed in a scrambled order with
+     * interleaved attributes. The vertices are scrambled as well. */
+    const DWORD grid_width = 4, grid_height = 3;
+    const DWORD num_faces = (grid_width - 1) * (grid_height - 1) * 2;
+    const DWORD num_vertices = grid_width * grid_height;
+    const DWORD options = D3DXMESH_32BIT | D3DXMESH_SYSTEMMEM;
+    D3DXVECTOR3 vertices[12], old_vertices[12], *new_vertices;
+    DWORD indices[36], old_indices[36], *new_indices;
+    DWORD attributes[12], old_attributes[12], *new_attributes;
+    DWORD adjacency[36], adjacency_out[36], face_remap[12];
+    D3DXATTRIBUTERANGE attrib_table[12];
+    DWORD attrib_table_size, *vertex_remap;
+    struct test_context *test_context;
+    ID3DXBuffer *vertex_remap_buffer;
+    ID3DXMesh *mesh;
+    BOOL seen[12], boundary;
+    DWORD i, j, k;
+    HRESULT hr;
+
+    for (i = 0; i < num_vertices; i++)
+    {
+        DWORD point = i * 7 % num_vertices;
+
+        vertices[i].x = point % grid_width;
+        vertices[i].y = point / grid_width;
+        vertices[i].z = 0.0f;
+    }
+    for (i = 0; i < num_faces; i++)
+    {
+        DWORD face = i * 5 % num_faces, quad = face / 2;
+        DWORD point = quad / (grid_width - 1) * grid_width + quad % (grid_width - 1);
+        DWORD corners[3];
+
+        if (face % 2)
+        {
+            corners[0] = point; corners[1] = point + 1; corners[2] = point + grid_width;
+        }
+        else
+        {
+            corners[0] = point + 1; corners[1] = point + grid_width + 1; corners[2] = point + grid_width;
+        }
+        /* vertex v holds grid point v * 7 % 12, 7 * 7 % 12 == 1 */
+        for (j = 0; j < 3; j++)
+            indices[i * 3 + j] = corners[j] * 7 % num_vertices;
+        attributes[i] = i % 3;
+    }
+
+    test_context = new_test_context();
+    if (!test_context)
+    {
+        skip("Couldn't create test context\n");
+        return;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(tc); i++)
+    {
+        hr = init_test_mesh(num_faces, num_vertices, options, declaration, test_context->device, &mesh,
+                            vertices, sizeof(*vertices), indices, attributes);
+        if (FAILED(hr))
+        {
+            skip("Couldn't initialize test mesh %u, hr %#x.\n", i, hr);
+            break;
+        }
+        if (tc[i].presort)
+        {
+            hr = mesh->lpVtbl->OptimizeInplace(mesh, D3DXMESHOPT_ATTRSORT | D3DXMESHOPT_IGNOREVERTS,
+                                               NULL, NULL, NULL, NULL);
+            ok(hr == D3D_OK, "Test %u: Failed to sort the mesh, hr %#x.\n", i, hr);
+        }
+
+        hr = mesh->lpVtbl->GenerateAdjacency(mesh, 0.0f, adjacency);
+        ok(hr == D3D_OK, "Test %u: GenerateAdjacency failed, hr %#x.\n", i, hr);
+        for (j = 0, boundary = FALSE; j < num_faces * 3; j++)
+            if (adjacency[j] == ~0u) boundary = TRUE;
+        ok(boundary, "Test %u: Expected boundary edges.\n", i);
+
+        mesh->lpVtbl->LockVertexBuffer(mesh, D3DLOCK_READONLY, (void **)&new_vertices);
+        memcpy(old_vertices, new_vertices, sizeof(old_vertices));
+        mesh->lpVtbl->UnlockVertexBuffer(mesh);
+        mesh->lpVtbl->LockIndexBuffer(mesh, D3DLOCK_READONLY, (void **)&new_indices);
+        memcpy(old_indices, new_indices, sizeof(old_indices));
+        mesh->lpVtbl->UnlockIndexBuffer(mesh);
+        mesh->lpVtbl->LockAttributeBuffer(mesh, D3DLOCK_READONLY, &new_attributes);
+        memcpy(old_attributes, new_attributes, sizeof(old_attributes));
+        mesh->lpVtbl->UnlockAttributeBuffer(mesh);
+
+        memset(adjacency_out, 0xcc, sizeof(adjacency_out));
+        memset(face_remap, 0xcc, sizeof(face_remap));
+        vertex_remap_buffer = NULL;
+        hr = mesh->lpVtbl->OptimizeInplace(mesh, tc[i].flags, adjacency, adjacency_out, face_remap,
+                                           &vertex_remap_buffer);
+        ok(hr == D3D_OK, "Test %u: OptimizeInplace failed, hr %#x.\n", i, hr);
+        if (FAILED(hr))
+        {
+            mesh->lpVtbl->Release(mesh);
+            continue;
+        }
+        ok(mesh->lpVtbl->GetNumFaces(mesh) == num_faces, "Test %u: Got %u faces.\n",
+           i, mesh->lpVtbl->GetNumFaces(mesh));
+        ok(mesh->lpVtbl->GetNumVertices(mesh) == num_vertices, "Test %u: Got %u vertices.\n",
+           i, mesh->lpVtbl->GetNumVertices(mesh));
+
+        /* face_remap holds the old index of each new face */
+        memset(seen, 0, sizeof(seen));
+        for (j = 0; j < num_faces; j++)
+        {
+            ok(face_remap[j] < num_faces && !seen[face_remap[j]],
+               "Test %u: Got face %u at %u.\n", i, face_remap[j], j);
+            if (face_remap[j] < num_faces) seen[face_remap[j]] = TRUE;
+            else face_remap[j] = 0;
+        }
+
+        /* and vertex_remap the old index of each new vertex */
+        ok(vertex_remap_buffer != NULL, "Test %u: Got no vertex remap.\n", i);
+        if (!vertex_remap_buffer)
+        {
+            mesh->lpVtbl->Release(mesh);
+            continue;
+        }
+        ok(ID3DXBuffer_GetBufferSize(vertex_remap_buffer) == num_vertices * sizeof(DWORD),
+           "Test %u: Got vertex remap size %u.\n", i, ID3DXBuffer_GetBufferSize(vertex_remap_buffer));
+        vertex_remap = ID3DXBuffer_GetBufferPointer(vertex_remap_buffer);
+        memset(seen, 0, sizeof(seen));
+        for (j = 0; j < num_vertices; j++)
+        {
+            ok(vertex_remap[j] < num_vertices && !seen[vertex_remap[j]],
+               "Test %u: Got vertex %u at %u.\n", i, vertex_remap[j], j);
+            if (vertex_remap[j] < num_vertices) seen[vertex_remap[j]] = TRUE;
+            else vertex_remap[j] = 0;
+            if (tc[i].flags & D3DXMESHOPT_IGNOREVERTS)
+                ok(vertex_remap[j] == j, "Test %u: Vertex %u was moved to %u.\n", i, vertex_remap[j], j);
+        }
+
+        mesh->lpVtbl->LockVertexBuffer(mesh, D3DLOCK_READONLY, (void **)&new_vertices);
+        for (j = 0; j < num_vertices; j++)
+            ok(!memcmp(&new_vertices[j], &old_vertices[vertex_remap[j]], sizeof(*new_vertices)),
+               "Test %u: Vertex %u doesn't match old vertex %u.\n", i, j, vertex_remap[j]);
+        mesh->lpVtbl->UnlockVertexBuffer(mesh);
+
+        mesh->lpVtbl->LockIndexBuffer(mesh, D3DLOCK_READONLY, (void **)&new_indices);
+        for (j = 0; j < num_faces; j++)
+        {
+            for (k = 0; k < 3; k++)
+            {
+                DWORD index = new_indices[j * 3 + k];
+
+                ok(index < num_vertices && vertex_remap[index] == old_indices[face_remap[j] * 3 + k],
+                   "Test %u: Got index %u for corner %u of face %u, old face %u.\n", i, index, k, j, face_remap[j]);
+            }
+        }
+
+        for (j = 0; j < num_faces; j++)
+        {
+            for (k = 0; k < 3; k++)
+            {
+                DWORD old_adjacent = adjacency[face_remap[j] * 3 + k];
+                DWORD adjacent = adjacency_out[j * 3 + k];
+
+                if (old_adjacent == ~0u)
+                    ok(adjacent == ~0u, "Test %u: Got adjacent face %u for edge %u of face %u.\n",
+                       i, adjacent, k, j);
+                else
+                    ok(adjacent < num_faces && face_remap[adjacent] == old_adjacent,
+                       "Test %u: Got adjacent face %u for edge %u of face %u, expected old face %u.\n",
+                       i, adjacent, k, j, old_adjacent);
+            }
+        }
+
+        mesh->lpVtbl->LockAttributeBuffer(mesh, D3DLOCK_READONLY, &new_attributes);
+        for (j = 0; j < num_faces; j++)
+        {
+            ok(new_attributes[j] == old_attributes[face_remap[j]], "Test %u: Got attribute %u for face %u.\n",
+               i, new_attributes[j], j);
+            if (j && (tc[i].flags & D3DXMESHOPT_ATTRSORT || tc[i].presort))
+                ok(new_attributes[j] >= new_attributes[j - 1], "Test %u: Face %u isn't sorted.\n", i, j);
+        }
+
+        /* the vertex ranges of the attribute table describe the new index buffer */
+        hr = mesh->lpVtbl->GetAttributeTable(mesh, NULL, &attrib_table_size);
+        ok(hr == D3D_OK, "Test %u: GetAttributeTable failed, hr %#x.\n", i, hr);
+        ok(attrib_table_size == 3, "Test %u: Got attribute table size %u.\n", i, attrib_table_size);
+        if (attrib_table_size > ARRAY_SIZE(attrib_table)) attrib_table_size = 0;
+        hr = mesh->lpVtbl->GetAttributeTable(mesh, attrib_table, &attrib_table_size);
+        ok(hr == D3D_OK, "Test %u: GetAttributeTable failed, hr %#x.\n", i, hr);
+        for (j = 0; j < attrib_table_size; j++)
+        {
+            const D3DXATTRIBUTERANGE *range = &attrib_table[j];
+            DWORD min_vertex = ~0u, max_vertex = 0;
+
+            ok(range->FaceStart + range->FaceCount <= num_faces, "Test %u: Got faces %u-%u in range %u.\n",
+               i, range->FaceStart, range->FaceCount, j);
+            if (range->FaceStart + range->FaceCount > num_faces) continue;
+            for (k = range->FaceStart; k < range->FaceStart + range->FaceCount; k++)
+            {
+                ok(new_attributes[k] == range->AttribId, "Test %u: Face %u has attribute %u, range %u has %u.\n",
+                   i, k, new_attributes[k], j, range->AttribId);
+                min_vertex = min(min_vertex, min(new_indices[k * 3], min(new_indices[k * 3 + 1], new_indices[k * 3 + 2])));
+                max_vertex = max(max_vertex, max(new_indices[k * 3], max(new_indices[k * 3 + 1], new_indices[k * 3 + 2])));
+            }
+            ok(range->VertexStart == min_vertex && range->VertexCount == max_vertex - min_vertex + 1,
+               "Test %u: Got vertices %u, count %u for range %u, expected %u, count %u.\n", i,
+               range->VertexStart, range->VertexCount, j, min_vertex, max_vertex - min_vertex + 1);
+        }
+        mesh->lpVtbl->UnlockAttributeBuffer(mesh);
+        mesh->lpVtbl->UnlockIndexBuffer(mesh);
+
+        ID3DXBuffer_Release(vertex_remap_buffer);
+        mesh->lpVtbl->Release(mesh);
+    }
+
+    free_test_context(test_context);
 }
 
 START_TEST(mesh)
@@ -10314,4 +10669,6 @@ START_TEST(mesh)
     test_clone_mesh();
     test_valid_mesh();
     test_optimize_faces();
+    test_optimize_vertices();
+    test_optimize_inplace();
 }
@@ -619,7 +619,7 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
     BOOL testdummy_ok, testbitmap_ok;
     IDirect3DTexture9 *tex;
     IDirect3DSurface9 *surf, *newsurf;
-    RECT rect, destrect;
+    RECT rect, destrect, srcrect;
     D3DLOCKED_RECT lockrect;
     const WORD pixdata_a8r3g3b2[] = { 0x57df, 0x98fc, 0xacdd, 0xc891 };
     const WORD pixdata_a1r5g5b5[] = { 0x46b5, 0x99c8, 0x06a2, 0x9431 };
@@ -628,6 +628,20 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
     const DWORD pixdata_g16r16[] = { 0x07d23fbe, 0xdc7f44a4, 0xe4d8976b, 0x9a84fe89 };
     const DWORD pixdata_a8b8g8r8[] = { 0xc3394cf0, 0x235ae892, 0x09b197fd, 0x8dc32bf6 };
     const DWORD pixdata_a2r10g10b10[] = { 0x57395aff, 0x5b7668fd, 0xb0d856b5, 0xff2c61d6 };
+    const DWORD pixdata_box[] =
+    {
+        0xff000000, 0xff808080, 0x80f00000, 0x80100000,
+        0xff000000, 0xff808080, 0x80800000, 0x80800000,
+        0xff000000, 0xff204060, 0x00000000, 0x00000000,
+        0xff204060, 0xff000000, 0x00000000, 0x00000000,
+    };
+    const DWORD pixdata_dxt[] =
+    {
+        0xffff0000, 0xffff0000, 0xff0000ff, 0xff0000ff,
+        0xffff0000, 0xffff0000, 0xff0000ff, 0xff0000ff,
+        0xff0000ff, 0xff0000ff, 0xffff0000, 0xffff0000,
+        0xff0000ff, 0xff0000ff, 0xffff0000, 0xffff0000,
+    };
 
     hr = create_file("testdummy.bmp", noimage, sizeof(noimage));  /* invalid image */
     testdummy_ok = SUCCEEDED(hr);
@@ -898,6 +912,17 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
         hr = IDirect3DSurface9_UnlockRect(surf);
         ok(SUCCEEDED(hr), "Failed to unlock surface, hr %#x\n", hr);
 
+        /* Box filtering a 4x4 image down to 2x2 averages each 2x2 quad. */
+        SetRect(&srcrect, 0, 0, 4, 4);
+        hr = D3DXLoadSurfaceFromMemory(surf, NULL, NULL, pixdata_box, D3DFMT_A8R8G8B8, 16, NULL, &srcrect, D3DX_FILTER_BOX, 0);
+        ok(hr == D3D_OK, "D3DXLoadSurfaceFromMemory returned %#x, expected %#x\n", hr, D3D_OK);
+        IDirect3DSurface9_LockRect(surf, &lockrect, NULL, D3DLOCK_READONLY);
+        check_pixel_4bpp(&lockrect, 0, 0, 0xff404040);
+        check_pixel_4bpp(&lockrect, 1, 0, 0x80800000);
+        check_pixel_4bpp(&lockrect, 0, 1, 0xff102030);
+        check_pixel_4bpp(&lockrect, 1, 1, 0x00000000);
+        IDirect3DSurface9_UnlockRect(surf);
+
         check_release((IUnknown*)surf, 0);
     }
 
@@ -1094,7 +1119,7 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
             hr = IDirect3DTexture9_GetSurfaceLevel(tex, 0, &newsurf);
             ok(SUCCEEDED(hr), "Failed to get the surface, hr %#x.\n", hr);
             hr = D3DXLoadSurfaceFromSurface(newsurf, NULL, NULL, surf, NULL, NULL, D3DX_FILTER_NONE, 0);
-            todo_wine ok(SUCCEEDED(hr), "Failed to convert pixels to DXT2 format.\n");
+            ok(SUCCEEDED(hr), "Failed to convert pixels to DXT2 format.\n");
             check_release((IUnknown*)newsurf, 1);
             check_release((IUnknown*)tex, 0);
         }
@@ -1107,7 +1132,7 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
             hr = IDirect3DTexture9_GetSurfaceLevel(tex, 0, &newsurf);
             ok(SUCCEEDED(hr), "Failed to get the surface, hr %#x.\n", hr);
             hr = D3DXLoadSurfaceFromSurface(newsurf, NULL, NULL, surf, NULL, NULL, D3DX_FILTER_NONE, 0);
-            todo_wine ok(SUCCEEDED(hr), "Failed to convert pixels to DXT3 format.\n");
+            ok(SUCCEEDED(hr), "Failed to convert pixels to DXT3 format.\n");
             check_release((IUnknown*)newsurf, 1);
             check_release((IUnknown*)tex, 0);
         }
@@ -1120,7 +1145,7 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
             hr = IDirect3DTexture9_GetSurfaceLevel(tex, 0, &newsurf);
             ok(SUCCEEDED(hr), "Failed to get the surface, hr %#x.\n", hr);
             hr = D3DXLoadSurfaceFromSurface(newsurf, NULL, NULL, surf, NULL, NULL, D3DX_FILTER_NONE, 0);
-            todo_wine ok(SUCCEEDED(hr), "Failed to convert pixels to DXT4 format.\n");
+            ok(SUCCEEDED(hr), "Failed to convert pixels to DXT4 format.\n");
             check_release((IUnknown*)newsurf, 1);
             check_release((IUnknown*)tex, 0);
         }
@@ -1133,7 +1158,7 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
             hr = IDirect3DTexture9_GetSurfaceLevel(tex, 0, &newsurf);
             ok(SUCCEEDED(hr), "Failed to get the surface, hr %#x.\n", hr);
             hr = D3DXLoadSurfaceFromSurface(newsurf, NULL, NULL, surf, NULL, NULL, D3DX_FILTER_NONE, 0);
-            todo_wine ok(SUCCEEDED(hr), "Failed to convert pixels to DXT5 format.\n");
+            ok(SUCCEEDED(hr), "Failed to convert pixels to DXT5 format.\n");
             check_release((IUnknown*)newsurf, 1);
             check_release((IUnknown*)tex, 0);
         }
@@ -1146,10 +1171,25 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
             hr = IDirect3DTexture9_GetSurfaceLevel(tex, 0, &newsurf);
             ok(SUCCEEDED(hr), "Failed to get the surface, hr %#x.\n", hr);
             hr = D3DXLoadSurfaceFromSurface(newsurf, NULL, NULL, surf, NULL, NULL, D3DX_FILTER_NONE, 0);
-            todo_wine ok(SUCCEEDED(hr), "Failed to convert pixels to DXT1 format.\n");
+            ok(SUCCEEDED(hr), "Failed to convert pixels to DXT1 format.\n");
+
+            hr = D3DXLoadSurfaceFromSurface(surf, NULL, NULL, newsurf, NULL, NULL, D3DX_FILTER_NONE, 0);
+            ok(SUCCEEDED(hr), "Failed to convert pixels from DXT1 format.\n");
 
+            /* Two colors exactly representable in R5G6B5 survive a round trip. */
+            SetRect(&srcrect, 0, 0, 4, 4);
+            hr = D3DXLoadSurfaceFromMemory(newsurf, NULL, NULL, pixdata_dxt, D3DFMT_A8R8G8B8, 16, NULL, &srcrect, D3DX_FILTER_NONE, 0);
+            ok(SUCCEEDED(hr), "Failed to convert pixels to DXT1 format, hr %#x.\n", hr);
             hr = D3DXLoadSurfaceFromSurface(surf, NULL, NULL, newsurf, NULL, NULL, D3DX_FILTER_NONE, 0);
-            todo_wine ok(SUCCEEDED(hr), "Failed to convert pixels from DXT1 format.\n");
+            ok(SUCCEEDED(hr), "Failed to convert pixels from DXT1 format, hr %#x.\n", hr);
+            hr = IDirect3DSurface9_LockRect(surf, &lockrect, NULL, D3DLOCK_READONLY);
+            ok(SUCCEEDED(hr), "Failed to lock surface, hr %#x.\n", hr);
+            check_pixel_4bpp(&lockrect, 0, 0, 0xffff0000);
+            check_pixel_4bpp(&lockrect, 3, 0, 0xff0000ff);
+            check_pixel_4bpp(&lockrect, 0, 3, 0xff0000ff);
+            check_pixel_4bpp(&lockrect, 3, 3, 0xffff0000);
+            hr = IDirect3DSurface9_UnlockRect(surf);
+            ok(SUCCEEDED(hr), "Failed to unlock surface, hr %#x.\n", hr);
 
             check_release((IUnknown*)newsurf, 1);
             check_release((IUnknown*)tex, 0);
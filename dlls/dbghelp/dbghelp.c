@@ -68,6 +68,24 @@ unsigned   dbghelp_options = SYMOPT_UNDNAME;
 
 static struct process* process_first /* = NULL */;
 
+/******************************************************************
+ *		DllMain (DBGHELP.@)
+ */
+BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved)
+{
+    switch (reason)
+    {
+    case DLL_PROCESS_ATTACH:
+        DisableThreadLibraryCalls(instance);
+        break;
+    case DLL_PROCESS_DETACH:
+        if (reserved) break;
+        module_cache_free();
+        break;
+    }
+    return TRUE;
+}
+
 /******************************************************************
  *		process_find_by_handle
  *
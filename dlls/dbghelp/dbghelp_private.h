@@ -605,6 +605,11 @@ extern struct module*
                                enum module_type type, BOOL virtual,
                                DWORD64 addr, DWORD64 size,
                                unsigned long stamp, unsigned long checksum) DECLSPEC_HIDDEN;
+extern struct module*
+                    module_find_cached(struct process* pcs, const WCHAR* name,
+                                       DWORD64 base, DWORD64 size,
+                                       unsigned long stamp, unsigned long checksum) DECLSPEC_HIDDEN;
+extern void         module_cache_free(void) DECLSPEC_HIDDEN;
 extern struct module*
                     module_get_containee(const struct process* pcs,
                                          const struct module* inner) DECLSPEC_HIDDEN;
@@ -2100,20 +2100,84 @@ static void dwarf2_load_one_entry(dwarf2_parse_context_t* ctx,
     }
 }
 
-static void dwarf2_set_line_number(struct module* module, unsigned long address,
-                                   const struct vector* v, unsigned file, unsigned line)
+/* functions of the current compilation unit, sorted by address
+ * (line numbers are attached through this table rather than through
+ * symt_find_nearest, which would resort the whole module's symbol table
+ * for every compilation unit)
+ */
+typedef struct dwarf2_cu_functions_s
+{
+    struct symt_function**      funcs;
+    unsigned                    num;
+    unsigned                    last;
+} dwarf2_cu_functions_t;
+
+static int dwarf2_cmp_function_addr(const void* p1, const void* p2)
+{
+    const struct symt_function* f1 = *(const struct symt_function* const*)p1;
+    const struct symt_function* f2 = *(const struct symt_function* const*)p2;
+
+    if (f1->address > f2->address) return 1;
+    if (f1->address < f2->address) return -1;
+    return 0;
+}
+
+static void dwarf2_init_cu_functions(dwarf2_parse_context_t* ctx, dwarf2_cu_functions_t* cuf)
+{
+    struct symt**       psym;
+    unsigned            i, count = vector_length(&ctx->compiland->vchildren);
+
+    cuf->num = cuf->last = 0;
+    if (!count || !(cuf->funcs = pool_alloc(&ctx->pool, count * sizeof(*cuf->funcs))))
+        return;
+    for (i = 0; i < count; i++)
+    {
+        psym = vector_at(&ctx->compiland->vchildren, i);
+        if ((*psym)->tag == SymTagFunction)
+            cuf->funcs[cuf->num++] = (struct symt_function*)*psym;
+    }
+    qsort(cuf->funcs, cuf->num, sizeof(*cuf->funcs), dwarf2_cmp_function_addr);
+}
+
+static struct symt_function* dwarf2_find_cu_function(dwarf2_cu_functions_t* cuf,
+                                                     unsigned long address)
+{
+    struct symt_function*       func;
+    unsigned                    low, high, mid;
+
+    if (!cuf->num) return NULL;
+    /* line programs mostly walk a function at a time */
+    func = cuf->funcs[cuf->last];
+    if (address >= func->address && address < func->address + func->size)
+        return func;
+
+    low = 0;
+    high = cuf->num;
+    while (high > low + 1)
+    {
+        mid = (low + high) / 2;
+        if (cuf->funcs[mid]->address <= address) low = mid;
+        else high = mid;
+    }
+    func = cuf->funcs[low];
+    if (address < func->address || address >= func->address + func->size)
+        return NULL;
+    cuf->last = low;
+    return func;
+}
+
+static void dwarf2_set_line_number(struct module* module, dwarf2_cu_functions_t* cuf,
+                                   unsigned long address, const struct vector* v,
+                                   unsigned file, unsigned line)
 {
     struct symt_function*       func;
-    struct symt_ht*             symt;
     unsigned*                   psrc;
 
     if (!file || !(psrc = vector_at(v, file - 1))) return;
 
     TRACE("%s %lx %s %u\n",
           debugstr_w(module->module.ModuleName), address, source_get(module, *psrc), line);
-    if (!(symt = symt_find_nearest(module, address)) ||
-        symt->symt.tag != SymTagFunction) return;
-    func = (struct symt_function*)symt;
+    if (!(func = dwarf2_find_cu_function(cuf, address))) return;
     symt_add_func_line(module, func, *psrc, line, address - func->address);
 }
 
@@ -2131,6 +2195,7 @@ static BOOL dwarf2_parse_line_numbers(const dwarf2_section_t* sections,
     struct vector               dirs;
     struct vector               files;
     const char**                p;
+    dwarf2_cu_functions_t       cuf;
 
     /* section with line numbers stripped */
     if (sections[section_line].address == IMAGE_NO_MAP)
@@ -2211,6 +2276,8 @@ static BOOL dwarf2_parse_line_numbers(const dwarf2_section_t* sections,
     }
     traverse.data++;
 
+    dwarf2_init_cu_functions(ctx, &cuf);
+
     while (traverse.data < traverse.end_data)
     {
         unsigned long address = 0;
@@ -2231,14 +2298,14 @@ static BOOL dwarf2_parse_line_numbers(const dwarf2_section_t* sections,
 
                 address += (delta / line_range) * insn_size;
                 line += line_base + (delta % line_range);
-                dwarf2_set_line_number(ctx->module, address, &files, file, line);
+                dwarf2_set_line_number(ctx->module, &cuf, address, &files, file, line);
             }
             else
             {
                 switch (opcode)
                 {
                 case DW_LNS_copy:
-                    dwarf2_set_line_number(ctx->module, address, &files, file, line);
+                    dwarf2_set_line_number(ctx->module, &cuf, address, &files, file, line);
                     break;
                 case DW_LNS_advance_pc:
                     address += insn_size * dwarf2_leb128_as_unsigned(&traverse);
@@ -2269,7 +2336,7 @@ static BOOL dwarf2_parse_line_numbers(const dwarf2_section_t* sections,
                     switch (extopcode)
                     {
                     case DW_LNE_end_sequence:
-                        dwarf2_set_line_number(ctx->module, address, &files, file, line);
+                        dwarf2_set_line_number(ctx->module, &cuf, address, &files, file, line);
                         end_sequence = TRUE;
                         break;
                     case DW_LNE_set_address:
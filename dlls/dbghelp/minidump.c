@@ -782,6 +782,29 @@ static  unsigned        dump_threads(struct dump_context* dc,
     return sz;
 }
 
+/* size of the blocks read at once from the debuggee's memory */
+#define DUMP_MEMORY_CHUNK       (64 * 1024)
+
+/******************************************************************
+ *		read_memory_pages
+ *
+ * Reads a block of the debuggee's memory page by page, zero-filling the
+ * pages that cannot be read, so that the block's layout is kept in the dump.
+ */
+static void read_memory_pages(struct dump_context* dc, ULONG64 addr, char* buffer, unsigned size,
+                              unsigned page_size)
+{
+    unsigned    pos, len;
+
+    for (pos = 0; pos < size; pos += len)
+    {
+        len = min(size - pos, page_size - ((addr + pos) & (page_size - 1)));
+        if (!ReadProcessMemory(dc->hProcess, (void*)(DWORD_PTR)(addr + pos),
+                               buffer + pos, len, NULL))
+            memset(buffer + pos, 0, len);
+    }
+}
+
 /******************************************************************
  *		dump_memory_info
  *
@@ -792,9 +815,22 @@ static unsigned         dump_memory_info(struct dump_context* dc)
     MINIDUMP_MEMORY_LIST        mdMemList;
     MINIDUMP_MEMORY_DESCRIPTOR  mdMem;
     DWORD                       written;
-    unsigned                    i, pos, len, sz;
+    unsigned                    i, pos, len, sz, chunk;
     RVA                         rva_base;
     char                        tmp[1024];
+    char*                       buffer;
+    SYSTEM_INFO                 sysInfo;
+
+    GetSystemInfo(&sysInfo);
+
+    /* every read is a server round trip, so use large blocks when we can */
+    if ((buffer = HeapAlloc(GetProcessHeap(), 0, DUMP_MEMORY_CHUNK)))
+        chunk = DUMP_MEMORY_CHUNK;
+    else
+    {
+        buffer = tmp;
+        chunk = sizeof(tmp);
+    }
 
     mdMemList.NumberOfMemoryRanges = dc->num_mem;
     append(dc, &mdMemList.NumberOfMemoryRanges,
@@ -810,13 +846,14 @@ static unsigned         dump_memory_info(struct dump_context* dc)
         mdMem.Memory.Rva = dc->rva;
         mdMem.Memory.DataSize = dc->mem[i].size;
         SetFilePointer(dc->hFile, dc->rva, NULL, FILE_BEGIN);
-        for (pos = 0; pos < dc->mem[i].size; pos += sizeof(tmp))
+        for (pos = 0; pos < dc->mem[i].size; pos += chunk)
         {
-            len = min(dc->mem[i].size - pos, sizeof(tmp));
-            if (ReadProcessMemory(dc->hProcess, 
-                                  (void*)(DWORD_PTR)(dc->mem[i].base + pos),
-                                  tmp, len, NULL))
-                WriteFile(dc->hFile, tmp, len, &written, NULL);
+            len = min(dc->mem[i].size - pos, chunk);
+            if (!ReadProcessMemory(dc->hProcess,
+                                   (void*)(DWORD_PTR)(dc->mem[i].base + pos),
+                                   buffer, len, NULL))
+                read_memory_pages(dc, dc->mem[i].base + pos, buffer, len, sysInfo.dwPageSize);
+            WriteFile(dc->hFile, buffer, len, &written, NULL);
         }
         dc->rva += mdMem.Memory.DataSize;
         writeat(dc, rva_base + i * sizeof(mdMem), &mdMem, sizeof(mdMem));
@@ -825,6 +862,7 @@ static unsigned         dump_memory_info(struct dump_context* dc)
             writeat(dc, dc->mem[i].rva, &mdMem.Memory.Rva, sizeof(mdMem.Memory.Rva));
         }
     }
+    if (buffer != tmp) HeapFree(GetProcessHeap(), 0, buffer);
 
     return sz;
 }
@@ -27,6 +27,7 @@
 
 #include "dbghelp_private.h"
 #include "psapi.h"
+#include "winreg.h"
 #include "winternl.h"
 #include "wine/debug.h"
 
@@ -675,14 +676,11 @@ DWORD64 WINAPI SymLoadModule64(HANDLE hProcess, HANDLE hFile, PCSTR ImageName,
  *		module_remove
  *
  */
-BOOL module_remove(struct process* pcs, struct module* module)
+static void module_destroy(struct process* pcs, struct module* module)
 {
     struct module_format*modfmt;
-    struct module**     p;
     unsigned            i;
 
-    TRACE("%s (%p)\n", debugstr_w(module->module.ModuleName), module);
-
     for (i = 0; i < DFI_LAST; i++)
     {
         if ((modfmt = module->format_info[i]) && modfmt->remove)
@@ -694,6 +692,123 @@ BOOL module_remove(struct process* pcs, struct module* module)
     HeapFree(GetProcessHeap(), 0, module->sources);
     HeapFree(GetProcessHeap(), 0, module->addr_sorttab);
     pool_destroy(&module->pool);
+    HeapFree(GetProcessHeap(), 0, module);
+}
+
+/* Removed PE modules, with their debug information already loaded, can be
+ * kept around (most recently removed first) so that loading the very same
+ * image again, in the same or another process, doesn't parse its debug
+ * information again. The number of kept modules is configured in the
+ * registry (disabled by default).
+ */
+static struct module*   module_cache;
+static int              module_cache_size = -1;
+
+static int get_module_cache_size(void)
+{
+    HKEY                hkey;
+    DWORD               type, value, size = sizeof(value);
+    int                 count = 0;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Dbghelp */
+    if (!RegOpenKeyA(HKEY_CURRENT_USER, "Software\\Wine\\Dbghelp", &hkey))
+    {
+        if (!RegQueryValueExA(hkey, "ModuleCacheSize", NULL, &type, (BYTE*)&value, &size) &&
+            type == REG_DWORD)
+            count = min(value, 256);
+        RegCloseKey(hkey);
+    }
+    return count;
+}
+
+static BOOL module_cache_store(struct module* module)
+{
+    struct module**     p;
+    int                 count;
+
+    if (module_cache_size < 0) module_cache_size = get_module_cache_size();
+    if (!module_cache_size || module->type != DMT_PE || module->is_virtual ||
+        !module->format_info[DFI_PE])
+        return FALSE;
+    /* only keep modules which have been worth parsing */
+    switch (module->module.SymType)
+    {
+    case SymNone: case SymDeferred: case SymExport: return FALSE;
+    default: break;
+    }
+
+    TRACE("keeping %s (%p)\n", debugstr_w(module->module.ModuleName), module);
+    module->process = NULL;
+    module->next = module_cache;
+    module_cache = module;
+
+    for (p = &module_cache, count = 0; *p; p = &(*p)->next)
+    {
+        if (++count > module_cache_size)
+        {
+            module_destroy(NULL, *p);
+            *p = NULL;
+            break;
+        }
+    }
+    return TRUE;
+}
+
+/******************************************************************
+ *		module_cache_free
+ *
+ * Destroys all the removed modules which have been kept.
+ */
+void module_cache_free(void)
+{
+    struct module*      module;
+
+    while ((module = module_cache))
+    {
+        module_cache = module->next;
+        module_destroy(NULL, module);
+    }
+}
+
+/******************************************************************
+ *		module_find_cached
+ *
+ * Reattaches to pcs a previously removed module for the given image, if any.
+ */
+struct module* module_find_cached(struct process* pcs, const WCHAR* name,
+                                  DWORD64 base, DWORD64 size,
+                                  unsigned long stamp, unsigned long checksum)
+{
+    struct module**     p;
+    struct module*      module;
+
+    for (p = &module_cache; *p; p = &(*p)->next)
+    {
+        module = *p;
+        if (module->module.BaseOfImage != base || module->module.ImageSize != size ||
+            module->module.TimeDateStamp != stamp || module->module.CheckSum != checksum ||
+            strcmpiW(module->module.LoadedImageName, name))
+            continue;
+        /* don't reuse a module loaded without the lines we now want */
+        if ((dbghelp_options & SYMOPT_LOAD_LINES) && !module->module.LineNumbers)
+            continue;
+
+        TRACE("reusing %s (%p)\n", debugstr_w(module->module.ModuleName), module);
+        *p = module->next;
+        module->process = pcs;
+        module->next = pcs->lmodules;
+        pcs->lmodules = module;
+        return module;
+    }
+    return NULL;
+}
+
+BOOL module_remove(struct process* pcs, struct module* module)
+{
+    struct module**     p;
+
+    TRACE("%s (%p)\n", debugstr_w(module->module.ModuleName), module);
+
     /* native dbghelp doesn't invoke registered callback(,CBA_SYMBOLS_UNLOADED,) here
      * so do we
      */
@@ -702,7 +817,8 @@ BOOL module_remove(struct process* pcs, struct module* module)
         if (*p == module)
         {
             *p = module->next;
-            HeapFree(GetProcessHeap(), 0, module);
+            if (!module_cache_store(module))
+                module_destroy(pcs, module);
             return TRUE;
         }
     }
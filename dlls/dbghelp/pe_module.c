@@ -767,10 +767,15 @@ struct module* pe_load_native_module(struct process* pcs, const WCHAR* name,
         if (!base) base = modfmt->u.pe_info->fmap.u.pe.ntheader.OptionalHeader.ImageBase;
         if (!size) size = modfmt->u.pe_info->fmap.u.pe.ntheader.OptionalHeader.SizeOfImage;
 
-        module = module_new(pcs, loaded_name, DMT_PE, FALSE, base, size,
-                            modfmt->u.pe_info->fmap.u.pe.ntheader.FileHeader.TimeDateStamp,
-                            modfmt->u.pe_info->fmap.u.pe.ntheader.OptionalHeader.CheckSum);
-        if (module)
+        if ((module = module_find_cached(pcs, loaded_name, base, size,
+                                         modfmt->u.pe_info->fmap.u.pe.ntheader.FileHeader.TimeDateStamp,
+                                         modfmt->u.pe_info->fmap.u.pe.ntheader.OptionalHeader.CheckSum)))
+        {
+            pe_unmap_file(&modfmt->u.pe_info->fmap);
+        }
+        else if ((module = module_new(pcs, loaded_name, DMT_PE, FALSE, base, size,
+                                      modfmt->u.pe_info->fmap.u.pe.ntheader.FileHeader.TimeDateStamp,
+                                      modfmt->u.pe_info->fmap.u.pe.ntheader.OptionalHeader.CheckSum)))
         {
             modfmt->module = module;
             modfmt->remove = pe_module_remove;
@@ -789,7 +794,7 @@ struct module* pe_load_native_module(struct process* pcs, const WCHAR* name,
             pe_unmap_file(&modfmt->u.pe_info->fmap);
         }
     }
-    if (!module) HeapFree(GetProcessHeap(), 0, modfmt);
+    if (!module || module->format_info[DFI_PE] != modfmt) HeapFree(GetProcessHeap(), 0, modfmt);
 
     if (opened) CloseHandle(hFile);
 
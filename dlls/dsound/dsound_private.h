@@ -80,8 +80,8 @@ struct DirectSoundDevice
     CRITICAL_SECTION            mixlock;
     IDirectSoundBufferImpl     *primary;
     DWORD                       speaker_config;
-    float *mix_buffer, *tmp_buffer;
-    DWORD                       tmp_buffer_len, mix_buffer_len;
+    float *mix_buffer, *tmp_buffer, *cp_buffer;
+    DWORD                       tmp_buffer_len, mix_buffer_len, cp_buffer_len;
 
     DSVOLUMEPAN                 volpan;
 
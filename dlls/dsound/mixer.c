@@ -227,30 +227,142 @@ void DSOUND_CheckEvent(const IDirectSoundBufferImpl *dsb, DWORD playpos, int len
 	}
 }
 
-static inline float get_current_sample(const IDirectSoundBufferImpl *dsb,
-        DWORD mixpos, DWORD channel)
+/**
+ * Read count frames of one channel of the secondary buffer, starting at the
+ * current mix position. Looping buffers wrap around, others are padded with
+ * silence past their end.
+ */
+static void get_samples(const IDirectSoundBufferImpl *dsb, DWORD channel,
+        float *out, UINT stride, UINT count)
 {
-    if (mixpos >= dsb->buflen && !(dsb->playflags & DSBPLAY_LOOPING))
-        return 0.0f;
-    return dsb->get(dsb, mixpos % dsb->buflen, channel);
+    UINT istride = dsb->pwfx->nBlockAlign;
+    DWORD pos = dsb->sec_mixpos;
+    UINT i;
+
+    for (i = 0; i < count; i++, out += stride)
+    {
+        if (pos >= dsb->buflen)
+        {
+            if (!(dsb->playflags & DSBPLAY_LOOPING))
+                break;
+            pos -= dsb->buflen;
+        }
+        *out = dsb->get(dsb, pos, channel);
+        pos += istride;
+    }
+    for (; i < count; i++, out += stride)
+        *out = 0.0f;
+}
+
+/* Get a scratch buffer of at least count floats for the copy functions. */
+static float *get_cp_buffer(DirectSoundDevice *device, UINT count)
+{
+    DWORD size = count * sizeof(float);
+
+    if (device->cp_buffer_len < size || !device->cp_buffer)
+    {
+        HeapFree(GetProcessHeap(), 0, device->cp_buffer);
+        device->cp_buffer = HeapAlloc(GetProcessHeap(), 0, size);
+        device->cp_buffer_len = device->cp_buffer ? size : 0;
+    }
+    return device->cp_buffer;
 }
 
 static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
 {
-    UINT istride = dsb->pwfx->nBlockAlign;
-    UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
+    UINT ochannels = dsb->device->pwfx->nChannels;
+    UINT ostride = ochannels * sizeof(float);
     DWORD channel, i;
-    for (i = 0; i < count; i++)
+    float *buf;
+
+    /* same channel layout: convert straight into the temporary buffer */
+    if (dsb->put == putieee32)
+    {
         for (channel = 0; channel < dsb->mix_channels; channel++)
-            dsb->put(dsb, i * ostride, channel, get_current_sample(dsb,
-                    dsb->sec_mixpos + i * istride, channel));
+            get_samples(dsb, channel, dsb->device->tmp_buffer + channel, ochannels, count);
+        return count;
+    }
+
+    if (!(buf = get_cp_buffer(dsb->device, count)))
+    {
+        memset(dsb->device->tmp_buffer, 0, count * ostride);
+        return count;
+    }
+    for (channel = 0; channel < dsb->mix_channels; channel++)
+    {
+        get_samples(dsb, channel, buf, 1, count);
+        for (i = 0; i < count; i++)
+            dsb->put(dsb, i * ostride, channel, buf[i]);
+    }
     return count;
 }
 
+/**
+ * Polyphase layout of the FIR, one table for each possible firstep.
+ *
+ * For each of the firstep phases, the table holds the FIR points used at that
+ * phase followed by the points just after them (those the fractional part of
+ * the position interpolates towards), each padded with zeros to a multiple of
+ * four points. This turns the strided FIR reads of the resampler into two
+ * contiguous dot products.
+ */
+static float *fir_phases[128];
+
+static inline UINT get_fir_taps(UINT firstep)
+{
+    return (((fir_len + firstep - 2) / firstep) + 3) & ~3;
+}
+
+static const float *get_fir_phases(UINT firstep)
+{
+    UINT taps = get_fir_taps(firstep), phase, k, idx;
+    float *table;
+
+    if (firstep >= sizeof(fir_phases) / sizeof(fir_phases[0]))
+        return NULL;
+    if (fir_phases[firstep])
+        return fir_phases[firstep];
+
+    table = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, firstep * taps * 2 * sizeof(float));
+    if (!table)
+        return NULL;
+
+    for (phase = 0; phase < firstep; phase++)
+    {
+        float *cur = table + phase * taps * 2, *next = cur + taps;
+        for (k = 0, idx = phase; idx < fir_len - 1; k++, idx += firstep)
+        {
+            cur[k] = fir[idx];
+            next[k] = fir[idx + 1];
+        }
+    }
+
+    /* the tables are shared by all devices and never freed */
+    if (InterlockedCompareExchangePointer((void **)&fir_phases[firstep], table, NULL))
+        HeapFree(GetProcessHeap(), 0, table);
+    return fir_phases[firstep];
+}
+
+/* count must be a multiple of 4; the partial sums keep the loop free of
+ * dependencies so that it can be vectorized */
+static inline float dot_product(const float *a, const float *b, UINT count)
+{
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+    UINT i;
+
+    for (i = 0; i < count; i += 4)
+    {
+        sum0 += a[i] * b[i];
+        sum1 += a[i + 1] * b[i + 1];
+        sum2 += a[i + 2] * b[i + 2];
+        sum3 += a[i + 3] * b[i + 3];
+    }
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
 static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, float *freqAcc)
 {
     UINT i, channel;
-    UINT istride = dsb->pwfx->nBlockAlign;
     UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
 
     float freqAdjust = dsb->freqAdjust;
@@ -260,24 +372,24 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, float *f
     UINT channels = dsb->mix_channels;
     UINT max_ipos = freqAcc_start + count * freqAdjust;
 
-    UINT fir_cachesize = (fir_len + dsbfirstep - 2) / dsbfirstep;
-    UINT required_input = max_ipos + fir_cachesize;
+    UINT fir_taps = get_fir_taps(dsbfirstep);
+    UINT required_input = max_ipos + fir_taps;
 
-    float* intermediate = HeapAlloc(GetProcessHeap(), 0,
-            sizeof(float) * required_input * channels);
+    const float *phases = get_fir_phases(dsbfirstep);
+    float *intermediate = get_cp_buffer(dsb->device, required_input * channels);
 
-    float* fir_copy = HeapAlloc(GetProcessHeap(), 0,
-            sizeof(float) * fir_cachesize);
+    if (!phases || !intermediate)
+    {
+        memset(dsb->device->tmp_buffer, 0, count * ostride);
+        goto done;
+    }
 
     /* Important: this buffer MUST be non-interleaved
      * if you want -msse3 to have any effect.
      * This is good for CPU cache effects, too.
      */
-    float* itmp = intermediate;
     for (channel = 0; channel < channels; channel++)
-        for (i = 0; i < required_input; i++)
-            *(itmp++) = get_current_sample(dsb,
-                    dsb->sec_mixpos + i * istride, channel);
+        get_samples(dsb, channel, intermediate + channel * required_input, 1, required_input);
 
     for(i = 0; i < count; ++i) {
         float total_fir_steps = (freqAcc_start + i * freqAdjust) * dsbfirstep;
@@ -286,32 +398,20 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, float *f
 
         UINT idx = (ipos + 1) * dsbfirstep - int_fir_steps - 1;
         float rem = int_fir_steps + 1.0 - total_fir_steps;
+        const float *cur = phases + idx * fir_taps * 2, *next = cur + fir_taps;
 
-        int fir_used = 0;
-        while (idx < fir_len - 1) {
-            fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
-            idx += dsb->firstep;
-        }
-
-        assert(fir_used <= fir_cachesize);
-        assert(ipos + fir_used <= required_input);
-
-        for (channel = 0; channel < dsb->mix_channels; channel++) {
-            int j;
-            float sum = 0.0;
-            float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
+        for (channel = 0; channel < channels; channel++) {
+            const float *cache = &intermediate[channel * required_input + ipos];
+            float sum = dot_product(cur, cache, fir_taps) * (1.0f - rem) +
+                        dot_product(next, cache, fir_taps) * rem;
             dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
         }
     }
 
+done:
     freqAcc_end -= (int)freqAcc_end;
     *freqAcc = freqAcc_end;
 
-    HeapFree(GetProcessHeap(), 0, fir_copy);
-    HeapFree(GetProcessHeap(), 0, intermediate);
-
     return max_ipos;
 }
 
@@ -381,11 +481,17 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 	cp_fields(dsb, frames, &dsb->freqAcc);
 }
 
+/**
+ * Mix the temporary buffer into the mix buffer, applying the volume and pan
+ * of the secondary buffer on the way.
+ */
 static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
 {
 	INT	i;
 	float vLeft, vRight;
-	UINT channels = dsb->device->pwfx->nChannels, chan;
+	UINT channels = dsb->device->pwfx->nChannels;
+	const float *src = dsb->device->tmp_buffer;
+	float *dst = dsb->device->mix_buffer;
 
 	TRACE("(%p,%d)\n",dsb,frames);
 	TRACE("left = %x, right = %x\n", dsb->volpan.dwTotalLeftAmpFactor,
@@ -394,22 +500,31 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
 	if ((!(dsb->dsbd.dwFlags & DSBCAPS_CTRLPAN) || (dsb->volpan.lPan == 0)) &&
 	    (!(dsb->dsbd.dwFlags & DSBCAPS_CTRLVOLUME) || (dsb->volpan.lVolume == 0)) &&
 	     !(dsb->dsbd.dwFlags & DSBCAPS_CTRL3D))
-		return; /* Nothing to do */
+	{
+		mixieee32(dsb->device->tmp_buffer, dst, frames * channels);
+		return;
+	}
 
 	if (channels != 1 && channels != 2)
 	{
 		FIXME("There is no support for %u channels\n", channels);
+		mixieee32(dsb->device->tmp_buffer, dst, frames * channels);
 		return;
 	}
 
 	vLeft = dsb->volpan.dwTotalLeftAmpFactor / ((float)0xFFFF);
 	vRight = dsb->volpan.dwTotalRightAmpFactor / ((float)0xFFFF);
-	for(i = 0; i < frames; ++i){
-		for(chan = 0; chan < channels; ++chan){
-			if(chan == 0)
-				dsb->device->tmp_buffer[i * channels + chan] *= vLeft;
-			else
-				dsb->device->tmp_buffer[i * channels + chan] *= vRight;
+	if (channels == 1)
+	{
+		for (i = 0; i < frames; i++)
+			dst[i] += src[i] * vLeft;
+	}
+	else
+	{
+		for (i = 0; i < frames; i++)
+		{
+			dst[2 * i] += src[2 * i] * vLeft;
+			dst[2 * i + 1] += src[2 * i + 1] * vRight;
 		}
 	}
 }
@@ -430,7 +545,6 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
 static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, DWORD writepos, DWORD fraglen)
 {
 	INT len = fraglen;
-	float *ibuf;
 	DWORD oldpos;
 	UINT frames = fraglen / dsb->device->pwfx->nBlockAlign;
 
@@ -447,13 +561,10 @@ static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, DWORD writepos, DWO
 	oldpos = dsb->sec_mixpos;
 
 	DSOUND_MixToTemporary(dsb, frames);
-	ibuf = dsb->device->tmp_buffer;
 
-	/* Apply volume if needed */
+	/* Apply volume if needed, and mix into the device buffer */
 	DSOUND_MixerVol(dsb, frames);
 
-	mixieee32(ibuf, dsb->device->mix_buffer, frames * dsb->device->pwfx->nChannels);
-
 	/* check for notification positions */
 	if (dsb->dsbd.dwFlags & DSBCAPS_CTRLPOSITIONNOTIFY &&
 	    dsb->state != STATE_STARTING) {
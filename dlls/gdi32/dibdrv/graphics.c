@@ -19,7 +19,9 @@
  */
 
 #include <assert.h>
+#include <stdio.h>
 #include "gdi_private.h"
+#include "winreg.h"
 #include "dibdrv.h"
 
 #include "wine/unicode.h"
@@ -43,6 +45,15 @@ enum glyph_type
 #define GLYPH_CACHE_PAGE_SIZE  0x100
 #define GLYPH_CACHE_PAGES      (0x10000 / GLYPH_CACHE_PAGE_SIZE)
 
+/* identifies a realized font across processes */
+struct shared_font_key
+{
+    LOGFONTW lf;        /* face name upper-cased and zero padded */
+    XFORM    xform;
+    UINT     aa_flags;
+    BYTE     head[36];  /* start of the 'head' table, identifies the font file */
+};
+
 struct cached_font
 {
     struct list           entry;
@@ -51,6 +62,9 @@ struct cached_font
     LOGFONTW              lf;
     XFORM                 xform;
     UINT                  aa_flags;
+    BOOL                  shared;      /* glyphs are also kept in the shared cache */
+    DWORD                 shared_hash;
+    struct shared_font_key shared_key;
     struct cached_glyph **glyphs[GLYPH_NBTYPES][GLYPH_CACHE_PAGES];
 };
 
@@ -482,6 +496,151 @@ static int font_cache_cmp( const struct cached_font *p1, const struct cached_fon
     return ret;
 }
 
+/* Glyph bitmaps can optionally be shared by all the processes of the prefix,
+ * so that short-lived processes don't have to rasterize the same glyphs again.
+ * The size of the shared cache in kilobytes is set by the GlyphCacheSize value
+ * of HKCU\Software\Wine\Fonts, it's disabled by default.
+ *
+ * The cache is a named section organized as a set associative table. Lookups
+ * don't take any lock, each entry has a sequence counter which is odd while
+ * the entry is being written. Insertions lock the set, never wait for it, and
+ * replace the least recently used entry of the set. Glyphs too large for an
+ * entry are only cached by the process. */
+
+#define SHARED_GLYPH_WAYS        8
+#define SHARED_GLYPH_ENTRY_SIZE  2048
+#define SHARED_GLYPH_MAX_SIZE    (256 * 1024)  /* in kilobytes */
+
+#define MS_MAKE_TAG( _x1, _x2, _x3, _x4 ) \
+          ( ( (DWORD)_x4 << 24 ) |     \
+            ( (DWORD)_x3 << 16 ) |     \
+            ( (DWORD)_x2 <<  8 ) |     \
+              (DWORD)_x1         )
+
+#define MS_HEAD_TAG MS_MAKE_TAG('h','e','a','d')
+
+struct shared_glyph
+{
+    LONG                   seq;        /* odd while the entry is being written */
+    LONG                   last_used;
+    DWORD                  hash;
+    UINT                   index;
+    enum glyph_type        type;
+    struct shared_font_key key;
+    GLYPHMETRICS           metrics;
+    DWORD                  size;
+    BYTE                   bits[1];
+};
+
+#define SHARED_GLYPH_BITS_SIZE (SHARED_GLYPH_ENTRY_SIZE - FIELD_OFFSET( struct shared_glyph, bits ))
+
+struct shared_glyph_cache
+{
+    LONG clock;
+    LONG locks[1];  /* one per set */
+};
+
+static struct shared_glyph_cache *shared_glyphs;
+static BYTE *shared_glyph_entries;
+static UINT shared_glyph_sets;
+
+static void init_shared_glyph_cache(void)
+{
+    static BOOL initialized;
+    HANDLE mapping;
+    HKEY hkey;
+    DWORD type, count, size = 0, entries_offset;
+    char name[64];
+    void *ptr;
+
+    if (initialized) return;
+    initialized = TRUE;
+
+    if (!RegOpenKeyA( HKEY_CURRENT_USER, "Software\\Wine\\Fonts", &hkey ))
+    {
+        count = sizeof(size);
+        if (RegQueryValueExA( hkey, "GlyphCacheSize", NULL, &type, (BYTE *)&size, &count ) ||
+            type != REG_DWORD)
+            size = 0;
+        RegCloseKey( hkey );
+    }
+    if (!size) return;
+
+    size = min( size, SHARED_GLYPH_MAX_SIZE );
+    if (!(shared_glyph_sets = size * 1024 / (SHARED_GLYPH_WAYS * SHARED_GLYPH_ENTRY_SIZE))) return;
+
+    /* the geometry is part of the name, so that all the users agree on it */
+    entries_offset = (FIELD_OFFSET( struct shared_glyph_cache, locks[shared_glyph_sets] ) + 63) & ~63;
+    size = entries_offset + shared_glyph_sets * SHARED_GLYPH_WAYS * SHARED_GLYPH_ENTRY_SIZE;
+    sprintf( name, "__wine_dib_glyph_cache_%u", shared_glyph_sets );
+
+    mapping = CreateFileMappingA( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, name );
+    if (!mapping)
+    {
+        WARN( "failed to create the shared glyph cache, error %u\n", GetLastError() );
+        return;
+    }
+    ptr = MapViewOfFile( mapping, FILE_MAP_WRITE, 0, 0, size );
+    CloseHandle( mapping );
+    if (!ptr)
+    {
+        WARN( "failed to map the shared glyph cache, error %u\n", GetLastError() );
+        return;
+    }
+
+    TRACE( "using %s, %u sets\n", name, shared_glyph_sets );
+    shared_glyph_entries = (BYTE *)ptr + entries_offset;
+    shared_glyphs = ptr;
+}
+
+static BOOL init_shared_font_key( HDC hdc, struct cached_font *font )
+{
+    struct shared_font_key *key = &font->shared_key;
+    const BYTE *ptr;
+    DWORD hash = 0x811c9dc5;
+    int i;
+
+    memset( key, 0, sizeof(*key) );
+    memcpy( &key->lf, &font->lf, FIELD_OFFSET( LOGFONTW, lfFaceName ));
+    for (i = 0; i < LF_FACESIZE - 1 && font->lf.lfFaceName[i]; i++)
+        key->lf.lfFaceName[i] = toupperW( font->lf.lfFaceName[i] );
+    key->xform = font->xform;
+    key->aa_flags = font->aa_flags;
+
+    /* only outline fonts with a 'head' table can be identified */
+    if (GetFontData( hdc, MS_HEAD_TAG, 0, key->head, sizeof(key->head) ) != sizeof(key->head))
+        return FALSE;
+
+    for (i = 0, ptr = (const BYTE *)key; i < sizeof(*key); i++)
+        hash = (hash ^ ptr[i]) * 0x01000193;
+    font->shared_hash = hash;
+    return TRUE;
+}
+
+static DWORD shared_glyph_hash( const struct cached_font *font, UINT index, enum glyph_type type )
+{
+    DWORD hash = font->shared_hash ^ (index * 0x9e3779b1) ^ type;
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+static inline struct shared_glyph *get_shared_entry( DWORD hash, UINT way )
+{
+    UINT set = hash % shared_glyph_sets;
+    return (struct shared_glyph *)(shared_glyph_entries +
+                                   (set * SHARED_GLYPH_WAYS + way) * SHARED_GLYPH_ENTRY_SIZE);
+}
+
+static inline BOOL shared_entry_matches( const struct shared_glyph *entry, const struct cached_font *font,
+                                         DWORD hash, UINT index, enum glyph_type type )
+{
+    return entry->hash == hash && entry->index == index && entry->type == type &&
+           !memcmp( &entry->key, &font->shared_key, sizeof(entry->key) );
+}
+
 static struct cached_font *add_cached_font( HDC hdc, HFONT hfont, UINT aa_flags )
 {
     struct cached_font font, *ptr, *last_unused = NULL;
@@ -501,6 +660,7 @@ static struct cached_font *add_cached_font( HDC hdc, HFONT hfont, UINT aa_flags
     font.hash = font_cache_hash( &font );
 
     EnterCriticalSection( &font_cache_cs );
+    init_shared_glyph_cache();
     LIST_FOR_EACH_ENTRY( ptr, &font_cache, struct cached_font, entry )
     {
         if (!font_cache_cmp( &font, ptr ))
@@ -539,6 +699,7 @@ static struct cached_font *add_cached_font( HDC hdc, HFONT hfont, UINT aa_flags
 
     *ptr = font;
     ptr->ref = 1;
+    ptr->shared = shared_glyphs && init_shared_font_key( hdc, ptr );
     memset( ptr->glyphs, 0, sizeof(ptr->glyphs) );
 done:
     list_add_head( &font_cache, &ptr->entry );
@@ -662,6 +823,106 @@ static int get_glyph_depth( UINT aa_flags )
     }
 }
 
+/***********************************************************************
+ *         get_shared_glyph
+ *
+ * Copy a glyph from the shared cache into the font cache of the process.
+ */
+static struct cached_glyph *get_shared_glyph( struct cached_font *font, UINT index, UINT flags )
+{
+    enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
+    struct shared_glyph *entry;
+    struct cached_glyph *glyph;
+    DWORD hash, size;
+    LONG seq;
+    UINT way;
+
+    if (!font->shared) return NULL;
+
+    hash = shared_glyph_hash( font, index, type );
+    for (way = 0; way < SHARED_GLYPH_WAYS; way++)
+    {
+        entry = get_shared_entry( hash, way );
+        seq = InterlockedCompareExchange( &entry->seq, 0, 0 );
+        if (!seq || (seq & 1)) continue;
+        if (!shared_entry_matches( entry, font, hash, index, type )) continue;
+
+        size = entry->size;
+        if (size > SHARED_GLYPH_BITS_SIZE) continue;
+        if (!(glyph = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET( struct cached_glyph, bits[size] ))))
+            return NULL;
+        glyph->metrics = entry->metrics;
+        memcpy( glyph->bits, entry->bits, size );
+
+        /* discard the copy if the entry has been replaced in the meantime */
+        if (InterlockedCompareExchange( &entry->seq, 0, 0 ) != seq ||
+            size != glyph->metrics.gmBlackBoxY * get_dib_stride( glyph->metrics.gmBlackBoxX,
+                                                                 get_glyph_depth( font->aa_flags )))
+        {
+            HeapFree( GetProcessHeap(), 0, glyph );
+            continue;
+        }
+        entry->last_used = shared_glyphs->clock;
+        return add_cached_glyph( font, index, flags, glyph );
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *         put_shared_glyph
+ *
+ * Publish a newly rasterized glyph to the other processes.
+ */
+static void put_shared_glyph( struct cached_font *font, UINT index, UINT flags,
+                              const struct cached_glyph *glyph, DWORD size )
+{
+    enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
+    struct shared_glyph *entry, *victim = NULL;
+    DWORD hash;
+    LONG *lock;
+    UINT way;
+
+    if (!font->shared || size > SHARED_GLYPH_BITS_SIZE) return;
+
+    hash = shared_glyph_hash( font, index, type );
+    lock = &shared_glyphs->locks[hash % shared_glyph_sets];
+
+    /* a process that died while holding the lock leaves the set read-only */
+    if (InterlockedCompareExchange( lock, 1, 0 )) return;
+
+    for (way = 0; way < SHARED_GLYPH_WAYS; way++)
+    {
+        entry = get_shared_entry( hash, way );
+        if (!entry->seq)
+        {
+            victim = entry;
+            break;
+        }
+        if (!(entry->seq & 1) && shared_entry_matches( entry, font, hash, index, type ))
+        {
+            victim = NULL;  /* already added by another process */
+            break;
+        }
+        if (!victim || (LONG)((ULONG)entry->last_used - (ULONG)victim->last_used) < 0) victim = entry;
+    }
+
+    if (victim)
+    {
+        if (!(victim->seq & 1)) InterlockedIncrement( &victim->seq );
+        victim->hash    = hash;
+        victim->index   = index;
+        victim->type    = type;
+        victim->key     = font->shared_key;
+        victim->metrics = glyph->metrics;
+        victim->size    = size;
+        memcpy( victim->bits, glyph->bits, size );
+        victim->last_used = InterlockedIncrement( &shared_glyphs->clock );
+        InterlockedIncrement( &victim->seq );
+    }
+
+    InterlockedExchange( lock, 0 );
+}
+
 static const BYTE masks[8] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
 static const int padding[4] = {0, 3, 2, 1};
 
@@ -733,6 +994,7 @@ static struct cached_glyph *cache_glyph_bitmap( HDC hdc, struct cached_font *fon
 
 done:
     glyph->metrics = metrics;
+    put_shared_glyph( font, index, flags, glyph, size );
     return add_cached_glyph( font, index, flags, glyph );
 }
 
@@ -760,6 +1022,7 @@ static void render_string( HDC hdc, dib_info *dib, struct cached_font *font, INT
     for (i = 0; i < count; i++)
     {
         if (!(glyph = get_cached_glyph( font, str[i], flags )) &&
+            !(glyph = get_shared_glyph( font, str[i], flags )) &&
             !(glyph = cache_glyph_bitmap( hdc, font, str[i], flags ))) continue;
 
         glyph_dib.width       = glyph->metrics.gmBlackBoxX;
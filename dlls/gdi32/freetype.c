@@ -487,6 +487,7 @@ static const WCHAR face_internal_leading_value[] = {'I','n','t','e','r','n','a',
 static const WCHAR face_font_sig_value[] = {'F','o','n','t',' ','S','i','g','n','a','t','u','r','e',0};
 static const WCHAR face_file_name_value[] = {'F','i','l','e',' ','N','a','m','e','\0'};
 static const WCHAR face_full_name_value[] = {'F','u','l','l',' ','N','a','m','e','\0'};
+static const WCHAR font_index_generation_value[] = {'I','n','d','e','x',' ','G','e','n','e','r','a','t','i','o','n',0};
 
 
 struct font_mapping
@@ -1709,6 +1710,7 @@ static void add_face_to_cache(Face *face)
     HKEY hkey_family, hkey_face;
     WCHAR *face_key_name;
 
+    RegDeleteValueW(hkey_font_cache, font_index_generation_value);
     RegCreateKeyExW(hkey_font_cache, face->family->FamilyName, 0,
                     NULL, REG_OPTION_VOLATILE, KEY_ALL_ACCESS, NULL, &hkey_family, NULL);
     if(face->family->EnglishName)
@@ -1758,6 +1760,7 @@ static void remove_face_from_cache( Face *face )
 {
     HKEY hkey_family;
 
+    RegDeleteValueW( hkey_font_cache, font_index_generation_value );
     RegOpenKeyExW( hkey_font_cache, face->family->FamilyName, 0, KEY_ALL_ACCESS, &hkey_family );
 
     if (face->scalable)
@@ -1775,6 +1778,393 @@ static void remove_face_from_cache( Face *face )
     RegCloseKey(hkey_family);
 }
 
+/* The registry font cache is also saved to a binary index in the prefix
+ * directory by the process that builds it. The other processes map the index
+ * instead of walking the registry cache, which takes several server calls per
+ * face. The index is only used if its generation matches the one stored in the
+ * registry cache; that value is removed whenever the registry cache changes. */
+
+#define FONT_INDEX_MAGIC    0x58494657  /* 'WFIX' */
+#define FONT_INDEX_VERSION  1
+
+struct font_index_header
+{
+    DWORD magic;
+    DWORD version;
+    DWORD generation;
+    DWORD size;
+    DWORD family_count;
+    DWORD face_count;
+};
+
+struct font_index_family
+{
+    DWORD name;          /* offsets of the strings from the start of the index, 0 if none */
+    DWORD english_name;
+    DWORD first_face;
+    DWORD face_count;
+};
+
+struct font_index_face
+{
+    DWORD style_name;
+    DWORD full_name;
+    DWORD file;
+    DWORD face_index;
+    DWORD ntm_flags;
+    DWORD font_version;
+    DWORD flags;
+    FONTSIGNATURE fs;
+    DWORD scalable;
+    INT   height;
+    INT   width;
+    INT   size;
+    INT   x_ppem;
+    INT   y_ppem;
+    INT   internal_leading;
+};
+
+static char *get_font_index_path( const char *suffix )
+{
+    static const char font_index_name[] = "/fontindex.dat";
+    const char *config_dir = wine_get_config_dir();
+    char *path;
+
+    if (!config_dir) return NULL;
+    if (!(path = HeapAlloc( GetProcessHeap(), 0, strlen(config_dir) + sizeof(font_index_name) +
+                            strlen(suffix) )))
+        return NULL;
+    strcpy( path, config_dir );
+    strcat( path, font_index_name );
+    strcat( path, suffix );
+    return path;
+}
+
+static int family_index_cmp( const void *a, const void *b )
+{
+    const Family *family1 = *(const Family * const *)a, *family2 = *(const Family * const *)b;
+    return strcmpiW( family1->FamilyName, family2->FamilyName );
+}
+
+/* faces are stored in the order load_font_list_from_cache() finds them in the
+ * registry: face keys in case-insensitive order, strikes after the scalable
+ * face in the order of their ppem key names */
+static int face_index_cmp( const void *a, const void *b )
+{
+    static const WCHAR fmtW[] = {'%','d',0};
+    const Face *face1 = *(const Face * const *)a, *face2 = *(const Face * const *)b;
+    WCHAR ppem1[12], ppem2[12];
+    int ret;
+
+    if ((ret = strcmpiW( face1->StyleName, face2->StyleName ))) return ret;
+    if (face1->scalable != face2->scalable) return face1->scalable ? -1 : 1;
+    if (face1->scalable) return 0;
+    sprintfW( ppem1, fmtW, face1->size.y_ppem );
+    sprintfW( ppem2, fmtW, face2->size.y_ppem );
+    return strcmpiW( ppem1, ppem2 );
+}
+
+static inline DWORD index_string_size( const WCHAR *str )
+{
+    return str ? (strlenW( str ) + 1) * sizeof(WCHAR) : 0;
+}
+
+static DWORD add_index_string( BYTE *index, DWORD *pos, const WCHAR *str )
+{
+    DWORD ret = *pos, size = index_string_size( str );
+
+    if (!size) return 0;
+    memcpy( index + ret, str, size );
+    *pos += size;
+    return ret;
+}
+
+static void save_font_index(void)
+{
+    struct font_index_header *header;
+    struct font_index_family *index_families = NULL;
+    struct font_index_face *index_faces;
+    Family *family, **families = NULL;
+    Face *face, **faces = NULL;
+    DWORD family_count = 0, face_count = 0, count, size, pos, generation, i, j;
+    char *path = NULL, *tmp_path = NULL;
+    BYTE *index = NULL;
+    int fd;
+
+    LIST_FOR_EACH_ENTRY( family, &font_list, Family, entry )
+    {
+        family_count++;
+        LIST_FOR_EACH_ENTRY( face, &family->faces, Face, entry ) face_count++;
+    }
+
+    families = HeapAlloc( GetProcessHeap(), 0, family_count * sizeof(*families) );
+    index_families = HeapAlloc( GetProcessHeap(), 0, family_count * sizeof(*index_families) );
+    faces = HeapAlloc( GetProcessHeap(), 0, face_count * sizeof(*faces) );
+    if ((family_count && (!families || !index_families)) || (face_count && !faces)) goto done;
+
+    i = 0;
+    LIST_FOR_EACH_ENTRY( family, &font_list, Family, entry ) families[i++] = family;
+    qsort( families, family_count, sizeof(*families), family_index_cmp );
+
+    /* only the faces stored in the registry cache go to the index, and family
+     * names differing only by case share the same registry key */
+    count = face_count = 0;
+    size = sizeof(*header);
+    for (i = 0; i < family_count; i++)
+    {
+        if (!count || strcmpiW( families[i]->FamilyName, families[i - 1]->FamilyName ))
+        {
+            if (count && !index_families[count - 1].face_count) count--;
+            index_families[count].name = i;  /* for now the index of the family */
+            index_families[count].first_face = face_count;
+            index_families[count].face_count = 0;
+            count++;
+        }
+        LIST_FOR_EACH_ENTRY( face, &families[i]->faces, Face, entry )
+        {
+            if (!(face->flags & ADDFONT_ADD_TO_CACHE)) continue;
+            faces[face_count++] = face;
+            index_families[count - 1].face_count++;
+        }
+    }
+    if (count && !index_families[count - 1].face_count) count--;
+
+    for (i = 0; i < count; i++)
+    {
+        family = families[index_families[i].name];
+        size += sizeof(*index_families) + index_string_size( family->FamilyName ) +
+                index_string_size( family->EnglishName );
+        qsort( faces + index_families[i].first_face, index_families[i].face_count,
+               sizeof(*faces), face_index_cmp );
+    }
+    for (i = 0; i < face_count; i++)
+        size += sizeof(*index_faces) + index_string_size( faces[i]->StyleName ) +
+                index_string_size( faces[i]->FullName ) + index_string_size( faces[i]->file );
+
+    if (!(index = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, size ))) goto done;
+
+    generation = GetTickCount() ^ (GetCurrentProcessId() << 16);
+    if (!generation) generation = 1;
+
+    header = (struct font_index_header *)index;
+    header->magic        = FONT_INDEX_MAGIC;
+    header->version      = FONT_INDEX_VERSION;
+    header->generation   = generation;
+    header->size         = size;
+    header->family_count = count;
+    header->face_count   = face_count;
+
+    index_faces = (struct font_index_face *)((struct font_index_family *)(header + 1) + count);
+    pos = (BYTE *)(index_faces + face_count) - index;
+
+    for (i = 0; i < count; i++)
+    {
+        struct font_index_family *index_family = (struct font_index_family *)(header + 1) + i;
+
+        family = families[index_families[i].name];
+        index_family->name         = add_index_string( index, &pos, family->FamilyName );
+        index_family->english_name = add_index_string( index, &pos, family->EnglishName );
+        index_family->first_face   = index_families[i].first_face;
+        index_family->face_count   = index_families[i].face_count;
+    }
+
+    for (j = 0; j < face_count; j++)
+    {
+        struct font_index_face *index_face = index_faces + j;
+
+        face = faces[j];
+        index_face->style_name       = add_index_string( index, &pos, face->StyleName );
+        index_face->full_name        = add_index_string( index, &pos, face->FullName );
+        index_face->file             = add_index_string( index, &pos, face->file );
+        index_face->face_index       = face->face_index;
+        index_face->ntm_flags        = face->ntmFlags;
+        index_face->font_version     = face->font_version;
+        index_face->flags            = face->flags;
+        index_face->fs               = face->fs;
+        index_face->scalable         = face->scalable;
+        index_face->height           = face->size.height;
+        index_face->width            = face->size.width;
+        index_face->size             = face->size.size;
+        index_face->x_ppem           = face->size.x_ppem;
+        index_face->y_ppem           = face->size.y_ppem;
+        index_face->internal_leading = face->size.internal_leading;
+    }
+    assert( pos == size );
+
+    /* write to a temporary file so that readers never see a partial index */
+    if (!(path = get_font_index_path( "" )) || !(tmp_path = get_font_index_path( ".tmp" ))) goto done;
+    if ((fd = open( tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644 )) == -1)
+    {
+        WARN( "can't create %s\n", debugstr_a(tmp_path) );
+        goto done;
+    }
+    pos = write( fd, index, size );
+    close( fd );
+    if (pos != size || rename( tmp_path, path ) == -1)
+    {
+        WARN( "can't write %s\n", debugstr_a(path) );
+        unlink( tmp_path );
+        goto done;
+    }
+
+    reg_save_dword( hkey_font_cache, font_index_generation_value, generation );
+    TRACE( "saved %u families, %u faces to %s\n", count, face_count, debugstr_a(path) );
+
+done:
+    HeapFree( GetProcessHeap(), 0, index );
+    HeapFree( GetProcessHeap(), 0, path );
+    HeapFree( GetProcessHeap(), 0, tmp_path );
+    HeapFree( GetProcessHeap(), 0, faces );
+    HeapFree( GetProcessHeap(), 0, index_families );
+    HeapFree( GetProcessHeap(), 0, families );
+}
+
+static const WCHAR *get_index_string( const BYTE *index, DWORD size, DWORD offset )
+{
+    const WCHAR *str;
+    DWORD i;
+
+    if (!offset) return NULL;
+    if (offset >= size || offset % sizeof(WCHAR)) return NULL;
+    str = (const WCHAR *)(index + offset);
+    for (i = 0; i < (size - offset) / sizeof(WCHAR); i++) if (!str[i]) return str;
+    return NULL;
+}
+
+static BOOL validate_font_index( const BYTE *index, DWORD size, DWORD generation )
+{
+    const struct font_index_header *header = (const struct font_index_header *)index;
+    const struct font_index_family *families;
+    const struct font_index_face *faces;
+    DWORD i;
+
+    if (size < sizeof(*header)) return FALSE;
+    if (header->magic != FONT_INDEX_MAGIC || header->version != FONT_INDEX_VERSION ||
+        header->generation != generation || header->size != size)
+        return FALSE;
+    if (header->family_count > size / sizeof(*families) || header->face_count > size / sizeof(*faces) ||
+        sizeof(*header) + header->family_count * sizeof(*families) +
+        header->face_count * sizeof(*faces) > size)
+        return FALSE;
+
+    families = (const struct font_index_family *)(header + 1);
+    faces = (const struct font_index_face *)(families + header->family_count);
+    for (i = 0; i < header->family_count; i++)
+    {
+        if (!get_index_string( index, size, families[i].name )) return FALSE;
+        if (families[i].english_name && !get_index_string( index, size, families[i].english_name ))
+            return FALSE;
+        if (families[i].first_face > header->face_count ||
+            families[i].face_count > header->face_count - families[i].first_face)
+            return FALSE;
+    }
+    for (i = 0; i < header->face_count; i++)
+    {
+        if (!get_index_string( index, size, faces[i].style_name )) return FALSE;
+        if (!get_index_string( index, size, faces[i].file )) return FALSE;
+        if (faces[i].full_name && !get_index_string( index, size, faces[i].full_name )) return FALSE;
+    }
+    return TRUE;
+}
+
+/* same as load_face(), from an index entry */
+static void load_face_from_index( const BYTE *index, DWORD size, const struct font_index_face *index_face,
+                                  Family *family )
+{
+    const WCHAR *full_name = get_index_string( index, size, index_face->full_name );
+    Face *face = HeapAlloc( GetProcessHeap(), 0, sizeof(*face) );
+
+    face->cached_enum_data = NULL;
+    face->family = NULL;
+    face->refcount = 1;
+    face->file = strdupW( get_index_string( index, size, index_face->file ));
+    face->StyleName = strdupW( get_index_string( index, size, index_face->style_name ));
+    face->FullName = full_name ? strdupW( full_name ) : NULL;
+    face->face_index = index_face->face_index;
+    face->ntmFlags = index_face->ntm_flags;
+    face->font_version = index_face->font_version;
+    face->flags = index_face->flags;
+    face->fs = index_face->fs;
+    face->scalable = index_face->scalable;
+    face->size.height = index_face->height;
+    face->size.width = index_face->width;
+    face->size.size = index_face->size;
+    face->size.x_ppem = index_face->x_ppem;
+    face->size.y_ppem = index_face->y_ppem;
+    face->size.internal_leading = index_face->internal_leading;
+
+    if (insert_face_in_family_list(face, family))
+        TRACE("Added font %s %s\n", debugstr_w(family->FamilyName), debugstr_w(face->StyleName));
+
+    release_face( face );
+}
+
+static BOOL load_font_list_from_index(void)
+{
+    const struct font_index_header *header;
+    const struct font_index_family *families;
+    const struct font_index_face *faces;
+    DWORD generation, i, j;
+    struct stat st;
+    BYTE *index = NULL;
+    char *path;
+    int fd;
+
+    if (reg_load_dword( hkey_font_cache, font_index_generation_value, &generation )) return FALSE;
+    if (!(path = get_font_index_path( "" ))) return FALSE;
+
+    fd = open( path, O_RDONLY );
+    HeapFree( GetProcessHeap(), 0, path );
+    if (fd == -1) return FALSE;
+    if (fstat( fd, &st ) != -1 && st.st_size >= sizeof(*header) && st.st_size <= 0x7fffffff)
+    {
+        index = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+        if (index == MAP_FAILED) index = NULL;
+    }
+    close( fd );
+    if (!index) return FALSE;
+
+    if (!validate_font_index( index, st.st_size, generation ))
+    {
+        WARN( "ignoring stale or invalid font index\n" );
+        munmap( index, st.st_size );
+        return FALSE;
+    }
+
+    header = (const struct font_index_header *)index;
+    families = (const struct font_index_family *)(header + 1);
+    faces = (const struct font_index_face *)(families + header->family_count);
+
+    for (i = 0; i < header->family_count; i++)
+    {
+        const WCHAR *english_name = get_index_string( index, st.st_size, families[i].english_name );
+        WCHAR *english_family = english_name ? strdupW( english_name ) : NULL;
+        Family *family;
+
+        family = create_family( strdupW( get_index_string( index, st.st_size, families[i].name )),
+                                english_family );
+        if (english_family)
+        {
+            FontSubst *subst = HeapAlloc(GetProcessHeap(), 0, sizeof(*subst));
+            subst->from.name = strdupW(english_family);
+            subst->from.charset = -1;
+            subst->to.name = strdupW(family->FamilyName);
+            subst->to.charset = -1;
+            add_font_subst(&font_subst_list, subst, 0);
+        }
+
+        for (j = 0; j < families[i].face_count; j++)
+            load_face_from_index( index, st.st_size, faces + families[i].first_face + j, family );
+
+        release_family( family );
+    }
+
+    TRACE( "loaded %u families, %u faces\n", header->family_count, header->face_count );
+    munmap( index, st.st_size );
+    reorder_vertical_fonts();
+    return TRUE;
+}
+
 static WCHAR *prepend_at(WCHAR *family)
 {
     WCHAR *str;
@@ -4135,8 +4525,11 @@ BOOL WineEngInit(void)
     create_font_cache_key(&hkey_font_cache, &disposition);
 
     if(disposition == REG_CREATED_NEW_KEY)
+    {
         init_font_list();
-    else
+        save_font_index();
+    }
+    else if (!load_font_list_from_index())
         load_font_list_from_cache(hkey_font_cache);
 
     reorder_font_list();
@@ -17,6 +17,7 @@
  */
 
 #include <stdarg.h>
+#include <stdlib.h>
 #include <math.h>
 #include <limits.h>
 
@@ -939,6 +940,316 @@ static ARGB resample_bitmap_pixel(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT
     }
 }
 
+/* Weights are fixed point numbers with this many fractional bits. */
+#define RESAMPLE_WEIGHT_BITS 14
+
+/* Filter taps of one destination row or column: count source pixels
+ * starting at first, with their weights at offset in the weight table,
+ * and the weight of the outside color for taps beyond the image. */
+struct resample_taps
+{
+    INT first;
+    INT count;
+    INT offset;
+    INT outside;
+};
+
+static BOOL resample_filter_is_cubic(InterpolationMode interpolation)
+{
+    return interpolation == InterpolationModeBicubic ||
+           interpolation == InterpolationModeHighQualityBicubic ||
+           interpolation == InterpolationModeHighQuality;
+}
+
+static BOOL resample_filter_is_prefiltered(InterpolationMode interpolation)
+{
+    return interpolation == InterpolationModeHighQualityBilinear ||
+           interpolation == InterpolationModeHighQualityBicubic ||
+           interpolation == InterpolationModeHighQuality;
+}
+
+static REAL resample_filter(BOOL cubic, REAL x)
+{
+    x = fabsf(x);
+
+    if (!cubic)
+        return x < 1.0 ? 1.0 - x : 0.0;
+
+    /* cubic convolution with a = -0.5 */
+    if (x < 1.0)
+        return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0)
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+/* Computes the filter taps for dst_count destination pixels. Destination
+ * pixel i samples the source at origin + (i + pixel_offset) * step, where
+ * source pixel j is at j + pixel_offset; pixels sampling outside
+ * [src_start, src_end) aren't drawn. Like sample_bitmap_pixel, taps
+ * outside the image of the given size use the outside color, the others
+ * are clamped to the source pixels lo..hi. */
+static GpStatus resample_get_taps(InterpolationMode interpolation, REAL pixel_offset,
+    REAL origin, REAL step, INT dst_count, REAL src_start, REAL src_end,
+    INT lo, INT hi, INT size, struct resample_taps **taps, SHORT **weights)
+{
+    BOOL cubic = resample_filter_is_cubic(interpolation);
+    REAL stretch = 1.0, radius = cubic ? 2.0 : 1.0;
+    REAL *values;
+    INT i, j, max_taps;
+
+    /* When downscaling, the high quality modes widen the filter so that
+     * every source pixel contributes to the result. */
+    if (resample_filter_is_prefiltered(interpolation) && fabsf(step) > 1.0)
+        stretch = fabsf(step);
+    radius *= stretch;
+    max_taps = min((INT)ceilf(radius * 2.0) + 1, hi - lo + 1);
+
+    *taps = GdipAlloc(sizeof(**taps) * dst_count);
+    *weights = GdipAlloc(sizeof(**weights) * dst_count * max_taps);
+    values = GdipAlloc(sizeof(*values) * max_taps);
+    if (!*taps || !*weights || !values)
+    {
+        GdipFree(*taps);
+        GdipFree(*weights);
+        GdipFree(values);
+        return OutOfMemory;
+    }
+
+    for (i = 0; i < dst_count; i++)
+    {
+        struct resample_taps *tap = &(*taps)[i];
+        SHORT *weight = *weights + i * max_taps;
+        REAL pos = origin + (i + pixel_offset) * step;
+        REAL center = pos - pixel_offset, total = 0.0, outside = 0.0;
+        INT first, last, sum, largest = 0;
+
+        tap->offset = i * max_taps;
+        tap->first = tap->count = tap->outside = 0;
+
+        if (pos < src_start || pos >= src_end)
+            continue;
+
+        first = ceilf(center - radius);
+        last = floorf(center + radius);
+        if (first > hi) first = hi;
+        if (last < lo) last = lo;
+
+        tap->first = max(first, lo);
+        tap->count = min(last, hi) - tap->first + 1;
+        if (tap->count > max_taps)
+        {
+            /* only possible through rounding at the edges */
+            tap->count = max_taps;
+        }
+
+        memset(values, 0, sizeof(*values) * max_taps);
+        for (j = first; j <= last; j++)
+        {
+            INT index = min(max(j, lo), hi) - tap->first;
+            REAL value = resample_filter(cubic, (j - center) / stretch);
+
+            total += value;
+            if (j < 0 || j >= size)
+            {
+                outside += value;
+                continue;
+            }
+            if (index >= tap->count) index = tap->count - 1;
+            values[index] += value;
+        }
+
+        if (total == 0.0)
+        {
+            /* the center is exactly between two taps of the linear filter */
+            values[0] = total = 1.0;
+            outside = 0.0;
+        }
+
+        tap->outside = gdip_round(outside / total * (1 << RESAMPLE_WEIGHT_BITS));
+        sum = tap->outside;
+        for (j = 0; j < tap->count; j++)
+        {
+            weight[j] = gdip_round(values[j] / total * (1 << RESAMPLE_WEIGHT_BITS));
+            sum += weight[j];
+            if (weight[j] > weight[largest])
+                largest = j;
+        }
+
+        /* make the weights add up to exactly one */
+        weight[largest] += (1 << RESAMPLE_WEIGHT_BITS) - sum;
+    }
+
+    GdipFree(values);
+    return Ok;
+}
+
+static inline BYTE resample_clamp(INT value, INT max_value)
+{
+    if (value < 0) return 0;
+    if (value > max_value) return max_value;
+    return value;
+}
+
+/* Resamples an axis-aligned scaled image in two separable passes, using
+ * precomputed filter weights for every destination column and row.
+ * src_data is premultiplied ARGB, dst_data receives ARGB. */
+static GpStatus resample_bitmap_scaled(GDIPCONST GpRect *src_area, const DWORD *src_data,
+    UINT width, UINT height, REAL srcx, REAL srcy, REAL srcwidth, REAL srcheight,
+    const GpPointF *origin, REAL x_step, REAL y_step, const RECT *dst_area, DWORD *dst_data,
+    GDIPCONST GpImageAttributes *attributes, InterpolationMode interpolation,
+    PixelOffsetMode offset_mode)
+{
+    INT dst_width = dst_area->right - dst_area->left;
+    INT dst_height = dst_area->bottom - dst_area->top;
+    INT lo_x = src_area->X, hi_x = src_area->X + src_area->Width - 1;
+    INT lo_y = src_area->Y, hi_y = src_area->Y + src_area->Height - 1;
+    struct resample_taps *x_taps, *y_taps;
+    SHORT *x_weights, *y_weights;
+    INT first_row, last_row, x, y, i;
+    INT outside[4];
+    INT *rows;
+    REAL pixel_offset;
+    GpStatus stat;
+
+    if (lo_x > hi_x || lo_y > hi_y)
+        return Ok;
+
+    /* the same sample positions as resample_bitmap_pixel */
+    switch (offset_mode)
+    {
+    default:
+    case PixelOffsetModeNone:
+    case PixelOffsetModeHighSpeed:
+        pixel_offset = 0.0;
+        break;
+
+    case PixelOffsetModeHalf:
+    case PixelOffsetModeHighQuality:
+        pixel_offset = 0.5;
+        break;
+    }
+
+    /* premultiplied outside color */
+    outside[3] = attributes->outside_color >> 24;
+    outside[2] = ((attributes->outside_color >> 16) & 0xff) * outside[3] / 0xff;
+    outside[1] = ((attributes->outside_color >> 8) & 0xff) * outside[3] / 0xff;
+    outside[0] = (attributes->outside_color & 0xff) * outside[3] / 0xff;
+
+    stat = resample_get_taps(interpolation, pixel_offset, origin->X + dst_area->left * x_step, x_step,
+        dst_width, srcx, srcx + srcwidth, lo_x, hi_x, width, &x_taps, &x_weights);
+    if (stat != Ok)
+        return stat;
+
+    stat = resample_get_taps(interpolation, pixel_offset, origin->Y + dst_area->top * y_step, y_step,
+        dst_height, srcy, srcy + srcheight, lo_y, hi_y, height, &y_taps, &y_weights);
+    if (stat != Ok)
+    {
+        GdipFree(x_taps);
+        GdipFree(x_weights);
+        return stat;
+    }
+
+    /* find the source rows needed by the vertical pass */
+    first_row = hi_y + 1;
+    last_row = lo_y - 1;
+    for (y = 0; y < dst_height; y++)
+    {
+        if (!y_taps[y].count) continue;
+        first_row = min(first_row, y_taps[y].first);
+        last_row = max(last_row, y_taps[y].first + y_taps[y].count - 1);
+    }
+
+    if (first_row > last_row)
+        rows = NULL;
+    else if (!(rows = GdipAlloc(sizeof(*rows) * 4 * dst_width * (last_row - first_row + 1))))
+        stat = OutOfMemory;
+
+    /* horizontal pass, the result keeps 6 fractional bits */
+    for (y = first_row; rows && y <= last_row; y++)
+    {
+        const DWORD *src_row = src_data + (y - src_area->Y) * src_area->Width - src_area->X;
+        INT *row = rows + 4 * dst_width * (y - first_row);
+
+        for (x = 0; x < dst_width; x++, row += 4)
+        {
+            const struct resample_taps *tap = &x_taps[x];
+            const SHORT *weight = x_weights + tap->offset;
+            const DWORD *src = src_row + tap->first;
+            INT b = tap->outside * outside[0], g = tap->outside * outside[1];
+            INT r = tap->outside * outside[2], a = tap->outside * outside[3];
+
+            for (i = 0; i < tap->count; i++)
+            {
+                DWORD pixel = src[i];
+                b += weight[i] * (INT)(pixel & 0xff);
+                g += weight[i] * (INT)((pixel >> 8) & 0xff);
+                r += weight[i] * (INT)((pixel >> 16) & 0xff);
+                a += weight[i] * (INT)(pixel >> 24);
+            }
+
+            row[0] = (b + (1 << (RESAMPLE_WEIGHT_BITS - 7))) >> (RESAMPLE_WEIGHT_BITS - 6);
+            row[1] = (g + (1 << (RESAMPLE_WEIGHT_BITS - 7))) >> (RESAMPLE_WEIGHT_BITS - 6);
+            row[2] = (r + (1 << (RESAMPLE_WEIGHT_BITS - 7))) >> (RESAMPLE_WEIGHT_BITS - 6);
+            row[3] = (a + (1 << (RESAMPLE_WEIGHT_BITS - 7))) >> (RESAMPLE_WEIGHT_BITS - 6);
+        }
+    }
+
+    /* vertical pass, converting back to straight alpha */
+    for (y = 0; rows && y < dst_height; y++)
+    {
+        const struct resample_taps *tap = &y_taps[y];
+        const SHORT *weight = y_weights + tap->offset;
+        const INT *src = rows + 4 * dst_width * (tap->first - first_row);
+        DWORD *dst = dst_data + y * dst_width;
+
+        if (!tap->count)
+            continue;
+
+        for (x = 0; x < dst_width; x++, src += 4)
+        {
+            const INT round = 1 << (RESAMPLE_WEIGHT_BITS + 5);
+            INT b = round + ((tap->outside * outside[0]) << 6), g = round + ((tap->outside * outside[1]) << 6);
+            INT r = round + ((tap->outside * outside[2]) << 6), a = round + ((tap->outside * outside[3]) << 6);
+            BYTE alpha;
+
+            if (!x_taps[x].count)
+                continue;
+
+            for (i = 0; i < tap->count; i++)
+            {
+                const INT *pixel = src + 4 * dst_width * i;
+                b += weight[i] * pixel[0];
+                g += weight[i] * pixel[1];
+                r += weight[i] * pixel[2];
+                a += weight[i] * pixel[3];
+            }
+
+            alpha = resample_clamp(a >> (RESAMPLE_WEIGHT_BITS + 6), 0xff);
+            if (!alpha)
+                continue;
+
+            b = resample_clamp(b >> (RESAMPLE_WEIGHT_BITS + 6), alpha);
+            g = resample_clamp(g >> (RESAMPLE_WEIGHT_BITS + 6), alpha);
+            r = resample_clamp(r >> (RESAMPLE_WEIGHT_BITS + 6), alpha);
+            if (alpha != 0xff)
+            {
+                b = (b * 0xff + alpha / 2) / alpha;
+                g = (g * 0xff + alpha / 2) / alpha;
+                r = (r * 0xff + alpha / 2) / alpha;
+            }
+            dst[x] = (alpha << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+
+    GdipFree(rows);
+    GdipFree(x_taps);
+    GdipFree(x_weights);
+    GdipFree(y_taps);
+    GdipFree(y_weights);
+    return stat;
+}
+
 static REAL intersect_line_scanline(const GpPointF *p1, const GpPointF *p2, REAL y)
 {
     return (p1->X - p2->X) * (p2->Y - y) / (p2->Y - p1->Y) + p2->X;
@@ -2924,23 +3235,44 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
             y_dx = dst_to_src_points[2].X - dst_to_src_points[0].X;
             y_dy = dst_to_src_points[2].Y - dst_to_src_points[0].Y;
 
-            for (x=dst_area.left; x<dst_area.right; x++)
+            if (x_dy == 0.0 && y_dx == 0.0 && imageAttributes->wrap == WrapModeClamp &&
+                interpolation != InterpolationModeNearestNeighbor)
+            {
+                /* Scaling without rotation can be done one axis at a time. */
+                convert_32bppARGB_to_32bppPARGB(src_area.Width, src_area.Height,
+                    src_data, src_stride, src_data, src_stride);
+
+                stat = resample_bitmap_scaled(&src_area, (DWORD*)src_data, bitmap->width, bitmap->height,
+                    srcx, srcy, srcwidth, srcheight, &dst_to_src_points[0], x_dx, y_dy, &dst_area,
+                    (DWORD*)dst_data, imageAttributes, interpolation, offset_mode);
+
+                if (stat != Ok)
+                {
+                    GdipFree(src_data);
+                    GdipFree(dst_data);
+                    return stat;
+                }
+            }
+            else
             {
-                for (y=dst_area.top; y<dst_area.bottom; y++)
+                for (x=dst_area.left; x<dst_area.right; x++)
                 {
-                    GpPointF src_pointf;
-                    ARGB *dst_color;
+                    for (y=dst_area.top; y<dst_area.bottom; y++)
+                    {
+                        GpPointF src_pointf;
+                        ARGB *dst_color;
 
-                    src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
-                    src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
+                        src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
+                        src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
 
-                    dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
+                        dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
 
-                    if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
-                        *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
-                                                           imageAttributes, interpolation, offset_mode);
-                    else
-                        *dst_color = 0;
+                        if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
+                            *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
+                                                               imageAttributes, interpolation, offset_mode);
+                        else
+                            *dst_color = 0;
+                    }
                 }
             }
 
@@ -3547,25 +3879,374 @@ end:
     return retval;
 }
 
+/* Number of sub-scanlines sampled per pixel row when anti-aliasing.
+ * Horizontal coverage is computed exactly. */
+#define RASTER_SUBSCANLINES 16
+
+struct raster_edge
+{
+    REAL ymin, ymax;
+    REAL x; /* x at ymin */
+    REAL dxdy;
+    INT winding;
+};
+
+struct raster_crossing
+{
+    REAL x;
+    INT winding;
+};
+
+static int raster_edge_compare(const void *a, const void *b)
+{
+    const struct raster_edge *edge_a = a, *edge_b = b;
+
+    if (edge_a->ymin < edge_b->ymin) return -1;
+    if (edge_a->ymin > edge_b->ymin) return 1;
+    return 0;
+}
+
+static void raster_add_edge(struct raster_edge *edges, INT *count,
+    const GpPointF *start, const GpPointF *end, REAL offset)
+{
+    struct raster_edge *edge = &edges[*count];
+
+    /* horizontal edges don't cross any scanline */
+    if (start->Y == end->Y)
+        return;
+
+    if (start->Y < end->Y)
+    {
+        edge->ymin = start->Y + offset;
+        edge->ymax = end->Y + offset;
+        edge->x = start->X + offset;
+        edge->winding = 1;
+    }
+    else
+    {
+        edge->ymin = end->Y + offset;
+        edge->ymax = start->Y + offset;
+        edge->x = end->X + offset;
+        edge->winding = -1;
+    }
+    edge->dxdy = (end->X - start->X) / (end->Y - start->Y);
+    (*count)++;
+}
+
+/* Builds the sorted edge list of a flattened path. Every figure is
+ * implicitly closed. */
+static GpStatus raster_build_edges(const GpPath *path, REAL offset,
+    struct raster_edge **edges, INT *count)
+{
+    const GpPointF *points = path->pathdata.Points;
+    const BYTE *types = path->pathdata.Types;
+    INT i, start = 0;
+
+    *count = 0;
+    *edges = GdipAlloc(sizeof(**edges) * (path->pathdata.Count + 1));
+    if (!*edges)
+        return OutOfMemory;
+
+    for (i = 1; i <= path->pathdata.Count; i++)
+    {
+        if (i == path->pathdata.Count || (types[i] & PathPointTypePathTypeMask) == PathPointTypeStart)
+        {
+            raster_add_edge(*edges, count, &points[i-1], &points[start], offset);
+            start = i;
+        }
+        else
+            raster_add_edge(*edges, count, &points[i-1], &points[i], offset);
+    }
+
+    qsort(*edges, *count, sizeof(**edges), raster_edge_compare);
+
+    return Ok;
+}
+
+/* Adds the coverage of the span [left, right) on one sub-scanline. The
+ * coverage of partially covered pixels goes to area, fully covered runs are
+ * stored as start/end markers in cover and summed up once per row. */
+static void raster_add_span(REAL *area, REAL *cover, INT width, REAL left, REAL right,
+    REAL weight, BOOL antialias)
+{
+    INT first, last;
+
+    if (left < 0.0) left = 0.0;
+    if (right > width) right = width;
+    if (left >= right)
+        return;
+
+    if (!antialias)
+    {
+        /* pixels whose centers are in the span */
+        first = ceilf(left - 0.5);
+        last = ceilf(right - 0.5);
+        if (first < last)
+        {
+            cover[first] += 1.0;
+            cover[last] -= 1.0;
+        }
+        return;
+    }
+
+    first = floorf(left);
+    last = floorf(right);
+    if (first == last)
+    {
+        area[first] += (right - left) * weight;
+        return;
+    }
+
+    area[first] += (first + 1 - left) * weight;
+    cover[first + 1] += weight;
+    cover[last] -= weight;
+    if (last < width)
+        area[last] += (right - last) * weight;
+}
+
+/* Renders the coverage of a flattened path, in device coordinates, to a
+ * zero-initialized 8-bit mask covering fill_area. Returns the bounds of the covered pixels
+ * in covered (relative to fill_area). */
+static GpStatus raster_fill_mask(const GpPath *path, FillMode fill_mode, BOOL antialias,
+    REAL offset, const GpRect *fill_area, BYTE *mask, RECT *covered)
+{
+    struct raster_edge *edges;
+    struct raster_crossing *crossings;
+    INT *active;
+    REAL *area, *cover;
+    INT edge_count, active_count = 0, next_edge = 0;
+    INT samples = antialias ? RASTER_SUBSCANLINES : 1;
+    REAL weight = 1.0 / samples;
+    INT x, y, sample, i, j;
+    GpStatus stat;
+
+    stat = raster_build_edges(path, offset, &edges, &edge_count);
+    if (stat != Ok)
+        return stat;
+
+    crossings = GdipAlloc(sizeof(*crossings) * (edge_count + 1));
+    active = GdipAlloc(sizeof(*active) * (edge_count + 1));
+    area = GdipAlloc(sizeof(*area) * (fill_area->Width + 1));
+    cover = GdipAlloc(sizeof(*cover) * (fill_area->Width + 1));
+    if (!crossings || !active || !area || !cover)
+    {
+        stat = OutOfMemory;
+        goto end;
+    }
+
+    covered->left = fill_area->Width;
+    covered->top = fill_area->Height;
+    covered->right = covered->bottom = 0;
+
+    for (y = 0; y < fill_area->Height; y++)
+    {
+        BYTE *row = mask + y * fill_area->Width;
+        REAL sum = 0.0;
+
+        for (sample = 0; sample < samples; sample++)
+        {
+            REAL sample_y = fill_area->Y + y + (sample + 0.5) * weight;
+            INT winding = 0;
+
+            /* update the active edge list */
+            for (i = 0, j = 0; i < active_count; i++)
+                if (edges[active[i]].ymax > sample_y)
+                    active[j++] = active[i];
+            active_count = j;
+            while (next_edge < edge_count && edges[next_edge].ymin <= sample_y)
+            {
+                if (edges[next_edge].ymax > sample_y)
+                    active[active_count++] = next_edge;
+                next_edge++;
+            }
+
+            if (!active_count)
+                continue;
+
+            /* sort the crossings of this sub-scanline by x */
+            for (i = 0; i < active_count; i++)
+            {
+                const struct raster_edge *edge = &edges[active[i]];
+                struct raster_crossing crossing;
+
+                crossing.x = edge->x + (sample_y - edge->ymin) * edge->dxdy - fill_area->X;
+                crossing.winding = edge->winding;
+
+                for (j = i; j > 0 && crossings[j-1].x > crossing.x; j--)
+                    crossings[j] = crossings[j-1];
+                crossings[j] = crossing;
+            }
+
+            for (i = 0; i < active_count - 1; i++)
+            {
+                winding += crossings[i].winding;
+                if (fill_mode == FillModeAlternate ? (winding & 1) : winding)
+                    raster_add_span(area, cover, fill_area->Width, crossings[i].x,
+                        crossings[i+1].x, weight, antialias);
+            }
+        }
+
+        for (x = 0; x < fill_area->Width; x++)
+        {
+            REAL coverage;
+
+            sum += cover[x];
+            coverage = sum + area[x];
+            if (coverage >= 1.0)
+                row[x] = 0xff;
+            else if (coverage > 0.0)
+                row[x] = coverage * 255.0 + 0.5;
+            else
+                row[x] = 0;
+
+            if (row[x])
+            {
+                if (x < covered->left) covered->left = x;
+                if (x >= covered->right) covered->right = x + 1;
+                if (y < covered->top) covered->top = y;
+                covered->bottom = y + 1;
+            }
+        }
+
+        memset(area, 0, sizeof(*area) * (fill_area->Width + 1));
+        memset(cover, 0, sizeof(*cover) * (fill_area->Width + 1));
+
+        if (!active_count)
+        {
+            if (next_edge == edge_count)
+                break;
+
+            /* skip the empty rows above the next edge */
+            while (y + 1 < fill_area->Height && fill_area->Y + y + 2 <= edges[next_edge].ymin)
+                y++;
+        }
+    }
+
+end:
+    GdipFree(edges);
+    GdipFree(crossings);
+    GdipFree(active);
+    GdipFree(area);
+    GdipFree(cover);
+    return stat;
+}
+
 static GpStatus SOFTWARE_GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPath *path)
 {
     GpStatus stat;
-    GpRegion *rgn;
+    GpPath *flat_path;
+    GpMatrix world_to_device;
+    GpRectF graphics_bounds, path_bounds;
+    GpRect fill_area, gp_bound_rect;
+    RECT covered;
+    BYTE *mask = NULL;
+    DWORD *pixel_data;
+    BOOL antialias;
+    REAL offset;
+    INT x, y;
 
     if (!brush_can_fill_pixels(brush))
         return NotImplemented;
 
-    /* FIXME: This could probably be done more efficiently without regions. */
+    antialias = graphics->smoothing == SmoothingModeAntiAlias ||
+                graphics->smoothing == SmoothingModeHighQuality;
+
+    /* The rasterizer puts pixel centers at half-integer coordinates. */
+    offset = (graphics->pixeloffset == PixelOffsetModeHalf ||
+              graphics->pixeloffset == PixelOffsetModeHighQuality) ? 0.0 : 0.5;
+
+    stat = get_graphics_bounds(graphics, &graphics_bounds);
+
+    if (stat == Ok)
+        stat = GdipClonePath(path, &flat_path);
+
+    if (stat != Ok)
+        return stat;
+
+    stat = get_graphics_transform(graphics, CoordinateSpaceDevice,
+        CoordinateSpaceWorld, &world_to_device);
+
+    if (stat == Ok)
+        stat = GdipFlattenPath(flat_path, &world_to_device, 0.25);
+
+    if (stat == Ok)
+        stat = GdipGetPathWorldBounds(flat_path, &path_bounds, NULL, NULL);
+
+    if (stat == Ok)
+    {
+        INT left = max(floorf(path_bounds.X + offset), graphics_bounds.X);
+        INT top = max(floorf(path_bounds.Y + offset), graphics_bounds.Y);
+        INT right = min(ceilf(path_bounds.X + path_bounds.Width + offset),
+                        graphics_bounds.X + graphics_bounds.Width);
+        INT bottom = min(ceilf(path_bounds.Y + path_bounds.Height + offset),
+                         graphics_bounds.Y + graphics_bounds.Height);
+
+        if (left >= right || top >= bottom)
+        {
+            GdipDeletePath(flat_path);
+            return Ok;
+        }
+
+        fill_area.X = left;
+        fill_area.Y = top;
+        fill_area.Width = right - left;
+        fill_area.Height = bottom - top;
+
+        mask = GdipAlloc(fill_area.Width * fill_area.Height);
+        if (!mask)
+            stat = OutOfMemory;
+    }
+
+    if (stat == Ok)
+        stat = raster_fill_mask(flat_path, flat_path->fill, antialias, offset,
+            &fill_area, mask, &covered);
 
-    stat = GdipCreateRegionPath(path, &rgn);
+    GdipDeletePath(flat_path);
+
+    if (stat != Ok || covered.left >= covered.right)
+    {
+        GdipFree(mask);
+        return stat;
+    }
+
+    gp_bound_rect.X = fill_area.X + covered.left;
+    gp_bound_rect.Y = fill_area.Y + covered.top;
+    gp_bound_rect.Width = covered.right - covered.left;
+    gp_bound_rect.Height = covered.bottom - covered.top;
+
+    pixel_data = GdipAlloc(sizeof(*pixel_data) * gp_bound_rect.Width * gp_bound_rect.Height);
+    if (!pixel_data)
+        stat = OutOfMemory;
+
+    if (stat == Ok)
+        stat = brush_fill_pixels(graphics, brush, pixel_data,
+            &gp_bound_rect, gp_bound_rect.Width);
 
     if (stat == Ok)
     {
-        stat = GdipFillRegion(graphics, brush, rgn);
+        /* scale the brush alpha by the coverage */
+        for (y = 0; y < gp_bound_rect.Height; y++)
+        {
+            const BYTE *coverage = mask + (covered.top + y) * fill_area.Width + covered.left;
+            DWORD *pixel = pixel_data + y * gp_bound_rect.Width;
+
+            for (x = 0; x < gp_bound_rect.Width; x++)
+            {
+                if (coverage[x] == 0xff)
+                    continue;
+                pixel[x] = (pixel[x] & 0xffffff) |
+                    ((((pixel[x] >> 24) * coverage[x] + 127) / 255) << 24);
+            }
+        }
 
-        GdipDeleteRegion(rgn);
+        stat = alpha_blend_pixels(graphics, gp_bound_rect.X, gp_bound_rect.Y,
+            (BYTE*)pixel_data, gp_bound_rect.Width, gp_bound_rect.Height,
+            gp_bound_rect.Width * 4);
     }
 
+    GdipFree(pixel_data);
+    GdipFree(mask);
+
     return stat;
 }
 
@@ -5539,6 +5539,79 @@ static void test_GdipFillRectangles(void)
     ReleaseDC(hwnd, hdc);
 }
 
+static void test_fillpath_smoothing(void)
+{
+    GpStatus status;
+    GpGraphics *graphics;
+    GpBitmap *bitmap;
+    GpSolidFill *brush;
+    ARGB color;
+
+    status = GdipCreateBitmapFromScan0(8, 8, 0, PixelFormat32bppARGB, NULL, &bitmap);
+    expect(Ok, status);
+
+    status = GdipGetImageGraphicsContext((GpImage*)bitmap, &graphics);
+    expect(Ok, status);
+
+    status = GdipCreateSolidFill(0xff0000ff, &brush);
+    expect(Ok, status);
+
+    status = GdipSetSmoothingMode(graphics, SmoothingModeNone);
+    expect(Ok, status);
+
+    status = GdipFillRectangle(graphics, (GpBrush*)brush, 2.0, 2.0, 4.0, 4.0);
+    expect(Ok, status);
+
+    status = GdipBitmapGetPixel(bitmap, 2, 2, &color);
+    expect(Ok, status);
+    expect(0xff0000ff, color);
+
+    status = GdipBitmapGetPixel(bitmap, 5, 5, &color);
+    expect(Ok, status);
+    expect(0xff0000ff, color);
+
+    status = GdipBitmapGetPixel(bitmap, 1, 2, &color);
+    expect(Ok, status);
+    expect(0, color);
+
+    status = GdipBitmapGetPixel(bitmap, 6, 6, &color);
+    expect(Ok, status);
+    expect(0, color);
+
+    status = GdipGraphicsClear(graphics, 0);
+    expect(Ok, status);
+
+    /* pixel centers are on integer coordinates, so the edges of the
+     * rectangle cover half of the border pixels */
+    status = GdipSetSmoothingMode(graphics, SmoothingModeAntiAlias);
+    expect(Ok, status);
+
+    status = GdipFillRectangle(graphics, (GpBrush*)brush, 2.0, 2.0, 4.0, 4.0);
+    expect(Ok, status);
+
+    status = GdipBitmapGetPixel(bitmap, 4, 4, &color);
+    expect(Ok, status);
+    expect(0xff0000ff, color);
+
+    status = GdipBitmapGetPixel(bitmap, 4, 2, &color);
+    expect(Ok, status);
+    ok((color & 0xffffff) == 0xff && (color >> 24) >= 0x70 && (color >> 24) <= 0x90,
+       "expected half covered pixel, got %08x\n", color);
+
+    status = GdipBitmapGetPixel(bitmap, 2, 2, &color);
+    expect(Ok, status);
+    ok((color & 0xffffff) == 0xff && (color >> 24) >= 0x30 && (color >> 24) <= 0x50,
+       "expected quarter covered pixel, got %08x\n", color);
+
+    status = GdipBitmapGetPixel(bitmap, 1, 1, &color);
+    expect(Ok, status);
+    expect(0, color);
+
+    GdipDeleteBrush((GpBrush*)brush);
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage*)bitmap);
+}
+
 START_TEST(graphics)
 {
     struct GdiplusStartupInput gdiplusStartupInput;
@@ -5610,6 +5683,7 @@ START_TEST(graphics)
     test_alpha_hdc();
     test_bitmapfromgraphics();
     test_GdipFillRectangles();
+    test_fillpath_smoothing();
 
     GdiplusShutdown(gdiplusToken);
     DestroyWindow( hwnd );
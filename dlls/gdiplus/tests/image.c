@@ -3983,6 +3983,135 @@ static void test_DrawImage_scale(void)
     expect(Ok, status);
 }
 
+static void test_DrawImage_resample(void)
+{
+    static const DWORD ramp_4x2[8] = { 0xff000000,0xff555555,0xffaaaaaa,0xffffffff,
+                                       0xff000000,0xff555555,0xffaaaaaa,0xffffffff };
+    static const DWORD stripes_8x2[16] = { 0xff000000,0xffffffff,0xff000000,0xffffffff,
+                                           0xff000000,0xffffffff,0xff000000,0xffffffff,
+                                           0xff000000,0xffffffff,0xff000000,0xffffffff,
+                                           0xff000000,0xffffffff,0xff000000,0xffffffff };
+    static const DWORD red_4x2[8] = { 0xffff0000,0xffff0000,0xffff0000,0xffff0000,
+                                      0xffff0000,0xffff0000,0xffff0000,0xffff0000 };
+    static const struct test_data
+    {
+        const DWORD *src;
+        INT src_width, dst_width;
+        InterpolationMode interpolation;
+        PixelOffsetMode pixel_offset_mode;
+        INT x;
+        ARGB expected;
+        BYTE max_diff;
+    } td[] =
+    {
+        /* scaling up, pixels of the source are at integer or half-integer positions */
+        { ramp_4x2, 4, 8, InterpolationModeBilinear, PixelOffsetModeNone, 3, 0xff808080, 2 }, /* 0 */
+        { ramp_4x2, 4, 8, InterpolationModeBilinear, PixelOffsetModeNone, 4, 0xffaaaaaa, 2 },
+        { ramp_4x2, 4, 8, InterpolationModeBilinear, PixelOffsetModeHalf, 3, 0xff6a6a6a, 2 },
+        { ramp_4x2, 4, 8, InterpolationModeBilinear, PixelOffsetModeHalf, 4, 0xff959595, 2 },
+        { ramp_4x2, 4, 8, InterpolationModeBicubic, PixelOffsetModeNone, 3, 0xff808080, 2 },
+        { ramp_4x2, 4, 8, InterpolationModeBicubic, PixelOffsetModeNone, 4, 0xffaaaaaa, 2 }, /* 5 */
+        { ramp_4x2, 4, 8, InterpolationModeBicubic, PixelOffsetModeHalf, 3, 0xff6a6a6a, 2 },
+        { ramp_4x2, 4, 8, InterpolationModeBicubic, PixelOffsetModeHalf, 4, 0xff959595, 2 },
+        { ramp_4x2, 4, 8, InterpolationModeHighQualityBicubic, PixelOffsetModeNone, 3, 0xff808080, 2 },
+        { ramp_4x2, 4, 8, InterpolationModeHighQualityBicubic, PixelOffsetModeHalf, 4, 0xff959595, 2 },
+
+        /* scaling down, only the high quality modes use every source pixel */
+        { stripes_8x2, 8, 4, InterpolationModeBilinear, PixelOffsetModeNone, 2, 0xff000000, 2 }, /* 10 */
+        { stripes_8x2, 8, 4, InterpolationModeBilinear, PixelOffsetModeHalf, 2, 0xff808080, 2 },
+        { stripes_8x2, 8, 4, InterpolationModeBicubic, PixelOffsetModeNone, 2, 0xff000000, 2 },
+        { stripes_8x2, 8, 4, InterpolationModeHighQualityBilinear, PixelOffsetModeNone, 2, 0xff808080, 8 },
+        { stripes_8x2, 8, 4, InterpolationModeHighQualityBilinear, PixelOffsetModeHalf, 2, 0xff808080, 8 },
+        { stripes_8x2, 8, 4, InterpolationModeHighQualityBicubic, PixelOffsetModeNone, 2, 0xff808080, 8 }, /* 15 */
+        { stripes_8x2, 8, 4, InterpolationModeHighQualityBicubic, PixelOffsetModeHalf, 2, 0xff808080, 8 },
+
+        /* the right edge is blended with the outside color */
+        { red_4x2, 4, 8, InterpolationModeBilinear, PixelOffsetModeNone, 6, 0xffff0000, 2 },
+        { red_4x2, 4, 8, InterpolationModeBilinear, PixelOffsetModeNone, 7, 0xff800000, 2 },
+    };
+    DWORD src[16], dst[16];
+    GpImageAttributes *imageattr;
+    GpBitmap *src_bitmap, *dst_bitmap;
+    GpGraphics *graphics;
+    GpStatus status;
+    ARGB color;
+    int i, j;
+
+    for (i = 0; i < sizeof(td)/sizeof(td[0]); i++)
+    {
+        memcpy(src, td[i].src, sizeof(DWORD) * td[i].src_width * 2);
+        status = GdipCreateBitmapFromScan0(td[i].src_width, 2, td[i].src_width * 4,
+                                           PixelFormat32bppARGB, (BYTE *)src, &src_bitmap);
+        expect(Ok, status);
+        status = GdipBitmapSetResolution(src_bitmap, 100.0, 100.0);
+        expect(Ok, status);
+
+        for (j = 0; j < td[i].dst_width * 2; j++)
+            dst[j] = 0xff000000;
+        status = GdipCreateBitmapFromScan0(td[i].dst_width, 2, td[i].dst_width * 4,
+                                           PixelFormat32bppARGB, (BYTE *)dst, &dst_bitmap);
+        expect(Ok, status);
+        status = GdipBitmapSetResolution(dst_bitmap, 100.0, 100.0);
+        expect(Ok, status);
+        status = GdipGetImageGraphicsContext((GpImage *)dst_bitmap, &graphics);
+        expect(Ok, status);
+        status = GdipSetInterpolationMode(graphics, td[i].interpolation);
+        expect(Ok, status);
+        status = GdipSetPixelOffsetMode(graphics, td[i].pixel_offset_mode);
+        expect(Ok, status);
+
+        status = GdipDrawImageRectRectI(graphics, (GpImage *)src_bitmap, 0, 0, td[i].dst_width, 2,
+                                        0, 0, td[i].src_width, 2, UnitPixel, NULL, NULL, NULL);
+        expect(Ok, status);
+
+        status = GdipBitmapGetPixel(dst_bitmap, td[i].x, 0, &color);
+        expect(Ok, status);
+        ok(color_match(td[i].expected, color, td[i].max_diff),
+           "%d: expected %08x, got %08x\n", i, td[i].expected, color);
+
+        GdipDeleteGraphics(graphics);
+        GdipDisposeImage((GpImage *)dst_bitmap);
+        GdipDisposeImage((GpImage *)src_bitmap);
+    }
+
+    /* a non-default outside color of a clamped image */
+    memcpy(src, red_4x2, sizeof(red_4x2));
+    for (j = 0; j < 16; j++)
+        dst[j] = 0xff000000;
+    status = GdipCreateBitmapFromScan0(4, 2, 16, PixelFormat32bppARGB, (BYTE *)src, &src_bitmap);
+    expect(Ok, status);
+    status = GdipBitmapSetResolution(src_bitmap, 100.0, 100.0);
+    expect(Ok, status);
+    status = GdipCreateBitmapFromScan0(8, 2, 32, PixelFormat32bppARGB, (BYTE *)dst, &dst_bitmap);
+    expect(Ok, status);
+    status = GdipBitmapSetResolution(dst_bitmap, 100.0, 100.0);
+    expect(Ok, status);
+    status = GdipGetImageGraphicsContext((GpImage *)dst_bitmap, &graphics);
+    expect(Ok, status);
+    status = GdipSetInterpolationMode(graphics, InterpolationModeBilinear);
+    expect(Ok, status);
+    status = GdipCreateImageAttributes(&imageattr);
+    expect(Ok, status);
+    status = GdipSetImageAttributesWrapMode(imageattr, WrapModeClamp, 0xff0000ff, FALSE);
+    expect(Ok, status);
+
+    status = GdipDrawImageRectRectI(graphics, (GpImage *)src_bitmap, 0, 0, 8, 2, 0, 0, 4, 2,
+                                    UnitPixel, imageattr, NULL, NULL);
+    expect(Ok, status);
+
+    status = GdipBitmapGetPixel(dst_bitmap, 6, 0, &color);
+    expect(Ok, status);
+    ok(color_match(0xffff0000, color, 2), "expected ffff0000, got %08x\n", color);
+    status = GdipBitmapGetPixel(dst_bitmap, 7, 0, &color);
+    expect(Ok, status);
+    ok(color_match(0xff800080, color, 2), "expected ff800080, got %08x\n", color);
+
+    GdipDisposeImageAttributes(imageattr);
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage *)dst_bitmap);
+    GdipDisposeImage((GpImage *)src_bitmap);
+}
+
 static const BYTE animatedgif[] = {
 'G','I','F','8','9','a',0x01,0x00,0x01,0x00,0xA1,0x02,0x00,
 0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,
@@ -4283,6 +4412,7 @@ START_TEST(image)
     test_CloneBitmapArea();
     test_ARGB_conversion();
     test_DrawImage_scale();
+    test_DrawImage_resample();
     test_image_format();
     test_DrawImage();
     test_GdipDrawImagePointRect();
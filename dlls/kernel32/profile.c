@@ -50,6 +50,8 @@ typedef struct tagPROFILEKEY
 {
     WCHAR                 *value;
     struct tagPROFILEKEY  *next;
+    struct tagPROFILEKEY  *hash_next;  /* next key in the same index bucket */
+    UINT                   hash;
     WCHAR                  name[1];
 } PROFILEKEY;
 
@@ -57,6 +59,12 @@ typedef struct tagPROFILESECTION
 {
     struct tagPROFILEKEY       *key;
     struct tagPROFILESECTION   *next;
+    struct tagPROFILESECTION   *hash_next;  /* next section in the same index bucket */
+    struct tagPROFILEKEY      **key_tail;   /* where to link the next appended key */
+    struct tagPROFILEKEY      **key_index;  /* key name hash buckets, built on demand */
+    UINT                        key_index_size;
+    UINT                        nb_keys;
+    UINT                        hash;
     WCHAR                       name[1];
 } PROFILESECTION;
 
@@ -65,13 +73,23 @@ typedef struct
 {
     BOOL             changed;
     PROFILESECTION  *section;
+    PROFILESECTION **section_tail;
+    PROFILESECTION **section_index;  /* section name hash buckets, built on demand */
+    UINT             section_index_size;
+    UINT             nb_sections;
     WCHAR           *filename;
     FILETIME LastWriteTime;
     ENCODING encoding;
 } PROFILE;
 
 
-#define N_CACHED_PROFILES 10
+#define N_CACHED_PROFILES 32
+
+/* Sections and keys are looked up linearly until there are this many of them */
+#define PROFILE_MIN_INDEXED 8
+
+/* Size in WCHARs of the buffer used to write out a profile */
+#define PROFILE_SAVE_BUFFER_SIZE 8192
 
 /* Cached profile files */
 static PROFILE *MRUProfile[N_CACHED_PROFILES]={NULL};
@@ -195,10 +213,12 @@ static void PROFILE_WriteLine( HANDLE hFile, WCHAR * szLine, int len, ENCODING e
 static void PROFILE_Save( HANDLE hFile, const PROFILESECTION *section, ENCODING encoding )
 {
     PROFILEKEY *key;
-    WCHAR *buffer, *p;
+    WCHAR *buffer = NULL, *p;
+    int used = 0, size = 0;
 
     PROFILE_WriteMarker(hFile, encoding);
 
+    /* sections are gathered into a shared buffer to keep the number of writes down */
     for ( ; section; section = section->next)
     {
         int len = 0;
@@ -211,10 +231,20 @@ static void PROFILE_Save( HANDLE hFile, const PROFILESECTION *section, ENCODING
             if (key->value) len += strlenW(key->value) + 1;
         }
 
-        buffer = HeapAlloc(GetProcessHeap(), 0, len * sizeof(WCHAR));
-        if (!buffer) return;
+        if (used + len > size)
+        {
+            if (used) PROFILE_WriteLine( hFile, buffer, used, encoding );
+            used = 0;
+            if (len > size)
+            {
+                HeapFree(GetProcessHeap(), 0, buffer);
+                size = max( len, PROFILE_SAVE_BUFFER_SIZE );
+                buffer = HeapAlloc(GetProcessHeap(), 0, size * sizeof(WCHAR));
+                if (!buffer) return;
+            }
+        }
 
-        p = buffer;
+        p = buffer + used;
         if (section->name[0])
         {
             *p++ = '[';
@@ -238,9 +268,10 @@ static void PROFILE_Save( HANDLE hFile, const PROFILESECTION *section, ENCODING
             *p++ = '\r';
             *p++ = '\n';
         }
-        PROFILE_WriteLine( hFile, buffer, len, encoding );
-        HeapFree(GetProcessHeap(), 0, buffer);
+        used += len;
     }
+    if (used) PROFILE_WriteLine( hFile, buffer, used, encoding );
+    HeapFree(GetProcessHeap(), 0, buffer);
 }
 
 
@@ -263,10 +294,43 @@ static void PROFILE_Free( PROFILESECTION *section )
             HeapFree( GetProcessHeap(), 0, key );
         }
         next_section = section->next;
+        HeapFree( GetProcessHeap(), 0, section->key_index );
         HeapFree( GetProcessHeap(), 0, section );
     }
 }
 
+
+/***********************************************************************
+ *           PROFILE_SetSections
+ *
+ * Replace the profile tree of a cached profile.
+ */
+static void PROFILE_SetSections( PROFILE *profile, PROFILESECTION *sections )
+{
+    PROFILESECTION **tail = &profile->section;
+
+    PROFILE_Free( profile->section );
+    HeapFree( GetProcessHeap(), 0, profile->section_index );
+    profile->section = sections;
+    profile->section_index = NULL;
+    profile->section_index_size = 0;
+    profile->nb_sections = 0;
+    while (*tail)
+    {
+        profile->nb_sections++;
+        tail = &(*tail)->next;
+    }
+    profile->section_tail = tail;
+}
+
+/* case-insensitive hash of the first len characters of a section or key name */
+static inline UINT PROFILE_HashName( const WCHAR *name, int len )
+{
+    UINT hash = 0;
+    while (len-- > 0) hash = hash * 31 + tolowerW( *name++ );
+    return hash;
+}
+
 /* returns TRUE if a whitespace character, else FALSE */
 static inline BOOL PROFILE_isspaceW(WCHAR c)
 {
@@ -314,7 +378,7 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
     int line = 0, len;
     PROFILESECTION *section, *first_section;
     PROFILESECTION **next_section;
-    PROFILEKEY *key, *prev_key, **next_key;
+    PROFILEKEY *key, *prev_key;
     DWORD dwFileSize;
     
     TRACE("%p\n", hFile);
@@ -394,8 +458,14 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
     first_section->name[0] = 0;
     first_section->key  = NULL;
     first_section->next = NULL;
+    first_section->hash_next = NULL;
+    first_section->key_tail  = &first_section->key;
+    first_section->key_index = NULL;
+    first_section->key_index_size = 0;
+    first_section->nb_keys = 0;
+    first_section->hash = 0;
+    section      = first_section;
     next_section = &first_section->next;
-    next_key     = &first_section->key;
     prev_key     = NULL;
     next_line    = szFile;
 
@@ -436,9 +506,14 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
                 section->name[len] = '\0';
                 section->key  = NULL;
                 section->next = NULL;
+                section->hash_next = NULL;
+                section->key_tail  = &section->key;
+                section->key_index = NULL;
+                section->key_index_size = 0;
+                section->nb_keys = 0;
+                section->hash = PROFILE_HashName( section->name, len );
                 *next_section = section;
                 next_section  = &section->next;
-                next_key      = &section->key;
                 prev_key      = NULL;
 
                 TRACE("New section: %s\n", debugstr_w(section->name));
@@ -466,6 +541,7 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
             if (!(key = HeapAlloc( GetProcessHeap(), 0, sizeof(*key) + len * sizeof(WCHAR) ))) break;
             memcpy(key->name, szLineStart, len * sizeof(WCHAR));
             key->name[len] = '\0';
+            key->hash = PROFILE_HashName( key->name, len );
             if (szValueStart)
             {
                 len = (int)(szLineEnd - szValueStart);
@@ -476,8 +552,10 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
             else key->value = NULL;
 
            key->next  = NULL;
-           *next_key  = key;
-           next_key   = &key->next;
+           key->hash_next = NULL;
+           *section->key_tail = key;
+           section->key_tail  = &key->next;
+           section->nb_keys++;
            prev_key   = key;
 
            TRACE("New key: name=%s, value=%s\n",
@@ -491,26 +569,181 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
 }
 
 
+/* size of a hash index able to hold count entries */
+static UINT PROFILE_IndexSize( UINT count )
+{
+    UINT size = PROFILE_MIN_INDEXED;
+    while (size < count) size <<= 1;
+    return size;
+}
+
+static inline BOOL PROFILE_NameMatches( const WCHAR *name, const WCHAR *str, int len )
+{
+    return !strncmpiW( name, str, len ) && !name[len];
+}
+
+
+/***********************************************************************
+ *           PROFILE_IndexSection
+ *
+ * Append a section to its index bucket, keeping the file order.
+ */
+static void PROFILE_IndexSection( PROFILE *profile, PROFILESECTION *section )
+{
+    PROFILESECTION **bucket = &profile->section_index[section->hash & (profile->section_index_size - 1)];
+
+    while (*bucket) bucket = &(*bucket)->hash_next;
+    *bucket = section;
+    section->hash_next = NULL;
+}
+
+
+/***********************************************************************
+ *           PROFILE_IndexKey
+ *
+ * Append a key to its index bucket, keeping the file order.
+ */
+static void PROFILE_IndexKey( PROFILESECTION *section, PROFILEKEY *key )
+{
+    PROFILEKEY **bucket = &section->key_index[key->hash & (section->key_index_size - 1)];
+
+    while (*bucket) bucket = &(*bucket)->hash_next;
+    *bucket = key;
+    key->hash_next = NULL;
+}
+
+
+/***********************************************************************
+ *           PROFILE_BuildSectionIndex
+ *
+ * (Re)build the section index of a profile if it is large enough to need one.
+ * On allocation failure the index is simply left out.
+ */
+static void PROFILE_BuildSectionIndex( PROFILE *profile )
+{
+    PROFILESECTION *section;
+
+    if (profile->nb_sections < PROFILE_MIN_INDEXED) return;
+    if (profile->section_index && profile->nb_sections <= 2 * profile->section_index_size) return;
+
+    HeapFree( GetProcessHeap(), 0, profile->section_index );
+    profile->section_index_size = PROFILE_IndexSize( profile->nb_sections );
+    profile->section_index = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                        profile->section_index_size * sizeof(*profile->section_index) );
+    if (!profile->section_index) return;
+
+    for (section = profile->section; section; section = section->next)
+        if (section->name[0]) PROFILE_IndexSection( profile, section );
+}
+
+
+/***********************************************************************
+ *           PROFILE_BuildKeyIndex
+ *
+ * (Re)build the key index of a section if it is large enough to need one.
+ */
+static void PROFILE_BuildKeyIndex( PROFILESECTION *section )
+{
+    PROFILEKEY *key;
+
+    if (section->nb_keys < PROFILE_MIN_INDEXED) return;
+    if (section->key_index && section->nb_keys <= 2 * section->key_index_size) return;
+
+    HeapFree( GetProcessHeap(), 0, section->key_index );
+    section->key_index_size = PROFILE_IndexSize( section->nb_keys );
+    section->key_index = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                    section->key_index_size * sizeof(*section->key_index) );
+    if (!section->key_index) return;
+
+    for (key = section->key; key; key = key->next) PROFILE_IndexKey( section, key );
+}
+
+
+/***********************************************************************
+ *           PROFILE_FindSection
+ *
+ * Find the first named section matching the first len characters of name
+ * that follows prev in the file, or the first one at all if prev is NULL.
+ */
+static PROFILESECTION *PROFILE_FindSection( PROFILE *profile, PROFILESECTION *prev,
+                                            LPCWSTR name, int len, UINT hash )
+{
+    PROFILESECTION *section;
+
+    if (!prev) PROFILE_BuildSectionIndex( profile );
+
+    if (profile->section_index)
+    {
+        section = prev ? prev->hash_next
+                       : profile->section_index[hash & (profile->section_index_size - 1)];
+        for ( ; section; section = section->hash_next)
+            if (section->hash == hash && PROFILE_NameMatches( section->name, name, len ))
+                return section;
+        return NULL;
+    }
+
+    for (section = prev ? prev->next : profile->section; section; section = section->next)
+        if (section->name[0] && PROFILE_NameMatches( section->name, name, len ))
+            return section;
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           PROFILE_FindKey
+ *
+ * Find the first key of a section matching the first len characters of name.
+ */
+static PROFILEKEY *PROFILE_FindKey( PROFILESECTION *section, LPCWSTR name, int len, UINT hash )
+{
+    PROFILEKEY *key;
+
+    PROFILE_BuildKeyIndex( section );
+
+    if (section->key_index)
+    {
+        for (key = section->key_index[hash & (section->key_index_size - 1)]; key; key = key->hash_next)
+            if (key->hash == hash && PROFILE_NameMatches( key->name, name, len ))
+                return key;
+        return NULL;
+    }
+
+    for (key = section->key; key; key = key->next)
+        if (PROFILE_NameMatches( key->name, name, len ))
+            return key;
+    return NULL;
+}
+
+
 /***********************************************************************
  *           PROFILE_DeleteSection
  *
  * Delete a section from a profile tree.
  */
-static BOOL PROFILE_DeleteSection( PROFILESECTION **section, LPCWSTR name )
+static BOOL PROFILE_DeleteSection( PROFILE *profile, LPCWSTR name )
 {
-    while (*section)
+    PROFILESECTION *to_del, **section;
+    int len = strlenW( name );
+
+    if (!(to_del = PROFILE_FindSection( profile, NULL, name, len, PROFILE_HashName( name, len ) )))
+        return FALSE;
+
+    if (profile->section_index)
     {
-        if ((*section)->name[0] && !strcmpiW( (*section)->name, name ))
-        {
-            PROFILESECTION *to_del = *section;
-            *section = to_del->next;
-            to_del->next = NULL;
-            PROFILE_Free( to_del );
-            return TRUE;
-        }
-        section = &(*section)->next;
+        section = &profile->section_index[to_del->hash & (profile->section_index_size - 1)];
+        while (*section != to_del) section = &(*section)->hash_next;
+        *section = to_del->hash_next;
     }
-    return FALSE;
+
+    section = &profile->section;
+    while (*section != to_del) section = &(*section)->next;
+    *section = to_del->next;
+    if (profile->section_tail == &to_del->next) profile->section_tail = section;
+    profile->nb_sections--;
+
+    to_del->next = NULL;
+    PROFILE_Free( to_del );
+    return TRUE;
 }
 
 
@@ -519,28 +752,35 @@ static BOOL PROFILE_DeleteSection( PROFILESECTION **section, LPCWSTR name )
  *
  * Delete a key from a profile tree.
  */
-static BOOL PROFILE_DeleteKey( PROFILESECTION **section,
-			       LPCWSTR section_name, LPCWSTR key_name )
+static BOOL PROFILE_DeleteKey( PROFILE *profile, LPCWSTR section_name, LPCWSTR key_name )
 {
-    while (*section)
+    PROFILESECTION *section = NULL;
+    int seclen = strlenW( section_name ), keylen = strlenW( key_name );
+    UINT sechash = PROFILE_HashName( section_name, seclen );
+    UINT keyhash = PROFILE_HashName( key_name, keylen );
+
+    while ((section = PROFILE_FindSection( profile, section, section_name, seclen, sechash )))
     {
-        if ((*section)->name[0] && !strcmpiW( (*section)->name, section_name ))
+        PROFILEKEY *to_del, **key;
+
+        if (!(to_del = PROFILE_FindKey( section, key_name, keylen, keyhash ))) continue;
+
+        if (section->key_index)
         {
-            PROFILEKEY **key = &(*section)->key;
-            while (*key)
-            {
-                if (!strcmpiW( (*key)->name, key_name ))
-                {
-                    PROFILEKEY *to_del = *key;
-                    *key = to_del->next;
-                    HeapFree( GetProcessHeap(), 0, to_del->value);
-                    HeapFree( GetProcessHeap(), 0, to_del );
-                    return TRUE;
-                }
-                key = &(*key)->next;
-            }
+            key = &section->key_index[to_del->hash & (section->key_index_size - 1)];
+            while (*key != to_del) key = &(*key)->hash_next;
+            *key = to_del->hash_next;
         }
-        section = &(*section)->next;
+
+        key = &section->key;
+        while (*key != to_del) key = &(*key)->next;
+        *key = to_del->next;
+        if (section->key_tail == &to_del->next) section->key_tail = key;
+        section->nb_keys--;
+
+        HeapFree( GetProcessHeap(), 0, to_del->value);
+        HeapFree( GetProcessHeap(), 0, to_del );
+        return TRUE;
     }
     return FALSE;
 }
@@ -553,22 +793,26 @@ static BOOL PROFILE_DeleteKey( PROFILESECTION **section,
  */
 static void PROFILE_DeleteAllKeys( LPCWSTR section_name)
 {
-    PROFILESECTION **section= &CurProfile->section;
-    while (*section)
+    PROFILESECTION *section = NULL;
+    int len = strlenW( section_name );
+    UINT hash = PROFILE_HashName( section_name, len );
+
+    while ((section = PROFILE_FindSection( CurProfile, section, section_name, len, hash )))
     {
-        if ((*section)->name[0] && !strcmpiW( (*section)->name, section_name ))
+        PROFILEKEY *to_del;
+
+        while ((to_del = section->key))
         {
-            PROFILEKEY **key = &(*section)->key;
-            while (*key)
-            {
-                PROFILEKEY *to_del = *key;
-		*key = to_del->next;
-                HeapFree( GetProcessHeap(), 0, to_del->value);
-		HeapFree( GetProcessHeap(), 0, to_del );
-		CurProfile->changed =TRUE;
-            }
+            section->key = to_del->next;
+            HeapFree( GetProcessHeap(), 0, to_del->value);
+            HeapFree( GetProcessHeap(), 0, to_del );
+            CurProfile->changed =TRUE;
         }
-        section = &(*section)->next;
+        section->key_tail = &section->key;
+        section->nb_keys = 0;
+        HeapFree( GetProcessHeap(), 0, section->key_index );
+        section->key_index = NULL;
+        section->key_index_size = 0;
     }
 }
 
@@ -578,78 +822,85 @@ static void PROFILE_DeleteAllKeys( LPCWSTR section_name)
  *
  * Find a key in a profile tree, optionally creating it.
  */
-static PROFILEKEY *PROFILE_Find( PROFILESECTION **section, LPCWSTR section_name,
+static PROFILEKEY *PROFILE_Find( PROFILE *profile, LPCWSTR section_name,
                                  LPCWSTR key_name, BOOL create, BOOL create_always )
 {
     LPCWSTR p;
-    int seclen, keylen;
+    int seclen = 0, keylen = 0;
+    PROFILESECTION *section;
+    PROFILEKEY *key;
+    BOOL new_section = FALSE;
 
     while (PROFILE_isspaceW(*section_name)) section_name++;
     if (*section_name)
+    {
         p = section_name + strlenW(section_name) - 1;
-    else
-        p = section_name;
-
-    while ((p > section_name) && PROFILE_isspaceW(*p)) p--;
-    seclen = p - section_name + 1;
+        while ((p > section_name) && PROFILE_isspaceW(*p)) p--;
+        seclen = p - section_name + 1;
+    }
 
     while (PROFILE_isspaceW(*key_name)) key_name++;
     if (*key_name)
+    {
         p = key_name + strlenW(key_name) - 1;
-    else
-        p = key_name;
-
-    while ((p > key_name) && PROFILE_isspaceW(*p)) p--;
-    keylen = p - key_name + 1;
+        while ((p > key_name) && PROFILE_isspaceW(*p)) p--;
+        keylen = p - key_name + 1;
+    }
 
-    while (*section)
+    section = PROFILE_FindSection( profile, NULL, section_name, seclen,
+                                   PROFILE_HashName( section_name, seclen ) );
+    if (section)
     {
-        if ( ((*section)->name[0])
-             && (!(strncmpiW( (*section)->name, section_name, seclen )))
-             && (((*section)->name)[seclen] == '\0') )
-        {
-            PROFILEKEY **key = &(*section)->key;
-
-            while (*key)
-            {
-                /* If create_always is FALSE then we check if the keyname
-                 * already exists. Otherwise we add it regardless of its
-                 * existence, to allow keys to be added more than once in
-                 * some cases.
-                 */
-                if(!create_always)
-                {
-                    if ( (!(strncmpiW( (*key)->name, key_name, keylen )))
-                         && (((*key)->name)[keylen] == '\0') )
-                        return *key;
-                }
-                key = &(*key)->next;
-            }
-            if (!create) return NULL;
-            if (!(*key = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
-                return NULL;
-            strcpyW( (*key)->name, key_name );
-            (*key)->value = NULL;
-            (*key)->next  = NULL;
-            return *key;
-        }
-        section = &(*section)->next;
+        /* If create_always is FALSE then we check if the keyname
+         * already exists. Otherwise we add it regardless of its
+         * existence, to allow keys to be added more than once in
+         * some cases.
+         */
+        if (!create_always &&
+            (key = PROFILE_FindKey( section, key_name, keylen, PROFILE_HashName( key_name, keylen ) )))
+            return key;
+        if (!create) return NULL;
     }
-    if (!create) return NULL;
-    *section = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILESECTION) + strlenW(section_name) * sizeof(WCHAR) );
-    if(*section == NULL) return NULL;
-    strcpyW( (*section)->name, section_name );
-    (*section)->next = NULL;
-    if (!((*section)->key  = HeapAlloc( GetProcessHeap(), 0,
-                                        sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
+    else
     {
-        HeapFree(GetProcessHeap(), 0, *section);
+        if (!create) return NULL;
+        section = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILESECTION) + strlenW(section_name) * sizeof(WCHAR) );
+        if (section == NULL) return NULL;
+        strcpyW( section->name, section_name );
+        section->key  = NULL;
+        section->next = NULL;
+        section->hash_next = NULL;
+        section->key_tail  = &section->key;
+        section->key_index = NULL;
+        section->key_index_size = 0;
+        section->nb_keys = 0;
+        section->hash = PROFILE_HashName( section->name, strlenW(section->name) );
+        new_section = TRUE;
+    }
+
+    if (!(key = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
+    {
+        if (new_section) HeapFree( GetProcessHeap(), 0, section );
         return NULL;
     }
-    strcpyW( (*section)->key->name, key_name );
-    (*section)->key->value = NULL;
-    (*section)->key->next  = NULL;
-    return (*section)->key;
+    strcpyW( key->name, key_name );
+    key->value = NULL;
+    key->next  = NULL;
+    key->hash_next = NULL;
+    key->hash  = PROFILE_HashName( key->name, strlenW(key->name) );
+
+    if (new_section)
+    {
+        *profile->section_tail = section;
+        profile->section_tail = &section->next;
+        profile->nb_sections++;
+        if (profile->section_index && section->name[0]) PROFILE_IndexSection( profile, section );
+    }
+    *section->key_tail = key;
+    section->key_tail = &key->next;
+    section->nb_keys++;
+    if (section->key_index) PROFILE_IndexKey( section, key );
+    return key;
 }
 
 
@@ -698,10 +949,9 @@ static BOOL PROFILE_FlushFile(void)
 static void PROFILE_ReleaseFile(void)
 {
     PROFILE_FlushFile();
-    PROFILE_Free( CurProfile->section );
+    PROFILE_SetSections( CurProfile, NULL );
     HeapFree( GetProcessHeap(), 0, CurProfile->filename );
     CurProfile->changed = FALSE;
-    CurProfile->section = NULL;
     CurProfile->filename  = NULL;
     CurProfile->encoding = ENCODING_ANSI;
     ZeroMemory(&CurProfile->LastWriteTime, sizeof(CurProfile->LastWriteTime));
@@ -751,6 +1001,10 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
           if(MRUProfile[i] == NULL) break;
           MRUProfile[i]->changed=FALSE;
           MRUProfile[i]->section=NULL;
+          MRUProfile[i]->section_tail=&MRUProfile[i]->section;
+          MRUProfile[i]->section_index=NULL;
+          MRUProfile[i]->section_index_size=0;
+          MRUProfile[i]->nb_sections=0;
           MRUProfile[i]->filename=NULL;
           MRUProfile[i]->encoding=ENCODING_ANSI;
           ZeroMemory(&MRUProfile[i]->LastWriteTime, sizeof(FILETIME));
@@ -812,15 +1066,23 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
                 {
                     TRACE("(%s): already opened, needs refreshing (mru=%d)\n",
                           debugstr_w(buffer), i);
-                    PROFILE_Free(CurProfile->section);
-                    CurProfile->section = PROFILE_Load(hFile, &CurProfile->encoding);
+                    PROFILE_SetSections(CurProfile, PROFILE_Load(hFile, &CurProfile->encoding));
                     CurProfile->LastWriteTime = LastWriteTime;
                 }
                 CloseHandle(hFile);
                 return TRUE;
             }
-            else TRACE("(%s): already opened, not yet created (mru=%d)\n",
-                       debugstr_w(buffer), i);
+            TRACE("(%s): already opened, not yet created (mru=%d)\n",
+                  debugstr_w(buffer), i);
+            /* Drop the stale contents in place rather than evicting another
+             * cached profile to make room for a new empty one. */
+            if (!CurProfile->changed)
+            {
+                PROFILE_SetSections(CurProfile, NULL);
+                CurProfile->encoding = ENCODING_ANSI;
+                ZeroMemory(&CurProfile->LastWriteTime, sizeof(CurProfile->LastWriteTime));
+                return TRUE;
+            }
         }
     }
 
@@ -843,7 +1105,7 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
 
     if (hFile != INVALID_HANDLE_VALUE)
     {
-        CurProfile->section = PROFILE_Load(hFile, &CurProfile->encoding);
+        PROFILE_SetSections(CurProfile, PROFILE_Load(hFile, &CurProfile->encoding));
         GetFileTime(hFile, NULL, NULL, &CurProfile->LastWriteTime);
         CloseHandle(hFile);
     }
@@ -862,52 +1124,53 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
  * Returns all keys of a section.
  * If return_values is TRUE, also include the corresponding values.
  */
-static INT PROFILE_GetSection( PROFILESECTION *section, LPCWSTR section_name,
+static INT PROFILE_GetSection( PROFILE *profile, LPCWSTR section_name,
 			       LPWSTR buffer, UINT len, BOOL return_values )
 {
+    PROFILESECTION *section;
     PROFILEKEY *key;
+    int seclen;
 
     if(!buffer) return 0;
 
     TRACE("%s,%p,%u\n", debugstr_w(section_name), buffer, len);
 
-    while (section)
+    seclen = strlenW( section_name );
+    section = PROFILE_FindSection( profile, NULL, section_name, seclen,
+                                   PROFILE_HashName( section_name, seclen ) );
+    if (section)
     {
-        if (section->name[0] && !strcmpiW( section->name, section_name ))
+        UINT oldlen = len;
+        for (key = section->key; key; key = key->next)
         {
-            UINT oldlen = len;
-            for (key = section->key; key; key = key->next)
-            {
-                if (len <= 2) break;
-                if (!*key->name) continue;  /* Skip empty lines */
-                if (IS_ENTRY_COMMENT(key->name)) continue;  /* Skip comments */
-                if (!return_values && !key->value) continue;  /* Skip lines w.o. '=' */
-                PROFILE_CopyEntry( buffer, key->name, len - 1, 0 );
+            if (len <= 2) break;
+            if (!*key->name) continue;  /* Skip empty lines */
+            if (IS_ENTRY_COMMENT(key->name)) continue;  /* Skip comments */
+            if (!return_values && !key->value) continue;  /* Skip lines w.o. '=' */
+            PROFILE_CopyEntry( buffer, key->name, len - 1, 0 );
+            len -= strlenW(buffer) + 1;
+            buffer += strlenW(buffer) + 1;
+            if (len < 2)
+                break;
+            if (return_values && key->value) {
+                buffer[-1] = '=';
+                PROFILE_CopyEntry ( buffer, key->value, len - 1, 0 );
                 len -= strlenW(buffer) + 1;
                 buffer += strlenW(buffer) + 1;
-		if (len < 2)
-		    break;
-		if (return_values && key->value) {
-			buffer[-1] = '=';
-			PROFILE_CopyEntry ( buffer, key->value, len - 1, 0 );
-			len -= strlenW(buffer) + 1;
-			buffer += strlenW(buffer) + 1;
-                }
             }
-            *buffer = '\0';
-            if (len <= 1)
-                /*If either lpszSection or lpszKey is NULL and the supplied
-                  destination buffer is too small to hold all the strings,
-                  the last string is truncated and followed by two null characters.
-                  In this case, the return value is equal to cchReturnBuffer
-                  minus two. */
-            {
-		buffer[-1] = '\0';
-                return oldlen - 2;
-            }
-            return oldlen - len;
         }
-        section = section->next;
+        *buffer = '\0';
+        if (len <= 1)
+            /*If either lpszSection or lpszKey is NULL and the supplied
+              destination buffer is too small to hold all the strings,
+              the last string is truncated and followed by two null characters.
+              In this case, the return value is equal to cchReturnBuffer
+              minus two. */
+        {
+            buffer[-1] = '\0';
+            return oldlen - 2;
+        }
+        return oldlen - len;
     }
     buffer[0] = buffer[1] = '\0';
     return 0;
@@ -993,7 +1256,7 @@ static INT PROFILE_GetString( LPCWSTR section, LPCWSTR key_name,
             PROFILE_CopyEntry(buffer, def_val, len, TRUE);
             return strlenW(buffer);
         }
-        key = PROFILE_Find( &CurProfile->section, section, key_name, FALSE, FALSE);
+        key = PROFILE_Find( CurProfile, section, key_name, FALSE, FALSE);
         PROFILE_CopyEntry( buffer, (key && key->value) ? key->value : def_val,
                            len, TRUE );
         TRACE("(%s,%s,%s): returning %s\n",
@@ -1004,7 +1267,7 @@ static INT PROFILE_GetString( LPCWSTR section, LPCWSTR key_name,
     /* no "else" here ! */
     if (section && section[0])
     {
-        INT ret = PROFILE_GetSection(CurProfile->section, section, buffer, len, FALSE);
+        INT ret = PROFILE_GetSection(CurProfile, section, buffer, len, FALSE);
         if (!buffer[0]) /* no luck -> def_val */
         {
             PROFILE_CopyEntry(buffer, def_val, len, TRUE);
@@ -1028,21 +1291,19 @@ static BOOL PROFILE_SetString( LPCWSTR section_name, LPCWSTR key_name,
     if (!key_name)  /* Delete a whole section */
     {
         TRACE("(%s)\n", debugstr_w(section_name));
-        CurProfile->changed |= PROFILE_DeleteSection( &CurProfile->section,
-                                                      section_name );
+        CurProfile->changed |= PROFILE_DeleteSection( CurProfile, section_name );
         return TRUE;         /* Even if PROFILE_DeleteSection() has failed,
                                 this is not an error on application's level.*/
     }
     else if (!value)  /* Delete a key */
     {
         TRACE("(%s,%s)\n", debugstr_w(section_name), debugstr_w(key_name) );
-        CurProfile->changed |= PROFILE_DeleteKey( &CurProfile->section,
-                                                  section_name, key_name );
+        CurProfile->changed |= PROFILE_DeleteKey( CurProfile, section_name, key_name );
         return TRUE;          /* same error handling as above */
     }
     else  /* Set the key value */
     {
-        PROFILEKEY *key = PROFILE_Find(&CurProfile->section, section_name,
+        PROFILEKEY *key = PROFILE_Find(CurProfile, section_name,
                                         key_name, TRUE, create_always );
         TRACE("(%s,%s,%s):\n",
               debugstr_w(section_name), debugstr_w(key_name), debugstr_w(value) );
@@ -1298,7 +1559,7 @@ INT WINAPI GetPrivateProfileSectionW( LPCWSTR section, LPWSTR buffer,
     RtlEnterCriticalSection( &PROFILE_CritSect );
 
     if (PROFILE_Open( filename, FALSE ))
-        ret = PROFILE_GetSection(CurProfile->section, section, buffer, len, TRUE);
+        ret = PROFILE_GetSection(CurProfile, section, buffer, len, TRUE);
 
     RtlLeaveCriticalSection( &PROFILE_CritSect );
 
@@ -1623,7 +1884,7 @@ BOOL WINAPI GetPrivateProfileStructW (LPCWSTR section, LPCWSTR key,
     RtlEnterCriticalSection( &PROFILE_CritSect );
 
     if (PROFILE_Open( filename, FALSE )) {
-        PROFILEKEY *k = PROFILE_Find ( &CurProfile->section, section, key, FALSE, FALSE);
+        PROFILEKEY *k = PROFILE_Find ( CurProfile, section, key, FALSE, FALSE);
 	if (k) {
 	    TRACE("value (at %p): %s\n", k->value, debugstr_w(k->value));
 	    if (((strlenW(k->value) - 2) / 2) == len)
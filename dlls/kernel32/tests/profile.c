@@ -509,6 +509,87 @@ static void test_profile_refresh(void)
         "Got %d instead of 421\n", res);
 }
 
+static void test_profile_many_keys(void)
+{
+    static const char testfile[] = ".\\winetest_many.ini";
+    char section[32], key[32], value[32], buffer[64], *data, *p;
+    DWORD ret;
+    int i, j;
+
+    DeleteFileA(testfile);
+
+    data = HeapAlloc(GetProcessHeap(), 0, 50 * 32);
+    for (i = 0; i < 50; i++)
+    {
+        p = data;
+        for (j = 0; j < 50; j++) p += sprintf(p, "Key%d=%d", j, i * 100 + j) + 1;
+        *p = 0;
+        sprintf(section, "Section%d", i);
+        ret = WritePrivateProfileSectionA(section, data, testfile);
+        ok(ret, "WritePrivateProfileSection failed with error %u\n", GetLastError());
+    }
+    HeapFree(GetProcessHeap(), 0, data);
+
+    for (i = 0; i < 50; i++)
+    {
+        sprintf(section, "SECTION%d", i);
+        for (j = 0; j < 50; j++)
+        {
+            sprintf(key, "  kEy%d ", j);
+            ret = GetPrivateProfileIntA(section, key, -1, testfile);
+            ok(ret == i * 100 + j, "%s %s: got %d\n", section, key, ret);
+        }
+    }
+
+    /* delete every other key of every other section, and add a new one */
+    for (i = 0; i < 50; i += 2)
+    {
+        sprintf(section, "section%d", i);
+        for (j = 0; j < 50; j += 2)
+        {
+            sprintf(key, "key%d", j);
+            ret = WritePrivateProfileStringA(section, key, NULL, testfile);
+            ok(ret, "WritePrivateProfileString failed with error %u\n", GetLastError());
+        }
+        ret = WritePrivateProfileStringA(section, "Added", "1", testfile);
+        ok(ret, "WritePrivateProfileString failed with error %u\n", GetLastError());
+    }
+
+    for (i = 0; i < 50; i++)
+    {
+        sprintf(section, "Section%d", i);
+        for (j = 0; j < 50; j++)
+        {
+            sprintf(key, "Key%d", j);
+            sprintf(value, "%d", i * 100 + j);
+            ret = GetPrivateProfileStringA(section, key, "none", buffer, sizeof(buffer), testfile);
+            if (i % 2 || j % 2)
+                ok(!strcmp(buffer, value), "%s %s: got %s\n", section, key, buffer);
+            else
+                ok(!strcmp(buffer, "none"), "%s %s: got %s\n", section, key, buffer);
+        }
+        ret = GetPrivateProfileIntA(section, "added", 0, testfile);
+        ok(ret == !(i % 2), "%s: got %d\n", section, ret);
+    }
+
+    /* remove half of the sections */
+    for (i = 0; i < 50; i += 2)
+    {
+        sprintf(section, "section%d", i);
+        ret = WritePrivateProfileStringA(section, NULL, NULL, testfile);
+        ok(ret, "WritePrivateProfileString failed with error %u\n", GetLastError());
+    }
+
+    for (i = 0; i < 50; i++)
+    {
+        sprintf(section, "Section%d", i);
+        ret = GetPrivateProfileIntA(section, "Key1", -1, testfile);
+        ok(ret == (i % 2 ? i * 100 + 1 : -1), "%s: got %d\n", section, ret);
+    }
+
+    ok(DeleteFileA(testfile), "delete failed\n");
+}
+
 static void create_test_file(LPCSTR name, LPCSTR data, DWORD size)
 {
     HANDLE hfile;
@@ -1132,6 +1213,7 @@ START_TEST(profile)
     test_profile_existing();
     test_profile_delete_on_close();
     test_profile_refresh();
+    test_profile_many_keys();
     test_GetPrivateProfileString(
         "[section1]\r\n"
         "name1=val1\r\n"
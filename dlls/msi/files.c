@@ -262,7 +262,7 @@ static MSIFILE *find_file( MSIPACKAGE *package, UINT disk_id, const WCHAR *filen
 static BOOL installfiles_cb(MSIPACKAGE *package, LPCWSTR file, DWORD action,
                             LPWSTR *path, DWORD *attrs, PVOID user)
 {
-    static MSIFILE *f = NULL;
+    MSIFILE *f;
     UINT_PTR disk_id = (UINT_PTR)user;
 
     if (action == MSICABEXTRACT_BEGINEXTRACT)
@@ -284,8 +284,8 @@ static BOOL installfiles_cb(MSIPACKAGE *package, LPCWSTR file, DWORD action,
     }
     else if (action == MSICABEXTRACT_FILEEXTRACTED)
     {
-        f->state = msifs_installed;
-        f = NULL;
+        /* files may be reported after the next one has been started */
+        if ((f = find_file( package, disk_id, file ))) f->state = msifs_installed;
     }
 
     return TRUE;
@@ -363,6 +363,7 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
             data.package = package;
             data.cb = installfiles_cb;
             data.user = (PVOID)(UINT_PTR)mi->disk_id;
+            data.pipelined = TRUE;
 
             if (file->IsCompressed &&
                 !msi_cabextract(package, mi, &data))
@@ -551,6 +552,7 @@ UINT ACTION_PatchFiles( MSIPACKAGE *package )
             data.package = package;
             data.cb = patchfiles_cb;
             data.user = (PVOID)(UINT_PTR)mi->disk_id;
+            data.pipelined = FALSE;
 
             if (!msi_cabextract(package, mi, &data))
             {
@@ -125,6 +125,336 @@ static MSICABINETSTREAM *msi_get_cabinet_stream( MSIPACKAGE *package, UINT disk_
     return NULL;
 }
 
+/* Files extracted from a cabinet can be handed over to a small pool of
+ * writer threads, so that decompression of the next block overlaps with
+ * the disk I/O of the previous ones. All data for a given file goes to
+ * the same thread, which keeps the writes for that file in order. A file
+ * is only reported as extracted once its thread has written and closed it. */
+
+#define CAB_WRITER_MAX_THREADS 4
+#define CAB_WRITER_MAX_PENDING (16 * 1024 * 1024)
+
+enum cab_work_op
+{
+    CAB_WORK_WRITE,
+    CAB_WORK_CLOSE,
+    CAB_WORK_ABORT
+};
+
+struct cab_output
+{
+    struct list        entry;       /* entry in the writer's outputs, in creation order */
+    struct list        handle_entry; /* entry in cab_output_handles */
+    struct cab_writer *writer;
+    HANDLE             handle;
+    WCHAR             *file;
+    unsigned int       thread;
+    BOOL               closing;     /* close has been queued */
+    BOOL               closed;      /* handle has been closed by the writer thread */
+    BOOL               extracted;   /* file is complete and can be reported */
+    BOOL               failed;
+};
+
+struct cab_work
+{
+    struct list        entry;
+    enum cab_work_op   op;
+    struct cab_output *output;
+    BOOL               set_time;
+    FILETIME           time;
+    UINT               size;
+    BYTE               data[1];
+};
+
+struct cab_writer
+{
+    CRITICAL_SECTION   cs;
+    CONDITION_VARIABLE work_cv;
+    CONDITION_VARIABLE space_cv;
+    struct list        outputs;
+    struct list        queue[CAB_WRITER_MAX_THREADS];
+    HANDLE             threads[CAB_WRITER_MAX_THREADS];
+    unsigned int       thread_count;
+    unsigned int       next_thread;
+    LONG               thread_index;
+    SIZE_T             pending;
+    BOOL               shutdown;
+    DWORD              error;
+};
+
+/* The FDI file callbacks only get the file handle, so outputs of all writers
+ * are registered here to tell them apart from the cabinet handles. */
+static struct list cab_output_handles = LIST_INIT( cab_output_handles );
+static CRITICAL_SECTION cab_output_cs;
+static CRITICAL_SECTION_DEBUG cab_output_cs_debug =
+{
+    0, 0, &cab_output_cs,
+    { &cab_output_cs_debug.ProcessLocksList, &cab_output_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": cab_output_cs") }
+};
+static CRITICAL_SECTION cab_output_cs = { &cab_output_cs_debug, -1, 0, 0, 0, 0 };
+
+static void cab_writer_set_error( struct cab_writer *writer, struct cab_output *output, DWORD err )
+{
+    output->failed = TRUE;
+    EnterCriticalSection( &writer->cs );
+    if (!writer->error) writer->error = err ? err : ERROR_WRITE_FAULT;
+    LeaveCriticalSection( &writer->cs );
+}
+
+static void cab_writer_process( struct cab_writer *writer, struct cab_work *work )
+{
+    struct cab_output *output = work->output;
+    DWORD written;
+
+    switch (work->op)
+    {
+    case CAB_WORK_WRITE:
+        if (output->failed) break;
+        if (!WriteFile( output->handle, work->data, work->size, &written, NULL ) || written != work->size)
+        {
+            DWORD err = GetLastError();
+
+            ERR("failed to write extracted file data (error %u)\n", err);
+            cab_writer_set_error( writer, output, err );
+        }
+        break;
+    case CAB_WORK_CLOSE:
+        if (!output->failed && work->set_time && !SetFileTime( output->handle, &work->time, 0, &work->time ))
+        {
+            DWORD err = GetLastError();
+
+            ERR("failed to set file time (error %u)\n", err);
+            cab_writer_set_error( writer, output, err );
+        }
+        if (!CloseHandle( output->handle ) && !output->failed)
+            cab_writer_set_error( writer, output, GetLastError() );
+        EnterCriticalSection( &writer->cs );
+        output->extracted = !output->failed;
+        output->closed = TRUE;
+        LeaveCriticalSection( &writer->cs );
+        break;
+    case CAB_WORK_ABORT:
+        CloseHandle( output->handle );
+        EnterCriticalSection( &writer->cs );
+        output->closed = TRUE;
+        LeaveCriticalSection( &writer->cs );
+        break;
+    }
+}
+
+static DWORD WINAPI cab_writer_thread( void *arg )
+{
+    struct cab_writer *writer = arg;
+    unsigned int index = InterlockedIncrement( &writer->thread_index ) - 1;
+    struct list *queue = &writer->queue[index];
+    struct cab_work *work;
+    struct list *ptr;
+
+    EnterCriticalSection( &writer->cs );
+    for (;;)
+    {
+        if ((ptr = list_head( queue )))
+        {
+            list_remove( ptr );
+            LeaveCriticalSection( &writer->cs );
+
+            work = LIST_ENTRY( ptr, struct cab_work, entry );
+            cab_writer_process( writer, work );
+
+            EnterCriticalSection( &writer->cs );
+            writer->pending -= work->size;
+            WakeConditionVariable( &writer->space_cv );
+            msi_free( work );
+        }
+        else if (writer->shutdown) break;
+        else SleepConditionVariableCS( &writer->work_cv, &writer->cs, INFINITE );
+    }
+    LeaveCriticalSection( &writer->cs );
+    return 0;
+}
+
+static struct cab_writer *cab_writer_start(void)
+{
+    struct cab_writer *writer;
+    SYSTEM_INFO si;
+    unsigned int i, count;
+
+    if (!(writer = msi_alloc_zero( sizeof(*writer) ))) return NULL;
+
+    InitializeCriticalSection( &writer->cs );
+    InitializeConditionVariable( &writer->work_cv );
+    InitializeConditionVariable( &writer->space_cv );
+    list_init( &writer->outputs );
+
+    GetSystemInfo( &si );
+    count = min( max( si.dwNumberOfProcessors, 1 ), CAB_WRITER_MAX_THREADS );
+    for (i = 0; i < count; i++) list_init( &writer->queue[i] );
+
+    for (i = 0; i < count; i++)
+    {
+        if (!(writer->threads[i] = CreateThread( NULL, 0, cab_writer_thread, writer, 0, NULL )))
+            break;
+    }
+    writer->thread_count = i;
+    TRACE("started %u writer threads\n", writer->thread_count);
+    return writer;
+}
+
+static void cab_writer_free_output( struct cab_output *output )
+{
+    EnterCriticalSection( &cab_output_cs );
+    list_remove( &output->handle_entry );
+    LeaveCriticalSection( &cab_output_cs );
+
+    list_remove( &output->entry );
+    msi_free( output->file );
+    msi_free( output );
+}
+
+/* report the files whose data has been written, in extraction order */
+static void cab_writer_report( MSICABDATA *data )
+{
+    struct cab_writer *writer = data->writer;
+    struct cab_output *output;
+    struct list *ptr;
+
+    for (;;)
+    {
+        EnterCriticalSection( &writer->cs );
+        ptr = list_head( &writer->outputs );
+        output = ptr ? LIST_ENTRY( ptr, struct cab_output, entry ) : NULL;
+        if (output && !output->closed) output = NULL;
+        LeaveCriticalSection( &writer->cs );
+        if (!output) break;
+
+        if (output->extracted)
+            data->cb( data->package, output->file, MSICABEXTRACT_FILEEXTRACTED, NULL, NULL, data->user );
+        cab_writer_free_output( output );
+    }
+}
+
+/* wait for all queued data to hit the disk, returns the first write error */
+static DWORD cab_writer_stop( MSICABDATA *data )
+{
+    struct cab_writer *writer = data->writer;
+    struct cab_output *output, *next;
+    DWORD err;
+    unsigned int i;
+
+    EnterCriticalSection( &writer->cs );
+    writer->shutdown = TRUE;
+    WakeAllConditionVariable( &writer->work_cv );
+    LeaveCriticalSection( &writer->cs );
+
+    if (writer->thread_count)
+        WaitForMultipleObjects( writer->thread_count, writer->threads, TRUE, INFINITE );
+    for (i = 0; i < writer->thread_count; i++) CloseHandle( writer->threads[i] );
+
+    /* outputs that were never closed by FDI */
+    LIST_FOR_EACH_ENTRY( output, &writer->outputs, struct cab_output, entry )
+    {
+        if (output->closing) continue;
+        CloseHandle( output->handle );
+        output->closed = TRUE;
+    }
+    cab_writer_report( data );
+    LIST_FOR_EACH_ENTRY_SAFE( output, next, &writer->outputs, struct cab_output, entry )
+        cab_writer_free_output( output );
+
+    err = writer->error;
+    DeleteCriticalSection( &writer->cs );
+    msi_free( writer );
+    data->writer = NULL;
+    return err;
+}
+
+static struct cab_output *cab_writer_add_output( struct cab_writer *writer, HANDLE handle )
+{
+    struct cab_output *output;
+
+    if (!(output = msi_alloc_zero( sizeof(*output) ))) return NULL;
+    output->writer = writer;
+    output->handle = handle;
+
+    EnterCriticalSection( &writer->cs );
+    if (writer->thread_count) output->thread = writer->next_thread++ % writer->thread_count;
+    list_add_tail( &writer->outputs, &output->entry );
+    LeaveCriticalSection( &writer->cs );
+
+    EnterCriticalSection( &cab_output_cs );
+    list_add_tail( &cab_output_handles, &output->handle_entry );
+    LeaveCriticalSection( &cab_output_cs );
+    return output;
+}
+
+static struct cab_output *cab_writer_find_output( INT_PTR hf )
+{
+    struct cab_output *output, *ret = NULL;
+
+    EnterCriticalSection( &cab_output_cs );
+    LIST_FOR_EACH_ENTRY( output, &cab_output_handles, struct cab_output, handle_entry )
+    {
+        if ((INT_PTR)output == hf)
+        {
+            ret = output;
+            break;
+        }
+    }
+    LeaveCriticalSection( &cab_output_cs );
+    return ret;
+}
+
+static BOOL cab_writer_queue( struct cab_output *output, struct cab_work *work )
+{
+    struct cab_writer *writer = output->writer;
+
+    work->output = output;
+    if (!writer->thread_count)
+    {
+        /* no threads could be created, do the work synchronously */
+        cab_writer_process( writer, work );
+        msi_free( work );
+        return TRUE;
+    }
+
+    EnterCriticalSection( &writer->cs );
+    while (writer->pending && writer->pending + work->size > CAB_WRITER_MAX_PENDING)
+        SleepConditionVariableCS( &writer->space_cv, &writer->cs, INFINITE );
+
+    writer->pending += work->size;
+    list_add_tail( &writer->queue[output->thread], &work->entry );
+    WakeAllConditionVariable( &writer->work_cv );
+    LeaveCriticalSection( &writer->cs );
+    return TRUE;
+}
+
+static BOOL cab_writer_write( struct cab_output *output, const void *data, UINT size )
+{
+    struct cab_work *work;
+
+    if (!(work = msi_alloc( FIELD_OFFSET( struct cab_work, data[size] ) ))) return FALSE;
+    work->op   = CAB_WORK_WRITE;
+    work->size = size;
+    memcpy( work->data, data, size );
+    return cab_writer_queue( output, work );
+}
+
+static BOOL cab_writer_close( struct cab_output *output, enum cab_work_op op, const FILETIME *time )
+{
+    struct cab_work *work;
+
+    /* if this fails, the output stays open and cab_writer_stop closes it */
+    if (!(work = msi_alloc( sizeof(*work) ))) return FALSE;
+
+    output->closing = TRUE;
+    work->op        = op;
+    work->size      = 0;
+    work->set_time  = time != NULL;
+    if (time) work->time = *time;
+    return cab_writer_queue( output, work );
+}
+
 static void * CDECL cabinet_alloc(ULONG cb)
 {
     return msi_alloc(cb);
@@ -181,6 +511,10 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 {
     HANDLE handle = (HANDLE)hf;
     DWORD written;
+    struct cab_output *output;
+
+    if ((output = cab_writer_find_output(hf)))
+        return cab_writer_write(output, pv, cb) ? cb : 0;
 
     if (WriteFile(handle, pv, cb, &written, NULL))
         return written;
@@ -191,6 +525,11 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 static int CDECL cabinet_close(INT_PTR hf)
 {
     HANDLE handle = (HANDLE)hf;
+    struct cab_output *output;
+
+    if ((output = cab_writer_find_output(hf)))
+        return cab_writer_close(output, CAB_WORK_ABORT, NULL) ? 0 : -1;
+
     return CloseHandle(handle) ? 0 : -1;
 }
 
@@ -257,6 +596,11 @@ static UINT CDECL cabinet_read_stream( INT_PTR hf, void *pv, UINT cb )
 static int CDECL cabinet_close_stream( INT_PTR hf )
 {
     IStream *stm = (IStream *)hf;
+    struct cab_output *output;
+
+    if ((output = cab_writer_find_output( hf )))
+        return cab_writer_close( output, CAB_WORK_ABORT, NULL ) ? 0 : -1;
+
     IStream_Release( stm );
     return 0;
 }
@@ -433,6 +777,8 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
     LPWSTR path = NULL;
     DWORD attrs;
 
+    if (data->writer) cab_writer_report(data);
+
     data->curfile = strdupAtoW(pfdin->psz1);
     if (!data->cb(data->package, data->curfile, MSICABEXTRACT_BEGINEXTRACT, &path,
                   &attrs, data->user))
@@ -509,6 +855,17 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
 done:
     msi_free(path);
 
+    if (data->writer && handle && handle != INVALID_HANDLE_VALUE)
+    {
+        struct cab_output *output;
+
+        if (!(output = cab_writer_add_output(data->writer, handle)))
+        {
+            CloseHandle(handle);
+            return -1;
+        }
+        return (INT_PTR)output;
+    }
     return (INT_PTR)handle;
 }
 
@@ -522,14 +879,35 @@ static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
 
     data->mi->is_continuous = FALSE;
 
-    if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft))
-        return -1;
-    if (!LocalFileTimeToFileTime(&ft, &ftLocal))
-        return -1;
-    if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
-        return -1;
+    if (data->writer)
+    {
+        struct cab_output *output = (struct cab_output *)pfdin->hf;
+
+        if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft) ||
+            !LocalFileTimeToFileTime(&ft, &ftLocal))
+        {
+            cab_writer_close(output, CAB_WORK_ABORT, NULL);
+            return -1;
+        }
+        /* the file is reported once the writer thread is done with it */
+        output->file = data->curfile;
+        data->curfile = NULL;
+        if (!cab_writer_close(output, CAB_WORK_CLOSE, &ftLocal))
+            return -1;
+        cab_writer_report(data);
+        return 1;
+    }
+    else
+    {
+        if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft))
+            return -1;
+        if (!LocalFileTimeToFileTime(&ft, &ftLocal))
+            return -1;
+        if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
+            return -1;
 
-    CloseHandle(handle);
+        CloseHandle(handle);
+    }
 
     data->cb(data->package, data->curfile, MSICABEXTRACT_FILEEXTRACTED, NULL, NULL,
              data->user);
@@ -661,11 +1039,26 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
  */
 BOOL msi_cabextract(MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data)
 {
+    MSICABDATA *cabdata = data;
+    DWORD err;
+    BOOL ret;
+
+    cabdata->writer = NULL;
+    if (cabdata->pipelined && !(cabdata->writer = cab_writer_start()))
+        WARN("failed to start writer threads, extracting synchronously\n");
+
     if (mi->cabinet[0] == '#')
+        ret = extract_cabinet_stream( package, mi, data );
+    else
+        ret = extract_cabinet( package, mi, data );
+
+    if (cabdata->writer && (err = cab_writer_stop( cabdata )))
     {
-        return extract_cabinet_stream( package, mi, data );
+        ERR("failed to write extracted files (error %u)\n", err);
+        mi->is_extracted = FALSE;
+        ret = FALSE;
     }
-    return extract_cabinet( package, mi, data );
+    return ret;
 }
 
 void msi_free_media_info(MSIMEDIAINFO *mi)
@@ -1044,6 +1044,8 @@ typedef struct
     PMSICABEXTRACTCB cb;
     LPWSTR curfile;
     PVOID user;
+    BOOL pipelined; /* extracted files are written by background threads */
+    struct cab_writer *writer;
 } MSICABDATA;
 
 extern UINT ready_media(MSIPACKAGE *package, BOOL compressed, MSIMEDIAINFO *mi) DECLSPEC_HIDDEN;
@@ -426,6 +426,19 @@ static const CHAR co2_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\t
                                     "2\t12\t\ttest3.cab\tDISK3\t\n"
                                     "3\t2\t\ttest2.cab\tDISK2\t\n";
 
+/* tables for test_cabextract */
+static const CHAR ce_file_dat[] = "File\tComponent_\tFileName\tFileSize\tVersion\tLanguage\tAttributes\tSequence\n"
+                                  "s72\ts72\tl255\ti4\tS72\tS20\tI2\ti2\n"
+                                  "File\tFile\n"
+                                  "maximus\tmaximus\tmaximus\t500\t\t\t16384\t1\n"
+                                  "augustus\taugustus\taugustus\t200000\t\t\t16384\t2\n"
+                                  "caesar\tcaesar\tcaesar\t70000\t\t\t16384\t3";
+
+static const CHAR ce_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\tVolumeLabel\tSource\n"
+                                   "i2\ti4\tL64\tS255\tS32\tS72\n"
+                                   "Media\tDiskId\n"
+                                   "1\t3\t\ttest1.cab\tDISK1\t\n";
+
 static const CHAR mm_file_dat[] = "File\tComponent_\tFileName\tFileSize\tVersion\tLanguage\tAttributes\tSequence\n"
                                   "s72\ts72\tl255\ti4\tS72\tS20\tI2\ti2\n"
                                   "File\tFile\n"
@@ -1440,6 +1453,18 @@ static const msi_table co_tables[] =
     ADD_TABLE(property),
 };
 
+static const msi_table ce_tables[] =
+{
+    ADD_TABLE(cc_component),
+    ADD_TABLE(directory),
+    ADD_TABLE(cc_feature),
+    ADD_TABLE(cc_feature_comp),
+    ADD_TABLE(ce_file),
+    ADD_TABLE(install_exec_seq),
+    ADD_TABLE(ce_media),
+    ADD_TABLE(property),
+};
+
 static const msi_table co2_tables[] =
 {
     ADD_TABLE(cc_component),
@@ -3154,6 +3179,105 @@ error:
     DeleteFileA(msifile);
 }
 
+static void create_pattern_file(const char *name, DWORD size, const FILETIME *time)
+{
+    HANDLE file;
+    DWORD i, written;
+    BYTE *data;
+
+    data = HeapAlloc(GetProcessHeap(), 0, size);
+    for (i = 0; i < size; i++) data[i] = (i * 7 + name[0]) & 0xff;
+
+    file = CreateFileA(name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to create %s (%u)\n", name, GetLastError());
+    WriteFile(file, data, size, &written, NULL);
+    SetFileTime(file, time, time, time);
+    CloseHandle(file);
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
+static void check_pattern_file(const char *name, DWORD size, const FILETIME *time)
+{
+    char path[MAX_PATH];
+    FILETIME ft;
+    HANDLE file;
+    DWORD i, read;
+    BYTE *data;
+    BOOL match;
+
+    lstrcpyA(path, PROG_FILES_DIR);
+    lstrcatA(path, "\\msitest\\");
+    lstrcatA(path, name);
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to open %s (%u)\n", path, GetLastError());
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    ok(GetFileSize(file, NULL) == size, "%s: expected size %u, got %u\n", name, size, GetFileSize(file, NULL));
+    data = HeapAlloc(GetProcessHeap(), 0, size);
+    ok(ReadFile(file, data, size, &read, NULL) && read == size, "%s: failed to read data\n", name);
+    for (i = 0, match = TRUE; i < read; i++)
+        if (data[i] != ((i * 7 + name[0]) & 0xff)) match = FALSE;
+    ok(match, "%s: contents don't match\n", name);
+
+    GetFileTime(file, NULL, NULL, &ft);
+    ok(!CompareFileTime(&ft, time), "%s: expected time %08x%08x, got %08x%08x\n", name,
+       time->dwHighDateTime, time->dwLowDateTime, ft.dwHighDateTime, ft.dwLowDateTime);
+
+    CloseHandle(file);
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
+static void test_cabextract(void)
+{
+    static const SYSTEMTIME st = {2010, 1, 0, 2, 3, 4, 6, 0};
+    FILETIME local, time;
+    UINT r;
+
+    if (is_process_limited())
+    {
+        skip("process is limited\n");
+        return;
+    }
+
+    /* the cabinet stores local DOS times, which have a 2 seconds resolution */
+    SystemTimeToFileTime(&st, &local);
+    LocalFileTimeToFileTime(&local, &time);
+
+    create_pattern_file("maximus", 500, &time);
+    create_pattern_file("augustus", 200000, &time);
+    create_pattern_file("caesar", 70000, &time);
+    create_cab_file("test1.cab", MEDIA_SIZE, "maximus\0augustus\0caesar\0");
+
+    create_database(msifile, ce_tables, sizeof(ce_tables) / sizeof(msi_table));
+
+    MsiSetInternalUI(INSTALLUILEVEL_NONE, NULL);
+
+    r = MsiInstallProductA(msifile, NULL);
+    if (r == ERROR_INSTALL_PACKAGE_REJECTED)
+    {
+        skip("Not enough rights to perform tests\n");
+        goto error;
+    }
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+
+    check_pattern_file("maximus", 500, &time);
+    check_pattern_file("augustus", 200000, &time);
+    check_pattern_file("caesar", 70000, &time);
+
+    ok(delete_pf("msitest\\maximus", TRUE), "File not installed\n");
+    ok(delete_pf("msitest\\augustus", TRUE), "File not installed\n");
+    ok(delete_pf("msitest\\caesar", TRUE), "File not installed\n");
+    ok(delete_pf("msitest", FALSE), "Directory not created\n");
+
+error:
+    delete_cab_files();
+    DeleteFileA("maximus");
+    DeleteFileA("augustus");
+    DeleteFileA("caesar");
+    DeleteFileA(msifile);
+}
+
 static void test_mixedmedia(void)
 {
     UINT r;
@@ -5871,6 +5995,7 @@ START_TEST(install)
     test_packagecoltypes();
     test_continuouscabs();
     test_caborder();
+    test_cabextract();
     test_mixedmedia();
     test_samesequence();
     test_uiLevelFlags();
@@ -30,6 +30,126 @@
 
 #include "tomcrypt.h"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+
+/*
+ * Processors with the AES instruction set extension do a whole round in
+ * one instruction and without any key or data dependent table lookups.
+ * The round keys are the same as for the table based code, they only
+ * have to be stored in byte order.
+ */
+#define HAVE_AES_NI
+
+static int aes_ni_supported(void)
+{
+    static int supported = -1;
+
+    if (supported == -1)
+    {
+        unsigned int regs[4];
+
+        __asm__("cpuid"
+                : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+                : "0" (1));
+        supported = (regs[2] & (1 << 25)) != 0;
+    }
+    return supported;
+}
+
+static void aes_ni_encrypt(const unsigned char *pt, unsigned char *ct, const unsigned char *rk, int Nr)
+{
+    Nr--;
+    __asm__ __volatile__(
+        "movdqu (%[pt]), %%xmm0\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n"
+        "1:\n\t"
+        "add $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "aesenc %%xmm1, %%xmm0\n\t"
+        "dec %[Nr]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm1\n\t"
+        "aesenclast %%xmm1, %%xmm0\n\t"
+        "movdqu %%xmm0, (%[ct])"
+        : [rk] "+r" (rk), [Nr] "+r" (Nr)
+        : [pt] "r" (pt), [ct] "r" (ct)
+        : "xmm0", "xmm1", "memory", "cc");
+}
+
+static void aes_ni_decrypt(const unsigned char *ct, unsigned char *pt, const unsigned char *rk, int Nr)
+{
+    Nr--;
+    __asm__ __volatile__(
+        "movdqu (%[ct]), %%xmm0\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n"
+        "1:\n\t"
+        "add $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm1\n\t"
+        "aesdec %%xmm1, %%xmm0\n\t"
+        "dec %[Nr]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm1\n\t"
+        "aesdeclast %%xmm1, %%xmm0\n\t"
+        "movdqu %%xmm0, (%[pt])"
+        : [rk] "+r" (rk), [Nr] "+r" (Nr)
+        : [ct] "r" (ct), [pt] "r" (pt)
+        : "xmm0", "xmm1", "memory", "cc");
+}
+
+/* CBC decryption of four blocks at once, the rounds of independent blocks
+ * overlap in the pipeline.  All ciphertext is read before any plaintext is
+ * written, so ct and pt may be the same buffer. */
+static void aes_ni_cbc_decrypt4(const unsigned char *ct, unsigned char *pt, unsigned char *iv,
+                                const unsigned char *rk, int Nr)
+{
+    Nr--;
+    __asm__ __volatile__(
+        "movdqu (%[ct]), %%xmm0\n\t"
+        "movdqu 16(%[ct]), %%xmm1\n\t"
+        "movdqu 32(%[ct]), %%xmm2\n\t"
+        "movdqu 48(%[ct]), %%xmm3\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"
+        "pxor %%xmm4, %%xmm1\n\t"
+        "pxor %%xmm4, %%xmm2\n\t"
+        "pxor %%xmm4, %%xmm3\n"
+        "1:\n\t"
+        "add $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "aesdec %%xmm4, %%xmm0\n\t"
+        "aesdec %%xmm4, %%xmm1\n\t"
+        "aesdec %%xmm4, %%xmm2\n\t"
+        "aesdec %%xmm4, %%xmm3\n\t"
+        "dec %[Nr]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm4\n\t"
+        "aesdeclast %%xmm4, %%xmm0\n\t"
+        "aesdeclast %%xmm4, %%xmm1\n\t"
+        "aesdeclast %%xmm4, %%xmm2\n\t"
+        "aesdeclast %%xmm4, %%xmm3\n\t"
+        "movdqu (%[iv]), %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm0\n\t"
+        "movdqu (%[ct]), %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm1\n\t"
+        "movdqu 16(%[ct]), %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm2\n\t"
+        "movdqu 32(%[ct]), %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        "movdqu 48(%[ct]), %%xmm5\n\t"
+        "movdqu %%xmm5, (%[iv])\n\t"
+        "movdqu %%xmm0, (%[pt])\n\t"
+        "movdqu %%xmm1, 16(%[pt])\n\t"
+        "movdqu %%xmm2, 32(%[pt])\n\t"
+        "movdqu %%xmm3, 48(%[pt])"
+        : [rk] "+r" (rk), [Nr] "+r" (Nr)
+        : [ct] "r" (ct), [pt] "r" (pt), [iv] "r" (iv)
+        : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "memory", "cc");
+}
+
+#endif /* __GNUC__ && __x86_64__ */
+
 static const ulong32 TE0[256] = {
     0xc66363a5UL, 0xf87c7c84UL, 0xee777799UL, 0xf67b7b8dUL,
     0xfff2f20dUL, 0xd66b6bbdUL, 0xde6f6fb1UL, 0x91c5c554UL,
@@ -1058,6 +1178,19 @@ int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
     *rk++ = *rrk++;
     *rk   = *rrk;
 
+    skey->ni = 0;
+#ifdef HAVE_AES_NI
+    if (aes_ni_supported())
+    {
+        for (i = 0; i < 4 * (skey->Nr + 1); i++)
+        {
+            STORE32H(skey->eK[i], skey->ni_eK + 4 * i);
+            STORE32H(skey->dK[i], skey->ni_dK + 4 * i);
+        }
+        skey->ni = 1;
+    }
+#endif
+
     return CRYPT_OK;
 }
 
@@ -1066,6 +1199,14 @@ void aes_ecb_encrypt(const unsigned char *pt, unsigned char *ct, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#ifdef HAVE_AES_NI
+    if (skey->ni)
+    {
+        aes_ni_encrypt(pt, ct, skey->ni_eK, skey->Nr);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->eK;
 
@@ -1167,6 +1308,14 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#ifdef HAVE_AES_NI
+    if (skey->ni)
+    {
+        aes_ni_decrypt(ct, pt, skey->ni_dK, skey->Nr);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->dK;
 
@@ -1264,3 +1413,29 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
         rk[3];
     STORE32H(s3, pt+12);
 }
+
+/* Decrypts len bytes (a multiple of the block size) in CBC mode.  iv holds
+ * the chaining value and is updated to the last ciphertext block. ct and pt
+ * may be the same buffer. */
+void aes_cbc_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long len,
+                     unsigned char *iv, aes_key *skey)
+{
+    unsigned char block[16];
+    int i;
+
+#ifdef HAVE_AES_NI
+    if (skey->ni)
+    {
+        for (; len >= 64; len -= 64, ct += 64, pt += 64)
+            aes_ni_cbc_decrypt4(ct, pt, iv, skey->ni_dK, skey->Nr);
+    }
+#endif
+
+    for (; len >= 16; len -= 16, ct += 16, pt += 16)
+    {
+        memcpy(block, ct, 16);
+        aes_ecb_decrypt(block, pt, skey);
+        for (i = 0; i < 16; i++) pt[i] ^= iv[i];
+        memcpy(iv, block, 16);
+    }
+}
@@ -375,6 +375,25 @@ BOOL encrypt_block_impl(ALG_ID aiAlgid, DWORD dwKeySpec, KEY_CONTEXT *pKeyContex
     return TRUE;
 }
 
+/* Decrypts as many whole blocks of data in CBC mode as the algorithm has a
+ * bulk implementation for and returns the number of bytes processed. */
+DWORD decrypt_cbc_impl(ALG_ID aiAlgid, KEY_CONTEXT *pKeyContext, BYTE *data, DWORD dwLen,
+                       BYTE *chain)
+{
+    switch (aiAlgid) {
+        case CALG_AES:
+        case CALG_AES_128:
+        case CALG_AES_192:
+        case CALG_AES_256:
+            dwLen &= ~15;
+            aes_cbc_decrypt(data, data, dwLen, chain, &pKeyContext->aes);
+            return dwLen;
+
+        default:
+            return 0;
+    }
+}
+
 BOOL encrypt_stream_impl(ALG_ID aiAlgid, KEY_CONTEXT *pKeyContext, BYTE *stream, DWORD dwLen)
 {
     switch (aiAlgid) {
@@ -456,6 +456,129 @@ void SHA256_Transform(SHA256_CTX* context, const sha2_word32* data) {
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+#if defined(__GNUC__) && defined(__x86_64__)
+
+/*
+ * SHA-256 using the SHA extensions of x86 processors.  The state is kept
+ * in two registers as ABEF and CDGH, four rounds are done per step with
+ * the message schedule computed four words ahead.
+ */
+#define HAVE_SHA256_NI
+
+static int sha256_use_ni(void) {
+	static int supported = -1;
+	unsigned int a, b, c, d, max;
+
+	if (supported == -1) {
+		supported = 0;
+		__asm__("cpuid" : "=a"(max), "=b"(b), "=c"(c), "=d"(d) : "a"(0), "c"(0));
+		if (max >= 7) {
+			unsigned int features;
+			__asm__("cpuid" : "=a"(a), "=b"(b), "=c"(features), "=d"(d) : "a"(1), "c"(0));
+			__asm__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(7), "c"(0));
+			/* SSSE3, SSE4.1 and SHA */
+			supported = (features & (1 << 9)) && (features & (1 << 19)) && (b & (1 << 29));
+		}
+	}
+	return supported;
+}
+
+static const sha2_byte sha256_ni_shuffle[16] = {
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+};
+
+#define NI_W0 "%%xmm3"
+#define NI_W1 "%%xmm4"
+#define NI_W2 "%%xmm5"
+#define NI_W3 "%%xmm6"
+
+/* load and byte swap four message words */
+#define NI_LOAD(off, w) \
+	"movdqu " #off "(%[data])," w "\n\t" \
+	"pshufb %%xmm8," w "\n\t"
+/* first two rounds of a group */
+#define NI_ROUNDS_A(off, w) \
+	"movdqu " #off "(%[k]),%%xmm0\n\t" \
+	"paddd " w ",%%xmm0\n\t" \
+	"sha256rnds2 %%xmm0,%%xmm1,%%xmm2\n\t"
+/* last two rounds of a group */
+#define NI_ROUNDS_B \
+	"pshufd $0x0e,%%xmm0,%%xmm0\n\t" \
+	"sha256rnds2 %%xmm0,%%xmm2,%%xmm1\n\t"
+/* finish the schedule of the next group */
+#define NI_MSG2(w, prev, next) \
+	"movdqa " w ",%%xmm7\n\t" \
+	"palignr $4," prev ",%%xmm7\n\t" \
+	"paddd %%xmm7," next "\n\t" \
+	"sha256msg2 " w "," next "\n\t"
+/* start the schedule of the group after next */
+#define NI_MSG1(w, prev) \
+	"sha256msg1 " w "," prev "\n\t"
+#define NI_GROUP(off, w, prev, next) \
+	NI_ROUNDS_A(off, w) NI_MSG2(w, prev, next) NI_ROUNDS_B NI_MSG1(w, prev)
+
+static void SHA256_Transform_ni(sha2_word32* state, const sha2_byte* data, size_t blocks) {
+	__asm__ __volatile__(
+		"movdqu (%[state]),%%xmm7\n\t"
+		"movdqu 16(%[state]),%%xmm2\n\t"
+		"pshufd $0xb1,%%xmm7,%%xmm7\n\t"	/* CDAB */
+		"pshufd $0x1b,%%xmm2,%%xmm2\n\t"	/* EFGH */
+		"movdqa %%xmm7,%%xmm1\n\t"
+		"palignr $8,%%xmm2,%%xmm1\n\t"		/* ABEF */
+		"pblendw $0xf0,%%xmm7,%%xmm2\n\t"	/* CDGH */
+		"movdqu (%[mask]),%%xmm8\n"
+		"1:\n\t"
+		"movdqa %%xmm1,%%xmm9\n\t"
+		"movdqa %%xmm2,%%xmm10\n\t"
+		NI_LOAD(0, NI_W0) NI_ROUNDS_A(0, NI_W0) NI_ROUNDS_B
+		NI_LOAD(16, NI_W1) NI_ROUNDS_A(16, NI_W1) NI_ROUNDS_B NI_MSG1(NI_W1, NI_W0)
+		NI_LOAD(32, NI_W2) NI_ROUNDS_A(32, NI_W2) NI_ROUNDS_B NI_MSG1(NI_W2, NI_W1)
+		NI_LOAD(48, NI_W3) NI_GROUP(48, NI_W3, NI_W2, NI_W0)
+		NI_GROUP(64, NI_W0, NI_W3, NI_W1)
+		NI_GROUP(80, NI_W1, NI_W0, NI_W2)
+		NI_GROUP(96, NI_W2, NI_W1, NI_W3)
+		NI_GROUP(112, NI_W3, NI_W2, NI_W0)
+		NI_GROUP(128, NI_W0, NI_W3, NI_W1)
+		NI_GROUP(144, NI_W1, NI_W0, NI_W2)
+		NI_GROUP(160, NI_W2, NI_W1, NI_W3)
+		NI_GROUP(176, NI_W3, NI_W2, NI_W0)
+		NI_GROUP(192, NI_W0, NI_W3, NI_W1)
+		NI_ROUNDS_A(208, NI_W1) NI_MSG2(NI_W1, NI_W0, NI_W2) NI_ROUNDS_B
+		NI_ROUNDS_A(224, NI_W2) NI_MSG2(NI_W2, NI_W1, NI_W3) NI_ROUNDS_B
+		NI_ROUNDS_A(240, NI_W3) NI_ROUNDS_B
+		"paddd %%xmm9,%%xmm1\n\t"
+		"paddd %%xmm10,%%xmm2\n\t"
+		"add $64,%[data]\n\t"
+		"dec %[blocks]\n\t"
+		"jnz 1b\n\t"
+		"pshufd $0x1b,%%xmm1,%%xmm7\n\t"	/* FEBA */
+		"pshufd $0xb1,%%xmm2,%%xmm2\n\t"	/* DCHG */
+		"movdqa %%xmm7,%%xmm1\n\t"
+		"pblendw $0xf0,%%xmm2,%%xmm1\n\t"	/* DCBA */
+		"palignr $8,%%xmm7,%%xmm2\n\t"		/* HGFE */
+		"movdqu %%xmm1,(%[state])\n\t"
+		"movdqu %%xmm2,16(%[state])\n\t"
+		: [data] "+r" (data), [blocks] "+r" (blocks)
+		: [state] "r" (state), [k] "r" (K256), [mask] "r" (sha256_ni_shuffle)
+		: "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7",
+		  "xmm8", "xmm9", "xmm10", "memory", "cc");
+}
+
+#endif /* __GNUC__ && __x86_64__ */
+
+static void sha256_transform(SHA256_CTX* context, const sha2_byte* data, size_t blocks) {
+#ifdef HAVE_SHA256_NI
+	if (sha256_use_ni()) {
+		SHA256_Transform_ni(context->state, data, blocks);
+		return;
+	}
+#endif
+	while (blocks--) {
+		SHA256_Transform(context, (const sha2_word32*)data);
+		data += SHA256_BLOCK_LENGTH;
+	}
+}
+
 void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 	unsigned int	freespace, usedspace;
 
@@ -478,7 +601,7 @@ void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 			context->bitcount += freespace << 3;
 			len -= freespace;
 			data += freespace;
-			SHA256_Transform(context, (sha2_word32*)context->buffer);
+			sha256_transform(context, context->buffer, 1);
 		} else {
 			/* The buffer is not yet full */
 			MEMCPY_BCOPY(&context->buffer[usedspace], data, len);
@@ -488,12 +611,14 @@ void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 			return;
 		}
 	}
-	while (len >= SHA256_BLOCK_LENGTH) {
+	if (len >= SHA256_BLOCK_LENGTH) {
 		/* Process as many complete blocks as we can */
-		SHA256_Transform(context, (const sha2_word32*)data);
-		context->bitcount += SHA256_BLOCK_LENGTH << 3;
-		len -= SHA256_BLOCK_LENGTH;
-		data += SHA256_BLOCK_LENGTH;
+		size_t blocks = len / SHA256_BLOCK_LENGTH;
+
+		sha256_transform(context, data, blocks);
+		context->bitcount += (sha2_word64)blocks * SHA256_BLOCK_LENGTH << 3;
+		len -= blocks * SHA256_BLOCK_LENGTH;
+		data += blocks * SHA256_BLOCK_LENGTH;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -530,7 +655,7 @@ void SHA256_Final(sha2_byte digest[], SHA256_CTX* context) {
 					MEMSET_BZERO(&context->buffer[usedspace], SHA256_BLOCK_LENGTH - usedspace);
 				}
 				/* Do second-to-last transform: */
-				SHA256_Transform(context, (sha2_word32*)context->buffer);
+				sha256_transform(context, context->buffer, 1);
 
 				/* And set-up for the last transform: */
 				MEMSET_BZERO(context->buffer, SHA256_SHORT_BLOCK_LENGTH);
@@ -546,7 +671,7 @@ void SHA256_Final(sha2_byte digest[], SHA256_CTX* context) {
 		*(sha2_word64*)&context->buffer[SHA256_SHORT_BLOCK_LENGTH] = context->bitcount;
 
 		/* Final transform: */
-		SHA256_Transform(context, (sha2_word32*)context->buffer);
+		sha256_transform(context, context->buffer, 1);
 
 #ifndef WORDS_BIGENDIAN
 		{
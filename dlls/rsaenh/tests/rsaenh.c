@@ -1041,7 +1041,7 @@ static void test_aes(int keylen)
     HCRYPTKEY hKey;
     BOOL result;
     DWORD dwLen;
-    unsigned char pbData[16], enc_data[16], bad_data[16];
+    unsigned char pbData[16], enc_data[16], bad_data[16], long_data[160];
     int i;
 
     switch (keylen)
@@ -1131,6 +1131,27 @@ static void test_aes(int keylen)
           printBytes("got",pbData,dwLen);
       }
     }
+
+    /* Several blocks decrypted in two calls, the chaining value has to be
+       carried over from the first one */
+    for (i=0; i<sizeof(long_data); i++) long_data[i] = (unsigned char)(i * 7);
+    dwLen = 150;
+    result = CryptEncrypt(hKey, 0, TRUE, 0, long_data, &dwLen, sizeof(long_data));
+    ok(result, "%08x\n", GetLastError());
+    ok(dwLen == 160, "length incorrect, got %d\n", dwLen);
+
+    dwLen = 80;
+    result = CryptDecrypt(hKey, 0, FALSE, 0, long_data, &dwLen);
+    ok(result, "%08x\n", GetLastError());
+    ok(dwLen == 80, "length incorrect, got %d\n", dwLen);
+    dwLen = 80;
+    result = CryptDecrypt(hKey, 0, TRUE, 0, long_data + 80, &dwLen);
+    ok(result, "%08x\n", GetLastError());
+    ok(dwLen == 70, "length incorrect, got %d\n", dwLen);
+    for (i=0; i<150; i++)
+        if (long_data[i] != (unsigned char)(i * 7)) break;
+    ok(i == 150, "decryption incorrect at %d\n", i);
+
     result = CryptDestroyKey(hKey);
     ok(result, "%08x\n", GetLastError());
 }
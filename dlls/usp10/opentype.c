@@ -1049,11 +1049,192 @@ static INT GSUB_apply_lookup(const OT_LookupList* lookup, INT lookup_index, WORD
     return GSUB_E_NOGLYPH;
 }
 
-INT OpenType_apply_GSUB_lookup(LPCVOID table, INT lookup_index, WORD *glyphs, INT glyph_index, INT write_dir, INT *glyph_count)
+static const WORD *GSUB_get_first_coverage(const OT_LookupTable *look, int subtable, BOOL *filtered)
 {
-    const GSUB_Header *header = (const GSUB_Header *)table;
+    const BYTE *sub = (const BYTE *)look + GET_BE_WORD(look->SubTable[subtable]);
+
+    switch (GET_BE_WORD(look->LookupType))
+    {
+        case 1:
+        case 2:
+        case 3:
+        case 4:
+        {
+            const GSUB_SingleSubstFormat1 *ssf1 = (const GSUB_SingleSubstFormat1 *)sub;
+            return (const WORD *)(sub + GET_BE_WORD(ssf1->Coverage));
+        }
+        case 6:
+        {
+            const GSUB_ChainContextSubstFormat3_1 *ccsf3_1 = (const GSUB_ChainContextSubstFormat3_1 *)sub;
+            const GSUB_ChainContextSubstFormat3_2 *ccsf3_2;
+
+            /* formats 1 and 2 are not implemented and never match */
+            if (GET_BE_WORD(ccsf3_1->SubstFormat) == 1 || GET_BE_WORD(ccsf3_1->SubstFormat) == 2)
+                return NULL;
+            if (GET_BE_WORD(ccsf3_1->SubstFormat) != 3)
+                break;
+            ccsf3_2 = (const GSUB_ChainContextSubstFormat3_2 *)(sub +
+                    FIELD_OFFSET(GSUB_ChainContextSubstFormat3_1, Coverage[GET_BE_WORD(ccsf3_1->BacktrackGlyphCount)]));
+            if (!GET_BE_WORD(ccsf3_2->InputGlyphCount))
+                break;
+            return (const WORD *)(sub + GET_BE_WORD(ccsf3_2->Coverage[0]));
+        }
+    }
+    *filtered = FALSE;
+    return NULL;
+}
+
+static BOOL GSUB_get_coverage_bounds(const WORD *coverage, WORD *first, WORD *last)
+{
+    const OT_CoverageFormat1 *cf1 = (const OT_CoverageFormat1 *)coverage;
+    int i, count;
+
+    if (GET_BE_WORD(cf1->CoverageFormat) == 1)
+    {
+        count = GET_BE_WORD(cf1->GlyphCount);
+        for (i = 0; i < count; i++)
+        {
+            WORD glyph = GET_BE_WORD(cf1->GlyphArray[i]);
+            *first = min(*first, glyph);
+            *last = max(*last, glyph);
+        }
+        return TRUE;
+    }
+    else if (GET_BE_WORD(cf1->CoverageFormat) == 2)
+    {
+        const OT_CoverageFormat2 *cf2 = (const OT_CoverageFormat2 *)coverage;
+
+        count = GET_BE_WORD(cf2->RangeCount);
+        for (i = 0; i < count; i++)
+        {
+            WORD start = GET_BE_WORD(cf2->RangeRecord[i].Start);
+            WORD end = GET_BE_WORD(cf2->RangeRecord[i].End);
+            if (start > end) continue;
+            *first = min(*first, start);
+            *last = max(*last, end);
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static void GSUB_fill_coverage_bits(const WORD *coverage, CompiledLookup *compiled)
+{
+    const OT_CoverageFormat1 *cf1 = (const OT_CoverageFormat1 *)coverage;
+    int i, count;
+    UINT glyph;
+
+    if (GET_BE_WORD(cf1->CoverageFormat) == 1)
+    {
+        count = GET_BE_WORD(cf1->GlyphCount);
+        for (i = 0; i < count; i++)
+        {
+            glyph = GET_BE_WORD(cf1->GlyphArray[i]) - compiled->first_glyph;
+            compiled->coverage[glyph / 8] |= 1 << (glyph % 8);
+        }
+    }
+    else
+    {
+        const OT_CoverageFormat2 *cf2 = (const OT_CoverageFormat2 *)coverage;
+
+        count = GET_BE_WORD(cf2->RangeCount);
+        for (i = 0; i < count; i++)
+        {
+            UINT end = GET_BE_WORD(cf2->RangeRecord[i].End) - compiled->first_glyph;
+            for (glyph = GET_BE_WORD(cf2->RangeRecord[i].Start) - compiled->first_glyph; glyph <= end; glyph++)
+                compiled->coverage[glyph / 8] |= 1 << (glyph % 8);
+        }
+    }
+}
+
+/* Collect the glyphs a lookup can start matching on, so that uncovered
+ * glyphs are rejected without walking all of its subtables. */
+static void GSUB_compile_lookup(const OT_LookupList *lookup, INT lookup_index, CompiledLookup *compiled)
+{
+    const OT_LookupTable *look;
+    const WORD *coverage;
+    WORD first = 0xffff, last = 0;
+    int i, count;
+
+    compiled->compiled = TRUE;
+    compiled->filtered = TRUE;
+
+    look = (const OT_LookupTable *)((const BYTE *)lookup + GET_BE_WORD(lookup->Lookup[lookup_index]));
+    count = GET_BE_WORD(look->SubTableCount);
+    for (i = 0; i < count; i++)
+    {
+        if (!(coverage = GSUB_get_first_coverage(look, i, &compiled->filtered)))
+        {
+            if (!compiled->filtered) return;
+            continue;
+        }
+        if (!GSUB_get_coverage_bounds(coverage, &first, &last))
+        {
+            compiled->filtered = FALSE;
+            return;
+        }
+    }
+
+    /* nothing can match, keep an empty range */
+    if (first > last)
+    {
+        compiled->first_glyph = 1;
+        compiled->last_glyph = 0;
+        return;
+    }
+
+    if (!(compiled->coverage = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, (last - first) / 8 + 1)))
+    {
+        compiled->filtered = FALSE;
+        return;
+    }
+    compiled->first_glyph = first;
+    compiled->last_glyph = last;
+
+    for (i = 0; i < count; i++)
+    {
+        if ((coverage = GSUB_get_first_coverage(look, i, &compiled->filtered)))
+            GSUB_fill_coverage_bits(coverage, compiled);
+    }
+    TRACE("lookup %i covers glyphs 0x%x-0x%x\n", lookup_index, first, last);
+}
+
+static BOOL GSUB_lookup_may_apply(ScriptCache *psc, const OT_LookupList *lookup, INT lookup_index, WORD glyph)
+{
+    CompiledLookup *compiled;
+
+    if (!psc->GSUB_lookups)
+    {
+        psc->GSUB_lookup_count = GET_BE_WORD(lookup->LookupCount);
+        psc->GSUB_lookups = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(CompiledLookup) * psc->GSUB_lookup_count);
+        if (!psc->GSUB_lookups)
+        {
+            psc->GSUB_lookup_count = 0;
+            return TRUE;
+        }
+    }
+    if (lookup_index < 0 || lookup_index >= psc->GSUB_lookup_count)
+        return TRUE;
+
+    compiled = &psc->GSUB_lookups[lookup_index];
+    if (!compiled->compiled)
+        GSUB_compile_lookup(lookup, lookup_index, compiled);
+    if (!compiled->filtered)
+        return TRUE;
+    if (glyph < compiled->first_glyph || glyph > compiled->last_glyph)
+        return FALSE;
+    glyph -= compiled->first_glyph;
+    return (compiled->coverage[glyph / 8] >> (glyph % 8)) & 1;
+}
+
+INT OpenType_apply_GSUB_lookup(ScriptCache *psc, INT lookup_index, WORD *glyphs, INT glyph_index, INT write_dir, INT *glyph_count)
+{
+    const GSUB_Header *header = (const GSUB_Header *)psc->GSUB_Table;
     const OT_LookupList *lookup = (const OT_LookupList*)((const BYTE*)header + GET_BE_WORD(header->LookupList));
 
+    if (!GSUB_lookup_may_apply(psc, lookup, lookup_index, glyphs[glyph_index]))
+        return GSUB_E_NOGLYPH;
+
     return GSUB_apply_lookup(lookup, lookup_index, glyphs, glyph_index, write_dir, glyph_count);
 }
 
@@ -1329,6 +1329,7 @@ static void test_ScriptShape(HDC hdc)
 {
     static const WCHAR test1[] = {'w', 'i', 'n', 'e',0};
     static const WCHAR test2[] = {0x202B, 'i', 'n', 0x202C,0};
+    static const WCHAR test3[] = {'e', 'i', 'n', 'w',0};
     HRESULT hr;
     SCRIPT_CACHE sc = NULL;
     WORD glyphs[4], glyphs2[4], logclust[4];
@@ -1453,6 +1454,22 @@ static void test_ScriptShape(HDC hdc)
     ok(attrs[2].fZeroWidth == 0, "fZeroWidth incorrect\n");
     ok(attrs[3].fZeroWidth == 0, "fZeroWidth incorrect\n");
 
+    /* shaping the same run again, and a different run of the same length */
+    items[0].a.fRTL = 0;
+    memset(glyphs2,-1,sizeof(glyphs2));
+    hr = ScriptShape(hdc, &sc, test1, 4, 4, &items[0].a, glyphs2, logclust, attrs, &nb);
+    ok(!hr, "ScriptShape should return S_OK not %08x\n", hr);
+    ok(nb == 4, "Wrong number of items\n");
+    ok(!memcmp(glyphs, glyphs2, sizeof(glyphs)), "Glyphs differ\n");
+    ok(logclust[0] == 0 && logclust[3] == 3, "clusters out of order\n");
+
+    memset(glyphs2,-1,sizeof(glyphs2));
+    hr = ScriptShape(hdc, &sc, test3, 4, 4, &items[0].a, glyphs2, logclust, attrs, &nb);
+    ok(!hr, "ScriptShape should return S_OK not %08x\n", hr);
+    ok(nb == 4, "Wrong number of items\n");
+    ok(glyphs2[0] == glyphs[3], "Wrong glyph %04x\n", glyphs2[0]);
+    ok(glyphs2[3] == glyphs[0], "Wrong glyph %04x\n", glyphs2[3]);
+
     ScriptFreeCache(&sc);
 }
 
@@ -1465,8 +1482,8 @@ static void test_ScriptPlace(HDC hdc)
     WORD glyphs[4], logclust[4];
     SCRIPT_VISATTR attrs[4];
     SCRIPT_ITEM items[2];
-    int nb, widths[4];
-    GOFFSET offset[4];
+    int nb, widths[4], widths2[4];
+    GOFFSET offset[4], offset2[4];
     ABC abc[4];
 
     hr = ScriptItemize(test1, 4, 2, NULL, NULL, items, NULL);
@@ -1502,6 +1519,17 @@ static void test_ScriptPlace(HDC hdc)
     ret = ExtTextOutW(hdc, 1, 1, 0, NULL, glyphs, 4, widths);
     ok(ret, "ExtTextOutW should return TRUE\n");
 
+    hr = ScriptPlace(hdc, &sc, glyphs, 4, attrs, &items[0].a, widths, offset, &abc[0]);
+    ok(!hr, "ScriptPlace should return S_OK not %08x\n", hr);
+    memset(widths2, 0xcc, sizeof(widths2));
+    memset(offset2, 0xcc, sizeof(offset2));
+    memset(&abc[1], 0xcc, sizeof(abc[1]));
+    hr = ScriptPlace(hdc, &sc, glyphs, 4, attrs, &items[0].a, widths2, offset2, &abc[1]);
+    ok(!hr, "ScriptPlace should return S_OK not %08x\n", hr);
+    ok(!memcmp(widths, widths2, sizeof(widths)), "widths differ\n");
+    ok(!memcmp(offset, offset2, sizeof(offset)), "offsets differ\n");
+    ok(!memcmp(&abc[0], &abc[1], sizeof(abc[0])), "ABC widths differ\n");
+
     ScriptFreeCache(&sc);
 }
 
@@ -875,6 +875,195 @@ static HRESULT init_script_cache(const HDC hdc, SCRIPT_CACHE *psc)
     return S_OK;
 }
 
+struct shaped_run
+{
+    DWORD hash;
+    DWORD last_used;
+    OPENTYPE_TAG script_tag;
+    OPENTYPE_TAG lang_tag;
+    SCRIPT_ANALYSIS sa;
+    int max_glyphs;
+    int char_count;
+    int glyph_count;
+    WCHAR *chars;
+    WORD *glyphs;
+    WORD *log_clust;
+    SCRIPT_CHARPROP *char_props;
+    SCRIPT_GLYPHPROP *glyph_props;
+};
+
+struct placed_run
+{
+    DWORD hash;
+    DWORD last_used;
+    OPENTYPE_TAG script_tag;
+    OPENTYPE_TAG lang_tag;
+    SCRIPT_ANALYSIS sa;
+    int glyph_count;
+    ABC abc;
+    int *advances;
+    GOFFSET *offsets;
+    WORD *glyphs;
+};
+
+static DWORD hash_run(DWORD hash, const void *data, SIZE_T size)
+{
+    const BYTE *p = data;
+    SIZE_T i;
+
+    for (i = 0; i < size; i++)
+        hash = (hash ^ p[i]) * 0x01000193;
+    return hash;
+}
+
+static DWORD hash_run_key(OPENTYPE_TAG script_tag, OPENTYPE_TAG lang_tag, const SCRIPT_ANALYSIS *sa,
+                          const void *data, SIZE_T size)
+{
+    DWORD hash = 0x811c9dc5;
+
+    hash = hash_run(hash, &script_tag, sizeof(script_tag));
+    hash = hash_run(hash, &lang_tag, sizeof(lang_tag));
+    hash = hash_run(hash, sa, sizeof(*sa));
+    return hash_run(hash, data, size);
+}
+
+static struct shaped_run *find_shaped_run(ScriptCache *sc, DWORD hash, OPENTYPE_TAG script_tag,
+                                          OPENTYPE_TAG lang_tag, const SCRIPT_ANALYSIS *sa,
+                                          const WCHAR *chars, int count, int max_glyphs)
+{
+    unsigned int i;
+
+    for (i = 0; i < RUN_CACHE_SIZE; i++)
+    {
+        struct shaped_run *run = sc->shaped_runs[i];
+
+        if (!run || run->hash != hash) continue;
+        if (run->script_tag != script_tag || run->lang_tag != lang_tag) continue;
+        if (run->char_count != count || run->max_glyphs != max_glyphs) continue;
+        if (memcmp(&run->sa, sa, sizeof(*sa)) || memcmp(run->chars, chars, count * sizeof(WCHAR))) continue;
+        run->last_used = ++sc->run_clock;
+        return run;
+    }
+    return NULL;
+}
+
+static void add_shaped_run(ScriptCache *sc, DWORD hash, OPENTYPE_TAG script_tag, OPENTYPE_TAG lang_tag,
+                           const SCRIPT_ANALYSIS *sa, const WCHAR *chars, int count, int max_glyphs,
+                           const WORD *glyphs, int glyph_count, const WORD *log_clust,
+                           const SCRIPT_CHARPROP *char_props, const SCRIPT_GLYPHPROP *glyph_props)
+{
+    struct shaped_run *run;
+    unsigned int i, victim;
+    SIZE_T size;
+
+    if (count > RUN_CACHE_MAX_CHARS || glyph_count > max_glyphs) return;
+
+    size = sizeof(*run) + count * (sizeof(WCHAR) + sizeof(WORD) + sizeof(SCRIPT_CHARPROP))
+           + glyph_count * (sizeof(WORD) + sizeof(SCRIPT_GLYPHPROP));
+
+    /* replace an empty slot, or the least recently used run */
+    for (i = 0, victim = 0; i < RUN_CACHE_SIZE; i++)
+    {
+        if (!sc->shaped_runs[i])
+        {
+            victim = i;
+            break;
+        }
+        if (sc->shaped_runs[i]->last_used < sc->shaped_runs[victim]->last_used) victim = i;
+    }
+    /* reuse the block of the evicted run */
+    if (sc->shaped_runs[victim])
+        run = heap_realloc_zero(sc->shaped_runs[victim], size);
+    else
+        run = heap_alloc(size);
+    if (!run) return;
+    sc->shaped_runs[victim] = run;
+
+    run->hash = hash;
+    run->last_used = ++sc->run_clock;
+    run->script_tag = script_tag;
+    run->lang_tag = lang_tag;
+    run->sa = *sa;
+    run->max_glyphs = max_glyphs;
+    run->char_count = count;
+    run->glyph_count = glyph_count;
+    run->glyph_props = (SCRIPT_GLYPHPROP *)(run + 1);
+    run->char_props = (SCRIPT_CHARPROP *)(run->glyph_props + glyph_count);
+    run->chars = (WCHAR *)(run->char_props + count);
+    run->log_clust = run->chars + count;
+    run->glyphs = run->log_clust + count;
+    memcpy(run->glyph_props, glyph_props, glyph_count * sizeof(*glyph_props));
+    memcpy(run->char_props, char_props, count * sizeof(*char_props));
+    memcpy(run->chars, chars, count * sizeof(*chars));
+    memcpy(run->log_clust, log_clust, count * sizeof(*log_clust));
+    memcpy(run->glyphs, glyphs, glyph_count * sizeof(*glyphs));
+}
+
+static struct placed_run *find_placed_run(ScriptCache *sc, DWORD hash, OPENTYPE_TAG script_tag,
+                                          OPENTYPE_TAG lang_tag, const SCRIPT_ANALYSIS *sa,
+                                          const WORD *glyphs, int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < RUN_CACHE_SIZE; i++)
+    {
+        struct placed_run *run = sc->placed_runs[i];
+
+        if (!run || run->hash != hash) continue;
+        if (run->script_tag != script_tag || run->lang_tag != lang_tag) continue;
+        if (run->glyph_count != count) continue;
+        if (memcmp(&run->sa, sa, sizeof(*sa)) || memcmp(run->glyphs, glyphs, count * sizeof(WORD))) continue;
+        run->last_used = ++sc->run_clock;
+        return run;
+    }
+    return NULL;
+}
+
+static void add_placed_run(ScriptCache *sc, DWORD hash, OPENTYPE_TAG script_tag, OPENTYPE_TAG lang_tag,
+                           const SCRIPT_ANALYSIS *sa, const WORD *glyphs, int count,
+                           const int *advances, const GOFFSET *offsets, const ABC *abc)
+{
+    struct placed_run *run;
+    unsigned int i, victim;
+    SIZE_T size;
+
+    if (count > RUN_CACHE_MAX_CHARS) return;
+
+    size = sizeof(*run) + count * (sizeof(int) + sizeof(GOFFSET) + sizeof(WORD));
+
+    /* replace an empty slot, or the least recently used run */
+    for (i = 0, victim = 0; i < RUN_CACHE_SIZE; i++)
+    {
+        if (!sc->placed_runs[i])
+        {
+            victim = i;
+            break;
+        }
+        if (sc->placed_runs[i]->last_used < sc->placed_runs[victim]->last_used) victim = i;
+    }
+    /* reuse the block of the evicted run */
+    if (sc->placed_runs[victim])
+        run = heap_realloc_zero(sc->placed_runs[victim], size);
+    else
+        run = heap_alloc(size);
+    if (!run) return;
+    sc->placed_runs[victim] = run;
+
+    run->hash = hash;
+    run->last_used = ++sc->run_clock;
+    run->script_tag = script_tag;
+    run->lang_tag = lang_tag;
+    run->sa = *sa;
+    run->glyph_count = count;
+    run->abc = *abc;
+    run->advances = (int *)(run + 1);
+    run->offsets = (GOFFSET *)(run->advances + count);
+    run->glyphs = (WORD *)(run->offsets + count);
+    memcpy(run->advances, advances, count * sizeof(*advances));
+    memcpy(run->offsets, offsets, count * sizeof(*offsets));
+    memcpy(run->glyphs, glyphs, count * sizeof(*glyphs));
+}
+
 static WCHAR mirror_char( WCHAR ch )
 {
     extern const WCHAR wine_mirror_map[];
@@ -1050,6 +1239,14 @@ HRESULT WINAPI ScriptFreeCache(SCRIPT_CACHE *psc)
             heap_free(((ScriptCache *)*psc)->scripts[n].languages);
         }
         heap_free(((ScriptCache *)*psc)->scripts);
+        for (n = 0; n < ((ScriptCache *)*psc)->GSUB_lookup_count; n++)
+            heap_free(((ScriptCache *)*psc)->GSUB_lookups[n].coverage);
+        heap_free(((ScriptCache *)*psc)->GSUB_lookups);
+        for (i = 0; i < RUN_CACHE_SIZE; i++)
+        {
+            heap_free(((ScriptCache *)*psc)->shaped_runs[i]);
+            heap_free(((ScriptCache *)*psc)->placed_runs[i]);
+        }
         heap_free(((ScriptCache *)*psc)->otm);
         heap_free(*psc);
         *psc = NULL;
@@ -2848,6 +3045,7 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
     unsigned int g;
     BOOL rtl;
     int cluster;
+    DWORD hash = 0;
 
     TRACE("(%p, %p, %p, %s, %s, %p, %p, %d, %s, %d, %d, %p, %p, %p, %p, %p )\n",
      hdc, psc, psa,
@@ -2899,6 +3097,24 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
     if (psa && !psa->fNoGlyphIndex)
     {
         WCHAR *rChars;
+
+        if (!cRanges)
+        {
+            struct shaped_run *run;
+
+            hash = hash_run_key(tagScript, tagLangSys, psa, pwcChars, cChars * sizeof(WCHAR));
+            if ((run = find_shaped_run(*psc, hash, tagScript, tagLangSys, psa, pwcChars, cChars, cMaxGlyphs)))
+            {
+                TRACE("using cached run\n");
+                *pcGlyphs = run->glyph_count;
+                memcpy(pwOutGlyphs, run->glyphs, run->glyph_count * sizeof(WORD));
+                memcpy(pOutGlyphProps, run->glyph_props, run->glyph_count * sizeof(SCRIPT_GLYPHPROP));
+                memcpy(pwLogClust, run->log_clust, cChars * sizeof(WORD));
+                memcpy(pCharProps, run->char_props, cChars * sizeof(SCRIPT_CHARPROP));
+                return S_OK;
+            }
+        }
+
         if ((hr = SHAPE_CheckFontForRequiredFeatures(hdc, (ScriptCache *)*psc, psa)) != S_OK) return hr;
 
         rChars = heap_alloc(sizeof(WCHAR) * cChars);
@@ -2961,6 +3177,10 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
         SHAPE_ApplyDefaultOpentypeFeatures(hdc, (ScriptCache *)*psc, psa, pwOutGlyphs, pcGlyphs, cMaxGlyphs, cChars, pwLogClust);
         SHAPE_CharGlyphProp(hdc, (ScriptCache *)*psc, psa, pwcChars, cChars, pwOutGlyphs, *pcGlyphs, pwLogClust, pCharProps, pOutGlyphProps);
         heap_free(rChars);
+
+        if (!cRanges)
+            add_shaped_run(*psc, hash, tagScript, tagLangSys, psa, pwcChars, cChars, cMaxGlyphs,
+                           pwOutGlyphs, *pcGlyphs, pwLogClust, pCharProps, pOutGlyphProps);
     }
     else
     {
@@ -3077,6 +3297,8 @@ HRESULT WINAPI ScriptPlaceOpenType( HDC hdc, SCRIPT_CACHE *psc, SCRIPT_ANALYSIS
 {
     HRESULT hr;
     int i;
+    DWORD hash = 0;
+    ABC total;
 
     TRACE("(%p, %p, %p, %s, %s, %p, %p, %d, %s, %p, %p, %d, %p, %p, %d, %p %p %p)\n",
      hdc, psc, psa,
@@ -3095,7 +3317,23 @@ HRESULT WINAPI ScriptPlaceOpenType( HDC hdc, SCRIPT_CACHE *psc, SCRIPT_ANALYSIS
     ((ScriptCache *)*psc)->userScript = tagScript;
     ((ScriptCache *)*psc)->userLang = tagLangSys;
 
+    if (!cRanges)
+    {
+        struct placed_run *run;
+
+        hash = hash_run_key(tagScript, tagLangSys, psa, pwGlyphs, cGlyphs * sizeof(WORD));
+        if ((run = find_placed_run(*psc, hash, tagScript, tagLangSys, psa, pwGlyphs, cGlyphs)))
+        {
+            TRACE("using cached run\n");
+            if (piAdvance) memcpy(piAdvance, run->advances, cGlyphs * sizeof(int));
+            memcpy(pGoffset, run->offsets, cGlyphs * sizeof(GOFFSET));
+            if (pABC) *pABC = run->abc;
+            return S_OK;
+        }
+    }
+
     if (pABC) memset(pABC, 0, sizeof(ABC));
+    memset(&total, 0, sizeof(total));
     for (i = 0; i < cGlyphs; i++)
     {
         ABC abc;
@@ -3115,12 +3353,9 @@ HRESULT WINAPI ScriptPlaceOpenType( HDC hdc, SCRIPT_CACHE *psc, SCRIPT_ANALYSIS
             }
             set_cache_glyph_widths(psc, pwGlyphs[i], &abc);
         }
-        if (pABC)
-        {
-            pABC->abcA += abc.abcA;
-            pABC->abcB += abc.abcB;
-            pABC->abcC += abc.abcC;
-        }
+        total.abcA += abc.abcA;
+        total.abcB += abc.abcB;
+        total.abcC += abc.abcC;
         /* FIXME: set to more reasonable values */
         pGoffset[i].du = pGoffset[i].dv = 0;
         if (piAdvance) piAdvance[i] = abc.abcA + abc.abcB + abc.abcC;
@@ -3128,6 +3363,10 @@ HRESULT WINAPI ScriptPlaceOpenType( HDC hdc, SCRIPT_CACHE *psc, SCRIPT_ANALYSIS
 
     SHAPE_ApplyOpenTypePositions(hdc, (ScriptCache *)*psc, psa, pwGlyphs, cGlyphs, piAdvance, pGoffset);
 
+    if (pABC) *pABC = total;
+    if (!cRanges && piAdvance)
+        add_placed_run(*psc, hash, tagScript, tagLangSys, psa, pwGlyphs, cGlyphs, piAdvance, pGoffset, &total);
+
     if (pABC) TRACE("Total for run: abcA=%d, abcB=%d, abcC=%d\n", pABC->abcA, pABC->abcB, pABC->abcC);
     return S_OK;
 }
@@ -159,10 +159,24 @@ typedef struct {
     LoadedLanguage *languages;
 } LoadedScript;
 
+typedef struct {
+    BOOL compiled;
+    BOOL filtered;
+    WORD first_glyph;
+    WORD last_glyph;
+    BYTE *coverage;
+} CompiledLookup;
+
 typedef struct {
     WORD *glyphs[GLYPH_MAX / GLYPH_BLOCK_SIZE];
 } CacheGlyphPage;
 
+#define RUN_CACHE_SIZE      32
+#define RUN_CACHE_MAX_CHARS 256
+
+struct shaped_run;
+struct placed_run;
+
 typedef struct {
     LOGFONTW lf;
     TEXTMETRICW tm;
@@ -179,9 +193,15 @@ typedef struct {
     BOOL scripts_initialized;
     INT script_count;
     LoadedScript *scripts;
+    INT GSUB_lookup_count;
+    CompiledLookup *GSUB_lookups;
 
     OPENTYPE_TAG userScript;
     OPENTYPE_TAG userLang;
+
+    DWORD run_clock;
+    struct shaped_run *shaped_runs[RUN_CACHE_SIZE];
+    struct placed_run *placed_runs[RUN_CACHE_SIZE];
 } ScriptCache;
 
 typedef struct _scriptData
@@ -246,7 +266,7 @@ void BREAK_line(const WCHAR *chars, int count, const SCRIPT_ANALYSIS *sa, SCRIPT
 
 DWORD OpenType_CMAP_GetGlyphIndex(HDC hdc, ScriptCache *psc, DWORD utf32c, LPWORD pgi, DWORD flags) DECLSPEC_HIDDEN;
 void OpenType_GDEF_UpdateGlyphProps(ScriptCache *psc, const WORD *pwGlyphs, const WORD cGlyphs, WORD* pwLogClust, const WORD cChars, SCRIPT_GLYPHPROP *pGlyphProp) DECLSPEC_HIDDEN;
-INT OpenType_apply_GSUB_lookup(LPCVOID table, INT lookup_index, WORD *glyphs, INT glyph_index, INT write_dir, INT *glyph_count) DECLSPEC_HIDDEN;
+INT OpenType_apply_GSUB_lookup(ScriptCache *psc, INT lookup_index, WORD *glyphs, INT glyph_index, INT write_dir, INT *glyph_count) DECLSPEC_HIDDEN;
 INT OpenType_apply_GPOS_lookup(ScriptCache *psc, LPOUTLINETEXTMETRICW lpotm, LPLOGFONTW lplogfont, const SCRIPT_ANALYSIS *analysis, INT* piAdvance, INT lookup_index, const WORD *glyphs, INT glyph_index, INT glyph_count, GOFFSET *pGoffset) DECLSPEC_HIDDEN;
 HRESULT OpenType_GetFontScriptTags(ScriptCache *psc, OPENTYPE_TAG searchingFor, int cMaxTags, OPENTYPE_TAG *pScriptTags, int *pcTags) DECLSPEC_HIDDEN;
 HRESULT OpenType_GetFontLanguageTags(ScriptCache *psc, OPENTYPE_TAG script_tag, OPENTYPE_TAG searchingFor, int cMaxTags, OPENTYPE_TAG *pLanguageTags, int *pcTags) DECLSPEC_HIDDEN;
@@ -67,11 +67,14 @@ struct pixelformatinfo {
     copyfunc copy_function;
 };
 
+struct pixelformatconversion;
+
 typedef struct FormatConverter {
     IWICFormatConverter IWICFormatConverter_iface;
     LONG ref;
     IWICBitmapSource *source;
     const struct pixelformatinfo *dst_format, *src_format;
+    const struct pixelformatconversion *conversion;
     WICBitmapDitherType dither;
     double alpha_threshold;
     WICBitmapPaletteType palette_type;
@@ -994,6 +997,291 @@ static HRESULT copypixels_to_24bppRGB(struct FormatConverter *This, const WICRec
     }
 }
 
+/* Row converters for the common format pairs. Converters that widen the
+ * pixels walk the row backwards and the others walk it forwards, so all of
+ * them can work in place with src and dst pointing at the same row. */
+
+static void convert_row_24bppBGR_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    src += width * 3;
+    dst += width * 4;
+    while (width--)
+    {
+        src -= 3;
+        dst -= 4;
+        dst[3] = 0xff;
+        dst[2] = src[2];
+        dst[1] = src[1];
+        dst[0] = src[0];
+    }
+}
+
+static void convert_row_24bppRGB_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    src += width * 3;
+    dst += width * 4;
+    while (width--)
+    {
+        BYTE red, green, blue;
+        src -= 3;
+        dst -= 4;
+        red = src[0];
+        green = src[1];
+        blue = src[2];
+        dst[0] = blue;
+        dst[1] = green;
+        dst[2] = red;
+        dst[3] = 0xff;
+    }
+}
+
+static void convert_row_8bppGray_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst + width;
+
+    src += width;
+    while (width--)
+    {
+        BYTE gray = *--src;
+        *--dstpixel = 0xff000000 | gray << 16 | gray << 8 | gray;
+    }
+}
+
+static void convert_row_8bppGray_to_24bppBGR(const BYTE *src, BYTE *dst, UINT width)
+{
+    src += width;
+    dst += width * 3;
+    while (width--)
+    {
+        BYTE gray = *--src;
+        dst -= 3;
+        dst[2] = dst[1] = dst[0] = gray;
+    }
+}
+
+static void convert_row_32bppBGR_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    const DWORD *srcpixel = (const DWORD *)src;
+    DWORD *dstpixel = (DWORD *)dst;
+
+    while (width--)
+        *dstpixel++ = *srcpixel++ | 0xff000000;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+
+/*
+ * SSE2 is part of x86-64, so premultiplying can use it without checking
+ * the processor. Four pixels are done at once, with c * a / 255 computed
+ * exactly as (t + 1 + (t >> 8)) >> 8 for t = c * a, so the result is the
+ * same as in the C loop.
+ */
+#define HAVE_SSE2_PREMULTIPLY
+
+static void sse2_premultiply_row(const BYTE *src, BYTE *dst, ULONG_PTR count)
+{
+    static const WORD one[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+    static const DWORD alpha_mask[4] = {0xff000000, 0xff000000, 0xff000000, 0xff000000};
+
+    if (!count) return;
+
+    __asm__ __volatile__(
+        "pxor %%xmm7, %%xmm7\n\t"
+        "movdqu %[one], %%xmm6\n\t"
+        "movdqu %[mask], %%xmm5\n"
+        "1:\n\t"
+        "movdqu (%[src]), %%xmm0\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm4\n\t"
+        "punpcklbw %%xmm7, %%xmm0\n\t"
+        "punpckhbw %%xmm7, %%xmm1\n\t"
+        /* spread the alpha of each pixel over its four words */
+        "pshuflw $0xff, %%xmm0, %%xmm2\n\t"
+        "pshufhw $0xff, %%xmm2, %%xmm2\n\t"
+        "pshuflw $0xff, %%xmm1, %%xmm3\n\t"
+        "pshufhw $0xff, %%xmm3, %%xmm3\n\t"
+        "pmullw %%xmm2, %%xmm0\n\t"
+        "pmullw %%xmm3, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "movdqa %%xmm1, %%xmm3\n\t"
+        "psrlw $8, %%xmm2\n\t"
+        "psrlw $8, %%xmm3\n\t"
+        "paddw %%xmm6, %%xmm0\n\t"
+        "paddw %%xmm6, %%xmm1\n\t"
+        "paddw %%xmm2, %%xmm0\n\t"
+        "paddw %%xmm3, %%xmm1\n\t"
+        "psrlw $8, %%xmm0\n\t"
+        "psrlw $8, %%xmm1\n\t"
+        "packuswb %%xmm1, %%xmm0\n\t"
+        /* keep the original alpha */
+        "movdqa %%xmm5, %%xmm3\n\t"
+        "pand %%xmm5, %%xmm4\n\t"
+        "pandn %%xmm0, %%xmm3\n\t"
+        "por %%xmm4, %%xmm3\n\t"
+        "movdqu %%xmm3, (%[dst])\n\t"
+        "add $16, %[src]\n\t"
+        "add $16, %[dst]\n\t"
+        "dec %[count]\n\t"
+        "jnz 1b"
+        : [src] "+r" (src), [dst] "+r" (dst), [count] "+r" (count)
+        : [one] "m" (one), [mask] "m" (alpha_mask)
+        : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "memory", "cc");
+}
+
+#endif
+
+static void convert_row_32bppBGRA_to_32bppPBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+#ifdef HAVE_SSE2_PREMULTIPLY
+    sse2_premultiply_row(src, dst, width / 4);
+    src += (width & ~3) * 4;
+    dst += (width & ~3) * 4;
+    width &= 3;
+#endif
+
+    while (width--)
+    {
+        BYTE alpha = src[3];
+        if (alpha == 255)
+            *(DWORD *)dst = *(const DWORD *)src;
+        else
+        {
+            dst[0] = src[0] * alpha / 255;
+            dst[1] = src[1] * alpha / 255;
+            dst[2] = src[2] * alpha / 255;
+            dst[3] = alpha;
+        }
+        src += 4;
+        dst += 4;
+    }
+}
+
+static void convert_row_32bppBGRA_to_24bppBGR(const BYTE *src, BYTE *dst, UINT width)
+{
+    while (width--)
+    {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        src += 4;
+        dst += 3;
+    }
+}
+
+static void convert_row_32bppBGRA_to_24bppRGB(const BYTE *src, BYTE *dst, UINT width)
+{
+    while (width--)
+    {
+        BYTE blue = src[0];
+        dst[1] = src[1];
+        dst[0] = src[2];
+        dst[2] = blue;
+        src += 4;
+        dst += 3;
+    }
+}
+
+struct pixelformatconversion {
+    enum pixelformat src_format, dst_format;
+    UINT src_bpp, dst_bpp; /* bytes per pixel */
+    void (*convert_row)(const BYTE *src, BYTE *dst, UINT width);
+};
+
+static const struct pixelformatconversion direct_conversions[] = {
+    {format_24bppBGR, format_32bppBGR, 3, 4, convert_row_24bppBGR_to_32bppBGRA},
+    {format_24bppBGR, format_32bppBGRA, 3, 4, convert_row_24bppBGR_to_32bppBGRA},
+    {format_24bppBGR, format_32bppPBGRA, 3, 4, convert_row_24bppBGR_to_32bppBGRA},
+    {format_24bppRGB, format_32bppBGR, 3, 4, convert_row_24bppRGB_to_32bppBGRA},
+    {format_24bppRGB, format_32bppBGRA, 3, 4, convert_row_24bppRGB_to_32bppBGRA},
+    {format_24bppRGB, format_32bppPBGRA, 3, 4, convert_row_24bppRGB_to_32bppBGRA},
+    {format_8bppGray, format_32bppBGR, 1, 4, convert_row_8bppGray_to_32bppBGRA},
+    {format_8bppGray, format_32bppBGRA, 1, 4, convert_row_8bppGray_to_32bppBGRA},
+    {format_8bppGray, format_32bppPBGRA, 1, 4, convert_row_8bppGray_to_32bppBGRA},
+    {format_8bppGray, format_24bppBGR, 1, 3, convert_row_8bppGray_to_24bppBGR},
+    {format_8bppGray, format_24bppRGB, 1, 3, convert_row_8bppGray_to_24bppBGR},
+    {format_32bppBGR, format_32bppPBGRA, 4, 4, convert_row_32bppBGR_to_32bppBGRA},
+    {format_32bppBGRA, format_32bppPBGRA, 4, 4, convert_row_32bppBGRA_to_32bppPBGRA},
+    {format_32bppBGR, format_24bppBGR, 4, 3, convert_row_32bppBGRA_to_24bppBGR},
+    {format_32bppBGRA, format_24bppBGR, 4, 3, convert_row_32bppBGRA_to_24bppBGR},
+    {format_32bppPBGRA, format_24bppBGR, 4, 3, convert_row_32bppBGRA_to_24bppBGR},
+    {format_32bppBGR, format_24bppRGB, 4, 3, convert_row_32bppBGRA_to_24bppRGB},
+    {format_32bppBGRA, format_24bppRGB, 4, 3, convert_row_32bppBGRA_to_24bppRGB},
+    {format_32bppPBGRA, format_24bppRGB, 4, 3, convert_row_32bppBGRA_to_24bppRGB},
+    {0}
+};
+
+static const struct pixelformatconversion *get_conversion(enum pixelformat src_format,
+    enum pixelformat dst_format)
+{
+    UINT i;
+
+    for (i=0; direct_conversions[i].convert_row; i++)
+        if (direct_conversions[i].src_format == src_format &&
+            direct_conversions[i].dst_format == dst_format)
+            return &direct_conversions[i];
+
+    return NULL;
+}
+
+/* maximum size of the source rows buffered when the destination pixels are narrower */
+#define CONVERT_STRIP_SIZE 0x10000
+
+static HRESULT copypixels_direct(struct FormatConverter *This, const WICRect *prc,
+    UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+{
+    const struct pixelformatconversion *conversion = This->conversion;
+    UINT srcstride, dststride, strip_height, y, i;
+    BYTE *srcdata;
+    HRESULT hr;
+
+    if (prc->Width <= 0 || prc->Height <= 0) return S_OK;
+
+    srcstride = conversion->src_bpp * prc->Width;
+    dststride = conversion->dst_bpp * prc->Width;
+
+    if (cbStride < dststride || cbStride * (prc->Height-1) + dststride > cbBufferSize)
+        return E_INVALIDARG;
+
+    if (srcstride <= cbStride)
+    {
+        /* The source rows fit in the destination rows, so convert in place. */
+        hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+        if (FAILED(hr)) return hr;
+
+        for (y=0; y<prc->Height; y++)
+            conversion->convert_row(pbBuffer + cbStride * y, pbBuffer + cbStride * y, prc->Width);
+
+        return S_OK;
+    }
+
+    strip_height = max(1, min(prc->Height, CONVERT_STRIP_SIZE / srcstride));
+
+    srcdata = HeapAlloc(GetProcessHeap(), 0, srcstride * strip_height);
+    if (!srcdata) return E_OUTOFMEMORY;
+
+    hr = S_OK;
+    for (y=0; y<prc->Height && SUCCEEDED(hr); y+=strip_height)
+    {
+        WICRect rc;
+
+        rc.X = prc->X;
+        rc.Y = prc->Y + y;
+        rc.Width = prc->Width;
+        rc.Height = min(strip_height, prc->Height - y);
+
+        hr = IWICBitmapSource_CopyPixels(This->source, &rc, srcstride, srcstride * rc.Height, srcdata);
+        if (SUCCEEDED(hr))
+        {
+            for (i=0; i<rc.Height; i++)
+                conversion->convert_row(srcdata + srcstride * i, pbBuffer + cbStride * (y + i), prc->Width);
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, srcdata);
+
+    return hr;
+}
+
 static const struct pixelformatinfo supported_formats[] = {
     {format_1bppIndexed, &GUID_WICPixelFormat1bppIndexed, NULL},
     {format_2bppIndexed, &GUID_WICPixelFormat2bppIndexed, NULL},
@@ -1150,6 +1438,9 @@ static HRESULT WINAPI FormatConverter_CopyPixels(IWICFormatConverter *iface,
             prc = &rc;
         }
 
+        if (This->conversion)
+            return copypixels_direct(This, prc, cbStride, cbBufferSize, pbBuffer);
+
         return This->dst_format->copy_function(This, prc, cbStride, cbBufferSize,
             pbBuffer, This->src_format->format);
     }
@@ -1204,6 +1495,7 @@ static HRESULT WINAPI FormatConverter_Initialize(IWICFormatConverter *iface,
         IWICBitmapSource_AddRef(pISource);
         This->src_format = srcinfo;
         This->dst_format = dstinfo;
+        This->conversion = get_conversion(srcinfo->format, dstinfo->format);
         This->dither = dither;
         This->alpha_threshold = alphaThresholdPercent;
         This->palette_type = paletteTranslate;
@@ -1286,6 +1578,7 @@ HRESULT FormatConverter_CreateInstance(REFIID iid, void** ppv)
     This->IWICFormatConverter_iface.lpVtbl = &FormatConverter_Vtbl;
     This->ref = 1;
     This->source = NULL;
+    This->conversion = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": FormatConverter.lock");
 
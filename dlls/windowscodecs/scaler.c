@@ -19,6 +19,7 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -33,6 +34,18 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+/* Filter weights are fixed point numbers with this many fractional bits. */
+#define WEIGHT_BITS 14
+
+/* Source pixels first..first+count-1 contribute to a destination row or
+ * column, with the weights stored at offset in the weight table. */
+struct scaler_taps
+{
+    UINT first;
+    UINT count;
+    UINT offset;
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -43,6 +56,16 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    /* filtered scaling, used when x_taps is set */
+    UINT channels; /* one byte per channel */
+    INT alpha_channel; /* -1 if there is no alpha */
+    BOOL premultiplied;
+    struct scaler_taps *x_taps, *y_taps;
+    SHORT *x_weights, *y_weights;
+    UINT ring_size; /* number of horizontally scaled source rows kept */
+    INT *ring;
+    UINT *ring_rows; /* source row in each slot of the ring, ~0u if empty */
+    BYTE *src_bits;
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -97,6 +120,13 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        HeapFree(GetProcessHeap(), 0, This->x_taps);
+        HeapFree(GetProcessHeap(), 0, This->y_taps);
+        HeapFree(GetProcessHeap(), 0, This->x_weights);
+        HeapFree(GetProcessHeap(), 0, This->y_weights);
+        HeapFree(GetProcessHeap(), 0, This->ring);
+        HeapFree(GetProcessHeap(), 0, This->ring_rows);
+        HeapFree(GetProcessHeap(), 0, This->src_bits);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -191,6 +221,392 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+static double filter_weight(WICBitmapInterpolationMode mode, double x)
+{
+    x = fabs(x);
+
+    if (mode == WICBitmapInterpolationModeCubic)
+    {
+        /* cubic convolution with a = -0.5 */
+        if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+        if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+        return 0.0;
+    }
+
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+/* Computes the taps for scaling src_size pixels to dst_size pixels along
+ * one axis. Fant averages the source pixels covered by each destination
+ * pixel, the other modes sample a linear or cubic filter at the pixel
+ * center. Taps outside the image are folded into the edge pixels. */
+static HRESULT get_scaler_taps(WICBitmapInterpolationMode mode, UINT src_size, UINT dst_size,
+    struct scaler_taps **taps, SHORT **weights, UINT *max_taps)
+{
+    double step = (double)src_size / dst_size, radius;
+    double *values;
+    UINT i, j, size;
+
+    if (mode == WICBitmapInterpolationModeFant)
+        radius = max(step, 1.0) / 2.0;
+    else
+        radius = mode == WICBitmapInterpolationModeCubic ? 2.0 : 1.0;
+
+    size = min((UINT)ceil(radius * 2.0) + 1, src_size);
+
+    *taps = HeapAlloc(GetProcessHeap(), 0, sizeof(**taps) * dst_size);
+    *weights = HeapAlloc(GetProcessHeap(), 0, sizeof(**weights) * dst_size * size);
+    values = HeapAlloc(GetProcessHeap(), 0, sizeof(*values) * size);
+    if (!*taps || !*weights || !values)
+    {
+        HeapFree(GetProcessHeap(), 0, *taps);
+        HeapFree(GetProcessHeap(), 0, *weights);
+        HeapFree(GetProcessHeap(), 0, values);
+        *taps = NULL;
+        *weights = NULL;
+        return E_OUTOFMEMORY;
+    }
+
+    *max_taps = 1;
+
+    for (i = 0; i < dst_size; i++)
+    {
+        SHORT *weight = *weights + i * size;
+        double center = (i + 0.5) * step, total = 0.0;
+        INT first, last, pos;
+        INT sum = 0, largest = 0;
+
+        if (mode == WICBitmapInterpolationModeFant)
+        {
+            first = floor(center - radius);
+            last = ceil(center + radius) - 1;
+        }
+        else
+        {
+            first = ceil(center - 0.5 - radius);
+            last = floor(center - 0.5 + radius);
+        }
+        if (first < 0) first = 0;
+        if (first > src_size - 1) first = src_size - 1;
+        if (last > (INT)src_size - 1) last = src_size - 1;
+        if (last < first) last = first;
+        if (last - first + 1 > size) last = first + size - 1;
+
+        (*taps)[i].first = first;
+        (*taps)[i].count = last - first + 1;
+        (*taps)[i].offset = i * size;
+        *max_taps = max(*max_taps, (*taps)[i].count);
+
+        memset(values, 0, sizeof(*values) * size);
+
+        if (mode == WICBitmapInterpolationModeFant)
+        {
+            for (pos = first; pos <= last; pos++)
+            {
+                double left = max(pos, center - radius), right = min(pos + 1, center + radius);
+                if (right > left) values[pos - first] = right - left;
+                total += values[pos - first];
+            }
+        }
+        else
+        {
+            for (pos = ceil(center - 0.5 - radius); pos <= floor(center - 0.5 + radius); pos++)
+            {
+                INT index = min(max(pos, first), last) - first;
+                double value = filter_weight(mode, pos - (center - 0.5));
+                values[index] += value;
+                total += value;
+            }
+        }
+
+        if (total == 0.0)
+            values[0] = total = 1.0;
+
+        for (j = 0; j < (*taps)[i].count; j++)
+        {
+            weight[j] = floor(values[j] / total * (1 << WEIGHT_BITS) + 0.5);
+            sum += weight[j];
+            if (weight[j] > weight[largest]) largest = j;
+        }
+        weight[largest] += (1 << WEIGHT_BITS) - sum;
+    }
+
+    HeapFree(GetProcessHeap(), 0, values);
+    return S_OK;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+
+/*
+ * SSE2 is part of x86-64, so the horizontal pass for four channel formats
+ * can use it without checking the processor. pmaddwd multiplies the
+ * channels of two neighbouring pixels by their weights and adds the
+ * products, so the sums are the same as in the C loop.
+ */
+#define HAVE_SSE2_SCALER
+
+static void sse2_scale_row_4(const struct scaler_taps *taps, const SHORT *weights, UINT width,
+    const BYTE *src, INT *dst)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, dst += 4)
+    {
+        const BYTE *pixel = src + taps[x].first * 4;
+        const SHORT *weight = weights + taps[x].offset;
+        ULONG_PTR pairs = taps[x].count / 2;
+
+        __asm__ __volatile__(
+            "pxor %%xmm3, %%xmm3\n\t"
+            "movd %[round], %%xmm0\n\t"
+            "pshufd $0, %%xmm0, %%xmm0\n\t"
+            "test %[pairs], %[pairs]\n\t"
+            "jz 2f\n"
+            "1:\n\t"
+            /* interleave the channels of two pixels, p0c0 p1c0 p0c1 p1c1 ... */
+            "movq (%[pixel]), %%xmm1\n\t"
+            "punpcklbw %%xmm3, %%xmm1\n\t"
+            "pshufd $0xd8, %%xmm1, %%xmm1\n\t"
+            "pshuflw $0xd8, %%xmm1, %%xmm1\n\t"
+            "pshufhw $0xd8, %%xmm1, %%xmm1\n\t"
+            "movd (%[weight]), %%xmm2\n\t"
+            "pshufd $0, %%xmm2, %%xmm2\n\t"
+            "pmaddwd %%xmm2, %%xmm1\n\t"
+            "paddd %%xmm1, %%xmm0\n\t"
+            "add $8, %[pixel]\n\t"
+            "add $4, %[weight]\n\t"
+            "dec %[pairs]\n\t"
+            "jnz 1b\n"
+            "2:\n\t"
+            "test $1, %[count]\n\t"
+            "jz 3f\n\t"
+            /* odd number of taps, the last pixel is paired with a zero weight */
+            "movd (%[pixel]), %%xmm1\n\t"
+            "punpcklbw %%xmm3, %%xmm1\n\t"
+            "punpcklwd %%xmm3, %%xmm1\n\t"
+            "pinsrw $0, (%[weight]), %%xmm3\n\t"
+            "pshufd $0, %%xmm3, %%xmm2\n\t"
+            "pmaddwd %%xmm2, %%xmm1\n\t"
+            "paddd %%xmm1, %%xmm0\n"
+            "3:\n\t"
+            "psrad $%c[shift], %%xmm0\n\t"
+            "movdqu %%xmm0, (%[dst])"
+            : [pixel] "+r" (pixel), [weight] "+r" (weight), [pairs] "+r" (pairs)
+            : [count] "r" (taps[x].count), [dst] "r" (dst),
+              [round] "r" (1 << (WEIGHT_BITS - 7)), [shift] "i" (WEIGHT_BITS - 6)
+            : "xmm0", "xmm1", "xmm2", "xmm3", "memory", "cc");
+    }
+}
+
+#endif
+
+/* Scales one source row horizontally, the result keeps 6 fractional bits. */
+static void Filtered_ScaleRow(BitmapScaler *This, BYTE *src, INT *dst)
+{
+    UINT x, i, c, channels = This->channels;
+
+    if (This->alpha_channel >= 0 && !This->premultiplied)
+    {
+        for (x = 0; x < This->src_width; x++)
+        {
+            BYTE *pixel = src + x * channels, alpha = pixel[This->alpha_channel];
+
+            if (alpha == 0xff) continue;
+            for (c = 0; c < channels; c++)
+                if (c != This->alpha_channel)
+                    pixel[c] = (pixel[c] * alpha + 127) / 255;
+        }
+    }
+
+#ifdef HAVE_SSE2_SCALER
+    if (channels == 4)
+    {
+        sse2_scale_row_4(This->x_taps, This->x_weights, This->width, src, dst);
+        return;
+    }
+#endif
+
+    for (x = 0; x < This->width; x++, dst += channels)
+    {
+        const struct scaler_taps *tap = &This->x_taps[x];
+        const SHORT *weight = This->x_weights + tap->offset;
+        const BYTE *pixel = src + tap->first * channels;
+
+        for (c = 0; c < channels; c++)
+        {
+            INT sum = 1 << (WEIGHT_BITS - 7);
+
+            for (i = 0; i < tap->count; i++)
+                sum += weight[i] * pixel[i * channels + c];
+            dst[c] = sum >> (WEIGHT_BITS - 6);
+        }
+    }
+}
+
+/* Makes sure the ring holds the given source rows. Missing rows are read
+ * from the source with one CopyPixels call per run of rows. */
+static HRESULT Filtered_GetSourceRows(BitmapScaler *This, UINT first, UINT count)
+{
+    UINT src_stride = This->src_width * This->channels;
+    UINT row_size = This->width * This->channels;
+    UINT y = first, end, i;
+    WICRect rect;
+    HRESULT hr;
+
+    while (y < first + count)
+    {
+        if (This->ring_rows[y % This->ring_size] == y)
+        {
+            y++;
+            continue;
+        }
+
+        for (end = y + 1; end < first + count; end++)
+            if (This->ring_rows[end % This->ring_size] == end) break;
+
+        rect.X = 0;
+        rect.Y = y;
+        rect.Width = This->src_width;
+        rect.Height = end - y;
+
+        hr = IWICBitmapSource_CopyPixels(This->source, &rect, src_stride,
+            src_stride * rect.Height, This->src_bits);
+        if (FAILED(hr))
+            return hr;
+
+        for (i = 0; i < rect.Height; i++)
+        {
+            UINT slot = (y + i) % This->ring_size;
+
+            Filtered_ScaleRow(This, This->src_bits + i * src_stride, This->ring + slot * row_size);
+            This->ring_rows[slot] = y + i;
+        }
+
+        y = end;
+    }
+
+    return S_OK;
+}
+
+static HRESULT Filtered_CopyPixels(BitmapScaler *This, const WICRect *dest_rect,
+    UINT cbStride, BYTE *pbBuffer)
+{
+    UINT row_size = This->width * This->channels, channels = This->channels;
+    INT x, y, i, c;
+    HRESULT hr;
+
+    for (y = 0; y < dest_rect->Height; y++)
+    {
+        const struct scaler_taps *tap = &This->y_taps[dest_rect->Y + y];
+        const SHORT *weight = This->y_weights + tap->offset;
+        BYTE *dst = pbBuffer + cbStride * y;
+
+        hr = Filtered_GetSourceRows(This, tap->first, tap->count);
+        if (FAILED(hr))
+            return hr;
+
+        for (x = 0; x < dest_rect->Width; x++, dst += channels)
+        {
+            UINT offset = (dest_rect->X + x) * channels;
+            INT alpha = 0xff;
+
+            for (c = 0; c < channels; c++)
+            {
+                INT sum = 1 << (WEIGHT_BITS + 5);
+
+                for (i = 0; i < tap->count; i++)
+                    sum += weight[i] * This->ring[((tap->first + i) % This->ring_size) * row_size + offset + c];
+                sum >>= WEIGHT_BITS + 6;
+                dst[c] = sum < 0 ? 0 : sum > 0xff ? 0xff : sum;
+            }
+
+            if (This->alpha_channel < 0)
+                continue;
+
+            alpha = dst[This->alpha_channel];
+            for (c = 0; c < channels; c++)
+            {
+                if (c == This->alpha_channel) continue;
+                if (dst[c] > alpha) dst[c] = alpha;
+                if (!This->premultiplied && alpha && alpha != 0xff)
+                    dst[c] = (dst[c] * 0xff + alpha / 2) / alpha;
+            }
+        }
+    }
+
+    return S_OK;
+}
+
+/* Sets up filtered scaling for formats with one byte per channel. */
+static HRESULT Filtered_Initialize(BitmapScaler *This, const WICPixelFormatGUID *format)
+{
+    static const struct
+    {
+        const WICPixelFormatGUID *format;
+        UINT channels;
+        INT alpha_channel;
+        BOOL premultiplied;
+    } formats[] =
+    {
+        { &GUID_WICPixelFormat8bppGray, 1, -1, FALSE },
+        { &GUID_WICPixelFormat24bppBGR, 3, -1, FALSE },
+        { &GUID_WICPixelFormat24bppRGB, 3, -1, FALSE },
+        { &GUID_WICPixelFormat32bppBGR, 4, -1, FALSE },
+        { &GUID_WICPixelFormat32bppBGRA, 4, 3, FALSE },
+        { &GUID_WICPixelFormat32bppPBGRA, 4, 3, TRUE },
+    };
+    UINT i, max_x_taps;
+    HRESULT hr;
+
+    for (i = 0; i < sizeof(formats)/sizeof(formats[0]); i++)
+        if (IsEqualGUID(formats[i].format, format)) break;
+
+    if (i == sizeof(formats)/sizeof(formats[0]) || !This->width || !This->height ||
+        !This->src_width || !This->src_height)
+        return E_NOTIMPL;
+
+    This->channels = formats[i].channels;
+    This->alpha_channel = formats[i].alpha_channel;
+    This->premultiplied = formats[i].premultiplied;
+
+    hr = get_scaler_taps(This->mode, This->src_width, This->width,
+        &This->x_taps, &This->x_weights, &max_x_taps);
+    if (SUCCEEDED(hr))
+        hr = get_scaler_taps(This->mode, This->src_height, This->height,
+            &This->y_taps, &This->y_weights, &This->ring_size);
+
+    if (SUCCEEDED(hr))
+    {
+        This->ring = HeapAlloc(GetProcessHeap(), 0,
+            sizeof(*This->ring) * This->ring_size * This->width * This->channels);
+        This->ring_rows = HeapAlloc(GetProcessHeap(), 0, sizeof(*This->ring_rows) * This->ring_size);
+        This->src_bits = HeapAlloc(GetProcessHeap(), 0,
+            This->ring_size * This->src_width * This->channels);
+        if (!This->ring || !This->ring_rows || !This->src_bits)
+            hr = E_OUTOFMEMORY;
+        else
+            memset(This->ring_rows, 0xff, sizeof(*This->ring_rows) * This->ring_size);
+    }
+
+    if (FAILED(hr))
+    {
+        HeapFree(GetProcessHeap(), 0, This->x_taps);
+        HeapFree(GetProcessHeap(), 0, This->y_taps);
+        HeapFree(GetProcessHeap(), 0, This->x_weights);
+        HeapFree(GetProcessHeap(), 0, This->y_weights);
+        HeapFree(GetProcessHeap(), 0, This->ring);
+        HeapFree(GetProcessHeap(), 0, This->ring_rows);
+        HeapFree(GetProcessHeap(), 0, This->src_bits);
+        This->x_taps = This->y_taps = NULL;
+        This->x_weights = This->y_weights = NULL;
+        This->ring = NULL;
+        This->ring_rows = NULL;
+        This->src_bits = NULL;
+    }
+
+    return hr;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -245,6 +661,12 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if (This->x_taps)
+    {
+        hr = Filtered_CopyPixels(This, &dest_rect, cbStride, pbBuffer);
+        goto end;
+    }
+
     /* MSDN recommends calling CopyPixels once for each scanline from top to
      * bottom, and claims codecs optimize for this. Ideally, when called in this
      * way, we should avoid requesting a scanline from the source more than
@@ -336,10 +758,22 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+            if (Filtered_Initialize(This, &src_pixelformat) == S_OK)
+            {
+                IWICBitmapSource_AddRef(pISource);
+                This->source = pISource;
+                break;
+            }
+            FIXME("mode %i not supported for format %s\n", mode, debugstr_guid(&src_pixelformat));
+            goto nearest_neighbor;
         default:
             FIXME("unsupported mode %i\n", mode);
             /* fall-through */
         case WICBitmapInterpolationModeNearestNeighbor:
+        nearest_neighbor:
             if ((This->bpp % 8) == 0)
             {
                 IWICBitmapSource_AddRef(pISource);
@@ -391,6 +825,11 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    This->x_taps = This->y_taps = NULL;
+    This->x_weights = This->y_weights = NULL;
+    This->ring = NULL;
+    This->ring_rows = NULL;
+    This->src_bits = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
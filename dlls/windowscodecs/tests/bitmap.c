@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <math.h>
+#include <stdlib.h>
 
 #define COBJMACROS
 #define CONST_VTABLE
@@ -977,6 +978,50 @@ static void test_clipper(void)
     IWICBitmapClipper_Release(clipper);
 }
 
+static void test_scaler(void)
+{
+    static const BYTE src_data[24] = {
+        10,20,30, 30,40,50, 100,100,100, 200,200,200,
+        50,60,70, 70,80,90, 100,100,100, 100,100,100 };
+    static const BYTE expected[6] = { 40,50,60, 125,125,125 };
+    BYTE data[6];
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    WICPixelFormatGUID format;
+    UINT width, height, i;
+    HRESULT hr;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4, 2, &GUID_WICPixelFormat24bppBGR,
+                                                   12, sizeof(src_data), (BYTE *)src_data, &bitmap);
+    ok(hr == S_OK, "IWICImagingFactory_CreateBitmapFromMemory error %#x\n", hr);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "IWICImagingFactory_CreateBitmapScaler error %#x\n", hr);
+
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 2, 1,
+                                     WICBitmapInterpolationModeFant);
+    ok(hr == S_OK, "IWICBitmapScaler_Initialize error %#x\n", hr);
+
+    hr = IWICBitmapScaler_GetSize(scaler, &width, &height);
+    ok(hr == S_OK, "IWICBitmapScaler_GetSize error %#x\n", hr);
+    ok(width == 2, "expected 2, got %u\n", width);
+    ok(height == 1, "expected 1, got %u\n", height);
+
+    hr = IWICBitmapScaler_GetPixelFormat(scaler, &format);
+    ok(hr == S_OK, "IWICBitmapScaler_GetPixelFormat error %#x\n", hr);
+    ok(IsEqualGUID(&format, &GUID_WICPixelFormat24bppBGR), "unexpected pixel format %s\n",
+       wine_dbgstr_guid(&format));
+
+    memset(data, 0, sizeof(data));
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 6, sizeof(data), data);
+    ok(hr == S_OK, "IWICBitmapScaler_CopyPixels error %#x\n", hr);
+    for (i = 0; i < sizeof(data); i++)
+        ok(abs(data[i] - expected[i]) <= 1, "%u: expected %u, got %u\n", i, expected[i], data[i]);
+
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmap_Release(bitmap);
+}
+
 START_TEST(bitmap)
 {
     HRESULT hr;
@@ -993,6 +1038,7 @@ START_TEST(bitmap)
     test_CreateBitmapFromHICON();
     test_CreateBitmapFromHBITMAP();
     test_clipper();
+    test_scaler();
 
     IWICImagingFactory_Release(factory);
 
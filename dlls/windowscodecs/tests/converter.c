@@ -271,6 +271,24 @@ static void compare_bitmap_data(const struct bitmap_data *expect, IWICBitmapSour
     HeapFree(GetProcessHeap(), 0, converted_bits);
 }
 
+static const BYTE bits_8bppGray[] = {
+    0,128,255,64,
+    32,96,160,224};
+static const struct bitmap_data testdata_8bppGray = {
+    &GUID_WICPixelFormat8bppGray, 8, bits_8bppGray, 4, 2, 96.0, 96.0};
+
+static const BYTE bits_gray_24bppBGR[] = {
+    0,0,0, 128,128,128, 255,255,255, 64,64,64,
+    32,32,32, 96,96,96, 160,160,160, 224,224,224};
+static const struct bitmap_data testdata_gray_24bppBGR = {
+    &GUID_WICPixelFormat24bppBGR, 24, bits_gray_24bppBGR, 4, 2, 96.0, 96.0};
+
+static const BYTE bits_gray_32bppBGRA[] = {
+    0,0,0,255, 128,128,128,255, 255,255,255,255, 64,64,64,255,
+    32,32,32,255, 96,96,96,255, 160,160,160,255, 224,224,224,255};
+static const struct bitmap_data testdata_gray_32bppBGRA = {
+    &GUID_WICPixelFormat32bppBGRA, 32, bits_gray_32bppBGRA, 4, 2, 96.0, 96.0};
+
 static const BYTE bits_24bppBGR[] = {
     255,0,0, 0,255,0, 0,0,255, 0,0,0,
     0,255,255, 255,0,255, 255,255,0, 255,255,255};
@@ -659,6 +677,11 @@ START_TEST(converter)
 
     test_conversion(&testdata_32bppBGR, &testdata_24bppRGB, "32bppBGR -> 24bppRGB", FALSE);
     test_conversion(&testdata_24bppRGB, &testdata_32bppBGR, "24bppRGB -> 32bppBGR", FALSE);
+    test_conversion(&testdata_24bppBGR, &testdata_32bppBGRA, "24bppBGR -> 32bppBGRA", FALSE);
+    test_conversion(&testdata_32bppBGRA, &testdata_24bppBGR, "32bppBGRA -> 24bppBGR", FALSE);
+
+    test_conversion(&testdata_8bppGray, &testdata_gray_32bppBGRA, "8bppGray -> 32bppBGRA", FALSE);
+    test_conversion(&testdata_8bppGray, &testdata_gray_24bppBGR, "8bppGray -> 24bppBGR", FALSE);
 
     test_invalid_conversion();
     test_default_converter();
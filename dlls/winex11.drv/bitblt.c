@@ -1556,13 +1556,25 @@ DWORD get_pixmap_image( Pixmap pixmap, int width, int height, const XVisualInfo
 }
 
 
+/* the damage of window surfaces is tracked in tiles of 32x32 pixels */
+#define SURFACE_TILE_SHIFT 5
+#define SURFACE_TILE_SIZE  (1 << SURFACE_TILE_SHIFT)
+
+/* estimated cost of an extra PutImage request, in pixels */
+#define SURFACE_RECT_COST  (4 * SURFACE_TILE_SIZE * SURFACE_TILE_SIZE)
+
 struct x11drv_window_surface
 {
     struct window_surface header;
     Window                window;
     GC                    gc;
     XImage               *image;
-    RECT                  bounds;
+    RECT                  bounds;      /* damage reported since the surface was last locked or unlocked */
+    RECT                  dirty;       /* bounding rectangle of the damage not yet flushed */
+    BYTE                 *dirty_tiles; /* damaged tiles, tiles_x per row */
+    int                   tiles_x;
+    int                   tiles_y;
+    int                   lock_count;
     BOOL                  byteswap;
     BOOL                  is_argb;
     COLORREF              color_key;
@@ -1810,6 +1822,141 @@ failed:
 }
 #endif /* HAVE_LIBXXSHM */
 
+/***********************************************************************
+ *           add_surface_damage
+ *
+ * Move the damage accumulated in the surface bounds to the dirty tiles.
+ * Called with the surface lock held.
+ */
+static void add_surface_damage( struct x11drv_window_surface *surface )
+{
+    RECT rect;
+    int y, left, right, bottom;
+
+    SetRect( &rect, 0, 0, surface->header.rect.right - surface->header.rect.left,
+             surface->header.rect.bottom - surface->header.rect.top );
+    if (IntersectRect( &rect, &rect, &surface->bounds ))
+    {
+        add_bounds_rect( &surface->dirty, &rect );
+        if (surface->dirty_tiles)
+        {
+            left   = rect.left >> SURFACE_TILE_SHIFT;
+            right  = (rect.right - 1) >> SURFACE_TILE_SHIFT;
+            bottom = (rect.bottom - 1) >> SURFACE_TILE_SHIFT;
+            for (y = rect.top >> SURFACE_TILE_SHIFT; y <= bottom; y++)
+                memset( surface->dirty_tiles + y * surface->tiles_x + left, 1, right - left + 1 );
+        }
+    }
+    reset_bounds( &surface->bounds );
+}
+
+/***********************************************************************
+ *           get_dirty_rects
+ *
+ * Merge the dirty tiles into rectangles clipped to the visible rectangle,
+ * joining runs of tiles horizontally and then vertically.
+ * Returns the number of rectangles, or -1 on failure.
+ */
+static int get_dirty_rects( struct x11drv_window_surface *surface, const RECT *visrect, RECT **ret )
+{
+    int left   = visrect->left >> SURFACE_TILE_SHIFT;
+    int top    = visrect->top >> SURFACE_TILE_SHIFT;
+    int right  = ((visrect->right - 1) >> SURFACE_TILE_SHIFT) + 1;
+    int bottom = ((visrect->bottom - 1) >> SURFACE_TILE_SHIFT) + 1;
+    int x, y, start, i, count = 0;
+    RECT *rects;
+    int *open;
+
+    if (!surface->dirty_tiles) return -1;
+
+    /* each row of tiles has at most one run every other tile */
+    rects = HeapAlloc( GetProcessHeap(), 0, (bottom - top) * ((right - left + 1) / 2) * sizeof(*rects) +
+                       surface->tiles_x * sizeof(*open) );
+    if (!rects) return -1;
+    open = (int *)(rects + (bottom - top) * ((right - left + 1) / 2));
+
+    /* open[x] is the last rectangle started at tile column x; it can still
+     * be extended if it ends on the previous row with the same width */
+    for (x = left; x < right; x++) open[x] = -1;
+
+    for (y = top; y < bottom; y++)
+    {
+        const BYTE *row = surface->dirty_tiles + y * surface->tiles_x;
+
+        for (x = left; x < right; )
+        {
+            while (x < right && !row[x]) x++;
+            if (x == right) break;
+            start = x;
+            while (x < right && row[x]) x++;
+
+            i = open[start];
+            if (i != -1 && rects[i].bottom == y && rects[i].right == x)
+                rects[i].bottom = y + 1;
+            else
+            {
+                SetRect( &rects[count], start, y, x, y + 1 );
+                open[start] = count++;
+            }
+        }
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        rects[i].left   <<= SURFACE_TILE_SHIFT;
+        rects[i].top    <<= SURFACE_TILE_SHIFT;
+        rects[i].right  <<= SURFACE_TILE_SHIFT;
+        rects[i].bottom <<= SURFACE_TILE_SHIFT;
+        IntersectRect( &rects[i], &rects[i], visrect );
+    }
+    *ret = rects;
+    return count;
+}
+
+/***********************************************************************
+ *           copy_surface_rows
+ *
+ * Copy rows of the surface bits to the image, converting the pixels if needed.
+ */
+static void copy_surface_rows( struct x11drv_window_surface *surface, int top, int bottom )
+{
+    unsigned char *src = surface->bits;
+    unsigned char *dst = (unsigned char *)surface->image->data;
+    const int *mapping = NULL;
+    int width_bytes = surface->image->bytes_per_line;
+
+    if (src == dst || top >= bottom) return;
+
+    if (surface->image->bits_per_pixel == 4 || surface->image->bits_per_pixel == 8)
+        mapping = X11DRV_PALETTE_PaletteToXPixel;
+
+    src += top * width_bytes;
+    dst += top * width_bytes;
+    copy_image_byteswap( &surface->info, src, dst, width_bytes, width_bytes,
+                         bottom - top, surface->byteswap, mapping, ~0u );
+}
+
+/***********************************************************************
+ *           put_surface_rect
+ */
+static void put_surface_rect( struct x11drv_window_surface *surface, const RECT *rect )
+{
+#ifdef HAVE_LIBXXSHM
+    if (surface->shminfo.shmid != -1)
+        XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
+                      rect->left, rect->top,
+                      surface->header.rect.left + rect->left,
+                      surface->header.rect.top + rect->top,
+                      rect->right - rect->left, rect->bottom - rect->top, False );
+    else
+#endif
+    XPutImage( gdi_display, surface->window, surface->gc, surface->image,
+               rect->left, rect->top,
+               surface->header.rect.left + rect->left,
+               surface->header.rect.top + rect->top,
+               rect->right - rect->left, rect->bottom - rect->top );
+}
+
 /***********************************************************************
  *           x11drv_surface_lock
  */
@@ -1818,6 +1965,9 @@ static void x11drv_surface_lock( struct window_surface *window_surface )
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
 
     EnterCriticalSection( &surface->crit );
+    /* the bounds are reset on every lock and unlock, so that the damage of
+     * each drawing operation can be recorded on its own */
+    if (!surface->lock_count++) add_surface_damage( surface );
 }
 
 /***********************************************************************
@@ -1827,6 +1977,7 @@ static void x11drv_surface_unlock( struct window_surface *window_surface )
 {
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
 
+    if (!--surface->lock_count) add_surface_damage( surface );
     LeaveCriticalSection( &surface->crit );
 }
 
@@ -1888,57 +2039,50 @@ static void x11drv_surface_set_region( struct window_surface *window_surface, HR
 static void x11drv_surface_flush( struct window_surface *window_surface )
 {
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
-    unsigned char *src = surface->bits;
-    unsigned char *dst = (unsigned char *)surface->image->data;
-    struct bitblt_coords coords;
+    RECT visrect, *rects = NULL;
+    int i, y, width, height, count, area = 0;
 
     window_surface->funcs->lock( window_surface );
-    coords.x = 0;
-    coords.y = 0;
-    coords.width  = surface->header.rect.right - surface->header.rect.left;
-    coords.height = surface->header.rect.bottom - surface->header.rect.top;
-    SetRect( &coords.visrect, 0, 0, coords.width, coords.height );
-    if (IntersectRect( &coords.visrect, &coords.visrect, &surface->bounds ))
+    width  = surface->header.rect.right - surface->header.rect.left;
+    height = surface->header.rect.bottom - surface->header.rect.top;
+    SetRect( &visrect, 0, 0, width, height );
+    if (IntersectRect( &visrect, &visrect, &surface->dirty ))
     {
-        TRACE( "flushing %p %dx%d bounds %s bits %p\n",
-               surface, coords.width, coords.height,
-               wine_dbgstr_rect( &surface->bounds ), surface->bits );
+        TRACE( "flushing %p %dx%d dirty %s bits %p\n",
+               surface, width, height, wine_dbgstr_rect( &surface->dirty ), surface->bits );
 
         if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
 
-        if (src != dst)
-        {
-            const int *mapping = NULL;
-            int width_bytes = surface->image->bytes_per_line;
-
-            if (surface->image->bits_per_pixel == 4 || surface->image->bits_per_pixel == 8)
-                mapping = X11DRV_PALETTE_PaletteToXPixel;
+        count = get_dirty_rects( surface, &visrect, &rects );
+        for (i = 0; i < count; i++)
+            area += (rects[i].right - rects[i].left) * (rects[i].bottom - rects[i].top);
 
-            src += coords.visrect.top * width_bytes;
-            dst += coords.visrect.top * width_bytes;
-            copy_image_byteswap( &surface->info, src, dst, width_bytes, width_bytes,
-                                 coords.visrect.bottom - coords.visrect.top,
-                                 surface->byteswap, mapping, ~0u );
+        /* send the bounding rectangle instead if it isn't much larger */
+        if (count <= 1 || area + count * SURFACE_RECT_COST >=
+            (visrect.right - visrect.left) * (visrect.bottom - visrect.top) + SURFACE_RECT_COST)
+        {
+            TRACE( "sending %s\n", wine_dbgstr_rect( &visrect ));
+            copy_surface_rows( surface, visrect.top, visrect.bottom );
+            put_surface_rect( surface, &visrect );
         }
-
-#ifdef HAVE_LIBXXSHM
-        if (surface->shminfo.shmid != -1)
-            XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                          coords.visrect.left, coords.visrect.top,
-                          surface->header.rect.left + coords.visrect.left,
-                          surface->header.rect.top + coords.visrect.top,
-                          coords.visrect.right - coords.visrect.left,
-                          coords.visrect.bottom - coords.visrect.top, False );
         else
-#endif
-        XPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                   coords.visrect.left, coords.visrect.top,
-                   surface->header.rect.left + coords.visrect.left,
-                   surface->header.rect.top + coords.visrect.top,
-                   coords.visrect.right - coords.visrect.left,
-                   coords.visrect.bottom - coords.visrect.top );
+        {
+            TRACE( "sending %d rects, %d of %d pixels\n", count, area,
+                   (visrect.right - visrect.left) * (visrect.bottom - visrect.top) );
+            for (y = visrect.top >> SURFACE_TILE_SHIFT; y << SURFACE_TILE_SHIFT < visrect.bottom; y++)
+            {
+                const BYTE *row = surface->dirty_tiles + y * surface->tiles_x;
+
+                if (memchr( row, 1, surface->tiles_x ))
+                    copy_surface_rows( surface, max( y << SURFACE_TILE_SHIFT, visrect.top ),
+                                       min( (y + 1) << SURFACE_TILE_SHIFT, visrect.bottom ));
+            }
+            for (i = 0; i < count; i++) put_surface_rect( surface, &rects[i] );
+        }
+        HeapFree( GetProcessHeap(), 0, rects );
     }
-    reset_bounds( &surface->bounds );
+    if (surface->dirty_tiles) memset( surface->dirty_tiles, 0, surface->tiles_x * surface->tiles_y );
+    reset_bounds( &surface->dirty );
     window_surface->funcs->unlock( window_surface );
 }
 
@@ -1969,6 +2113,7 @@ static void x11drv_surface_destroy( struct window_surface *window_surface )
     surface->crit.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection( &surface->crit );
     if (surface->region) DeleteObject( surface->region );
+    HeapFree( GetProcessHeap(), 0, surface->dirty_tiles );
     HeapFree( GetProcessHeap(), 0, surface );
 }
 
@@ -2015,6 +2160,12 @@ struct window_surface *create_surface( Window window, const XVisualInfo *vis, co
     surface->is_argb = (use_alpha && vis->depth == 32 && surface->info.bmiHeader.biCompression == BI_RGB);
     set_color_key( surface, color_key );
     reset_bounds( &surface->bounds );
+    reset_bounds( &surface->dirty );
+
+    /* without the tiles the whole dirty rectangle gets flushed */
+    surface->tiles_x = (width + SURFACE_TILE_SIZE - 1) >> SURFACE_TILE_SHIFT;
+    surface->tiles_y = (height + SURFACE_TILE_SIZE - 1) >> SURFACE_TILE_SHIFT;
+    surface->dirty_tiles = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, surface->tiles_x * surface->tiles_y );
 
 #ifdef HAVE_LIBXXSHM
     surface->image = create_shm_image( vis, width, height, &surface->shminfo );
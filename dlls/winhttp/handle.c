@@ -148,6 +148,7 @@ BOOL free_handle( HINTERNET hinternet )
             TRACE("freeing child handle %p for parent handle 0x%lx\n", child->handle, handle + 1);
             free_handle( child->handle );
         }
+        if (hdr->type == WINHTTP_HANDLE_TYPE_REQUEST) cancel_tasks( (request_t *)hdr );
         release_object( hdr );
     }
 
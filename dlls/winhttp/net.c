@@ -38,6 +38,10 @@
 #ifdef HAVE_POLL_H
 # include <poll.h>
 #endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#include <fcntl.h>
 
 #define NONAMELESSUNION
 
@@ -72,6 +76,57 @@ static CRITICAL_SECTION cs_gethostbyname = { &critsect_debug, -1, 0, 0, 0, 0 };
 
 #endif
 
+/* cache of resolved host names, shared by all sessions */
+#define RESOLVE_CACHE_SIZE 32
+#define RESOLVE_CACHE_TIME 60000
+
+struct resolved_host
+{
+    struct list entry;
+    WCHAR *hostname;
+    INTERNET_PORT port;
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    ULONGLONG expires;
+};
+
+static struct list resolve_cache = LIST_INIT( resolve_cache );
+static unsigned int resolve_cache_count;
+
+static CRITICAL_SECTION resolve_cache_cs;
+static CRITICAL_SECTION_DEBUG resolve_cache_cs_debug =
+{
+    0, 0, &resolve_cache_cs,
+    { &resolve_cache_cs_debug.ProcessLocksList, &resolve_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": resolve_cache_cs") }
+};
+static CRITICAL_SECTION resolve_cache_cs = { &resolve_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+/* sockets of async requests waiting for data, watched by a single thread */
+struct socket_wait
+{
+    struct list entry;
+    int socket;         /* -1 for a plain timer */
+    unsigned int index; /* position in the poll array, 0 if not polled yet */
+    ULONGLONG deadline; /* 0 if the wait doesn't time out */
+    DWORD status;
+    void (*callback)( void *, DWORD );
+    void *ctx;
+};
+
+static struct list socket_waits = LIST_INIT( socket_waits );
+static BOOL poll_thread_running;
+static int wake_pipe[2] = { -1, -1 };
+
+static CRITICAL_SECTION poll_cs;
+static CRITICAL_SECTION_DEBUG poll_cs_debug =
+{
+    0, 0, &poll_cs,
+    { &poll_cs_debug.ProcessLocksList, &poll_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": poll_cs") }
+};
+static CRITICAL_SECTION poll_cs = { &poll_cs_debug, -1, 0, 0, 0, 0 };
+
 /* translate a unix error code into a winsock error code */
 static int sock_get_error( int err )
 {
@@ -276,9 +331,23 @@ BOOL netconn_init( netconn_t *conn )
 
 void netconn_unload( void )
 {
+    struct resolved_host *host, *next;
+
     if(cred_handle_initialized)
         FreeCredentialsHandle(&cred_handle);
     DeleteCriticalSection(&init_sechandle_cs);
+    LIST_FOR_EACH_ENTRY_SAFE( host, next, &resolve_cache, struct resolved_host, entry )
+    {
+        heap_free( host->hostname );
+        heap_free( host );
+    }
+    DeleteCriticalSection( &resolve_cache_cs );
+    if (wake_pipe[0] != -1)
+    {
+        close( wake_pipe[0] );
+        close( wake_pipe[1] );
+    }
+    DeleteCriticalSection( &poll_cs );
 #ifndef HAVE_GETADDRINFO
     DeleteCriticalSection(&cs_gethostbyname);
 #endif
@@ -289,6 +358,192 @@ BOOL netconn_connected( netconn_t *conn )
     return (conn->socket != -1);
 }
 
+/* check that an idle connection hasn't been closed or otherwise spoiled by the server */
+BOOL netconn_is_alive( netconn_t *conn )
+{
+    char b;
+    int len;
+#ifndef MSG_DONTWAIT
+    ULONG state = 1;
+#endif
+
+    if (conn->peek_len || conn->extra_len) return FALSE;
+#ifdef MSG_DONTWAIT
+    len = recv( conn->socket, &b, 1, MSG_PEEK | MSG_DONTWAIT );
+#else
+    if (ioctlsocket( conn->socket, FIONBIO, &state )) return FALSE;
+    len = recv( conn->socket, &b, 1, MSG_PEEK );
+    state = 0;
+    ioctlsocket( conn->socket, FIONBIO, &state );
+#endif
+    /* nothing should arrive on a connection that is not in use */
+    return len == -1 && sock_get_error( errno ) == WSAEWOULDBLOCK;
+}
+
+/* decrypted or partially received data that a read can use without polling the socket */
+BOOL netconn_data_buffered( netconn_t *conn )
+{
+    return conn->secure && (conn->peek_len || conn->extra_len);
+}
+
+static DWORD CALLBACK poll_proc( LPVOID module )
+{
+    struct socket_wait *wait, *next;
+    struct pollfd *fds = NULL;
+    unsigned int count, size = 0, i;
+    struct list ready;
+    ULONGLONG now;
+    char buf[32];
+    int res, timeout;
+
+    for (;;)
+    {
+        EnterCriticalSection( &poll_cs );
+        count = list_count( &socket_waits );
+        if (count + 1 > size)
+        {
+            size = max( size * 2, count + 1 );
+            heap_free( fds );
+            if (!(fds = heap_alloc( size * sizeof(*fds) )))
+            {
+                ERR("out of memory\n");
+                LeaveCriticalSection( &poll_cs );
+                Sleep( 100 );
+                size = 0;
+                continue;
+            }
+        }
+        fds[0].fd     = wake_pipe[0];
+        fds[0].events = POLLIN;
+        i = 1;
+        /* exit after a while without any waiters, the next waiter starts a new thread */
+        timeout = count ? -1 : 30000;
+        now = GetTickCount64();
+        LIST_FOR_EACH_ENTRY( wait, &socket_waits, struct socket_wait, entry )
+        {
+            fds[i].fd     = wait->socket; /* negative descriptors are ignored */
+            fds[i].events = POLLIN;
+            wait->index   = i++;
+            if (!wait->deadline) continue;
+            if (wait->deadline <= now) timeout = 0;
+            else if (timeout == -1 || wait->deadline - now < timeout) timeout = wait->deadline - now;
+        }
+        LeaveCriticalSection( &poll_cs );
+
+        res = poll( fds, count + 1, timeout );
+        if (res < 0 && errno != EINTR) WARN("poll failed (%s)\n", strerror( errno ));
+
+        list_init( &ready );
+        EnterCriticalSection( &poll_cs );
+        if (res > 0 && fds[0].revents)
+            while (read( wake_pipe[0], buf, sizeof(buf) ) > 0);
+        /* waits may have been cancelled or added meanwhile, only look at the current ones */
+        now = GetTickCount64();
+        LIST_FOR_EACH_ENTRY_SAFE( wait, next, &socket_waits, struct socket_wait, entry )
+        {
+            if (res > 0 && wait->index && fds[wait->index].revents) wait->status = ERROR_SUCCESS;
+            else if (wait->deadline && wait->deadline <= now) wait->status = ERROR_WINHTTP_TIMEOUT;
+            else continue;
+            list_remove( &wait->entry );
+            list_add_tail( &ready, &wait->entry );
+        }
+        if (!res && !count && list_empty( &socket_waits ))
+        {
+            poll_thread_running = FALSE;
+            LeaveCriticalSection( &poll_cs );
+            break;
+        }
+        LeaveCriticalSection( &poll_cs );
+
+        LIST_FOR_EACH_ENTRY_SAFE( wait, next, &ready, struct socket_wait, entry )
+        {
+            list_remove( &wait->entry );
+            wait->callback( wait->ctx, wait->status );
+            heap_free( wait );
+        }
+    }
+
+    heap_free( fds );
+    FreeLibraryAndExitThread( module, 0 );
+}
+
+/* call callback from the poll thread once the connection has data to read, or with
+ * ERROR_WINHTTP_TIMEOUT if nothing arrives within timeout milliseconds (0 for no limit);
+ * without a connection only the timeout is waited for */
+BOOL netconn_wait_readable( netconn_t *conn, DWORD timeout, void (*callback)( void *, DWORD ), void *ctx )
+{
+    struct socket_wait *wait;
+    BOOL ret = FALSE;
+
+    if (!(wait = heap_alloc( sizeof(*wait) ))) return FALSE;
+    wait->socket   = conn ? conn->socket : -1;
+    wait->index    = 0;
+    wait->deadline = timeout ? GetTickCount64() + timeout : 0;
+    wait->status   = ERROR_SUCCESS;
+    wait->callback = callback;
+    wait->ctx      = ctx;
+
+    EnterCriticalSection( &poll_cs );
+
+    if (wake_pipe[0] == -1)
+    {
+        if (pipe( wake_pipe ) == -1)
+        {
+            WARN("failed to create pipe (%s)\n", strerror( errno ));
+            wake_pipe[0] = wake_pipe[1] = -1;
+            goto done;
+        }
+        fcntl( wake_pipe[0], F_SETFL, O_NONBLOCK );
+        fcntl( wake_pipe[1], F_SETFL, O_NONBLOCK );
+    }
+    list_add_tail( &socket_waits, &wait->entry );
+
+    if (!poll_thread_running)
+    {
+        HANDLE thread = NULL;
+        HMODULE module;
+
+        /* the poll thread keeps a reference to the dll while it runs */
+        if (GetModuleHandleExW( GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (const WCHAR *)poll_proc, &module ))
+        {
+            if (!(thread = CreateThread( NULL, 0, poll_proc, module, 0, NULL ))) FreeLibrary( module );
+        }
+        if (!thread)
+        {
+            list_remove( &wait->entry );
+            goto done;
+        }
+        CloseHandle( thread );
+        poll_thread_running = TRUE;
+    }
+    else write( wake_pipe[1], "", 1 );
+    ret = TRUE;
+
+done:
+    LeaveCriticalSection( &poll_cs );
+    if (!ret) heap_free( wait );
+    return ret;
+}
+
+/* remove the wait with the given context, its callback won't be called if this succeeds */
+BOOL netconn_cancel_wait( void *ctx )
+{
+    struct socket_wait *wait;
+    BOOL ret = FALSE;
+
+    EnterCriticalSection( &poll_cs );
+    LIST_FOR_EACH_ENTRY( wait, &socket_waits, struct socket_wait, entry )
+    {
+        if (wait->ctx != ctx) continue;
+        list_remove( &wait->entry );
+        heap_free( wait );
+        ret = TRUE;
+        break;
+    }
+    LeaveCriticalSection( &poll_cs );
+    return ret;
+}
+
 BOOL netconn_create( netconn_t *conn, int domain, int type, int protocol )
 {
     if ((conn->socket = socket( domain, type, protocol )) == -1)
@@ -844,10 +1099,90 @@ static DWORD CALLBACK resolve_proc( LPVOID arg )
     return resolve_hostname( ra->hostname, ra->port, ra->sa, ra->sa_len );
 }
 
+static BOOL get_cached_address( const WCHAR *hostname, INTERNET_PORT port, struct sockaddr *sa, socklen_t *sa_len )
+{
+    struct resolved_host *host;
+    ULONGLONG now = GetTickCount64();
+    BOOL ret = FALSE;
+
+    EnterCriticalSection( &resolve_cache_cs );
+    LIST_FOR_EACH_ENTRY( host, &resolve_cache, struct resolved_host, entry )
+    {
+        if (host->port != port || strcmpiW( host->hostname, hostname )) continue;
+        if (host->expires > now && *sa_len >= host->addr_len)
+        {
+            memcpy( sa, &host->addr, host->addr_len );
+            *sa_len = host->addr_len;
+            list_remove( &host->entry );
+            list_add_head( &resolve_cache, &host->entry );
+            ret = TRUE;
+        }
+        break;
+    }
+    LeaveCriticalSection( &resolve_cache_cs );
+    return ret;
+}
+
+static void cache_address( const WCHAR *hostname, INTERNET_PORT port, const struct sockaddr *sa, socklen_t sa_len )
+{
+    struct resolved_host *host;
+    BOOL found = FALSE;
+
+    if (sa_len > sizeof(host->addr)) return;
+
+    EnterCriticalSection( &resolve_cache_cs );
+    LIST_FOR_EACH_ENTRY( host, &resolve_cache, struct resolved_host, entry )
+    {
+        if (host->port == port && !strcmpiW( host->hostname, hostname ))
+        {
+            found = TRUE;
+            break;
+        }
+    }
+    if (!found)
+    {
+        WCHAR *name;
+
+        if (!(name = strdupW( hostname ))) goto done;
+        if (resolve_cache_count >= RESOLVE_CACHE_SIZE)
+        {
+            /* recycle the least recently used entry */
+            host = LIST_ENTRY( list_tail( &resolve_cache ), struct resolved_host, entry );
+            heap_free( host->hostname );
+        }
+        else if (!(host = heap_alloc( sizeof(*host) )))
+        {
+            heap_free( name );
+            goto done;
+        }
+        else
+        {
+            list_add_head( &resolve_cache, &host->entry );
+            resolve_cache_count++;
+        }
+        host->hostname = name;
+        host->port     = port;
+    }
+    memcpy( &host->addr, sa, sa_len );
+    host->addr_len = sa_len;
+    host->expires  = GetTickCount64() + RESOLVE_CACHE_TIME;
+    list_remove( &host->entry );
+    list_add_head( &resolve_cache, &host->entry );
+
+done:
+    LeaveCriticalSection( &resolve_cache_cs );
+}
+
 BOOL netconn_resolve( WCHAR *hostname, INTERNET_PORT port, struct sockaddr *sa, socklen_t *sa_len, int timeout )
 {
     DWORD ret;
 
+    if (get_cached_address( hostname, port, sa, sa_len ))
+    {
+        TRACE("using cached address for %s\n", debugstr_w(hostname));
+        return TRUE;
+    }
+
     if (timeout)
     {
         DWORD status;
@@ -874,6 +1209,7 @@ BOOL netconn_resolve( WCHAR *hostname, INTERNET_PORT port, struct sockaddr *sa,
         set_last_error( ret );
         return FALSE;
     }
+    cache_address( hostname, port, sa, *sa_len );
     return TRUE;
 }
 
@@ -177,20 +177,208 @@ static const WCHAR *attribute_table[] =
     NULL                            /* WINHTTP_QUERY_PASSPORT_CONFIG            = 78 */
 };
 
-static DWORD CALLBACK task_thread( LPVOID param )
+/* Async tasks run on a small pool of threads shared by all requests. A request's
+ * tasks run one after the other, and tasks that would block reading from the
+ * server wait in the poll thread until the connection becomes readable. Tasks
+ * that block otherwise, while connecting, sending or in a status callback, can
+ * still tie up every thread; another one is started when no task could be
+ * started for a while.
+ */
+#define MAX_TASK_THREADS 4
+#define TASK_STARVATION_TIME 500
+
+static CRITICAL_SECTION task_cs;
+static CRITICAL_SECTION_DEBUG task_cs_debug =
 {
-    task_header_t *task = param;
+    0, 0, &task_cs,
+    { &task_cs_debug.ProcessLocksList, &task_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": task_cs") }
+};
+static CRITICAL_SECTION task_cs = { &task_cs_debug, -1, 0, 0, 0, 0 };
 
-    task->proc( task );
+static CONDITION_VARIABLE task_cv = CONDITION_VARIABLE_INIT;
+static struct list ready_tasks = LIST_INIT( ready_tasks );
+static unsigned int task_threads, idle_task_threads, tasks_started;
+static BOOL starvation_check_pending;
 
-    release_object( &task->request->hdr );
-    heap_free( task );
-    return ERROR_SUCCESS;
+static BOOL schedule_task( task_header_t * );
+
+static void fail_task( task_header_t *task )
+{
+    WINHTTP_ASYNC_RESULT result;
+
+    TRACE("task %p failed with %u\n", task, task->error);
+    result.dwResult = task->api;
+    result.dwError  = task->error;
+    send_callback( &task->request->hdr, WINHTTP_CALLBACK_STATUS_REQUEST_ERROR, &result, sizeof(result) );
+}
+
+static DWORD CALLBACK task_thread( LPVOID module )
+{
+    task_header_t *task, *next;
+    request_t *request;
+
+    for (;;)
+    {
+        EnterCriticalSection( &task_cs );
+        while (list_empty( &ready_tasks ))
+        {
+            BOOL woken;
+
+            /* threads started because the others were blocked don't linger */
+            idle_task_threads++;
+            woken = SleepConditionVariableCS( &task_cv, &task_cs, task_threads > MAX_TASK_THREADS ? 0 : 30000 );
+            idle_task_threads--;
+            if (!woken && list_empty( &ready_tasks ))
+            {
+                task_threads--;
+                LeaveCriticalSection( &task_cs );
+                FreeLibraryAndExitThread( module, 0 );
+            }
+        }
+        task = LIST_ENTRY( list_head( &ready_tasks ), task_header_t, entry );
+        list_remove( &task->entry );
+        tasks_started++;
+        LeaveCriticalSection( &task_cs );
+
+        request = task->request;
+        if (task->error) fail_task( task );
+        else task->proc( task );
+        heap_free( task );
+
+        EnterCriticalSection( &task_cs );
+        if (list_empty( &request->task_queue )) request->task_busy = FALSE;
+        else
+        {
+            next = LIST_ENTRY( list_head( &request->task_queue ), task_header_t, entry );
+            list_remove( &next->entry );
+            schedule_task( next );
+        }
+        LeaveCriticalSection( &task_cs );
+
+        release_object( &request->hdr );
+    }
+}
+
+/* called with task_cs held */
+static BOOL start_task_thread( void )
+{
+    HANDLE thread = NULL;
+    HMODULE module;
+
+    /* task threads keep a reference to the dll while they run */
+    if (GetModuleHandleExW( GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (const WCHAR *)task_thread, &module ))
+    {
+        if (!(thread = CreateThread( NULL, 0, task_thread, module, 0, NULL ))) FreeLibrary( module );
+    }
+    if (!thread) return FALSE;
+    task_threads++;
+    CloseHandle( thread );
+    return TRUE;
+}
+
+static void check_starvation( void *, DWORD );
+
+/* called with task_cs held */
+static void check_starvation_later( void )
+{
+    if (starvation_check_pending) return;
+    starvation_check_pending = netconn_wait_readable( NULL, TASK_STARVATION_TIME, check_starvation,
+                                                      (void *)(ULONG_PTR)tasks_started );
+}
+
+/* called from the poll thread, ready tasks are stuck if no thread picked up a task meanwhile */
+static void check_starvation( void *ctx, DWORD error )
+{
+    EnterCriticalSection( &task_cs );
+    starvation_check_pending = FALSE;
+    if (!list_empty( &ready_tasks ) && !idle_task_threads)
+    {
+        if (tasks_started == (ULONG_PTR)ctx)
+        {
+            TRACE("all %u task threads are blocked, starting another one\n", task_threads);
+            start_task_thread();
+        }
+        check_starvation_later();
+    }
+    LeaveCriticalSection( &task_cs );
+}
+
+/* called with task_cs held */
+static BOOL run_task( task_header_t *task )
+{
+    list_add_tail( &ready_tasks, &task->entry );
+    if (idle_task_threads) WakeConditionVariable( &task_cv );
+
+    if (list_count( &ready_tasks ) > idle_task_threads)
+    {
+        if (task_threads >= MAX_TASK_THREADS) check_starvation_later();
+        else if (!start_task_thread() && !task_threads)
+        {
+            ERR("failed to start a task thread\n");
+            list_remove( &task->entry );
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void task_data_ready( void *ctx, DWORD error )
+{
+    task_header_t *task = ctx;
+
+    EnterCriticalSection( &task_cs );
+    task->request->waiting_task = NULL;
+    task->error = error;
+    run_task( task );
+    LeaveCriticalSection( &task_cs );
+}
+
+/* called with task_cs held */
+static BOOL schedule_task( task_header_t *task )
+{
+    request_t *request = task->request;
+
+    if (task->ready && !task->ready( request ))
+    {
+        if (request->task_cancel) task->error = ERROR_WINHTTP_OPERATION_CANCELLED;
+        else if (netconn_wait_readable( &request->netconn, request->recv_timeout, task_data_ready, task ))
+        {
+            request->waiting_task = task;
+            return TRUE;
+        }
+    }
+    return run_task( task );
 }
 
 static BOOL queue_task( task_header_t *task )
 {
-    return QueueUserWorkItem( task_thread, task, WT_EXECUTELONGFUNCTION );
+    request_t *request = task->request;
+    BOOL ret = TRUE;
+
+    task->error = ERROR_SUCCESS;
+
+    EnterCriticalSection( &task_cs );
+    if (request->task_busy) list_add_tail( &request->task_queue, &task->entry );
+    else if ((ret = schedule_task( task ))) request->task_busy = TRUE;
+    LeaveCriticalSection( &task_cs );
+    return ret;
+}
+
+/* called when the request handle is closed, a task waiting for data would keep it alive */
+void cancel_tasks( request_t *request )
+{
+    task_header_t *task;
+
+    EnterCriticalSection( &task_cs );
+    request->task_cancel = TRUE;
+    if ((task = request->waiting_task) && netconn_cancel_wait( task ))
+    {
+        request->waiting_task = NULL;
+        task->error = ERROR_WINHTTP_OPERATION_CANCELLED;
+        run_task( task );
+    }
+    LeaveCriticalSection( &task_cs );
 }
 
 static void free_header( header_t *header )
@@ -936,7 +1124,179 @@ static WCHAR *addr_to_str( const struct sockaddr *addr )
     return strdupAW( buf );
 }
 
-static BOOL open_connection( request_t *request )
+/* idle keep-alive connections, shared between the requests of a session */
+#define COLLECT_TIME 60000
+
+struct pooled_connection
+{
+    struct list entry;
+    session_t *session;
+    WCHAR *key;
+    netconn_t netconn;
+    ULONGLONG keep_until;
+};
+
+static CRITICAL_SECTION connection_pool_cs;
+static CRITICAL_SECTION_DEBUG connection_pool_cs_debug =
+{
+    0, 0, &connection_pool_cs,
+    { &connection_pool_cs_debug.ProcessLocksList, &connection_pool_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": connection_pool_cs") }
+};
+static CRITICAL_SECTION connection_pool_cs = { &connection_pool_cs_debug, -1, 0, 0, 0, 0 };
+
+static struct list connection_pool = LIST_INIT( connection_pool );
+static BOOL collector_running;
+
+static void free_pooled_connection( struct pooled_connection *conn )
+{
+    netconn_close( &conn->netconn );
+    heap_free( conn->key );
+    heap_free( conn );
+}
+
+static DWORD CALLBACK collect_connections_proc( LPVOID module )
+{
+    struct pooled_connection *conn, *next;
+    BOOL remaining;
+    ULONGLONG now;
+
+    do
+    {
+        Sleep( 5000 );
+
+        EnterCriticalSection( &connection_pool_cs );
+
+        now = GetTickCount64();
+        remaining = FALSE;
+        LIST_FOR_EACH_ENTRY_SAFE( conn, next, &connection_pool, struct pooled_connection, entry )
+        {
+            if (conn->keep_until < now)
+            {
+                TRACE("closing idle connection %p\n", conn);
+                list_remove( &conn->entry );
+                free_pooled_connection( conn );
+            }
+            else remaining = TRUE;
+        }
+        if (!remaining) collector_running = FALSE;
+
+        LeaveCriticalSection( &connection_pool_cs );
+    } while (remaining);
+
+    FreeLibraryAndExitThread( module, 0 );
+}
+
+void close_pooled_connections( session_t *session )
+{
+    struct pooled_connection *conn, *next;
+
+    EnterCriticalSection( &connection_pool_cs );
+    LIST_FOR_EACH_ENTRY_SAFE( conn, next, &connection_pool, struct pooled_connection, entry )
+    {
+        if (conn->session != session) continue;
+        list_remove( &conn->entry );
+        free_pooled_connection( conn );
+    }
+    LeaveCriticalSection( &connection_pool_cs );
+}
+
+/* connections are only shared between requests going to the same server through the same route */
+static WCHAR *get_pool_key( connect_t *connect, INTERNET_PORT port )
+{
+    static const WCHAR fmtW[] = {'%','s',':','%','u','/','%','s',0};
+    WCHAR *key;
+    DWORD len = strlenW( connect->servername ) + strlenW( connect->hostname ) + sizeof("65535:/");
+
+    if ((key = heap_alloc( len * sizeof(WCHAR) ))) sprintfW( key, fmtW, connect->servername, port, connect->hostname );
+    return key;
+}
+
+static BOOL get_pooled_connection( request_t *request )
+{
+    session_t *session = request->connect->session;
+    BOOL secure = (request->hdr.flags & WINHTTP_FLAG_SECURE) != 0;
+    struct pooled_connection *conn, *next, *found = NULL;
+
+    EnterCriticalSection( &connection_pool_cs );
+    LIST_FOR_EACH_ENTRY_SAFE( conn, next, &connection_pool, struct pooled_connection, entry )
+    {
+        if (conn->session != session || conn->netconn.secure != secure ||
+            conn->netconn.security_flags != request->netconn.security_flags ||
+            strcmpiW( conn->key, request->pool_key )) continue;
+
+        list_remove( &conn->entry );
+        if (netconn_is_alive( &conn->netconn ))
+        {
+            found = conn;
+            break;
+        }
+        TRACE("connection %p closed while idle\n", conn);
+        free_pooled_connection( conn );
+    }
+    LeaveCriticalSection( &connection_pool_cs );
+
+    if (!found) return FALSE;
+
+    TRACE("reusing connection %p\n", found);
+    request->netconn = found->netconn;
+    heap_free( found->key );
+    heap_free( found );
+    return TRUE;
+}
+
+void release_connection( request_t *request )
+{
+    struct pooled_connection *conn;
+    DWORD security_flags;
+    BOOL run_collector;
+
+    if (!netconn_connected( &request->netconn )) return;
+
+    if (!request->keep_alive || !request->pool_key || !(conn = heap_alloc( sizeof(*conn) )))
+    {
+        netconn_close( &request->netconn );
+        return;
+    }
+    conn->session    = request->connect->session;
+    conn->key        = request->pool_key;
+    conn->netconn    = request->netconn;
+    conn->keep_until = GetTickCount64() + COLLECT_TIME;
+
+    security_flags = request->netconn.security_flags;
+    netconn_init( &request->netconn );
+    request->netconn.security_flags = security_flags;
+    request->pool_key = NULL;
+
+    EnterCriticalSection( &connection_pool_cs );
+    list_add_head( &connection_pool, &conn->entry );
+    run_collector = !collector_running;
+    collector_running = TRUE;
+    LeaveCriticalSection( &connection_pool_cs );
+
+    if (run_collector)
+    {
+        HANDLE thread = NULL;
+        HMODULE module;
+
+        /* the collector keeps a reference to the dll while it runs */
+        if (GetModuleHandleExW( GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (const WCHAR *)collect_connections_proc,
+                                &module ))
+        {
+            if (!(thread = CreateThread( NULL, 0, collect_connections_proc, module, 0, NULL )))
+                FreeLibrary( module );
+        }
+        if (thread) CloseHandle( thread );
+        else
+        {
+            EnterCriticalSection( &connection_pool_cs );
+            collector_running = FALSE;
+            LeaveCriticalSection( &connection_pool_cs );
+        }
+    }
+}
+
+static BOOL open_connection( request_t *request, BOOL use_pool )
 {
     connect_t *connect;
     WCHAR *addressW = NULL;
@@ -949,6 +1309,18 @@ static BOOL open_connection( request_t *request )
 
     connect = request->connect;
     port = connect->serverport ? connect->serverport : (request->hdr.flags & WINHTTP_FLAG_SECURE ? 443 : 80);
+
+    heap_free( request->pool_key );
+    if (!(request->pool_key = get_pool_key( connect, port ))) return FALSE;
+    if (use_pool && get_pooled_connection( request ))
+    {
+        netconn_set_timeout( &request->netconn, TRUE, request->send_timeout );
+        netconn_set_timeout( &request->netconn, FALSE, request->recv_timeout );
+        request->reused_connection = TRUE;
+        goto done;
+    }
+    request->reused_connection = FALSE;
+
     saddr = (struct sockaddr *)&connect->sockaddr;
     slen = sizeof(struct sockaddr);
 
@@ -1004,6 +1376,7 @@ static BOOL open_connection( request_t *request )
     send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_CONNECTED_TO_SERVER, addressW, strlenW(addressW) + 1 );
 
 done:
+    request->keep_alive = FALSE;
     request->read_pos = request->read_size = 0;
     request->read_chunked = FALSE;
     request->read_chunked_size = ~0u;
@@ -1058,6 +1431,37 @@ static void clear_response_headers( request_t *request )
     }
 }
 
+static BOOL is_connection_reset( DWORD error )
+{
+    return error == WSAECONNRESET || error == WSAECONNABORTED || error == WSAESHUTDOWN;
+}
+
+/* A request can be sent again on a new connection if the pooled one was
+ * closed or reset by the server before anything came back, and if sending
+ * it twice can't have side effects. */
+static BOOL can_resend_request( request_t *request, DWORD body_len )
+{
+    static const WCHAR putW[]     = {'P','U','T',0};
+    static const WCHAR deleteW[]  = {'D','E','L','E','T','E',0};
+    static const WCHAR optionsW[] = {'O','P','T','I','O','N','S',0};
+    static const WCHAR traceW[]   = {'T','R','A','C','E',0};
+
+    if (!request->reused_connection) return FALSE;
+    if (!body_len) return TRUE;
+    return !strcmpW( request->verb, getW ) || !strcmpW( request->verb, headW ) ||
+           !strcmpW( request->verb, putW ) || !strcmpW( request->verb, deleteW ) ||
+           !strcmpW( request->verb, optionsW ) || !strcmpW( request->verb, traceW );
+}
+
+static BOOL send_request_data( request_t *request, const char *req, DWORD len, void *optional, DWORD optional_len )
+{
+    int bytes_sent;
+
+    if (!netconn_send( &request->netconn, req, len, &bytes_sent )) return FALSE;
+    if (optional_len && !netconn_send( &request->netconn, optional, optional_len, &bytes_sent )) return FALSE;
+    return TRUE;
+}
+
 static BOOL send_request( request_t *request, LPCWSTR headers, DWORD headers_len, LPVOID optional,
                           DWORD optional_len, DWORD total_len, DWORD_PTR context, BOOL async )
 {
@@ -1070,7 +1474,6 @@ static BOOL send_request( request_t *request, LPCWSTR headers, DWORD headers_len
     session_t *session = connect->session;
     WCHAR *req = NULL;
     char *req_ascii;
-    int bytes_sent;
     DWORD len, i, flags;
 
     clear_response_headers( request );
@@ -1114,7 +1517,7 @@ static BOOL send_request( request_t *request, LPCWSTR headers, DWORD headers_len
 
     if (context) request->hdr.context = context;
 
-    if (!(ret = open_connection( request ))) goto end;
+    if (!(ret = open_connection( request, TRUE ))) goto end;
     if (!(req = build_request_string( request ))) goto end;
 
     if (!(req_ascii = strdupWA( req ))) goto end;
@@ -1123,17 +1526,26 @@ static BOOL send_request( request_t *request, LPCWSTR headers, DWORD headers_len
 
     send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_SENDING_REQUEST, NULL, 0 );
 
-    ret = netconn_send( &request->netconn, req_ascii, len, &bytes_sent );
+    ret = send_request_data( request, req_ascii, len, optional, optional_len );
+    if (!ret && is_connection_reset( get_last_error() ) && can_resend_request( request, max( total_len, optional_len ) ))
+    {
+        /* the server may have closed the idle connection just after we checked it */
+        TRACE("reused connection failed, retrying with a new one\n");
+        netconn_close( &request->netconn );
+        if ((ret = open_connection( request, FALSE )))
+            ret = send_request_data( request, req_ascii, len, optional, optional_len );
+    }
     heap_free( req_ascii );
     if (!ret) goto end;
 
     if (optional_len)
     {
-        if (!netconn_send( &request->netconn, optional, optional_len, &bytes_sent )) goto end;
         request->optional = optional;
         request->optional_len = optional_len;
         len += optional_len;
     }
+    /* the request can only be sent again if no data follows with WinHttpWriteData */
+    if (total_len > optional_len) request->reused_connection = FALSE;
     send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_REQUEST_SENT, &len, sizeof(len) );
 
 end:
@@ -1190,6 +1602,8 @@ BOOL WINAPI WinHttpSendRequest( HINTERNET hrequest, LPCWSTR headers, DWORD heade
         if (!(s = heap_alloc( sizeof(send_request_t) ))) return FALSE;
         s->hdr.request  = request;
         s->hdr.proc     = task_send_request;
+        s->hdr.ready    = NULL;
+        s->hdr.api      = API_SEND_REQUEST;
         s->headers      = strdupW( headers );
         s->headers_len  = headers_len;
         s->optional     = optional;
@@ -1841,6 +2255,8 @@ static BOOL read_more_data( request_t *request, int maxlen, BOOL notify )
 
     if (notify) send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_RESPONSE_RECEIVED, &len, sizeof(len) );
 
+    /* only a connection closed or reset before the response may be retried */
+    if (len > 0 || (!ret && !is_connection_reset( get_last_error() ))) request->reused_connection = FALSE;
     request->read_size += len;
     return ret;
 }
@@ -2084,22 +2500,24 @@ static BOOL read_reply( request_t *request )
     return TRUE;
 }
 
-static void finished_reading( request_t *request )
+static BOOL connection_keep_alive( request_t *request )
 {
     static const WCHAR closeW[] = {'c','l','o','s','e',0};
 
-    BOOL close = FALSE;
     WCHAR connection[20];
     DWORD size = sizeof(connection);
 
-    if (request->hdr.disable_flags & WINHTTP_DISABLE_KEEP_ALIVE) close = TRUE;
-    else if (query_headers( request, WINHTTP_QUERY_CONNECTION, NULL, connection, &size, NULL ) ||
-             query_headers( request, WINHTTP_QUERY_PROXY_CONNECTION, NULL, connection, &size, NULL ))
-    {
-        if (!strcmpiW( connection, closeW )) close = TRUE;
-    }
-    else if (!strcmpW( request->version, http1_0 )) close = TRUE;
-    if (close) close_connection( request );
+    if (request->hdr.disable_flags & WINHTTP_DISABLE_KEEP_ALIVE) return FALSE;
+    if (query_headers( request, WINHTTP_QUERY_CONNECTION, NULL, connection, &size, NULL ) ||
+        query_headers( request, WINHTTP_QUERY_PROXY_CONNECTION, NULL, connection, &size, NULL ))
+        return strcmpiW( connection, closeW ) != 0;
+    return strcmpW( request->version, http1_0 ) != 0;
+}
+
+static void finished_reading( request_t *request )
+{
+    if (!connection_keep_alive( request )) close_connection( request );
+    else request->keep_alive = TRUE;
 }
 
 static BOOL read_data( request_t *request, void *buffer, DWORD size, DWORD *read, BOOL async )
@@ -2245,7 +2663,7 @@ static BOOL handle_redirect( request_t *request, DWORD status )
             request->read_chunked_eof = FALSE;
         }
         if (!(ret = add_host_header( request, WINHTTP_ADDREQ_FLAG_REPLACE ))) goto end;
-        if (!(ret = open_connection( request ))) goto end;
+        if (!(ret = open_connection( request, TRUE ))) goto end;
 
         heap_free( request->path );
         request->path = NULL;
@@ -2286,6 +2704,16 @@ static BOOL receive_response( request_t *request, BOOL async )
     {
         if (!(ret = read_reply( request )))
         {
+            if (can_resend_request( request, request->optional_len ))
+            {
+                /* nothing came back on a pooled connection, send the request again on a new one */
+                TRACE("reused connection failed, retrying with a new one\n");
+                netconn_close( &request->netconn );
+                if (!open_connection( request, FALSE ) ||
+                    !send_request( request, NULL, 0, request->optional, request->optional_len, 0, 0, FALSE ))
+                    break; /* keep the error of the new connection */
+                continue;
+            }
             set_last_error( ERROR_WINHTTP_INVALID_SERVER_RESPONSE );
             break;
         }
@@ -2325,7 +2753,12 @@ static BOOL receive_response( request_t *request, BOOL async )
         break;
     }
 
-    if (ret) refill_buffer( request, FALSE );
+    if (ret)
+    {
+        refill_buffer( request, FALSE );
+        /* a response without body can be pooled, closing is left to the read as before */
+        if (end_of_read_data( request ) && connection_keep_alive( request )) request->keep_alive = TRUE;
+    }
 
     if (async)
     {
@@ -2341,6 +2774,18 @@ static BOOL receive_response( request_t *request, BOOL async )
     return ret;
 }
 
+/* a read can go ahead without waiting for the server to send something */
+static BOOL response_ready( request_t *request )
+{
+    return request->read_size || !netconn_connected( &request->netconn ) ||
+           netconn_data_buffered( &request->netconn );
+}
+
+static BOOL data_ready( request_t *request )
+{
+    return end_of_read_data( request ) || response_ready( request );
+}
+
 static void task_receive_response( task_header_t *task )
 {
     receive_response_t *r = (receive_response_t *)task;
@@ -2376,6 +2821,8 @@ BOOL WINAPI WinHttpReceiveResponse( HINTERNET hrequest, LPVOID reserved )
         if (!(r = heap_alloc( sizeof(receive_response_t) ))) return FALSE;
         r->hdr.request = request;
         r->hdr.proc    = task_receive_response;
+        r->hdr.ready   = response_ready;
+        r->hdr.api     = API_RECEIVE_RESPONSE;
 
         addref_object( &request->hdr );
         ret = queue_task( (task_header_t *)r );
@@ -2442,6 +2889,8 @@ BOOL WINAPI WinHttpQueryDataAvailable( HINTERNET hrequest, LPDWORD available )
         if (!(q = heap_alloc( sizeof(query_data_t) ))) return FALSE;
         q->hdr.request = request;
         q->hdr.proc    = task_query_data_available;
+        q->hdr.ready   = data_ready;
+        q->hdr.api     = API_QUERY_DATA_AVAILABLE;
         q->available   = available;
 
         addref_object( &request->hdr );
@@ -2489,6 +2938,8 @@ BOOL WINAPI WinHttpReadData( HINTERNET hrequest, LPVOID buffer, DWORD to_read, L
         if (!(r = heap_alloc( sizeof(read_data_t) ))) return FALSE;
         r->hdr.request = request;
         r->hdr.proc    = task_read_data;
+        r->hdr.ready   = data_ready;
+        r->hdr.api     = API_READ_DATA;
         r->buffer      = buffer;
         r->to_read     = to_read;
         r->read        = read;
@@ -2560,6 +3011,8 @@ BOOL WINAPI WinHttpWriteData( HINTERNET hrequest, LPCVOID buffer, DWORD to_write
         if (!(w = heap_alloc( sizeof(write_data_t) ))) return FALSE;
         w->hdr.request = request;
         w->hdr.proc    = task_write_data;
+        w->hdr.ready   = NULL;
+        w->hdr.api     = API_WRITE_DATA;
         w->buffer      = buffer;
         w->to_write    = to_write;
         w->written     = written;
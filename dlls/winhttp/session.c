@@ -89,6 +89,7 @@ static void session_destroy( object_header_t *hdr )
 
     TRACE("%p\n", session);
 
+    close_pooled_connections( session );
     LIST_FOR_EACH_SAFE( item, next, &session->cookie_cache )
     {
         domain = LIST_ENTRY( item, domain_t, entry );
@@ -550,6 +551,8 @@ static void request_destroy( object_header_t *hdr )
 
     TRACE("%p\n", request);
 
+    release_connection( request );
+    heap_free( request->pool_key );
     release_object( &request->connect->hdr );
 
     destroy_authinfo( request->authinfo );
@@ -1051,6 +1054,7 @@ HINTERNET WINAPI WinHttpOpenRequest( HINTERNET hconnect, LPCWSTR verb, LPCWSTR o
     request->hdr.context = connect->hdr.context;
     request->hdr.redirect_policy = connect->hdr.redirect_policy;
     list_init( &request->hdr.children );
+    list_init( &request->task_queue );
 
     addref_object( &connect->hdr );
     request->connect = connect;
@@ -1778,6 +1778,12 @@ static const char proxymsg[] =
 "Proxy-Authenticate: Basic realm=\"placebo\"\r\n"
 "\r\n";
 
+static const char keepalivemsg[] =
+"HTTP/1.1 200 OK\r\n"
+"Server: winetest\r\n"
+"Content-Length: 1\r\n"
+"\r\n";
+
 struct server_info
 {
     HANDLE event;
@@ -1789,7 +1795,7 @@ struct server_info
 static DWORD CALLBACK server_thread(LPVOID param)
 {
     struct server_info *si = param;
-    int r, c, i, on;
+    int r, c = -1, i, on, conn_requests = 0;
     SOCKET s;
     struct sockaddr_in sa;
     char buffer[0x100];
@@ -1818,7 +1824,11 @@ static DWORD CALLBACK server_thread(LPVOID param)
     SetEvent(si->event);
     do
     {
-        c = accept(s, NULL, NULL);
+        if (c == -1)
+        {
+            c = accept(s, NULL, NULL);
+            conn_requests = 0;
+        }
 
         memset(buffer, 0, sizeof buffer);
         for(i = 0; i < sizeof buffer - 1; i++)
@@ -1854,6 +1864,14 @@ static DWORD CALLBACK server_thread(LPVOID param)
         {
             send(c, page1, sizeof page1 - 1, 0);
         }
+        if (strstr(buffer, "GET /keepalive"))
+        {
+            /* the body tells how many requests came before on this connection */
+            char count = '0' + conn_requests++;
+            send(c, keepalivemsg, sizeof keepalivemsg - 1, 0);
+            send(c, &count, 1, 0);
+            continue;
+        }
         if (strstr(buffer, "GET /quit"))
         {
             send(c, okmsg, sizeof okmsg - 1, 0);
@@ -1862,6 +1880,7 @@ static DWORD CALLBACK server_thread(LPVOID param)
         }
         shutdown(c, 2);
         closesocket(c);
+        c = -1;
 
     } while (!last_request);
 
@@ -2177,6 +2196,47 @@ static void test_multiple_reads(int port)
     WinHttpCloseHandle(ses);
 }
 
+static void test_keep_alive( int port )
+{
+    static const WCHAR keepaliveW[] = {'/','k','e','e','p','a','l','i','v','e',0};
+    HINTERNET ses, con, req;
+    char buffer[4];
+    DWORD count;
+    BOOL ret;
+    int i;
+
+    ses = WinHttpOpen( test_useragent, 0, NULL, NULL, 0 );
+    ok( ses != NULL, "failed to open session %u\n", GetLastError() );
+
+    /* idle connections are shared by all connect handles of the session */
+    for (i = 0; i < 2; i++)
+    {
+        con = WinHttpConnect( ses, localhostW, port, 0 );
+        ok( con != NULL, "failed to open a connection %u\n", GetLastError() );
+
+        req = WinHttpOpenRequest( con, NULL, keepaliveW, NULL, NULL, NULL, 0 );
+        ok( req != NULL, "failed to open a request %u\n", GetLastError() );
+
+        ret = WinHttpSendRequest( req, NULL, 0, NULL, 0, 0, 0 );
+        ok( ret, "failed to send request %u\n", GetLastError() );
+
+        ret = WinHttpReceiveResponse( req, NULL );
+        ok( ret, "failed to receive response %u\n", GetLastError() );
+
+        count = 0;
+        memset( buffer, 0, sizeof(buffer) );
+        ret = WinHttpReadData( req, buffer, sizeof(buffer), &count );
+        ok( ret, "failed to read data %u\n", GetLastError() );
+        ok( count == 1, "got %u\n", count );
+        ok( buffer[0] == '0' + i, "%d: got %s\n", i, buffer );
+
+        WinHttpCloseHandle( req );
+        WinHttpCloseHandle( con );
+    }
+    /* closing the session closes the pooled connection, which lets the server move on */
+    WinHttpCloseHandle( ses );
+}
+
 static void test_connection_info( int port )
 {
     static const WCHAR basicW[] = {'/','b','a','s','i','c',0};
@@ -3085,6 +3145,7 @@ START_TEST (winhttp)
     test_basic_authentication(si.port);
     test_bad_header(si.port);
     test_multiple_reads(si.port);
+    test_keep_alive(si.port);
 
     /* send the basic request again to shutdown the server thread */
     test_basic_request(si.port, NULL, quitW);
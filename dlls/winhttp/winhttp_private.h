@@ -182,6 +182,9 @@ typedef struct
     void *optional;
     DWORD optional_len;
     netconn_t netconn;
+    WCHAR *pool_key; /* identifies the server the connection goes to */
+    BOOL keep_alive; /* connection can be pooled once the request is done with it */
+    BOOL reused_connection; /* pooled connection with nothing received yet but a close or reset */
     int resolve_timeout;
     int connect_timeout;
     int send_timeout;
@@ -201,14 +204,22 @@ typedef struct
     DWORD num_accept_types;
     struct authinfo *authinfo;
     struct authinfo *proxy_authinfo;
+    struct list task_queue; /* async tasks waiting for the running one to finish */
+    BOOL task_busy;
+    struct _task_header_t *waiting_task; /* task parked until the server sends data */
+    BOOL task_cancel; /* handle was closed, tasks fail instead of waiting for data */
 } request_t;
 
 typedef struct _task_header_t task_header_t;
 
 struct _task_header_t
 {
+    struct list entry;
     request_t *request;
     void (*proc)( task_header_t * );
+    BOOL (*ready)( request_t * ); /* can run without waiting for the server? NULL if always */
+    DWORD api;   /* API_* reported when a task that waits for data fails */
+    DWORD error; /* set if the task fails instead of running */
 };
 
 typedef struct
@@ -259,12 +270,17 @@ void set_last_error( DWORD ) DECLSPEC_HIDDEN;
 DWORD get_last_error( void ) DECLSPEC_HIDDEN;
 void send_callback( object_header_t *, DWORD, LPVOID, DWORD ) DECLSPEC_HIDDEN;
 void close_connection( request_t * ) DECLSPEC_HIDDEN;
+void release_connection( request_t * ) DECLSPEC_HIDDEN;
+void close_pooled_connections( session_t * ) DECLSPEC_HIDDEN;
+void cancel_tasks( request_t * ) DECLSPEC_HIDDEN;
 
 BOOL netconn_close( netconn_t * ) DECLSPEC_HIDDEN;
 BOOL netconn_connect( netconn_t *, const struct sockaddr *, unsigned int, int ) DECLSPEC_HIDDEN;
 BOOL netconn_connected( netconn_t * ) DECLSPEC_HIDDEN;
 BOOL netconn_create( netconn_t *, int, int, int ) DECLSPEC_HIDDEN;
+BOOL netconn_data_buffered( netconn_t * ) DECLSPEC_HIDDEN;
 BOOL netconn_init( netconn_t * ) DECLSPEC_HIDDEN;
+BOOL netconn_is_alive( netconn_t * ) DECLSPEC_HIDDEN;
 void netconn_unload( void ) DECLSPEC_HIDDEN;
 ULONG netconn_query_data_available( netconn_t * ) DECLSPEC_HIDDEN;
 BOOL netconn_recv( netconn_t *, void *, size_t, int, int * ) DECLSPEC_HIDDEN;
@@ -272,6 +288,8 @@ BOOL netconn_resolve( WCHAR *, INTERNET_PORT, struct sockaddr *, socklen_t *, in
 BOOL netconn_secure_connect( netconn_t *, WCHAR * ) DECLSPEC_HIDDEN;
 BOOL netconn_send( netconn_t *, const void *, size_t, int * ) DECLSPEC_HIDDEN;
 DWORD netconn_set_timeout( netconn_t *, BOOL, int ) DECLSPEC_HIDDEN;
+BOOL netconn_wait_readable( netconn_t *, DWORD, void (*)( void *, DWORD ), void * ) DECLSPEC_HIDDEN;
+BOOL netconn_cancel_wait( void * ) DECLSPEC_HIDDEN;
 const void *netconn_get_certificate( netconn_t * ) DECLSPEC_HIDDEN;
 int netconn_get_cipher_strength( netconn_t * ) DECLSPEC_HIDDEN;
 
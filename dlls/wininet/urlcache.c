@@ -199,6 +199,14 @@ typedef struct
     DWORD file_size; /* size of file when mapping was opened */
     HANDLE mutex; /* handle of mutex */
     DWORD default_entry_type;
+    HANDLE sequence_mapping; /* handle of section holding the sequence counter */
+    LONG *sequence; /* shared by all processes, odd while the index is being modified */
+    DWORD write_depth; /* recursion count of the mutex owner */
+    DWORD lock_depth; /* recursion count of cache_container_lock_index */
+    BOOL modifying; /* index was locked for modification */
+    SRWLOCK view_lock; /* protects view */
+    const urlcache_header *view; /* read-only view used for lookups without the mutex */
+    DWORD view_size;
 } cache_container;
 
 typedef struct
@@ -594,6 +602,22 @@ static BOOL cache_container_is_valid(urlcache_header *header, DWORD file_size)
     return TRUE;
 }
 
+/* Caller must hold container lock */
+static void cache_container_begin_write(cache_container *container)
+{
+    /* The counter may already be odd if the previous owner of the mutex
+     * died in the middle of a modification, keep it that way. */
+    if(!container->write_depth++ && container->sequence && !(*container->sequence & 1))
+        InterlockedIncrement(container->sequence);
+}
+
+/* Caller must hold container lock */
+static void cache_container_end_write(cache_container *container)
+{
+    if(!--container->write_depth && container->sequence)
+        InterlockedIncrement(container->sequence);
+}
+
 /***********************************************************************
  *           cache_container_open_index (Internal)
  *
@@ -620,6 +644,8 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
         return ERROR_SUCCESS;
     }
 
+    cache_container_begin_write(container);
+
     strcpyW(index_path, container->path);
     strcatW(index_path, index_dat);
 
@@ -631,6 +657,7 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
     }
     if(file == INVALID_HANDLE_VALUE) {
         TRACE("Could not open or create cache index file \"%s\"\n", debugstr_w(index_path));
+        cache_container_end_write(container);
         ReleaseMutex(container->mutex);
         return GetLastError();
     }
@@ -638,6 +665,7 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
     file_size = GetFileSize(file, NULL);
     if(file_size == INVALID_FILE_SIZE) {
         CloseHandle(file);
+	cache_container_end_write(container);
 	ReleaseMutex(container->mutex);
         return GetLastError();
     }
@@ -650,6 +678,7 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
     if(file_size < FILE_SIZE(blocks_no)) {
         DWORD ret = cache_container_set_size(container, file, blocks_no);
         CloseHandle(file);
+        cache_container_end_write(container);
         ReleaseMutex(container->mutex);
         return ret;
     }
@@ -675,10 +704,12 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
     if(!container->mapping)
     {
         ERR("Couldn't create file mapping (error is %d)\n", GetLastError());
+        cache_container_end_write(container);
         ReleaseMutex(container->mutex);
         return GetLastError();
     }
 
+    cache_container_end_write(container);
     ReleaseMutex(container->mutex);
     return ERROR_SUCCESS;
 }
@@ -694,15 +725,23 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
  */
 static void cache_container_close_index(cache_container *pContainer)
 {
+    AcquireSRWLockExclusive(&pContainer->view_lock);
+    if(pContainer->view)
+        UnmapViewOfFile(pContainer->view);
+    pContainer->view = NULL;
+    pContainer->view_size = 0;
     CloseHandle(pContainer->mapping);
     pContainer->mapping = NULL;
+    ReleaseSRWLockExclusive(&pContainer->view_lock);
 }
 
 static BOOL cache_containers_add(const char *cache_prefix, LPCWSTR path,
         DWORD default_entry_type, LPWSTR mutex_name)
 {
+    static const WCHAR sequence_suffix[] = {'!','s','e','q',0};
     cache_container *pContainer = heap_alloc(sizeof(cache_container));
     int cache_prefix_len = strlen(cache_prefix);
+    WCHAR sequence_name[MAX_PATH + sizeof(sequence_suffix)/sizeof(WCHAR)];
 
     if (!pContainer)
     {
@@ -712,6 +751,14 @@ static BOOL cache_containers_add(const char *cache_prefix, LPCWSTR path,
     pContainer->mapping = NULL;
     pContainer->file_size = 0;
     pContainer->default_entry_type = default_entry_type;
+    pContainer->sequence_mapping = NULL;
+    pContainer->sequence = NULL;
+    pContainer->write_depth = 0;
+    pContainer->lock_depth = 0;
+    pContainer->modifying = FALSE;
+    InitializeSRWLock(&pContainer->view_lock);
+    pContainer->view = NULL;
+    pContainer->view_size = 0;
 
     pContainer->path = heap_strdupW(path);
     if (!pContainer->path)
@@ -741,6 +788,20 @@ static BOOL cache_containers_add(const char *cache_prefix, LPCWSTR path,
         return FALSE;
     }
 
+    /* The sequence counter lets lookups run without the mutex. It's not
+     * a problem if it can't be created, readers will just take the mutex. */
+    strcpyW(sequence_name, mutex_name);
+    strcatW(sequence_name, sequence_suffix);
+    pContainer->sequence_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL,
+            PAGE_READWRITE, 0, sizeof(LONG), sequence_name);
+    if(pContainer->sequence_mapping) {
+        pContainer->sequence = MapViewOfFile(pContainer->sequence_mapping, FILE_MAP_WRITE, 0, 0, sizeof(LONG));
+        if(!pContainer->sequence) {
+            CloseHandle(pContainer->sequence_mapping);
+            pContainer->sequence_mapping = NULL;
+        }
+    }
+
     list_add_head(&UrlContainers, &pContainer->entry);
 
     return TRUE;
@@ -751,6 +812,9 @@ static void cache_container_delete_container(cache_container *pContainer)
     list_remove(&pContainer->entry);
 
     cache_container_close_index(pContainer);
+    if(pContainer->sequence)
+        UnmapViewOfFile(pContainer->sequence);
+    CloseHandle(pContainer->sequence_mapping);
     CloseHandle(pContainer->mutex);
     heap_free(pContainer->path);
     heap_free(pContainer->cache_prefix);
@@ -896,16 +960,28 @@ static BOOL cache_containers_enum(char *search_pattern, DWORD index, cache_conta
     return FALSE;
 }
 
+/* Caller must hold container lock */
+static void cache_container_release_index(cache_container *container)
+{
+    if(!--container->lock_depth && container->modifying) {
+        container->modifying = FALSE;
+        cache_container_end_write(container);
+    }
+    /* release mutex */
+    ReleaseMutex(container->mutex);
+}
+
 /***********************************************************************
  *           cache_container_lock_index (Internal)
  *
- * Locks the index for system-wide exclusive access.
+ * Locks the index for system-wide exclusive access. Only callers that
+ * modify the index make lookups without the mutex retry.
  *
  * RETURNS
  *  Cache file header if successful
  *  NULL if failed and calls SetLastError.
  */
-static urlcache_header* cache_container_lock_index(cache_container *pContainer)
+static urlcache_header* cache_container_lock_index(cache_container *pContainer, BOOL modify)
 {
     BYTE index;
     LPVOID pIndexData;
@@ -914,12 +990,18 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
 
     /* acquire mutex */
     WaitForSingleObject(pContainer->mutex, INFINITE);
+    pContainer->lock_depth++;
+    if (modify && !pContainer->modifying)
+    {
+        pContainer->modifying = TRUE;
+        cache_container_begin_write(pContainer);
+    }
 
     pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
 
     if (!pIndexData)
     {
-        ReleaseMutex(pContainer->mutex);
+        cache_container_release_index(pContainer);
         ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
         return NULL;
     }
@@ -935,7 +1017,7 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
         error = cache_container_open_index(pContainer, MIN_BLOCK_NO);
         if (error != ERROR_SUCCESS)
         {
-            ReleaseMutex(pContainer->mutex);
+            cache_container_release_index(pContainer);
             SetLastError(error);
             return NULL;
         }
@@ -943,13 +1025,21 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
 
         if (!pIndexData)
         {
-            ReleaseMutex(pContainer->mutex);
+            cache_container_release_index(pContainer);
             ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
             return NULL;
         }
         pHeader = (urlcache_header*)pIndexData;
     }
 
+    if (!pContainer->view && pContainer->sequence)
+    {
+        AcquireSRWLockExclusive(&pContainer->view_lock);
+        pContainer->view = MapViewOfFile(pContainer->mapping, FILE_MAP_READ, 0, 0, 0);
+        pContainer->view_size = pContainer->view ? pContainer->file_size : 0;
+        ReleaseSRWLockExclusive(&pContainer->view_lock);
+    }
+
     TRACE("Signature: %s, file size: %d bytes\n", pHeader->signature, pHeader->size);
 
     for (index = 0; index < pHeader->dirs_no; index++)
@@ -966,8 +1056,7 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
  */
 static BOOL cache_container_unlock_index(cache_container *pContainer, urlcache_header *pHeader)
 {
-    /* release mutex */
-    ReleaseMutex(pContainer->mutex);
+    cache_container_release_index(pContainer);
     return UnmapViewOfFile(pHeader);
 }
 
@@ -1777,6 +1866,143 @@ static BOOL urlcache_hash_entry_is_locked(struct hash_entry *hash_entry, entry_u
     return TRUE;
 }
 
+/***********************************************************************
+ *           urlcache_copy_url_entry (Internal)
+ *
+ *  Looks up the url in the read-only view of the index and returns a
+ * private copy of its entry. The index may be modified by other threads
+ * or processes at the same time, so every offset is checked against the
+ * size of the view and the strings in the copy are known to be terminated.
+ *
+ * RETURNS
+ *    ERROR_SUCCESS if the entry was found
+ *    ERROR_FILE_NOT_FOUND if there is no entry for the url
+ *    ERROR_INVALID_DATA if the index is inconsistent
+ *
+ */
+static DWORD urlcache_copy_url_entry(const urlcache_header *header, DWORD view_size,
+        const char *url, entry_url **ret)
+{
+    DWORD key = urlcache_hash_key(url);
+    DWORD bucket = (key & (HASHTABLE_NUM_ENTRIES-1)) * HASHTABLE_BLOCKSIZE;
+    DWORD table_off, entry_off = 0, entry_size, id = 0;
+    const entry_hash_table *hash_table;
+    const entry_url *url_entry;
+    entry_url *copy;
+    int i;
+
+    key >>= HASHTABLE_FLAG_BITS;
+
+    for(table_off = header->hash_table_off; table_off && !entry_off; table_off = hash_table->next) {
+        if(table_off > view_size-sizeof(*hash_table) || id > view_size/sizeof(*hash_table))
+            return ERROR_INVALID_DATA;
+
+        hash_table = urlcache_get_hash_table(header, table_off);
+        if(hash_table->id != id++ || hash_table->header.signature != HASH_SIGNATURE)
+            continue;
+
+        for(i = 0; i < HASHTABLE_BLOCKSIZE; i++) {
+            if(key == hash_table->hash_table[bucket+i].key>>HASHTABLE_FLAG_BITS) {
+                entry_off = hash_table->hash_table[bucket+i].offset;
+                break;
+            }
+        }
+    }
+    if(!entry_off)
+        return ERROR_FILE_NOT_FOUND;
+
+    if(entry_off > view_size-sizeof(*url_entry))
+        return ERROR_INVALID_DATA;
+    url_entry = (const entry_url*)((const BYTE*)header + entry_off);
+    if(url_entry->header.signature != URL_SIGNATURE)
+        return ERROR_INVALID_DATA;
+
+    entry_size = url_entry->header.blocks_used;
+    if(entry_size > (view_size-entry_off)/BLOCKSIZE)
+        return ERROR_INVALID_DATA;
+    entry_size *= BLOCKSIZE;
+    if(entry_size < sizeof(*url_entry))
+        return ERROR_INVALID_DATA;
+
+    if(!(copy = heap_alloc(entry_size+1)))
+        return ERROR_OUTOFMEMORY;
+    memcpy(copy, url_entry, entry_size);
+    ((char*)copy)[entry_size] = 0;
+
+    if(copy->url_off >= entry_size || copy->local_name_off >= entry_size ||
+            copy->file_extension_off >= entry_size || copy->header_info_off > entry_size ||
+            copy->header_info_size > entry_size-copy->header_info_off) {
+        heap_free(copy);
+        return ERROR_INVALID_DATA;
+    }
+
+    *ret = copy;
+    return ERROR_SUCCESS;
+}
+
+/***********************************************************************
+ *           urlcache_get_entry_info_unlocked (Internal)
+ *
+ *  Fast path of urlcache_get_entry_info that doesn't take the container
+ * mutex. The sequence counter is odd while the index is being modified,
+ * the lookup is only trusted if the counter was even and didn't change.
+ *
+ * RETURNS
+ *    TRUE if the lookup was done, *error contains its result
+ *    FALSE if the caller has to retry with the mutex held
+ *
+ */
+static BOOL urlcache_get_entry_info_unlocked(cache_container *container, const char *url,
+        void *entry_info, DWORD *size, DWORD flags, BOOL unicode, DWORD *error)
+{
+    DWORD orig_size = size ? *size : 0;
+    entry_url *url_entry;
+    LONG sequence;
+    int tries;
+
+    if(!container->sequence)
+        return FALSE;
+
+    for(tries = 0; tries < 3; tries++) {
+        sequence = InterlockedCompareExchange(container->sequence, 0, 0);
+        if(sequence & 1) {
+            Sleep(0);
+            continue;
+        }
+
+        AcquireSRWLockShared(&container->view_lock);
+        if(!container->view) {
+            ReleaseSRWLockShared(&container->view_lock);
+            return FALSE;
+        }
+
+        url_entry = NULL;
+        *error = urlcache_copy_url_entry(container->view, container->view_size, url, &url_entry);
+        if(*error == ERROR_SUCCESS) {
+            if((flags & GET_INSTALLED_ENTRY) && !(url_entry->cache_entry_type & INSTALLED_CACHE_ENTRY)) {
+                *error = ERROR_FILE_NOT_FOUND;
+            }else if(size) {
+                if(!entry_info)
+                    *size = 0;
+                *error = urlcache_copy_entry(container, container->view, entry_info, size, url_entry, unicode);
+            }
+        }
+        ReleaseSRWLockShared(&container->view_lock);
+        heap_free(url_entry);
+
+        if(*error != ERROR_INVALID_DATA && *error != ERROR_OUTOFMEMORY &&
+                InterlockedCompareExchange(container->sequence, 0, 0) == sequence)
+            return TRUE;
+
+        if(size)
+            *size = orig_size;
+        if(*error == ERROR_INVALID_DATA || *error == ERROR_OUTOFMEMORY)
+            break;
+    }
+
+    return FALSE;
+}
+
 static BOOL urlcache_get_entry_info(const char *url, void *entry_info,
         DWORD *size, DWORD flags, BOOL unicode)
 {
@@ -1803,7 +2029,15 @@ static BOOL urlcache_get_entry_info(const char *url, void *entry_info,
         return FALSE;
     }
 
-    if(!(header = cache_container_lock_index(container)))
+    if(urlcache_get_entry_info_unlocked(container, url, entry_info, size, flags, unicode, &error)) {
+        if(error != ERROR_SUCCESS) {
+            SetLastError(error);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    if(!(header = cache_container_lock_index(container, FALSE)))
         return FALSE;
 
     if(!urlcache_find_hash_entry(header, url, &hash_entry)) {
@@ -2034,7 +2268,7 @@ BOOL WINAPI SetUrlCacheEntryInfoA(LPCSTR lpszUrlName,
         return FALSE;
     }
 
-    if (!(pHeader = cache_container_lock_index(pContainer)))
+    if (!(pHeader = cache_container_lock_index(pContainer, TRUE)))
         return FALSE;
 
     if (!urlcache_find_hash_entry(pHeader, lpszUrlName, &pHashEntry))
@@ -2106,7 +2340,7 @@ static BOOL urlcache_entry_get_file(const char *url, void *entry_info, DWORD *si
         return FALSE;
     }
 
-    if (!(header = cache_container_lock_index(container)))
+    if (!(header = cache_container_lock_index(container, TRUE)))
         return FALSE;
 
     if (!urlcache_find_hash_entry(header, url, &hash_entry)) {
@@ -2390,12 +2624,14 @@ BOOL WINAPI FreeUrlCacheSpaceW(LPCWSTR cache_path, DWORD size, DWORD filter)
                 BOOL ret_del;
 
                 WaitForSingleObject(container->mutex, INFINITE);
+                cache_container_begin_write(container);
 
                 /* unlock, delete, recreate and lock cache */
                 cache_container_close_index(container);
                 ret_del = cache_container_delete_dir(container->path);
                 err = cache_container_open_index(container, MIN_BLOCK_NO);
 
+                cache_container_end_write(container);
                 ReleaseMutex(container->mutex);
                 if(!ret_del || (err != ERROR_SUCCESS))
                     return FALSE;
@@ -2425,7 +2661,7 @@ BOOL WINAPI FreeUrlCacheSpaceW(LPCWSTR cache_path, DWORD size, DWORD filter)
         if(err != ERROR_SUCCESS)
             continue;
 
-        header = cache_container_lock_index(container);
+        header = cache_container_lock_index(container, TRUE);
         if(!header)
             continue;
 
@@ -2498,7 +2734,7 @@ BOOL WINAPI FreeUrlCacheSpaceW(LPCWSTR cache_path, DWORD size, DWORD filter)
                     return TRUE;
                 }
                 Sleep(0);
-                header = cache_container_lock_index(container);
+                header = cache_container_lock_index(container, TRUE);
             }
         }
 
@@ -2562,7 +2798,7 @@ BOOL WINAPI UnlockUrlCacheEntryFileA(LPCSTR lpszUrlName, DWORD dwReserved)
         return FALSE;
     }
 
-    if (!(pHeader = cache_container_lock_index(pContainer)))
+    if (!(pHeader = cache_container_lock_index(pContainer, TRUE)))
         return FALSE;
 
     if (!urlcache_find_hash_entry(pHeader, lpszUrlName, &pHashEntry))
@@ -2687,7 +2923,7 @@ static BOOL urlcache_entry_create(const char *url, const char *ext, WCHAR *full_
         return FALSE;
     }
 
-    if(!(header = cache_container_lock_index(container)))
+    if(!(header = cache_container_lock_index(container, FALSE)))
         return FALSE;
 
     if(header->dirs_no)
@@ -2873,7 +3109,7 @@ static BOOL urlcache_entry_commit(const char *url, const WCHAR *file_name,
         return FALSE;
     }
 
-    if(!(header = cache_container_lock_index(container)))
+    if(!(header = cache_container_lock_index(container, TRUE)))
         return FALSE;
 
     if(urlcache_find_hash_entry(header, url, &hash_entry)) {
@@ -3300,7 +3536,7 @@ BOOL WINAPI DeleteUrlCacheEntryA(LPCSTR lpszUrlName)
         return FALSE;
     }
 
-    if (!(pHeader = cache_container_lock_index(pContainer)))
+    if (!(pHeader = cache_container_lock_index(pContainer, TRUE)))
         return FALSE;
 
     if (!urlcache_find_hash_entry(pHeader, lpszUrlName, &pHashEntry))
@@ -3550,7 +3786,7 @@ static BOOL urlcache_find_next_entry(
             return FALSE;
         }
 
-        if (!(pHeader = cache_container_lock_index(pContainer)))
+        if (!(pHeader = cache_container_lock_index(pContainer, FALSE)))
             return FALSE;
 
         for (; urlcache_enum_hash_tables(pHeader, &pEntryHandle->hash_table_idx, &pHashTableEntry);
@@ -3898,7 +4134,7 @@ BOOL WINAPI IsUrlCacheEntryExpiredA(LPCSTR url, DWORD dwFlags, FILETIME* pftLast
         return TRUE;
     }
 
-    if (!(pHeader = cache_container_lock_index(pContainer)))
+    if (!(pHeader = cache_container_lock_index(pContainer, FALSE)))
     {
         memset(pftLastModified, 0, sizeof(*pftLastModified));
         return TRUE;
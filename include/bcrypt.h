@@ -40,6 +40,92 @@
 typedef LONG NTSTATUS;
 #endif
 
+#if defined(__GNUC__)
+#define BCRYPT_ALGORITHM_NAME        (const WCHAR []){'A','l','g','o','r','i','t','h','m','N','a','m','e',0}
+#define BCRYPT_AUTH_TAG_LENGTH       (const WCHAR []){'A','u','t','h','T','a','g','L','e','n','g','t','h',0}
+#define BCRYPT_BLOCK_LENGTH          (const WCHAR []){'B','l','o','c','k','L','e','n','g','t','h',0}
+#define BCRYPT_CHAINING_MODE         (const WCHAR []){'C','h','a','i','n','i','n','g','M','o','d','e',0}
+#define BCRYPT_HASH_BLOCK_LENGTH     (const WCHAR []){'H','a','s','h','B','l','o','c','k','L','e','n','g','t','h',0}
+#define BCRYPT_HASH_LENGTH           (const WCHAR []){'H','a','s','h','D','i','g','e','s','t','L','e','n','g','t','h',0}
+#define BCRYPT_KEY_LENGTH            (const WCHAR []){'K','e','y','L','e','n','g','t','h',0}
+#define BCRYPT_KEY_LENGTHS           (const WCHAR []){'K','e','y','L','e','n','g','t','h','s',0}
+#define BCRYPT_OBJECT_LENGTH         (const WCHAR []){'O','b','j','e','c','t','L','e','n','g','t','h',0}
+#define BCRYPT_PROVIDER_HANDLE       (const WCHAR []){'P','r','o','v','i','d','e','r','H','a','n','d','l','e',0}
+
+#define MS_PRIMITIVE_PROVIDER        (const WCHAR []){'M','i','c','r','o','s','o','f','t',' ','P','r','i','m','i','t','i','v','e',' ','P','r','o','v','i','d','e','r',0}
+
+#define BCRYPT_AES_ALGORITHM         (const WCHAR []){'A','E','S',0}
+#define BCRYPT_MD5_ALGORITHM         (const WCHAR []){'M','D','5',0}
+#define BCRYPT_RNG_ALGORITHM         (const WCHAR []){'R','N','G',0}
+#define BCRYPT_SHA1_ALGORITHM        (const WCHAR []){'S','H','A','1',0}
+#define BCRYPT_SHA256_ALGORITHM      (const WCHAR []){'S','H','A','2','5','6',0}
+#define BCRYPT_SHA384_ALGORITHM      (const WCHAR []){'S','H','A','3','8','4',0}
+#define BCRYPT_SHA512_ALGORITHM      (const WCHAR []){'S','H','A','5','1','2',0}
+
+#define BCRYPT_CHAIN_MODE_NA         (const WCHAR []){'C','h','a','i','n','i','n','g','M','o','d','e','N','/','A',0}
+#define BCRYPT_CHAIN_MODE_CBC        (const WCHAR []){'C','h','a','i','n','i','n','g','M','o','d','e','C','B','C',0}
+#define BCRYPT_CHAIN_MODE_ECB        (const WCHAR []){'C','h','a','i','n','i','n','g','M','o','d','e','E','C','B',0}
+#define BCRYPT_CHAIN_MODE_CFB        (const WCHAR []){'C','h','a','i','n','i','n','g','M','o','d','e','C','F','B',0}
+#define BCRYPT_CHAIN_MODE_CCM        (const WCHAR []){'C','h','a','i','n','i','n','g','M','o','d','e','C','C','M',0}
+#define BCRYPT_CHAIN_MODE_GCM        (const WCHAR []){'C','h','a','i','n','i','n','g','M','o','d','e','G','C','M',0}
+#elif defined(_MSC_VER)
+#define BCRYPT_ALGORITHM_NAME        L"AlgorithmName"
+#define BCRYPT_AUTH_TAG_LENGTH       L"AuthTagLength"
+#define BCRYPT_BLOCK_LENGTH          L"BlockLength"
+#define BCRYPT_CHAINING_MODE         L"ChainingMode"
+#define BCRYPT_HASH_BLOCK_LENGTH     L"HashBlockLength"
+#define BCRYPT_HASH_LENGTH           L"HashDigestLength"
+#define BCRYPT_KEY_LENGTH            L"KeyLength"
+#define BCRYPT_KEY_LENGTHS           L"KeyLengths"
+#define BCRYPT_OBJECT_LENGTH         L"ObjectLength"
+#define BCRYPT_PROVIDER_HANDLE       L"ProviderHandle"
+
+#define MS_PRIMITIVE_PROVIDER        L"Microsoft Primitive Provider"
+
+#define BCRYPT_AES_ALGORITHM         L"AES"
+#define BCRYPT_MD5_ALGORITHM         L"MD5"
+#define BCRYPT_RNG_ALGORITHM         L"RNG"
+#define BCRYPT_SHA1_ALGORITHM        L"SHA1"
+#define BCRYPT_SHA256_ALGORITHM      L"SHA256"
+#define BCRYPT_SHA384_ALGORITHM      L"SHA384"
+#define BCRYPT_SHA512_ALGORITHM      L"SHA512"
+
+#define BCRYPT_CHAIN_MODE_NA         L"ChainingModeN/A"
+#define BCRYPT_CHAIN_MODE_CBC        L"ChainingModeCBC"
+#define BCRYPT_CHAIN_MODE_ECB        L"ChainingModeECB"
+#define BCRYPT_CHAIN_MODE_CFB        L"ChainingModeCFB"
+#define BCRYPT_CHAIN_MODE_CCM        L"ChainingModeCCM"
+#define BCRYPT_CHAIN_MODE_GCM        L"ChainingModeGCM"
+#else
+static const WCHAR BCRYPT_ALGORITHM_NAME[] = {'A','l','g','o','r','i','t','h','m','N','a','m','e',0};
+static const WCHAR BCRYPT_AUTH_TAG_LENGTH[] = {'A','u','t','h','T','a','g','L','e','n','g','t','h',0};
+static const WCHAR BCRYPT_BLOCK_LENGTH[] = {'B','l','o','c','k','L','e','n','g','t','h',0};
+static const WCHAR BCRYPT_CHAINING_MODE[] = {'C','h','a','i','n','i','n','g','M','o','d','e',0};
+static const WCHAR BCRYPT_HASH_BLOCK_LENGTH[] = {'H','a','s','h','B','l','o','c','k','L','e','n','g','t','h',0};
+static const WCHAR BCRYPT_HASH_LENGTH[] = {'H','a','s','h','D','i','g','e','s','t','L','e','n','g','t','h',0};
+static const WCHAR BCRYPT_KEY_LENGTH[] = {'K','e','y','L','e','n','g','t','h',0};
+static const WCHAR BCRYPT_KEY_LENGTHS[] = {'K','e','y','L','e','n','g','t','h','s',0};
+static const WCHAR BCRYPT_OBJECT_LENGTH[] = {'O','b','j','e','c','t','L','e','n','g','t','h',0};
+static const WCHAR BCRYPT_PROVIDER_HANDLE[] = {'P','r','o','v','i','d','e','r','H','a','n','d','l','e',0};
+
+static const WCHAR MS_PRIMITIVE_PROVIDER[] = {'M','i','c','r','o','s','o','f','t',' ','P','r','i','m','i','t','i','v','e',' ','P','r','o','v','i','d','e','r',0};
+
+static const WCHAR BCRYPT_AES_ALGORITHM[] = {'A','E','S',0};
+static const WCHAR BCRYPT_MD5_ALGORITHM[] = {'M','D','5',0};
+static const WCHAR BCRYPT_RNG_ALGORITHM[] = {'R','N','G',0};
+static const WCHAR BCRYPT_SHA1_ALGORITHM[] = {'S','H','A','1',0};
+static const WCHAR BCRYPT_SHA256_ALGORITHM[] = {'S','H','A','2','5','6',0};
+static const WCHAR BCRYPT_SHA384_ALGORITHM[] = {'S','H','A','3','8','4',0};
+static const WCHAR BCRYPT_SHA512_ALGORITHM[] = {'S','H','A','5','1','2',0};
+
+static const WCHAR BCRYPT_CHAIN_MODE_NA[] = {'C','h','a','i','n','i','n','g','M','o','d','e','N','/','A',0};
+static const WCHAR BCRYPT_CHAIN_MODE_CBC[] = {'C','h','a','i','n','i','n','g','M','o','d','e','C','B','C',0};
+static const WCHAR BCRYPT_CHAIN_MODE_ECB[] = {'C','h','a','i','n','i','n','g','M','o','d','e','E','C','B',0};
+static const WCHAR BCRYPT_CHAIN_MODE_CFB[] = {'C','h','a','i','n','i','n','g','M','o','d','e','C','F','B',0};
+static const WCHAR BCRYPT_CHAIN_MODE_CCM[] = {'C','h','a','i','n','i','n','g','M','o','d','e','C','C','M',0};
+static const WCHAR BCRYPT_CHAIN_MODE_GCM[] = {'C','h','a','i','n','i','n','g','M','o','d','e','G','C','M',0};
+#endif
+
 typedef struct _BCRYPT_ALGORITHM_IDENTIFIER
 {
     LPWSTR pszName;
@@ -47,9 +133,81 @@ typedef struct _BCRYPT_ALGORITHM_IDENTIFIER
     ULONG  dwFlags;
 } BCRYPT_ALGORITHM_IDENTIFIER;
 
+typedef struct __BCRYPT_KEY_LENGTHS_STRUCT
+{
+    ULONG dwMinLength;
+    ULONG dwMaxLength;
+    ULONG dwIncrement;
+} BCRYPT_KEY_LENGTHS_STRUCT, BCRYPT_AUTH_TAG_LENGTHS_STRUCT;
+
+typedef struct _BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO
+{
+    ULONG     cbSize;
+    ULONG     dwInfoVersion;
+    UCHAR    *pbNonce;
+    ULONG     cbNonce;
+    UCHAR    *pbAuthData;
+    ULONG     cbAuthData;
+    UCHAR    *pbTag;
+    ULONG     cbTag;
+    UCHAR    *pbMacContext;
+    ULONG     cbMacContext;
+    ULONG     cbAAD;
+    ULONGLONG cbData;
+    ULONG     dwFlags;
+} BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO, *PBCRYPT_AUTHENTICATED_CIPHER_MODE_INFO;
+
+#define BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO_VERSION 1
+
+#define BCRYPT_INIT_AUTH_MODE_INFO(info) \
+    do { \
+        memset(&(info), 0, sizeof(BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO)); \
+        (info).cbSize = sizeof(BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO); \
+        (info).dwInfoVersion = BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO_VERSION; \
+    } while (0)
+
+#define BCRYPT_AUTH_MODE_CHAIN_CALLS_FLAG 0x00000001
+#define BCRYPT_AUTH_MODE_IN_PROGRESS_FLAG 0x00000002
+
+typedef PVOID BCRYPT_HANDLE;
 typedef PVOID BCRYPT_ALG_HANDLE;
+typedef PVOID BCRYPT_KEY_HANDLE;
+typedef PVOID BCRYPT_HASH_HANDLE;
+
+/* Operation classes */
+#define BCRYPT_CIPHER_OPERATION                0x00000001
+#define BCRYPT_HASH_OPERATION                  0x00000002
+#define BCRYPT_ASYMMETRIC_ENCRYPTION_OPERATION 0x00000004
+#define BCRYPT_SECRET_AGREEMENT_OPERATION      0x00000008
+#define BCRYPT_SIGNATURE_OPERATION             0x00000010
+#define BCRYPT_RNG_OPERATION                   0x00000020
+
+/* Flags for BCryptOpenAlgorithmProvider */
+#define BCRYPT_ALG_HANDLE_HMAC_FLAG 0x00000008
+
+/* Flags for BCryptCreateHash */
+#define BCRYPT_HASH_REUSABLE_FLAG   0x00000020
+
+/* Flags for BCryptEncrypt and BCryptDecrypt */
+#define BCRYPT_BLOCK_PADDING        0x00000001
 
 #define BCRYPT_RNG_USE_ENTROPY_IN_BUFFER 0x00000001
 #define BCRYPT_USE_SYSTEM_PREFERRED_RNG  0x00000002
 
+NTSTATUS WINAPI BCryptCloseAlgorithmProvider(BCRYPT_ALG_HANDLE, ULONG);
+NTSTATUS WINAPI BCryptCreateHash(BCRYPT_ALG_HANDLE, BCRYPT_HASH_HANDLE *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG);
+NTSTATUS WINAPI BCryptDecrypt(BCRYPT_KEY_HANDLE, PUCHAR, ULONG, VOID *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG *, ULONG);
+NTSTATUS WINAPI BCryptDestroyHash(BCRYPT_HASH_HANDLE);
+NTSTATUS WINAPI BCryptDestroyKey(BCRYPT_KEY_HANDLE);
+NTSTATUS WINAPI BCryptDuplicateHash(BCRYPT_HASH_HANDLE, BCRYPT_HASH_HANDLE *, PUCHAR, ULONG, ULONG);
+NTSTATUS WINAPI BCryptEncrypt(BCRYPT_KEY_HANDLE, PUCHAR, ULONG, VOID *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG *, ULONG);
+NTSTATUS WINAPI BCryptEnumAlgorithms(ULONG, ULONG *, BCRYPT_ALGORITHM_IDENTIFIER **, ULONG);
+NTSTATUS WINAPI BCryptFinishHash(BCRYPT_HASH_HANDLE, PUCHAR, ULONG, ULONG);
+NTSTATUS WINAPI BCryptGenerateSymmetricKey(BCRYPT_ALG_HANDLE, BCRYPT_KEY_HANDLE *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG);
+NTSTATUS WINAPI BCryptGenRandom(BCRYPT_ALG_HANDLE, PUCHAR, ULONG, ULONG);
+NTSTATUS WINAPI BCryptGetProperty(BCRYPT_HANDLE, LPCWSTR, PUCHAR, ULONG, ULONG *, ULONG);
+NTSTATUS WINAPI BCryptHashData(BCRYPT_HASH_HANDLE, PUCHAR, ULONG, ULONG);
+NTSTATUS WINAPI BCryptOpenAlgorithmProvider(BCRYPT_ALG_HANDLE *, LPCWSTR, LPCWSTR, ULONG);
+NTSTATUS WINAPI BCryptSetProperty(BCRYPT_HANDLE, LPCWSTR, PUCHAR, ULONG, ULONG);
+
 #endif  /* __WINE_BCRYPT_H */